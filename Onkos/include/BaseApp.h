@@ -13,6 +13,12 @@
 #include "Buffer.h"
 #include "SamplerState.h"
 #include "ModelLoader.h"
+#include "ModelLoadRequest.h"
+#include "TextureLoader.h"
+#include "StreamedTextures.h"
+#include "TextureStreamer.h"
+#include "ResourceManager.h"
+#include "ConstantBufferRing.h"
 
 /**
  * @class BaseApp
@@ -99,6 +105,38 @@ private:
 	static LRESULT CALLBACK
 	wndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
 
+	/**
+	 * @brief Creates the GPU buffers of m_mesh, replacing the previous ones.
+	 * @note Quantizes m_mesh first if m_useQuantizedVertices is set. The
+	 * material textures are only requested again if the maps changed, so the
+	 * preview and the final mesh of a load share them.
+	 * @return HRESULT S_OK if the buffers were created.
+	 */
+	HRESULT
+	uploadMesh();
+
+	/**
+	 * @brief Releases the material textures and starts staging the diffuse
+	 * maps of m_mesh on the workers of m_textureLoader.
+	 */
+	void
+	loadMaterialTextures();
+
+	/**
+	 * @brief Streams in the material textures staged since the last frame.
+	 * Never waits for the workers.
+	 */
+	void
+	updateMaterialTextures();
+
+	/**
+	 * @brief Binds the texture and color of a material of m_mesh.
+	 * @param materialId The material in m_mesh.m_materials. Out of range ids
+	 * draw with the default texture in white.
+	 */
+	void
+	bindMaterial(unsigned int materialId);
+
 private:
 	//--------------------------------------------------------------------------------------
 	// Global Variables
@@ -125,29 +163,43 @@ private:
 	ShaderProgram m_shaderProgram;
 	/** @brief The CPU-side mesh data (vertices/indices). */
 	MeshComponent m_mesh;
-	/** @brief The GPU-side vertex buffer. */
-	Buffer m_vertexBuffer;
-	/** @brief The GPU-side index buffer. */
-	Buffer m_indexBuffer;
+	/** @brief The GPU-side vertex and index buffers of m_mesh, shared through m_resourceManager. */
+	MeshHandle m_meshBuffers;
 	/** @brief GPU constant buffer for data updated once (e.g., View matrix). */
 	Buffer m_cbNeverChanges;
 	/** @brief GPU constant buffer for data updated on resize (e.g., Projection matrix). */
 	Buffer m_cbChangeOnResize;
-	/** @brief GPU constant buffer for data updated every frame (e.g., World matrix). */
-	Buffer m_cbChangesEveryFrame;
-	/** @brief A sample texture for the mesh. */
-	Texture m_textureCube;
+	/** @brief Writes and binds the per-object constants (cb: World matrix, color) every draw. */
+	ConstantBufferRing m_constantRing;
+	/** @brief A sample texture for the mesh, shared through m_resourceManager. */
+	TextureHandle m_textureCube;
+	/** @brief The diffuse textures of the materials of m_mesh, with the levels m_textureStreamer keeps resident. */
+	StreamedTextures m_materialTextures;
+	/** @brief The streamed texture of each material of m_mesh, kInvalidStreamedTexture for materials without one (yet). */
+	std::vector<StreamedTextureId> m_materialTextureIds;
+	/** @brief The diffuse map of each material the textures were requested for. */
+	std::vector<std::string> m_materialMaps;
+	/** @brief The materials that use each file of m_materialBatch. */
+	std::vector<std::vector<size_t>> m_batchMaterialIds;
+	/** @brief The material textures being staged, null once every one was streamed in. */
+	TextureBatchHandle m_materialBatch;
 	/** @brief The sampler state for texture sampling. */
 	SamplerState m_samplerState;
 
 	/** @brief The world transformation matrix. */
 	XMMATRIX m_World;
+	/** @brief Maps quantized positions back to model space (identity for full vertices). */
+	XMMATRIX m_dequantize;
 	/** @brief The view (camera) transformation matrix. */
 	XMMATRIX m_View;
 	/** @brief The projection (perspective) transformation matrix. */
 	XMMATRIX m_Projection;
 	/** @brief A color tint for the mesh. */
 	XMFLOAT4 m_vMeshColor;
+	/** @brief The camera position in world space. */
+	XMFLOAT3 m_eyePosition;
+	/** @brief The level of detail of m_mesh drawn this frame. */
+	size_t m_lod = 0;
 
 	/** @brief CPU-side struct for the 'ChangeOnResize' constant buffer. */
 	CBChangeOnResize cbChangesOnResize;
@@ -158,4 +210,14 @@ private:
 
 	/** @brief Utility class for loading 3D model data from files into mesh components. */
 	ModelLoader m_modelLoader;
+	/** @brief Decodes the material textures of m_mesh on worker threads. */
+	TextureLoader m_textureLoader;
+	/** @brief Streams the levels of the material textures under a memory budget. */
+	TextureStreamer m_textureStreamer;
+	/** @brief Shares the textures and mesh buffers with identical content. */
+	ResourceManager m_resourceManager;
+	/** @brief The background load of m_mesh, null once it finished or if the cooked mesh was found. */
+	ModelLoadHandle m_meshLoad;
+	/** @brief Uploads the mesh as QuantizedVertex (20 bytes) instead of SimpleVertex (48 bytes). */
+	bool m_useQuantizedVertices = false;
 };
\ No newline at end of file
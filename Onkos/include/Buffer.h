@@ -33,6 +33,10 @@ public:
 	/**
 	 * @brief Initializes the buffer as a static resource from mesh data.
 	 * This is typically used for creating Vertex Buffers or Index Buffers.
+	 * Vertex buffers use the format of the mesh (see MeshComponent::getVertexFormat()).
+	 * Index buffers use 16-bit indices whenever the mesh allows it
+	 * (see MeshComponent::getIndexFormat()); the chosen format is kept and
+	 * used by render().
 	 * @param device The graphics device used to create the buffer.
 	 * @param mesh The mesh component containing the vertex or index data.
 	 * @param bindFlag The bind flag (e.g., D3D11_BIND_VERTEX_BUFFER, D3D11_BIND_INDEX_BUFFER).
@@ -42,9 +46,10 @@ public:
 	init(Device& device, const MeshComponent& mesh, unsigned int bindFlag);
 
 	/**
-	 * @brief Initializes the buffer for dynamic use, typically a constant buffer.
-	 * This creates a buffer of a specific size with D3D11_USAGE_DYNAMIC and
-	 * D3D11_CPU_ACCESS_WRITE flags.
+	 * @brief Initializes the buffer as a constant buffer of a specific size
+	 * with D3D11_USAGE_DEFAULT, written with update().
+	 * @note Suits constants that rarely change. Constants written for every
+	 * object go through a ConstantBufferRing instead.
 	 * @param device The graphics device used to create the buffer.
 	 * @param byteWidth The size of the buffer in bytes.
 	 * @return HRESULT S_OK if successful.
@@ -83,7 +88,8 @@ public:
 	 * @param StartSlot The starting slot to bind the buffer to.
 	 * @param NumBuffers The number of buffers to bind (typically 1).
 	 * @param setPixelShader If true and this is a constant buffer, binds to the Pixel Shader stage. Otherwise, binds to Vertex Shader.
-	 * @param format The DXGI_FORMAT for an index buffer (e.g., DXGI_FORMAT_R32_UINT).
+	 * @param format The DXGI_FORMAT for an index buffer. DXGI_FORMAT_UNKNOWN uses
+	 * the format chosen by init().
 	 */
 	void
 	render(DeviceContext& deviceContext,
@@ -92,6 +98,14 @@ public:
 				 bool setPixelShader = false,
 				 DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN);
 
+	/**
+	 * @brief Gets the format of the indices stored in an index buffer.
+	 * @return DXGI_FORMAT DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT, or
+	 * DXGI_FORMAT_UNKNOWN if this isn't an index buffer.
+	 */
+	DXGI_FORMAT
+	getIndexFormat() const { return m_indexFormat; }
+
 	/**
 	 * @brief Releases the underlying ID3D11Buffer COM object.
 	 */
@@ -122,4 +136,7 @@ private:
 
 	/** @brief Stores the bind flag (e.g., D3D11_BIND_VERTEX_BUFFER) to determine behavior in render(). */
 	unsigned int m_bindFlag = 0;
+
+	/** @brief The format of the indices, for index buffers. */
+	DXGI_FORMAT m_indexFormat = DXGI_FORMAT_UNKNOWN;
 };
\ No newline at end of file
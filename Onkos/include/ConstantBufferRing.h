@@ -0,0 +1,185 @@
+#pragma once
+#include "Prerequisites.h"
+#include "RingAllocator.h"
+#include <deque>
+
+// Forward declarations
+class Device;
+class DeviceContext;
+struct ID3D11DeviceContext1;
+
+/**
+ * @struct ConstantBufferRingStats
+ * @brief How the constants of a ConstantBufferRing were written and bound.
+ */
+struct
+ConstantBufferRingStats {
+	/** @brief true if the constants go to ranges of one buffer, bound by offset (D3D11.1). */
+	bool offsetBinding = false;
+
+	/** @brief Constant blocks written since init. */
+	uint64_t bindCount = 0;
+
+	/** @brief Bytes written since init. */
+	uint64_t bytesWritten = 0;
+
+	/** @brief Times the ring was full and the CPU waited for the GPU to finish a frame. */
+	uint64_t waitCount = 0;
+
+	/** @brief Blocks that didn't fit in the ring even with the GPU idle; they went to a slot buffer. */
+	uint64_t overflowCount = 0;
+
+	/** @brief Usage of the ring. */
+	RingAllocatorStats ring;
+};
+
+/**
+ * @class ConstantBufferRing
+ * @brief Writes per-object constants into one large dynamic buffer and binds
+ * each block by its offset, instead of a default buffer updated with
+ * UpdateSubresource for every object.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Every bind takes a 256-byte aligned range of the buffer from a
+ * RingAllocator, writes it through Map(WRITE_NO_OVERWRITE) (the GPU may still
+ * read the other ranges) and binds it with VSSetConstantBuffers1. endFrame
+ * issues an event query as the fence of the frame; beginFrame frees the
+ * ranges of the frames the GPU finished. If the ring is full the CPU waits
+ * for the oldest frame.
+ *
+ * Binding by offset needs the D3D11.1 runtime (Windows 8) and the headers of
+ * the Windows SDK, which the project searches before the DirectX SDK (that one
+ * only supplies D3DX and XNA Math). Where the driver doesn't support it, on
+ * Windows 7 for example, every slot gets its own small dynamic buffer
+ * rewritten with Map(WRITE_DISCARD), which the driver renames without
+ * stalling or copying.
+ *
+ * A slot holds the same constants for the vertex and the pixel shader.
+ * Every call must come from the thread that owns the device context.
+ */
+class
+ConstantBufferRing {
+public:
+	/**
+	 * @brief Default constructor.
+	 */
+	ConstantBufferRing() = default;
+
+	/**
+	 * @brief Default destructor.
+	 */
+	~ConstantBufferRing() = default;
+
+	/**
+	 * @brief Creates the buffer of the ring, or prepares the slot buffers without D3D11.1.
+	 * @param device The graphics device.
+	 * @param deviceContext The immediate context the constants are written and bound with.
+	 * @param capacity Bytes of the ring; a few frames of constants.
+	 * @return HRESULT S_OK if successful.
+	 */
+	HRESULT
+	init(Device& device, DeviceContext& deviceContext, unsigned int capacity = 4 * 1024 * 1024);
+
+	/**
+	 * @brief Frees the ranges of the frames the GPU finished. Call before the first bind of a frame.
+	 * @param deviceContext The device context.
+	 */
+	void
+	beginFrame(DeviceContext& deviceContext);
+
+	/**
+	 * @brief Writes a block of constants and binds it to a slot of the vertex shader.
+	 * @param deviceContext The device context.
+	 * @param StartSlot The constant buffer slot.
+	 * @param pData The constants.
+	 * @param byteWidth Bytes of the constants, up to 64 KB.
+	 * @param setPixelShader If true, binds the block to the same slot of the pixel shader too.
+	 * @return bool false if the constants couldn't be written.
+	 */
+	bool
+	bind(DeviceContext& deviceContext,
+			 unsigned int StartSlot,
+			 const void* pData,
+			 unsigned int byteWidth,
+			 bool setPixelShader = false);
+
+	/**
+	 * @brief Tags the ranges written this frame with a fence. Call after the last draw of a frame.
+	 * @param deviceContext The device context.
+	 */
+	void
+	endFrame(DeviceContext& deviceContext);
+
+	/**
+	 * @brief Releases the buffers and the fences.
+	 */
+	void
+	destroy();
+
+	/**
+	 * @brief Gets the stats of the ring.
+	 * @return ConstantBufferRingStats The stats since init.
+	 */
+	ConstantBufferRingStats
+	getStats() const;
+
+private:
+	/**
+	 * @brief Writes a block through the slot buffer of StartSlot, growing it if needed.
+	 */
+	bool
+	bindDiscard(DeviceContext& deviceContext,
+							unsigned int StartSlot,
+							const void* pData,
+							unsigned int byteWidth,
+							bool setPixelShader);
+
+	/**
+	 * @brief Frees the ranges of the finished frames; waits for the oldest one if wait is true.
+	 */
+	void
+	retireFrames(DeviceContext& deviceContext, bool wait);
+
+	/**
+	 * @brief The event query issued at the end of a frame and the fence it stands for.
+	 */
+	struct
+	Fence {
+		ID3D11Query* query;
+		uint64_t value;
+	};
+
+	/** @brief Creates the slot buffers and the fences. */
+	Device* m_device = nullptr;
+
+	/** @brief The context that binds by offset, null without D3D11.1. */
+	ID3D11DeviceContext1* m_deviceContext1 = nullptr;
+
+	/** @brief The buffer of the ring. */
+	ID3D11Buffer* m_buffer = nullptr;
+
+	/** @brief true until the buffer of the ring is first mapped, with WRITE_DISCARD. */
+	bool m_firstMap = true;
+
+	/** @brief The ranges of the buffer of the ring. */
+	RingAllocator m_allocator;
+
+	/** @brief The fences of the frames the GPU may still be reading, oldest first. */
+	std::deque<Fence> m_pendingFences;
+
+	/** @brief Event queries ready to be reused. */
+	std::vector<ID3D11Query*> m_freeQueries;
+
+	/** @brief Fence value of the last ended frame. */
+	uint64_t m_fenceValue = 0;
+
+	/** @brief The buffer of every slot without offset binding, created on first use. */
+	ID3D11Buffer* m_slotBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = {};
+
+	/** @brief Bytes of every slot buffer. */
+	unsigned int m_slotSizes[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = {};
+
+	/** @brief How the constants were written. */
+	ConstantBufferRingStats m_stats;
+};
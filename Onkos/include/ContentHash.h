@@ -0,0 +1,36 @@
+#pragma once
+#include "Prerequisites.h"
+#include <cstdint>
+
+/**
+ * @class ContentHash
+ * @brief Computes 64-bit fingerprints of binary data.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Implements the XXH64 hash, which processes 32 bytes per iteration and runs
+ * at memory speed. It is used to detect when a source asset has changed and
+ * to identify identical data, not for any security purpose.
+ */
+class
+ContentHash {
+public:
+	/**
+	 * @brief Hashes a block of memory.
+	 * @param data Pointer to the first byte.
+	 * @param size The number of bytes to hash.
+	 * @param seed An optional seed, to derive independent hashes from the same data.
+	 * @return uint64_t The 64-bit hash of the data.
+	 */
+	static uint64_t
+	compute(const void* data, size_t size, uint64_t seed = 0);
+
+	/**
+	 * @brief Hashes the whole content of a file.
+	 * @param fileName The path to the file.
+	 * @param outHash Receives the 64-bit hash of the file.
+	 * @return bool true if the file could be read, false otherwise.
+	 */
+	static bool
+	computeFile(const std::string& fileName, uint64_t& outHash);
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @struct Image
+ * @brief A CPU-side image with 8-bit RGBA pixels.
+ *
+ * Rows are tightly packed (4 bytes per pixel, no padding), which is the
+ * layout stbi_load produces and D3D11 accepts as initial texture data.
+ */
+struct
+Image {
+	/** @brief Width of the image in pixels. */
+	unsigned int width = 0;
+
+	/** @brief Height of the image in pixels. */
+	unsigned int height = 0;
+
+	/** @brief The RGBA8 pixels, row after row. */
+	std::vector<unsigned char> pixels;
+
+	/**
+	 * @brief Gets the number of bytes of one row of pixels.
+	 * @return unsigned int The row pitch in bytes.
+	 */
+	unsigned int
+	getRowPitch() const { return width * 4; }
+
+	/**
+	 * @brief Checks if the image holds any pixel.
+	 * @return bool true if the image is empty.
+	 */
+	bool
+	empty() const { return pixels.empty(); }
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include "Prerequisites.h"
+#include "Image.h"
+
+/**
+ * @class ImageDecoder
+ * @brief Decodes PNG and JPG files into RGBA8 images on the CPU.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * A thin wrapper over stb_image that has no dependency on DirectX, so it can
+ * be used both by Texture and by the offline tools. This file also holds the
+ * stb_image implementation of the engine.
+ */
+class
+ImageDecoder {
+public:
+	/**
+	 * @brief Decodes an image file.
+	 * @param fileName The path to the PNG or JPG file.
+	 * @param outImage Receives the decoded RGBA8 pixels.
+	 * @return bool true if the file was decoded.
+	 */
+	static bool
+	decodeFile(const std::string& fileName, Image& outImage);
+
+	/**
+	 * @brief Decodes an encoded image that is already in memory.
+	 * @param data Pointer to the encoded PNG or JPG bytes.
+	 * @param size The number of encoded bytes.
+	 * @param outImage Receives the decoded RGBA8 pixels.
+	 * @return bool true if the data was decoded.
+	 */
+	static bool
+	decodeMemory(const void* data, size_t size, Image& outImage);
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @class MappedFile
+ * @brief A read-only memory mapping of a file on disk.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * This class maps an entire file into the address space of the process so its
+ * contents can be read directly from memory, without copying them into
+ * intermediate buffers or streams. It is used by the parsers of the engine
+ * (e.g. ModelLoader) to tokenize large files in place.
+ */
+class
+MappedFile {
+public:
+	/**
+	 * @brief Default constructor.
+	 */
+	MappedFile() = default;
+
+	/**
+	 * @brief Destructor. Unmaps the file if it is still mapped.
+	 */
+	~MappedFile() { destroy(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/**
+	 * @brief Opens a file and maps its whole content as read-only memory.
+	 * @param fileName The path to the file to map.
+	 * @return bool true if the file was mapped (an empty file maps to a null
+	 * pointer with size 0), false otherwise.
+	 */
+	bool
+	init(const std::string& fileName);
+
+	/**
+	 * @brief Unmaps the file and closes every handle associated with it.
+	 */
+	void
+	destroy();
+
+	/**
+	 * @brief Gets the first byte of the mapped file.
+	 * @return const char* Pointer to the mapped memory, nullptr if nothing is mapped.
+	 */
+	const char*
+	data() const { return m_data; }
+
+	/**
+	 * @brief Gets the size of the mapped file.
+	 * @return size_t The number of mapped bytes.
+	 */
+	size_t
+	size() const { return m_size; }
+
+private:
+	/** @brief Pointer to the first byte of the mapped view. */
+	const char* m_data = nullptr;
+
+	/** @brief The number of bytes in the mapped view. */
+	size_t m_size = 0;
+
+	/** @brief The OS handle of the opened file (Windows only). */
+	void* m_fileHandle = nullptr;
+
+	/** @brief The OS handle of the file mapping object (Windows only). */
+	void* m_mappingHandle = nullptr;
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @struct Material
+ * @brief The surface properties of a material read from an MTL library.
+ *
+ * The values not given by the library keep their defaults, which draw the
+ * surface white and opaque with the default texture.
+ */
+struct
+Material {
+	/** @brief The name given by newmtl and referenced by usemtl. */
+	std::string name;
+
+	/** @brief Ambient color (Ka). */
+	XMFLOAT3 ambient = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+	/** @brief Diffuse color (Kd). */
+	XMFLOAT3 diffuse = XMFLOAT3(1.0f, 1.0f, 1.0f);
+
+	/** @brief Specular color (Ks). */
+	XMFLOAT3 specular = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+	/** @brief Emissive color (Ke). */
+	XMFLOAT3 emissive = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+	/** @brief Specular exponent (Ns). */
+	float shininess = 0.0f;
+
+	/** @brief Opacity, 1 is opaque (d, or 1 - Tr). */
+	float opacity = 1.0f;
+
+	/** @brief The MTL illumination model (illum). */
+	int illumination = 2;
+
+	/** @brief Diffuse texture (map_Kd), relative to the working directory. Empty if none. */
+	std::string diffuseMap;
+
+	/** @brief Specular texture (map_Ks). Empty if none. */
+	std::string specularMap;
+
+	/** @brief Normal or bump texture (norm, map_Bump or bump). Empty if none. */
+	std::string normalMap;
+
+	/** @brief Opacity texture (map_d). Empty if none. */
+	std::string opacityMap;
+};
+
+/**
+ * @class MaterialLibrary
+ * @brief A utility class for reading Wavefront MTL material libraries.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * A model refers to its materials by name (usemtl), so the material list of a
+ * mesh is built from the names first and the libraries (mtllib) only fill in
+ * the properties of the materials with a matching name. Materials of the
+ * library that the model never uses are skipped.
+ *
+ * Texture paths are made relative to the directory of the library. Options
+ * before the file name of a map (-s, -o, -bm, ...) are ignored.
+ */
+class
+MaterialLibrary {
+public:
+	/**
+	 * @brief Reads an MTL file into the materials with the same names.
+	 * @param fileName The path to the .mtl file.
+	 * @param materials The materials to fill, looked up by name.
+	 * @return bool false if the file couldn't be opened.
+	 */
+	static bool
+	load(const std::string& fileName, std::vector<Material>& materials);
+
+	/**
+	 * @brief Gets the directory part of a path, with its trailing separator.
+	 * @param path A file path.
+	 * @return std::string The directory ("" for a bare file name).
+	 */
+	static std::string
+	getDirectory(const std::string& path);
+};
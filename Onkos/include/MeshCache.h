@@ -0,0 +1,182 @@
+#pragma once
+#include "Prerequisites.h"
+#include "MeshComponent.h"
+#include <cstdint>
+
+/**
+ * @brief Identifies a .onkmesh file ("ONKM" in little-endian).
+ */
+static const uint32_t kMeshCacheMagic = 0x4D4B4E4F;
+
+/**
+ * @brief Version of the .onkmesh layout. Bump it whenever SimpleVertex or the
+ * processing done by ModelLoader changes, so stale caches are rebuilt.
+ */
+static const uint32_t kMeshCacheVersion = 9;
+
+/**
+ * @struct MeshCacheSettings
+ * @brief The processing a .onkmesh was built with. The same source loaded with
+ * other settings gives other arrays, so a cache only matches its own settings.
+ */
+struct
+MeshCacheSettings {
+	/** @brief true if the vertex and index arrays went through MeshOptimizer. */
+	bool optimizeMesh = true;
+
+	/** @brief Levels of detail MeshSimplifier built below the full mesh, 0 for none. */
+	unsigned int lodLevelCount = 0;
+};
+
+/**
+ * @struct MeshCacheHeader
+ * @brief The fixed-size header at the start of every .onkmesh file.
+ *
+ * The vertex, index, submesh and level of detail arrays follow the header at 16-byte aligned
+ * offsets, so they can be used in place once the file is memory-mapped.
+ * Last comes the name table: the material libraries, the material names and
+ * the object names, each one terminated by a zero byte.
+ */
+struct
+MeshCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t vertexStride;
+	uint64_t sourceHash;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	float boundsMin[3];
+	float boundsMax[3];
+	uint32_t subMeshCount;
+	uint32_t lodCount;
+	uint64_t subMeshOffset;
+	uint64_t lodOffset;
+	uint32_t libraryCount;
+	uint32_t materialCount;
+	uint32_t objectCount;
+	uint32_t nameBytes;
+	uint64_t nameOffset;
+	uint32_t optimized;
+	uint32_t lodLevelCount;
+	uint32_t indexFormat;
+	uint32_t reserved;
+};
+
+/**
+ * @struct MeshCacheSubMesh
+ * @brief How one SubMesh is stored inside a .onkmesh file.
+ */
+struct
+MeshCacheSubMesh {
+	uint32_t startIndex;
+	uint32_t indexCount;
+	int32_t baseVertex;
+	uint32_t materialId;
+	uint32_t objectId;
+	uint32_t reserved;
+};
+
+/**
+ * @struct MeshCacheLod
+ * @brief How one MeshLod is stored inside a .onkmesh file.
+ */
+struct
+MeshCacheLod {
+	uint32_t firstSubMesh;
+	uint32_t subMeshCount;
+	float error;
+	uint32_t reserved;
+};
+
+/**
+ * @class MeshCache
+ * @brief Reads and writes the binary mesh cache format (.onkmesh).
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * A .onkmesh file stores the final vertex and index arrays of a
+ * MeshComponent, its submeshes, its levels of detail, its bounds, the names of
+ * its materials and objects, the hash of the source file it was built from and
+ * the settings it was processed with.
+ * Material properties aren't stored, they are read from the MTL libraries.
+ * Loading a cache memory-maps the file and points the mesh at the arrays
+ * inside the mapping, so nothing is parsed or copied. A cache whose hash,
+ * settings, version or vertex layout doesn't match is rejected and should be
+ * rebuilt.
+ */
+class
+MeshCache {
+public:
+	/**
+	 * @brief Default constructor.
+	 */
+	MeshCache() = default;
+
+	/**
+	 * @brief Default destructor.
+	 */
+	~MeshCache() = default;
+
+	/**
+	 * @brief Writes a mesh to a cache file.
+	 * @note The file is written under a temporary name and then renamed over the
+	 * old cache in one step, so a crash never leaves a truncated cache behind and
+	 * readers see either the old file or the new one.
+	 * @param cachePath The path of the .onkmesh file to write.
+	 * @param mesh The mesh whose vertex and index arrays are stored.
+	 * @param sourceHash The ContentHash of the source asset.
+	 * @param settings The processing the mesh went through.
+	 * @return bool true if the file was written.
+	 */
+	bool
+	save(const std::string& cachePath,
+			 const MeshComponent& mesh,
+			 uint64_t sourceHash,
+			 const MeshCacheSettings& settings);
+
+	/**
+	 * @brief Memory-maps a cache file into a mesh.
+	 * @param cachePath The path of the .onkmesh file to read.
+	 * @param sourceHash The expected ContentHash of the source asset.
+	 * @param settings The expected processing settings.
+	 * @param outMesh The mesh that will point at the mapped arrays.
+	 * @return bool true if the cache exists and is valid for this source and these settings.
+	 */
+	bool
+	load(const std::string& cachePath,
+			 uint64_t sourceHash,
+			 const MeshCacheSettings& settings,
+			 MeshComponent& outMesh);
+
+	/**
+	 * @brief Memory-maps a cooked .onkmesh file regardless of the source it came from.
+	 * @note Used for assets produced offline by OnkosCooker, whose source isn't shipped.
+	 * @param cachePath The path of the .onkmesh file to read.
+	 * @param outMesh The mesh that will point at the mapped arrays.
+	 * @return bool true if the file is a valid .onkmesh.
+	 */
+	bool
+	load(const std::string& cachePath, MeshComponent& outMesh);
+
+	/**
+	 * @brief Builds the cache path for a source asset (e.g. "test.obj" -> "test.onkmesh").
+	 * @param sourcePath The path to the source asset.
+	 * @return std::string The path of its .onkmesh file.
+	 */
+	static std::string
+	getCachePath(const std::string& sourcePath);
+
+private:
+	/**
+	 * @brief Maps and validates a .onkmesh file.
+	 */
+	bool
+	loadInternal(const std::string& cachePath,
+							 bool checkHash,
+							 uint64_t sourceHash,
+							 const MeshCacheSettings& settings,
+							 MeshComponent& outMesh);
+};
@@ -1,8 +1,56 @@
 #pragma once
 #include "Prerequisites.h"
+#include "MaterialLibrary.h"
+#include "Meshlets.h"
+#include "VertexQuantizer.h"
+#include <memory>
 
 // Forward declarations
 class DeviceContext;
+class MappedFile;
+
+/**
+ * @brief The largest number of vertices that 16-bit indices can address.
+ */
+static const size_t kMaxIndex16Vertices = 65536;
+
+/**
+ * @struct SubMesh
+ * @brief A range of the index array drawn with a single DrawIndexed call.
+ */
+struct
+SubMesh {
+	/** @brief The first index of the range. */
+	unsigned int startIndex = 0;
+
+	/** @brief The number of indices of the range. */
+	unsigned int indexCount = 0;
+
+	/** @brief Added by the GPU to every index of the range before fetching the vertex. */
+	int baseVertex = 0;
+
+	/** @brief The material of the range in MeshComponent::m_materials. */
+	unsigned int materialId = 0;
+
+	/** @brief The object (o/g) of the range in MeshComponent::m_objectNames. */
+	unsigned int objectId = 0;
+};
+
+/**
+ * @struct MeshLod
+ * @brief One level of detail: a run of consecutive submeshes.
+ */
+struct
+MeshLod {
+	/** @brief The first submesh of the level in MeshComponent::m_subMeshes. */
+	unsigned int firstSubMesh = 0;
+
+	/** @brief The number of submeshes of the level. */
+	unsigned int subMeshCount = 0;
+
+	/** @brief Largest distance between the level and the full mesh, in model units. */
+	float error = 0.0f;
+};
 
 /**
  * @class MeshComponent
@@ -15,6 +63,22 @@ class DeviceContext;
  * container that is typically used by a `Buffer` to create GPU-side vertex
  * and index buffers. It is likely part of an Entity-Component System (ECS)
  * architecture.
+ *
+ * The vertex and index arrays can also live in a memory-mapped file (see
+ * MeshCache). In that case m_vertex and m_index are empty and the data is
+ * reached through getVertexData() and getIndexData().
+ *
+ * The index array is split into m_subMeshes. Indices are relative to the
+ * baseVertex of their submesh, which lets meshes with more than 65536
+ * vertices still be drawn with 16-bit indices (see getIndexFormat()).
+ *
+ * Simplified versions of the mesh (see MeshSimplifier) share the vertex array
+ * and add their own submeshes; m_lods tells which submeshes belong to each
+ * level of detail.
+ *
+ * Every submesh belongs to one material and one object of the source file.
+ * The submeshes of a level are sorted by material, so drawing them in order
+ * changes the material state at most once per material.
  */
 class 
 MeshComponent {
@@ -30,6 +94,15 @@ public:
 	virtual
 	~MeshComponent() = default;
 
+	MeshComponent(const MeshComponent&) = default;
+	MeshComponent& operator=(const MeshComponent&) = default;
+
+	/**
+	 * @brief Move constructor and assignment, so meshes are handed over without copying their arrays.
+	 */
+	MeshComponent(MeshComponent&&) = default;
+	MeshComponent& operator=(MeshComponent&&) = default;
+
 	/**
 	 * @brief Initializes the mesh component.
 	 * @note Can be used to load mesh data from a file (e.g., .obj, .fbx)
@@ -62,6 +135,87 @@ public:
 	void
 	destroy();
 
+	/**
+	 * @brief Gets the vertex array, whether it is owned or memory-mapped.
+	 * @return const SimpleVertex* Pointer to the first vertex.
+	 */
+	const SimpleVertex*
+	getVertexData() const { return m_vertexView ? m_vertexView : m_vertex.data(); }
+
+	/**
+	 * @brief Gets the index array, whether it is owned or memory-mapped.
+	 * @return const unsigned int* Pointer to the first index.
+	 */
+	const unsigned int*
+	getIndexData() const { return m_indexView ? m_indexView : m_index.data(); }
+
+	/**
+	 * @brief Gets the number of vertices, whether they are owned or memory-mapped.
+	 * @return size_t The number of vertices.
+	 */
+	size_t
+	getVertexCount() const { return m_vertexView ? static_cast<size_t>(m_numVertex) : m_vertex.size(); }
+
+	/**
+	 * @brief Gets the number of indices, whether they are owned or memory-mapped.
+	 * @return size_t The number of indices.
+	 */
+	size_t
+	getIndexCount() const { return m_indexView ? static_cast<size_t>(m_numIndex) : m_index.size(); }
+
+	/**
+	 * @brief Gets the smallest index format that can hold every index.
+	 * @note Returns m_indexFormat when it is known; only meshes that were
+	 * never split nor loaded from a cache scan their indices.
+	 * @return DXGI_FORMAT DXGI_FORMAT_R16_UINT if all indices are below 65536,
+	 * DXGI_FORMAT_R32_UINT otherwise.
+	 */
+	DXGI_FORMAT
+	getIndexFormat() const;
+
+	/**
+	 * @brief Gets the format the vertices are uploaded with.
+	 * @return VertexFormat VERTEX_FORMAT_QUANTIZED once VertexQuantizer::quantize
+	 * has filled m_quantizedVertex, VERTEX_FORMAT_FULL otherwise.
+	 */
+	VertexFormat
+	getVertexFormat() const { return m_quantizedVertex.empty() ? VERTEX_FORMAT_FULL : VERTEX_FORMAT_QUANTIZED; }
+
+	/**
+	 * @brief Checks if the vertex and index arrays point into a mapped file.
+	 * @return bool true if the mesh data is memory-mapped.
+	 */
+	bool
+	isMapped() const { return m_mappedFile != nullptr; }
+
+	/**
+	 * @brief Gets the number of levels of detail, at least 1.
+	 */
+	size_t
+	getLodCount() const { return m_lods.empty() ? 1 : m_lods.size(); }
+
+	/**
+	 * @brief Gets a level of detail.
+	 * @note Without m_lods, level 0 is every submesh with no error.
+	 * @param lod The level, 0 is the full resolution mesh.
+	 * @return MeshLod The submeshes and error of the level.
+	 */
+	MeshLod
+	getLod(size_t lod) const;
+
+	/**
+	 * @brief Copies memory-mapped data into m_vertex and m_index so it can be modified.
+	 * @note Does nothing if the mesh already owns its data.
+	 */
+	void
+	materialize();
+
+	/**
+	 * @brief Recomputes m_boundsMin and m_boundsMax from the vertex positions.
+	 */
+	void
+	computeBounds();
+
 public:
 	/** @brief An identifier name for the mesh (e.g., "cube", "sphere_mesh"). */
 	std::string m_name;
@@ -77,4 +231,47 @@ public:
 
 	/** @brief Cached count of the number of indices. This is used for draw calls. */
 	int m_numIndex;
+
+	/** @brief Compressed copy of the vertices, uploaded instead of them when not empty. */
+	std::vector<QuantizedVertex> m_quantizedVertex;
+
+	/** @brief The ranges of the index array to draw. Empty means one range with every index. */
+	std::vector<SubMesh> m_subMeshes;
+
+	/** @brief The levels of detail, finest first. Empty means one level with every submesh. */
+	std::vector<MeshLod> m_lods;
+
+	/** @brief The materials referenced by SubMesh::materialId, in order of first use. */
+	std::vector<Material> m_materials;
+
+	/** @brief The MTL libraries (mtllib) the materials are read from, relative to the model. */
+	std::vector<std::string> m_materialLibraries;
+
+	/** @brief The names of the objects (o/g) referenced by SubMesh::objectId. */
+	std::vector<std::string> m_objectNames;
+
+	/** @brief Clusters of triangles for partial culling, filled by MeshletBuilder::build. */
+	MeshletData m_meshlets;
+
+	/** @brief Minimum corner of the axis-aligned bounding box of the positions. */
+	XMFLOAT3 m_boundsMin = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+	/** @brief Maximum corner of the axis-aligned bounding box of the positions. */
+	XMFLOAT3 m_boundsMax = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+	/** @brief Vertices inside m_mappedFile, used instead of m_vertex when not null. */
+	const SimpleVertex* m_vertexView = nullptr;
+
+	/** @brief Indices inside m_mappedFile, used instead of m_index when not null. */
+	const unsigned int* m_indexView = nullptr;
+
+	/** @brief Keeps the file behind m_vertexView and m_indexView mapped. */
+	std::shared_ptr<MappedFile> m_mappedFile;
+
+	/**
+	 * @brief The format every index fits in, set by MeshOptimizer::splitIndex16 and
+	 * MeshCache::load. DXGI_FORMAT_UNKNOWN until then; code that changes the
+	 * indices afterwards resets it.
+	 */
+	DXGI_FORMAT m_indexFormat = DXGI_FORMAT_UNKNOWN;
 };
\ No newline at end of file
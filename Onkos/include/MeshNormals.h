@@ -0,0 +1,84 @@
+#pragma once
+#include "Prerequisites.h"
+
+class ThreadPool;
+
+/**
+ * @brief Largest number of vertex ranges MeshNormals splits a mesh into, one
+ * task of the thread pool each.
+ */
+static const unsigned int kNormalMaxPartitions = 8;
+
+/**
+ * @brief Smallest number of triangles worth a vertex range of its own.
+ */
+static const unsigned int kNormalMinTrianglesPerPartition = 32768;
+
+/**
+ * @class MeshNormals
+ * @brief Generates smooth vertex normals and tangent frames.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Both passes add each face's contribution to its corners, weighted by the
+ * angle of the corner. A counting sort first lists the corners of every
+ * vertex in triangle order (4 bytes per corner and per vertex); the vertices
+ * are then split into a few contiguous ranges, and each range gathers the
+ * sums of its own vertices. Threads never write to the same memory, no
+ * atomics or per-thread copies of the sums are needed, and every vertex adds
+ * its faces in the same order, so the result is identical for any number of
+ * threads.
+ *
+ * Tangents follow the MikkTSpace approach: the per-face tangent and bitangent
+ * from the UV gradients are projected onto the plane of the vertex normal
+ * before being accumulated, and the final tangent is orthogonalized against
+ * the normal, with the handedness of the bitangent in Tangent.w.
+ */
+class
+MeshNormals {
+public:
+	/**
+	 * @brief Computes smooth normals into SimpleVertex::Norm.
+	 * @param vertices The vertices to update.
+	 * @param vertexCount The number of vertices.
+	 * @param indices The triangle list.
+	 * @param indexCount The number of indices.
+	 * @param baseVertex The index of vertices[0]: the triangles index
+	 * [baseVertex, baseVertex + vertexCount), e.g. the vertices appended to a mesh.
+	 * @param positionIds Optional, an id per vertex of the range, shared by every
+	 * vertex at the same position (e.g. the OBJ position index), so normals stay
+	 * smooth across UV seams. Null smooths per vertex.
+	 * @param positionCount The number of distinct ids in positionIds.
+	 * @param threadPool Optional, the pool that runs the vertex ranges.
+	 * @return bool false if an index or a position id is out of range.
+	 */
+	static bool
+	computeNormals(SimpleVertex* vertices,
+								 size_t vertexCount,
+								 const unsigned int* indices,
+								 size_t indexCount,
+								 unsigned int baseVertex = 0,
+								 const unsigned int* positionIds = nullptr,
+								 size_t positionCount = 0,
+								 ThreadPool* threadPool = nullptr);
+
+	/**
+	 * @brief Computes tangent frames into SimpleVertex::Tangent.
+	 * @note Needs the normals. Vertices without usable UVs get an arbitrary
+	 * tangent perpendicular to their normal.
+	 * @param vertices The vertices to update.
+	 * @param vertexCount The number of vertices.
+	 * @param indices The triangle list.
+	 * @param indexCount The number of indices.
+	 * @param baseVertex The index of vertices[0], as in computeNormals.
+	 * @param threadPool Optional, the pool that runs the vertex ranges.
+	 * @return bool false if an index is out of range.
+	 */
+	static bool
+	computeTangents(SimpleVertex* vertices,
+									size_t vertexCount,
+									const unsigned int* indices,
+									size_t indexCount,
+									unsigned int baseVertex = 0,
+									ThreadPool* threadPool = nullptr);
+};
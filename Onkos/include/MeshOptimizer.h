@@ -0,0 +1,245 @@
+#pragma once
+#include "Prerequisites.h"
+
+class MeshComponent;
+
+/**
+ * @brief Number of entries of the FIFO cache used by analyzeVertexCache.
+ * A conservative stand-in for the post-transform cache of current GPUs.
+ */
+static const unsigned int kVertexCacheSimSize = 16;
+
+/**
+ * @struct VertexCacheStats
+ * @brief Post-transform cache efficiency of an index buffer.
+ */
+struct
+VertexCacheStats {
+	/** @brief Number of vertex shader invocations (cache misses). */
+	unsigned int verticesTransformed = 0;
+
+	/** @brief Average cache miss ratio: transformed vertices per triangle (0.5 is ideal, 3 is worst). */
+	float acmr = 0.0f;
+
+	/** @brief Average transform to vertex ratio: transformed vertices per referenced vertex (1 is ideal). */
+	float atvr = 0.0f;
+};
+
+/**
+ * @brief Marks a vertex that no index refers to in a remap table.
+ */
+static const unsigned int kUnusedVertex = 0xFFFFFFFFu;
+
+/**
+ * @brief Size of the cache lines used by analyzeVertexFetch.
+ */
+static const unsigned int kVertexFetchLineSize = 64;
+
+/**
+ * @brief Number of cache lines used by analyzeVertexFetch (16 KB).
+ */
+static const unsigned int kVertexFetchLineCount = 256;
+
+/**
+ * @brief Default ACMR increase allowed by optimizeOverdraw (5%).
+ */
+static const float kOverdrawThreshold = 1.05f;
+
+/**
+ * @struct VertexFetchStats
+ * @brief Memory traffic of the vertex fetches of an index buffer.
+ */
+struct
+VertexFetchStats {
+	/** @brief Bytes read from the vertex buffer, counted in whole cache lines. */
+	unsigned int bytesFetched = 0;
+
+	/** @brief Fetched bytes per byte of referenced vertex data (1 is ideal). */
+	float overfetch = 0.0f;
+};
+
+/**
+ * @struct OverdrawStats
+ * @brief Pixel shading work of a triangle order, averaged over several views.
+ */
+struct
+OverdrawStats {
+	/** @brief Pixels covered by the mesh. */
+	unsigned int pixelsCovered = 0;
+
+	/** @brief Pixels that passed the depth test, i.e. were shaded. */
+	unsigned int pixelsShaded = 0;
+
+	/** @brief Shaded pixels per covered pixel (1 is ideal). */
+	float overdraw = 0.0f;
+};
+
+/**
+ * @class MeshOptimizer
+ * @brief CPU passes that reorder mesh data for faster GPU processing.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * The passes only change the order of the data, never the geometry, and work
+ * on plain index ranges so they can be applied to a whole MeshComponent, to
+ * one of its submeshes, or from an offline tool.
+ */
+class
+MeshOptimizer {
+public:
+	/**
+	 * @brief Reorders triangles for post-transform vertex cache locality.
+	 * @note Implements Tom Forsyth's "Linear-Speed Vertex Cache Optimisation":
+	 * triangles are emitted greedily by the score of their vertices, which
+	 * rewards vertices that are in a simulated LRU cache and vertices with
+	 * few remaining triangles. Runs in time linear in the number of triangles.
+	 * @param indices The triangle list to reorder in place.
+	 * @param indexCount The number of indices (a multiple of 3).
+	 * @param vertexCount The number of vertices the indices refer to.
+	 * @return bool false if an index is out of range (the indices are left untouched).
+	 */
+	static bool
+	optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+	/**
+	 * @brief Simulates a FIFO post-transform cache over a triangle list.
+	 * @param indices The triangle list to analyze.
+	 * @param indexCount The number of indices (a multiple of 3).
+	 * @param vertexCount The number of vertices the indices refer to.
+	 * @param cacheSize The number of entries of the simulated cache.
+	 * @return VertexCacheStats The number of transformed vertices, ACMR and ATVR.
+	 */
+	static VertexCacheStats
+	analyzeVertexCache(const unsigned int* indices,
+										 size_t indexCount,
+										 size_t vertexCount,
+										 unsigned int cacheSize = kVertexCacheSimSize);
+
+	/**
+	 * @brief Reorders clusters of triangles so outer surfaces tend to be drawn first.
+	 * @note Based on Sander et al., "Fast Triangle Reordering for Vertex Locality
+	 * and Reduced Overdraw". The triangle list (already optimized for the vertex
+	 * cache) is cut into clusters at the points where the cache starts cold, or
+	 * where a cluster drawn alone stays within threshold of the current ACMR.
+	 * Clusters are then sorted by how much they face away from the center of the
+	 * mesh, a view-independent estimate of which ones occlude the others.
+	 * @param indices The triangle list to reorder in place.
+	 * @param indexCount The number of indices (a multiple of 3).
+	 * @param positions The first vertex position (3 floats).
+	 * @param positionStride Bytes between two consecutive positions.
+	 * @param vertexCount The number of vertices the indices refer to.
+	 * @param threshold The ACMR increase allowed to get smaller clusters.
+	 * @return bool false if an index is out of range (the indices are left untouched).
+	 */
+	static bool
+	optimizeOverdraw(unsigned int* indices,
+									 size_t indexCount,
+									 const float* positions,
+									 size_t positionStride,
+									 size_t vertexCount,
+									 float threshold = kOverdrawThreshold);
+
+	/**
+	 * @brief Builds a table that renumbers vertices in the order the indices first use them.
+	 * @note Apply it with remapIndices and remapVertices, which also works for
+	 * any other per-vertex array that has to follow the mesh.
+	 * @param indices The triangle list.
+	 * @param indexCount The number of indices.
+	 * @param vertexCount The number of vertices the indices refer to.
+	 * @param outRemap Receives the new index of every vertex, or kUnusedVertex.
+	 * @return size_t The number of vertices left after the unused ones are dropped.
+	 */
+	static size_t
+	buildVertexFetchRemap(const unsigned int* indices,
+												size_t indexCount,
+												size_t vertexCount,
+												std::vector<unsigned int>& outRemap);
+
+	/**
+	 * @brief Rewrites indices through a remap table.
+	 * @param indices The indices to rewrite in place.
+	 * @param indexCount The number of indices.
+	 * @param remap A table built by buildVertexFetchRemap.
+	 */
+	static void
+	remapIndices(unsigned int* indices, size_t indexCount, const std::vector<unsigned int>& remap);
+
+	/**
+	 * @brief Reorders a per-vertex array through a remap table.
+	 * @param vertices The array to reorder; unused entries are dropped.
+	 * @param remap A table built by buildVertexFetchRemap.
+	 * @param newVertexCount The count returned by buildVertexFetchRemap.
+	 */
+	template<typename T>
+	static void
+	remapVertices(std::vector<T>& vertices, const std::vector<unsigned int>& remap, size_t newVertexCount) {
+		std::vector<T> remapped(newVertexCount);
+		for (size_t i = 0; i < vertices.size() && i < remap.size(); ++i) {
+			if (remap[i] != kUnusedVertex) {
+				remapped[remap[i]] = vertices[i];
+			}
+		}
+		vertices.swap(remapped);
+	}
+
+	/**
+	 * @brief Simulates the vertex fetches of a triangle list through a cache of lines.
+	 * @note Only vertices that miss the post-transform cache are fetched.
+	 * @param indices The triangle list to analyze.
+	 * @param indexCount The number of indices.
+	 * @param vertexCount The number of vertices the indices refer to.
+	 * @param vertexSize The size of one vertex in bytes.
+	 * @return VertexFetchStats The fetched bytes and the overfetch ratio.
+	 */
+	static VertexFetchStats
+	analyzeVertexFetch(const unsigned int* indices,
+										 size_t indexCount,
+										 size_t vertexCount,
+										 size_t vertexSize);
+
+	/**
+	 * @brief Rasterizes a triangle list from the six axis directions and counts overdraw.
+	 * @note Triangles are drawn in order with an early depth test and no culling,
+	 * so the result only depends on the submission order.
+	 * @param indices The triangle list to analyze.
+	 * @param indexCount The number of indices.
+	 * @param positions The first vertex position (3 floats).
+	 * @param positionStride Bytes between two consecutive positions.
+	 * @param vertexCount The number of vertices the indices refer to.
+	 * @return OverdrawStats The covered and shaded pixels of all views.
+	 */
+	static OverdrawStats
+	analyzeOverdraw(const unsigned int* indices,
+									size_t indexCount,
+									const float* positions,
+									size_t positionStride,
+									size_t vertexCount);
+
+	/**
+	 * @brief Runs every pass on a mesh: vertex cache, overdraw and vertex fetch order.
+	 * @note Materializes a memory-mapped mesh first. Triangles are reordered
+	 * inside each submesh, never across them. The vertex array is
+	 * renumbered, so anything indexing it must be built afterwards.
+	 * @param mesh The mesh to optimize.
+	 * @return bool false if the mesh has invalid indices.
+	 */
+	static bool
+	optimizeMesh(MeshComponent& mesh);
+
+	/**
+	 * @brief Splits a mesh into submeshes that can each be drawn with 16-bit indices.
+	 * @note A mesh with at most kMaxIndex16Vertices vertices keeps its submeshes
+	 * (or gets a single one) and is left as it is. In a larger one every submesh
+	 * is cut, in triangle order, into ranges that use at most
+	 * kMaxIndex16Vertices vertices each; every range gets its own copy of the
+	 * vertices it uses and indices relative to its baseVertex, and m_lods is
+	 * updated to the new submeshes. The submeshes of every level of detail are
+	 * cut on their own, so each level copies the vertices it uses as well.
+	 * Sets MeshComponent::m_indexFormat to DXGI_FORMAT_R16_UINT. Run it last, after optimizeMesh, whose fetch
+	 * order keeps the number of vertices shared between ranges (and thus
+	 * duplicated) low.
+	 * @param mesh The mesh to split. Its m_subMeshes are replaced.
+	 */
+	static void
+	splitIndex16(MeshComponent& mesh);
+};
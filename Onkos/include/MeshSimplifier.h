@@ -0,0 +1,94 @@
+#pragma once
+#include "Prerequisites.h"
+
+class MeshComponent;
+
+/**
+ * @brief Number of simplified levels added by default after the full mesh.
+ */
+static const unsigned int kLodDefaultLevelCount = 3;
+
+/**
+ * @brief Fraction of the triangles of the previous level kept by each level (50%, 25%, 12.5%...).
+ */
+static const float kLodTriangleRatio = 0.5f;
+
+/**
+ * @brief Default screen-space error, in pixels, tolerated by selectLod.
+ */
+static const float kLodMaxPixelError = 1.0f;
+
+/**
+ * @class MeshSimplifier
+ * @brief Reduces the triangle count of a mesh with quadric error metrics.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Edges are collapsed cheapest first, where the cost of moving a vertex is
+ * its distance to the planes of the triangles merged into it (Garland and
+ * Heckbert). Vertices are collapsed onto one of their neighbours instead of an
+ * optimal new position, so every level of detail reuses the vertex array of
+ * the full mesh and only adds indices.
+ *
+ * Vertices on open borders only slide along the border and vertices on UV
+ * seams only slide along the seam, moving both sides together; vertices where
+ * several borders or seams meet never move. Collapses that would flip a
+ * triangle are rejected.
+ */
+class
+MeshSimplifier {
+public:
+	/**
+	 * @brief Simplifies a triangle list.
+	 * @param vertices The vertex array the indices refer to.
+	 * @param vertexCount The number of vertices.
+	 * @param indices The triangle list to simplify.
+	 * @param indexCount The number of indices.
+	 * @param targetIndexCount The number of indices to reduce to. The result may
+	 * have more if no further collapse is allowed.
+	 * @param outIndices Receives the simplified triangle list (same vertices).
+	 * @param outError Optional, receives the largest distance a vertex moved
+	 * away from the original surface, in model units.
+	 * @return bool false if the indices are out of range.
+	 */
+	static bool
+	simplify(const SimpleVertex* vertices,
+					 size_t vertexCount,
+					 const unsigned int* indices,
+					 size_t indexCount,
+					 size_t targetIndexCount,
+					 std::vector<unsigned int>& outIndices,
+					 float* outError = nullptr);
+
+	/**
+	 * @brief Appends simplified levels of detail to a mesh.
+	 * @note Call after MeshOptimizer::optimizeMesh and before
+	 * MeshOptimizer::splitIndex16. Each submesh is simplified on its own, on a
+	 * compact copy of just the vertices it uses, and every level gets one
+	 * submesh per submesh of the full mesh, each reordered for the vertex
+	 * cache. The chain stops early when a level can't remove enough triangles.
+	 * @param mesh The mesh, memory-mapped data is copied first.
+	 * @param levelCount The number of levels to add after the full mesh.
+	 * @param triangleRatio The fraction of the triangles of the previous level kept by each level.
+	 * @return bool false if the mesh already has levels of detail or was already split.
+	 */
+	static bool
+	buildLodChain(MeshComponent& mesh,
+								unsigned int levelCount = kLodDefaultLevelCount,
+								float triangleRatio = kLodTriangleRatio);
+
+	/**
+	 * @brief Picks the coarsest level of detail whose error is invisible.
+	 * @param mesh The mesh with its levels of detail.
+	 * @param distance Distance from the camera to the closest point of the mesh, in model units.
+	 * @param pixelsPerUnit Size in pixels of one unit at distance 1, i.e.
+	 * viewportHeight / (2 * tan(verticalFov / 2)).
+	 * @param maxPixelError The largest projected error allowed, in pixels.
+	 * @return size_t The level to draw (see MeshComponent::getLod).
+	 */
+	static size_t
+	selectLod(const MeshComponent& mesh,
+						float distance,
+						float pixelsPerUnit,
+						float maxPixelError = kLodMaxPixelError);
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include "Prerequisites.h"
+#include "Meshlets.h"
+
+class MeshComponent;
+
+/**
+ * @class MeshletBuilder
+ * @brief Partitions the triangles of a mesh into small clusters (meshlets).
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Each meshlet has at most kMeshletMaxVertices vertices and
+ * kMeshletMaxTriangles triangles, a bounding sphere and a normal cone, so
+ * parts of a mesh can be culled or updated on their own. Triangles are taken
+ * in index order and a meshlet is closed when the next triangle doesn't fit;
+ * after MeshOptimizer the order is already local, which keeps meshlets
+ * compact and well filled. Meshlets never cross submeshes and only cover the
+ * full resolution level of detail.
+ */
+class
+MeshletBuilder {
+public:
+	/**
+	 * @brief Builds the meshlets of a mesh.
+	 * @param mesh The mesh to partition (owned or memory-mapped).
+	 * @param outMeshlets Receives the meshlets, replacing any previous content.
+	 */
+	static void
+	build(const MeshComponent& mesh, MeshletData& outMeshlets);
+
+	/**
+	 * @brief Tests if every triangle of a meshlet faces away from a camera.
+	 * @note Conservative: uses the bounding sphere instead of the cone apex,
+	 * so it may keep a backfacing meshlet but never culls a visible one.
+	 * @param meshlets The meshlets.
+	 * @param meshlet The meshlet to test.
+	 * @param cameraPosition The camera position in the space of the mesh.
+	 * @return bool true if the meshlet can be culled.
+	 */
+	static bool
+	isBackfacing(const MeshletData& meshlets, size_t meshlet, const XMFLOAT3& cameraPosition);
+};
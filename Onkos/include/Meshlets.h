@@ -0,0 +1,71 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @brief The largest number of unique vertices of a meshlet.
+ */
+static const unsigned int kMeshletMaxVertices = 64;
+
+/**
+ * @brief The largest number of triangles of a meshlet.
+ */
+static const unsigned int kMeshletMaxTriangles = 124;
+
+/**
+ * @struct MeshletData
+ * @brief The meshlets of a mesh in structure-of-arrays layout.
+ *
+ * Meshlet i uses the vertices vertexIndices[vertexOffset[i]] .. + vertexCount[i]
+ * (indices into the vertex array of the mesh, base vertex already applied) and
+ * the triangles triangleIndices[triangleOffset[i]] .. + triangleCount[i] * 3,
+ * whose 8-bit corners index that local vertex list.
+ *
+ * Each culling attribute lives in its own array so a culling loop streams
+ * only the data it tests.
+ */
+struct
+MeshletData {
+	/** @brief First entry of each meshlet in vertexIndices. */
+	std::vector<unsigned int> vertexOffset;
+
+	/** @brief Number of vertices of each meshlet. */
+	std::vector<unsigned char> vertexCount;
+
+	/** @brief First entry of each meshlet in triangleIndices. */
+	std::vector<unsigned int> triangleOffset;
+
+	/** @brief Number of triangles of each meshlet. */
+	std::vector<unsigned char> triangleCount;
+
+	/** @brief Bounding sphere center and radius of each meshlet. */
+	std::vector<float> centerX, centerY, centerZ, radius;
+
+	/** @brief Normal cone axis of each meshlet (unit length). */
+	std::vector<float> coneAxisX, coneAxisY, coneAxisZ;
+
+	/**
+	 * @brief Sine of the normal cone half-angle. 1 when the normals span a
+	 * hemisphere or more, which means the meshlet is never backfacing.
+	 */
+	std::vector<float> coneCutoff;
+
+	/** @brief The vertex lists of all meshlets, back to back. */
+	std::vector<unsigned int> vertexIndices;
+
+	/** @brief The local triangle corners of all meshlets, back to back. */
+	std::vector<unsigned char> triangleIndices;
+
+	/**
+	 * @brief Gets the number of meshlets.
+	 */
+	size_t
+	size() const { return vertexOffset.size(); }
+
+	/**
+	 * @brief Removes every meshlet.
+	 */
+	void
+	clear() {
+		*this = MeshletData();
+	}
+};
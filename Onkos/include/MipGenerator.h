@@ -0,0 +1,86 @@
+#pragma once
+#include "Prerequisites.h"
+#include "Image.h"
+
+class ThreadPool;
+
+/**
+ * @enum MipFilter
+ * @brief The filter that reduces one mip level into the next.
+ */
+enum
+MipFilter {
+	MIP_FILTER_BOX = 0,   ///< 2x2 average. Fast, slightly blurry.
+	MIP_FILTER_KAISER = 1 ///< Kaiser-windowed sinc over 12x12 texels. Sharper, no aliasing.
+};
+
+/**
+ * @struct MipSettings
+ * @brief How MipGenerator builds a mip chain.
+ */
+struct
+MipSettings {
+	/** @brief The reduction filter. */
+	MipFilter filter = MIP_FILTER_BOX;
+
+	/**
+	 * @brief Treats the color channels as sRGB and filters them in linear space.
+	 * @note Keeps the average brightness of color textures in the small
+	 * levels. Disable it for data textures (normal maps, masks). Alpha is
+	 * always linear.
+	 */
+	bool srgb = true;
+};
+
+/**
+ * @class MipGenerator
+ * @brief Builds the mip chain of an image on the CPU.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Each level is half the size of the previous one (rounded down, never below
+ * one pixel) and is computed from it. Texels outside the source level are
+ * clamped to its edge, which also covers odd sizes.
+ *
+ * The box filter of linear data averages 8-bit texels with SSE2 (scalar code
+ * on other targets, with identical results). The sRGB and Kaiser paths work
+ * on four-float texels. With a thread pool the rows of each level are split
+ * across the workers; the levels themselves are built one after another.
+ */
+class
+MipGenerator {
+public:
+	/**
+	 * @brief Gets the number of levels of a full mip chain.
+	 * @param width Width of the base level.
+	 * @param height Height of the base level.
+	 * @return unsigned int The number of levels down to 1x1, including the base.
+	 */
+	static unsigned int
+	getMipCount(unsigned int width, unsigned int height);
+
+	/**
+	 * @brief Appends every missing level to a mip chain.
+	 * @param mips The chain to complete. mips[0] must hold the base level;
+	 * any existing smaller levels are replaced.
+	 * @param settings The filter and the color space.
+	 * @param threadPool Optional, the pool that filters the rows of large levels.
+	 */
+	static void
+	generate(std::vector<Image>& mips,
+					 const MipSettings& settings = MipSettings(),
+					 ThreadPool* threadPool = nullptr);
+
+	/**
+	 * @brief Computes one level from the previous one.
+	 * @param source The larger level.
+	 * @param target Receives the reduced level; its size is set here.
+	 * @param settings The filter and the color space.
+	 * @param threadPool Optional, the pool that filters the rows.
+	 */
+	static void
+	reduce(const Image& source,
+				 Image& target,
+				 const MipSettings& settings = MipSettings(),
+				 ThreadPool* threadPool = nullptr);
+};
@@ -0,0 +1,188 @@
+#pragma once
+#include "Prerequisites.h"
+#include "MeshComponent.h"
+#include "ModelLoader.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+/**
+ * @enum ModelLoadStage
+ * @brief The step an asynchronous model load is in.
+ */
+enum
+ModelLoadStage {
+	MODEL_LOAD_QUEUED = 0,     ///< Waiting for the loading thread.
+	MODEL_LOAD_PARSING = 1,    ///< Mapping, hashing and parsing the file.
+	MODEL_LOAD_PROCESSING = 2, ///< Optimizing and simplifying; a preview mesh was published.
+	MODEL_LOAD_DONE = 3,       ///< The final mesh was published.
+	MODEL_LOAD_FAILED = 4,     ///< The file couldn't be loaded.
+	MODEL_LOAD_CANCELED = 5    ///< cancel() was called before the load finished.
+};
+
+/**
+ * @class ModelLoadRequest
+ * @brief The state of a model being loaded on a background thread.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Returned by ModelLoader::loadModelAsync. The loading thread publishes
+ * complete meshes as they become drawable: a preview as soon as the file is
+ * parsed and welded (before the optimization passes and the levels of detail,
+ * which take most of the time) and then the final mesh. A cache hit publishes
+ * the final mesh directly.
+ *
+ * The render loop polls takeMesh() between frames. It never waits for the
+ * loading thread: the mutex only guards the hand-over of a finished mesh.
+ */
+class
+ModelLoadRequest {
+public:
+	/**
+	 * @brief Constructor. Starts the clock of the time-to-first-mesh metric.
+	 */
+	ModelLoadRequest() : m_startTime(std::chrono::high_resolution_clock::now()) {}
+
+	/**
+	 * @brief Default destructor.
+	 */
+	~ModelLoadRequest() = default;
+
+	ModelLoadRequest(const ModelLoadRequest&) = delete;
+	ModelLoadRequest& operator=(const ModelLoadRequest&) = delete;
+
+	/**
+	 * @brief Moves the newest published mesh into outMesh, if there is one.
+	 * @note Meshes published between two calls are skipped, only the newest
+	 * one is returned. Without wait it never blocks on the loading thread,
+	 * and returns false if the thread holds the lock.
+	 * @param outMesh Receives the mesh. Left untouched if nothing new was published.
+	 * @param wait Waits for the lock instead. Once isFinished() is true the
+	 * final mesh is already published, so a waiting call can't miss it.
+	 * @return bool true if outMesh was replaced.
+	 */
+	bool
+	takeMesh(MeshComponent& outMesh, bool wait = false);
+
+	/**
+	 * @brief Asks the loading thread to stop at the next step.
+	 */
+	void
+	cancel() { m_canceled = true; }
+
+	/**
+	 * @brief Checks if cancel() was called.
+	 */
+	bool
+	isCanceled() const { return m_canceled; }
+
+	/**
+	 * @brief Gets the current step of the load.
+	 */
+	ModelLoadStage
+	getStage() const { return static_cast<ModelLoadStage>(m_stage.load()); }
+
+	/**
+	 * @brief Checks if the load ended, successfully or not.
+	 */
+	bool
+	isFinished() const { return getStage() >= MODEL_LOAD_DONE; }
+
+	/**
+	 * @brief Gets a rough fraction of the work done.
+	 * @return float From 0 when queued to 1 when done.
+	 */
+	float
+	getProgress() const { return m_progress; }
+
+	/**
+	 * @brief Gets the seconds from the request to the first drawable mesh.
+	 * @return double The time to first mesh, negative until one is published.
+	 */
+	double
+	getFirstMeshSeconds() const { return m_firstMeshSeconds; }
+
+	/**
+	 * @brief Gets the seconds from the request to the end of the load.
+	 * @return double The total time, negative until the load finishes.
+	 */
+	double
+	getTotalSeconds() const { return m_totalSeconds; }
+
+	/**
+	 * @brief Gets the statistics of the load.
+	 * @return ModelLoadStats The stats of the loader, valid once isFinished() is true.
+	 */
+	ModelLoadStats
+	getStats() const;
+
+	/**
+	 * @brief Moves the stage forward and raises the progress.
+	 * @note Called by the loading thread. The progress never goes back, so
+	 * chunks finishing out of order can report it concurrently.
+	 * @param stage The current stage.
+	 * @param progress The fraction of the work done.
+	 */
+	void
+	setProgress(ModelLoadStage stage, float progress);
+
+	/**
+	 * @brief Publishes a copy of a drawable mesh.
+	 * @note Called by the loading thread.
+	 * @param mesh The mesh to copy.
+	 */
+	void
+	publish(const MeshComponent& mesh);
+
+	/**
+	 * @brief Publishes the final mesh and ends the load.
+	 * @note Called by the loading thread.
+	 * @param mesh The mesh to move out, if the load succeeded.
+	 * @param stage MODEL_LOAD_DONE, MODEL_LOAD_FAILED or MODEL_LOAD_CANCELED.
+	 * @param stats The stats of the loader.
+	 */
+	void
+	finish(MeshComponent& mesh, ModelLoadStage stage, const ModelLoadStats& stats);
+
+private:
+	/**
+	 * @brief Hands a mesh over to takeMesh and records the time to first mesh.
+	 */
+	void
+	store(std::unique_ptr<MeshComponent> mesh);
+
+	/**
+	 * @brief Gets the seconds since the request was made.
+	 */
+	double
+	getElapsedSeconds() const;
+
+private:
+	/** @brief When the request was made. */
+	std::chrono::high_resolution_clock::time_point m_startTime;
+
+	/** @brief Guards m_published and m_stats. */
+	mutable std::mutex m_mutex;
+
+	/** @brief The newest mesh not taken yet, null if none. */
+	std::unique_ptr<MeshComponent> m_published;
+
+	/** @brief The stats of the loader, set when the load finishes. */
+	ModelLoadStats m_stats;
+
+	/** @brief The current ModelLoadStage. */
+	std::atomic<int> m_stage{ MODEL_LOAD_QUEUED };
+
+	/** @brief The fraction of the work done. */
+	std::atomic<float> m_progress{ 0.0f };
+
+	/** @brief Seconds to the first published mesh, negative before it. */
+	std::atomic<double> m_firstMeshSeconds{ -1.0 };
+
+	/** @brief Seconds to the end of the load, negative before it. */
+	std::atomic<double> m_totalSeconds{ -1.0 };
+
+	/** @brief Set by cancel(). */
+	std::atomic<bool> m_canceled{ false };
+};
@@ -1,6 +1,81 @@
 #pragma once
 #include "Prerequisites.h"
 #include "MeshComponent.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "ThreadPool.h"
+#include <memory>
+
+struct ObjChunk;
+class ModelLoadRequest;
+
+/**
+ * @brief A shared handle to an asynchronous model load (see ModelLoader::loadModelAsync).
+ */
+using ModelLoadHandle = std::shared_ptr<ModelLoadRequest>;
+
+/**
+ * @struct ModelLoadStats
+ * @brief Timing information about the last model loaded by a ModelLoader.
+ *
+ * Used to measure the throughput of the OBJ parser on large files.
+ */
+struct
+ModelLoadStats {
+	/** @brief The size in bytes of the parsed file. */
+	size_t fileBytes = 0;
+
+	/** @brief Seconds spent mapping and parsing the file. */
+	double parseSeconds = 0.0;
+
+	/** @brief Seconds spent scanning the text of every chunk (included in parseSeconds). */
+	double scanSeconds = 0.0;
+
+	/**
+	 * @brief Seconds spent merging the parsed chunks into welded, triangulated vertices and
+	 * indices (included in parseSeconds). With scanSeconds, the time of the parser alone.
+	 */
+	double mergeSeconds = 0.0;
+
+	/** @brief The number of threads used to parse the file. */
+	unsigned int threadCount = 0;
+
+	/** @brief The number of newline-aligned chunks the file was split into. */
+	unsigned int chunkCount = 0;
+
+	/** @brief Parsing throughput in megabytes per second. */
+	double megabytesPerSecond = 0.0;
+
+	/** @brief Seconds spent hashing the file to validate its mesh cache (included in parseSeconds). */
+	double hashSeconds = 0.0;
+
+	/** @brief True if the mesh was mapped from a valid .onkmesh cache instead of parsed. */
+	bool cacheHit = false;
+
+	/** @brief True if the file had no normals and they were generated. */
+	bool generatedNormals = false;
+
+	/** @brief Seconds spent generating normals and tangents (included in parseSeconds). */
+	double normalSeconds = 0.0;
+
+	/** @brief Seconds spent in the mesh optimization passes (included in parseSeconds). */
+	double optimizeSeconds = 0.0;
+
+	/** @brief Vertex cache efficiency of the indices in file order, zero without setOptimizeMesh. */
+	VertexCacheStats cacheBefore;
+
+	/** @brief Vertex cache efficiency after the optimization passes. */
+	VertexCacheStats cacheAfter;
+
+	/** @brief Vertex fetch traffic with the vertices in first-seen order, zero without setOptimizeMesh. */
+	VertexFetchStats fetchBefore;
+
+	/** @brief Vertex fetch traffic after the optimization passes. */
+	VertexFetchStats fetchAfter;
+
+	/** @brief Seconds spent building the levels of detail (included in optimizeSeconds). */
+	double simplifySeconds = 0.0;
+};
 
 /**
  * @class ModelLoader
@@ -11,6 +86,35 @@
  * This class provides functionality to parse a 3D model file (like a .obj file)
  * and load its geometry data (vertices, texture coordinates, normals, and faces)
  * into a MeshComponent object.
+ *
+ * The file is memory-mapped and tokenized in place with a hand-written number
+ * scanner, so no allocations are made per line or per face. Large files are
+ * split into newline-aligned chunks that are parsed on a thread pool and then
+ * merged in file order, so the result is identical for any thread count.
+ *
+ * Once merged, smooth normals are generated for files without vn records and
+ * tangent frames for every file (see MeshNormals). Then the triangles are
+ * reordered for the GPU's post-transform vertex cache and for less overdraw,
+ * and the vertices are renumbered in the order they are fetched (see
+ * MeshOptimizer). The cache and fetch efficiency before
+ * and after are reported in the load stats. Simplified levels of detail are
+ * then appended (see MeshSimplifier).
+ *
+ * Faces are grouped by the object (o/g) and material (usemtl) they were
+ * declared under: the index array is sorted by material, then object, and
+ * each group becomes a submesh tagged with its ids. The material properties
+ * come from the MTL libraries (mtllib) next to the model (see MaterialLibrary)
+ * and are read again on every load, cached or not, so editing a library
+ * doesn't require rebuilding the cache.
+ *
+ * After a successful parse the mesh is written to a .onkmesh cache next to the
+ * source file (see MeshCache). Later loads of the same, unchanged file with the
+ * same optimization and level of detail settings map the cache instead of
+ * parsing the text again.
+ *
+ * loadModelAsync runs the same load on a background thread and returns at
+ * once; see ModelLoadRequest for the progress, the preview mesh and the
+ * time-to-first-mesh metric.
  */
 class ModelLoader {
 public:
@@ -36,22 +140,129 @@ public:
 		loadModel(const std::string& fileName, MeshComponent& outMesh);
 
 	/**
-	 * @brief A utility function to parse a 2-component vector (XMFLOAT2) from a string stream.
-	 * @note This is likely a helper function for loadModel, used for parsing
-	 * texture coordinates (vt) from a .obj file.
-	 * @param streamLine The string stream containing the line of text to parse.
+	 * @brief Starts loading a model on a background thread.
+	 * @note Uses the settings of this loader at the time of the call. Loads
+	 * run one after another in request order. The destructor waits for the
+	 * pending loads, cancel them first to exit early.
+	 * @param fileName The path to the model file (e.g., "myModel.obj").
+	 * @return ModelLoadHandle The request, to poll for progress and meshes.
+	 */
+	ModelLoadHandle
+		loadModelAsync(const std::string& fileName);
+
+	/**
+	 * @brief Parses a 2-component vector (XMFLOAT2) from raw text.
+	 * @note Used for parsing texture coordinates (vt) from a .obj file.
+	 * @param cursor The first character after the line prefix.
+	 * @param end One past the last character of the line.
 	 * @param outVector The vector where the parsed XMFLOAT2 will be stored.
+	 * @return const char* The position right after the last parsed number.
 	 */
-	void
-		parseVec2(std::stringstream& streamLine, std::vector<XMFLOAT2>& outVector);
+	const char*
+		parseVec2(const char* cursor, const char* end, std::vector<XMFLOAT2>& outVector);
 
 	/**
-	 * @brief A utility function to parse a 3-component vector (XMFLOAT3) from a string stream.
-	 * @note This is likely a helper function for loadModel, used for parsing
-	 * vertex positions (v) or normals (vn) from a .obj file.
-	 * @param streamLine The string stream containing the line of text to parse.
+	 * @brief Parses a 3-component vector (XMFLOAT3) from raw text.
+	 * @note Used for parsing vertex positions (v) or normals (vn) from a .obj file.
+	 * @param cursor The first character after the line prefix.
+	 * @param end One past the last character of the line.
 	 * @param outVector The vector where the parsed XMFLOAT3 will be stored.
+	 * @return const char* The position right after the last parsed number.
+	 */
+	const char*
+		parseVec3(const char* cursor, const char* end, std::vector<XMFLOAT3>& outVector);
+
+	/**
+	 * @brief Gets the timing information of the last call to loadModel.
+	 * @return const ModelLoadStats& The size, time and throughput of the last parse.
+	 */
+	const ModelLoadStats&
+		getLastLoadStats() const { return m_lastLoadStats; }
+
+	/**
+	 * @brief Sets the number of threads used to parse a model.
+	 * @param threadCount The number of threads. 0 uses one per hardware thread,
+	 * 1 parses the whole file on the calling thread.
+	 */
+	void
+		setThreadCount(unsigned int threadCount) { m_threadCount = threadCount; }
+
+	/**
+	 * @brief Gets the configured number of parsing threads.
+	 * @return unsigned int The configured count (0 means one per hardware thread).
+	 */
+	unsigned int
+		getThreadCount() const { return m_threadCount; }
+
+	/**
+	 * @brief Enables or disables the .onkmesh cache.
+	 * @param useMeshCache true to read and write .onkmesh files next to the models.
+	 */
+	void
+		setUseMeshCache(bool useMeshCache) { m_useMeshCache = useMeshCache; }
+
+	/**
+	 * @brief Enables or disables the mesh optimization passes.
+	 * @param optimizeMesh true to reorder the parsed mesh for the GPU caches.
+	 */
+	void
+		setOptimizeMesh(bool optimizeMesh) { m_optimizeMesh = optimizeMesh; }
+
+	/**
+	 * @brief Sets the number of simplified levels of detail built for each parsed mesh.
+	 * @param lodLevelCount The number of levels after the full mesh, 0 builds none.
 	 */
 	void
-		parseVec3(std::stringstream& streamLine, std::vector<XMFLOAT3>& outVector);
-};
\ No newline at end of file
+		setLodLevelCount(unsigned int lodLevelCount) { m_lodLevelCount = lodLevelCount; }
+
+private:
+	/**
+	 * @brief Parses the v/vt/vn/f records of a range of whole lines.
+	 * @param begin The first character of the range.
+	 * @param end One past the last character of the range.
+	 * @param outChunk The chunk that receives the parsed attributes and face corners.
+	 */
+	void
+		parseChunk(const char* begin, const char* end, ObjChunk& outChunk);
+
+	/**
+	 * @brief Loads a model, reporting to an asynchronous request if there is one.
+	 * @param fileName The path to the model file.
+	 * @param outMesh The mesh to populate.
+	 * @param request Optional, receives the progress and the preview mesh and
+	 * is checked for cancellation between steps.
+	 * @return bool true if the model was loaded.
+	 */
+	bool
+		loadModelInternal(const std::string& fileName, MeshComponent& outMesh, ModelLoadRequest* request);
+
+	/**
+	 * @brief Fills the materials of a mesh from its MTL libraries.
+	 * @param fileName The path of the model, the libraries are relative to it.
+	 * @param outMesh The mesh whose m_materials are filled by name.
+	 */
+	void
+		loadMaterials(const std::string& fileName, MeshComponent& outMesh);
+
+private:
+	/** @brief The configured number of parsing threads (0 = hardware concurrency). */
+	unsigned int m_threadCount = 0;
+
+	/** @brief Whether the .onkmesh cache is read and written. */
+	bool m_useMeshCache = true;
+
+	/** @brief Whether the parsed mesh goes through the MeshOptimizer passes. */
+	bool m_optimizeMesh = true;
+
+	/** @brief The number of simplified levels of detail built after the full mesh. */
+	unsigned int m_lodLevelCount = kLodDefaultLevelCount;
+
+	/** @brief Workers used to parse the chunks of a file. */
+	ThreadPool m_threadPool;
+
+	/** @brief The thread that runs the loads started by loadModelAsync. */
+	ThreadPool m_asyncPool;
+
+	/** @brief Timing information of the last loaded model. */
+	ModelLoadStats m_lastLoadStats;
+};
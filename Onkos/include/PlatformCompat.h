@@ -0,0 +1,136 @@
+#pragma once
+
+/**
+ * @file PlatformCompat.h
+ * @brief Stand-ins for the Win32 and XNA Math types used by the CPU-side code.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Prerequisites.h includes this file instead of the Windows and DirectX
+ * headers when the engine sources are compiled on another platform. It only
+ * covers what the GPU-independent parts of the engine (model loading, mesh
+ * processing, image processing) need, so that the offline tools such as
+ * OnkosCooker can be built and run on Linux.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cwchar>
+
+typedef long HRESULT;
+
+#define S_OK           ((HRESULT)0L)
+#define S_FALSE        ((HRESULT)1L)
+#define E_FAIL         ((HRESULT)0x80004005L)
+#define E_POINTER      ((HRESULT)0x80004003L)
+#define E_INVALIDARG   ((HRESULT)0x80070057L)
+#define E_OUTOFMEMORY  ((HRESULT)0x8007000EL)
+#define FAILED(hr)     (((HRESULT)(hr)) < 0)
+#define SUCCEEDED(hr)  (((HRESULT)(hr)) >= 0)
+
+/**
+ * @brief Sends debug output to stderr, there is no debugger channel outside Windows.
+ */
+inline void
+OutputDebugStringW(const wchar_t* message) {
+  fputws(message, stderr);
+}
+
+/**
+ * @struct XMFLOAT2
+ * @brief Storage-compatible replacement of the XNA Math 2D vector.
+ */
+struct
+XMFLOAT2 {
+  float x;
+  float y;
+
+  XMFLOAT2() = default;
+  XMFLOAT2(float _x, float _y) : x(_x), y(_y) {}
+};
+
+/**
+ * @struct XMFLOAT3
+ * @brief Storage-compatible replacement of the XNA Math 3D vector.
+ */
+struct
+XMFLOAT3 {
+  float x;
+  float y;
+  float z;
+
+  XMFLOAT3() = default;
+  XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+};
+
+/**
+ * @struct XMFLOAT4
+ * @brief Storage-compatible replacement of the XNA Math 4D vector.
+ */
+struct
+XMFLOAT4 {
+  float x;
+  float y;
+  float z;
+  float w;
+
+  XMFLOAT4() = default;
+  XMFLOAT4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+};
+
+/**
+ * @struct XMMATRIX
+ * @brief Storage-only replacement of the XNA Math matrix, used by the constant buffer structs.
+ */
+struct
+XMMATRIX {
+  float m[4][4];
+};
+
+/**
+ * @enum DXGI_FORMAT
+ * @brief The subset of DXGI formats produced by the CPU mesh and texture pipelines
+ * or read from DDS and KTX2 files.
+ *
+ * Values match dxgiformat.h so cooked files are identical on every platform.
+ */
+enum
+DXGI_FORMAT {
+  DXGI_FORMAT_UNKNOWN = 0,
+  DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+  DXGI_FORMAT_R32G32B32_FLOAT = 6,
+  DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+  DXGI_FORMAT_R16G16B16A16_UNORM = 11,
+  DXGI_FORMAT_R32G32_FLOAT = 16,
+  DXGI_FORMAT_R10G10B10A2_UNORM = 24,
+  DXGI_FORMAT_R11G11B10_FLOAT = 26,
+  DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+  DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+  DXGI_FORMAT_R8G8B8A8_SNORM = 31,
+  DXGI_FORMAT_R16G16_FLOAT = 34,
+  DXGI_FORMAT_R16G16_SNORM = 37,
+  DXGI_FORMAT_R32_FLOAT = 41,
+  DXGI_FORMAT_R32_UINT = 42,
+  DXGI_FORMAT_R8G8_UNORM = 49,
+  DXGI_FORMAT_R16_FLOAT = 54,
+  DXGI_FORMAT_R16_UINT = 57,
+  DXGI_FORMAT_R8_UNORM = 61,
+  DXGI_FORMAT_BC1_UNORM = 71,
+  DXGI_FORMAT_BC1_UNORM_SRGB = 72,
+  DXGI_FORMAT_BC2_UNORM = 74,
+  DXGI_FORMAT_BC2_UNORM_SRGB = 75,
+  DXGI_FORMAT_BC3_UNORM = 77,
+  DXGI_FORMAT_BC3_UNORM_SRGB = 78,
+  DXGI_FORMAT_BC4_UNORM = 80,
+  DXGI_FORMAT_BC4_SNORM = 81,
+  DXGI_FORMAT_BC5_UNORM = 83,
+  DXGI_FORMAT_BC5_SNORM = 84,
+  DXGI_FORMAT_B5G6R5_UNORM = 85,
+  DXGI_FORMAT_B8G8R8A8_UNORM = 87,
+  DXGI_FORMAT_B8G8R8X8_UNORM = 88,
+  DXGI_FORMAT_B8G8R8A8_UNORM_SRGB = 91,
+  DXGI_FORMAT_BC6H_UF16 = 95,
+  DXGI_FORMAT_BC6H_SF16 = 96,
+  DXGI_FORMAT_BC7_UNORM = 98,
+  DXGI_FORMAT_BC7_UNORM_SRGB = 99
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @class PolygonTriangulator
+ * @brief Splits planar polygons of any size into triangles.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * The polygon is projected onto the axis plane where its normal (Newell's
+ * method) is largest. Convex polygons are split as a fan from the first
+ * corner, the same result quads always had; concave ones are ear-clipped.
+ * Triangles keep the winding of the polygon.
+ *
+ * The working arrays are kept between calls, so triangulating the faces of a
+ * file allocates only when a face is larger than every previous one.
+ */
+class
+PolygonTriangulator {
+public:
+	/**
+	 * @brief Default constructor.
+	 */
+	PolygonTriangulator() = default;
+
+	/**
+	 * @brief Default destructor.
+	 */
+	~PolygonTriangulator() = default;
+
+	/**
+	 * @brief Triangulates a polygon.
+	 * @note Self-intersecting or degenerate polygons still produce
+	 * cornerCount - 2 triangles, just not necessarily a good split.
+	 * @param points The positions of the corners, in order.
+	 * @param cornerCount The number of corners.
+	 * @param outTriangles Receives (cornerCount - 2) * 3 corner numbers (0 to cornerCount - 1).
+	 * @return size_t The number of triangles written, 0 for less than 3 corners.
+	 */
+	size_t
+	triangulate(const XMFLOAT3* points, size_t cornerCount, unsigned int* outTriangles);
+
+private:
+	/** @brief The corners projected onto the plane of the polygon. */
+	std::vector<XMFLOAT2> m_projected;
+
+	/** @brief The corners not clipped yet, in polygon order. */
+	std::vector<unsigned int> m_remaining;
+};
@@ -16,17 +16,24 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#if defined(_WIN32)
 #include <windows.h>
 #include <xnamath.h>
+#endif
 #include <thread>
 #include <map>
 
 // Librerias DirectX
+#if defined(_WIN32)
 #include <d3d11.h>
 #include <d3dx11.h>
 #include <d3dcompiler.h>
 #include "Resource.h"
 #include "resource.h"
+#else
+// Offline tools (e.g. OnkosCooker) build the CPU-side code without Windows
+#include "PlatformCompat.h"
+#endif
 
 // Third Party Libraries
 
@@ -80,12 +87,35 @@
  * @brief Defines the vertex structure for simple geometry.
  *
  * Contains position and texture coordinates, which is a common layout
- * for textured models.
+ * for textured models, plus the normal and the tangent frame used for
+ * lighting and normal mapping. Tangent.w is the handedness of the bitangent:
+ * bitangent = cross(Norm, Tangent.xyz) * Tangent.w.
  */
 struct 
 SimpleVertex {
   XMFLOAT3 Pos;
   XMFLOAT2 Tex;
+  XMFLOAT3 Norm;
+  XMFLOAT4 Tangent;
+};
+
+/**
+ * @struct QuantizedVertex
+ * @brief Compressed version of SimpleVertex (20 bytes instead of 48).
+ *
+ * Pos holds 16-bit normalized coordinates relative to the bounding box of the
+ * mesh (the 4th component is always 1.0), Tex holds half-float texture
+ * coordinates. Norm is the octahedral encoding of the normal in two 16-bit
+ * signed normalized values; Tangent holds the octahedral tangent in its first
+ * two 8-bit signed normalized values and the handedness in the third. See
+ * VertexQuantizer.
+ */
+struct
+QuantizedVertex {
+  unsigned short Pos[4];
+  unsigned short Tex[2];
+  short Norm[2];
+  signed char Tangent[4];
 };
 
 /**
@@ -134,7 +164,9 @@ enum
 ExtensionType {
   DDS = 0, ///< DirectDraw Surface (DDS) image format.
   PNG = 1, ///< Portable Network Graphics (PNG) image format.
-  JPG = 2  ///< JPEG (JPG) image format.
+  JPG = 2, ///< JPEG (JPG) image format.
+  ONKTEX = 3, ///< Texture cooked offline by OnkosCooker (.onktex), with its full mip chain.
+  KTX2 = 4 ///< Khronos texture container (.ktx2), read without supercompression.
 };
 
 /**
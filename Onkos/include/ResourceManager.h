@@ -0,0 +1,274 @@
+#pragma once
+#include "Prerequisites.h"
+#include "Buffer.h"
+#include "MeshComponent.h"
+#include "ModelLoader.h"
+#include "Texture.h"
+#include "TextureLoader.h"
+#include <memory>
+#include <unordered_map>
+
+class Device;
+
+/**
+ * @struct SharedTexture
+ * @brief A texture owned by a ResourceManager, released with its last handle.
+ */
+struct
+SharedTexture {
+	SharedTexture() = default;
+	~SharedTexture() { texture.destroy(); }
+	SharedTexture(const SharedTexture&) = delete;
+	SharedTexture& operator=(const SharedTexture&) = delete;
+
+	/** @brief The GPU texture. */
+	Texture texture;
+
+	/** @brief Hash of the levels uploaded to the GPU. */
+	uint64_t dataHash = 0;
+
+	/** @brief Bytes of the levels uploaded to the GPU. */
+	uint64_t bytes = 0;
+};
+
+/**
+ * @struct SharedMesh
+ * @brief The vertex and index buffers of a mesh owned by a ResourceManager,
+ * released with its last handle.
+ */
+struct
+SharedMesh {
+	SharedMesh() = default;
+	~SharedMesh() {
+		vertexBuffer.destroy();
+		indexBuffer.destroy();
+	}
+	SharedMesh(const SharedMesh&) = delete;
+	SharedMesh& operator=(const SharedMesh&) = delete;
+
+	/** @brief The CPU mesh (submeshes, materials, LODs). Empty for meshes acquired from memory. */
+	MeshComponent mesh;
+
+	/** @brief The GPU vertex buffer. */
+	Buffer vertexBuffer;
+
+	/** @brief The GPU index buffer. */
+	Buffer indexBuffer;
+
+	/** @brief Hash of the vertices and indices. */
+	uint64_t dataHash = 0;
+
+	/** @brief Bytes of the vertex and index buffers. */
+	uint64_t bytes = 0;
+};
+
+/**
+ * @brief A reference to a shared texture. The texture lives while any handle does.
+ */
+using TextureHandle = std::shared_ptr<SharedTexture>;
+
+/**
+ * @brief A reference to shared mesh buffers. The buffers live while any handle does.
+ */
+using MeshHandle = std::shared_ptr<SharedMesh>;
+
+/**
+ * @struct ResourceCacheStats
+ * @brief How often a ResourceManager reused a resource instead of creating one.
+ */
+struct
+ResourceCacheStats {
+	/** @brief Requests for a path already loaded; nothing was read. */
+	size_t pathHits = 0;
+
+	/** @brief Requests for a file whose bytes match a loaded file; nothing was decoded. */
+	size_t fileHits = 0;
+
+	/** @brief Requests whose decoded data match a loaded resource; nothing was created. */
+	size_t dataHits = 0;
+
+	/** @brief Requests that created a resource. */
+	size_t misses = 0;
+
+	/** @brief Requests whose file couldn't be read or whose resource couldn't be created. */
+	size_t failures = 0;
+
+	/** @brief GPU bytes that the hits didn't allocate. */
+	uint64_t bytesSaved = 0;
+
+	/** @brief Resources alive (held by at least one handle). */
+	size_t liveCount = 0;
+
+	/** @brief GPU bytes of the live resources. */
+	uint64_t liveBytes = 0;
+
+	/**
+	 * @brief Gets the fraction of the requests served by an existing resource.
+	 * @return double The hit rate in [0, 1], 0 without requests.
+	 */
+	double
+	getHitRate() const {
+		const size_t hits = pathHits + fileHits + dataHits;
+		const size_t requests = hits + misses + failures;
+		return requests > 0 ? static_cast<double>(hits) / requests : 0.0;
+	}
+};
+
+/**
+ * @class ResourceManager
+ * @brief Interns textures and mesh buffers by path and by content, and hands
+ * out reference-counted handles.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * A request is looked up three times before anything is created:
+ * - by path, which skips reading the file;
+ * - by the ContentHash of the file bytes, which catches copies of a file and
+ *   skips decoding or parsing it;
+ * - by the hash of the decoded data (every texture level, or the vertices
+ *   and indices), which catches the same pixels or geometry saved in
+ *   different files or built in memory.
+ *
+ * The manager only keeps weak references, so a resource is released as soon
+ * as its last handle is dropped, and the next request recreates it. Handles
+ * must be released before the Device. Every call must come from the thread
+ * that owns the device context.
+ */
+class
+ResourceManager {
+public:
+	/**
+	 * @brief Default constructor.
+	 */
+	ResourceManager() = default;
+
+	/**
+	 * @brief Default destructor.
+	 */
+	~ResourceManager() = default;
+
+	/**
+	 * @brief Sets the device that creates the resources.
+	 * @param device The graphics device, must outlive every handle.
+	 */
+	void
+	init(Device& device) { m_device = &device; }
+
+	/**
+	 * @brief Forgets every resource and resets the stats. Live handles keep their resources.
+	 */
+	void
+	destroy();
+
+	/**
+	 * @brief Gets the texture of a file, loading it if no identical one is loaded.
+	 * @param fileName A PNG, JPG, .onktex, .dds or .ktx2 file, staged with
+	 * TextureLoader::stage (mip chain included).
+	 * @return TextureHandle The shared texture, null if the file couldn't be loaded.
+	 */
+	TextureHandle
+	acquireTexture(const std::string& fileName);
+
+	/**
+	 * @brief Gets a texture for levels already in memory, created only if no identical one is loaded.
+	 * @param staged The levels.
+	 * @return TextureHandle The shared texture, null if it couldn't be created.
+	 */
+	TextureHandle
+	acquireTexture(const StagedTexture& staged);
+
+	/**
+	 * @brief Gets the buffers of a model file, loading it if no identical one is loaded.
+	 * @param fileName A file ModelLoader::loadModel reads.
+	 * @return MeshHandle The shared buffers with the CPU mesh, null if the file couldn't be loaded.
+	 */
+	MeshHandle
+	acquireMesh(const std::string& fileName);
+
+	/**
+	 * @brief Gets buffers for a mesh already in memory, created only if no identical ones exist.
+	 * @param mesh The mesh, not copied into the handle.
+	 * @return MeshHandle The shared buffers, null if they couldn't be created.
+	 */
+	MeshHandle
+	acquireMesh(const MeshComponent& mesh);
+
+	/**
+	 * @brief Removes the entries of released resources from the lookup tables.
+	 */
+	void
+	collect();
+
+	/**
+	 * @brief Gets the texture stats, with the live textures counted now.
+	 * @return ResourceCacheStats The stats since init.
+	 */
+	ResourceCacheStats
+	getTextureStats() const;
+
+	/**
+	 * @brief Gets the mesh stats, with the live meshes counted now.
+	 * @return ResourceCacheStats The stats since init.
+	 */
+	ResourceCacheStats
+	getMeshStats() const;
+
+	/**
+	 * @brief Hashes the format, layout and data of every level of a texture.
+	 * @param texture The levels.
+	 * @return uint64_t The hash.
+	 */
+	static uint64_t
+	hashTexture(const CookedTexture& texture);
+
+	/**
+	 * @brief Hashes the vertices and indices of a mesh, as the buffers would store them.
+	 * @param mesh The mesh.
+	 * @return uint64_t The hash.
+	 */
+	static uint64_t
+	hashMesh(const MeshComponent& mesh);
+
+private:
+	/**
+	 * @brief Creates a texture or returns an identical one, counting a data hit or a miss.
+	 */
+	TextureHandle
+	internTexture(const StagedTexture& staged);
+
+	/**
+	 * @brief Creates mesh buffers or returns identical ones, counting a data hit or a miss.
+	 */
+	MeshHandle
+	internMesh(const MeshComponent& mesh);
+
+	/** @brief Creates the resources. */
+	Device* m_device = nullptr;
+
+	/** @brief Parses the model files. */
+	ModelLoader m_modelLoader;
+
+	/** @brief Textures by normalized path. */
+	std::unordered_map<std::string, std::weak_ptr<SharedTexture>> m_texturesByPath;
+
+	/** @brief Textures by hash of their file. */
+	std::unordered_map<uint64_t, std::weak_ptr<SharedTexture>> m_texturesByFile;
+
+	/** @brief Textures by hash of their levels. */
+	std::unordered_map<uint64_t, std::weak_ptr<SharedTexture>> m_texturesByData;
+
+	/** @brief Meshes by normalized path. */
+	std::unordered_map<std::string, std::weak_ptr<SharedMesh>> m_meshesByPath;
+
+	/** @brief Meshes by hash of their file. */
+	std::unordered_map<uint64_t, std::weak_ptr<SharedMesh>> m_meshesByFile;
+
+	/** @brief Meshes by hash of their vertices and indices. */
+	std::unordered_map<uint64_t, std::weak_ptr<SharedMesh>> m_meshesByData;
+
+	/** @brief Texture requests since init. */
+	ResourceCacheStats m_textureStats;
+
+	/** @brief Mesh requests since init. */
+	ResourceCacheStats m_meshStats;
+};
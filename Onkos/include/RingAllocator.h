@@ -0,0 +1,148 @@
+#pragma once
+#include "Prerequisites.h"
+#include <deque>
+
+/**
+ * @struct RingAllocatorStats
+ * @brief How full a RingAllocator got and how often it ran out of space.
+ */
+struct
+RingAllocatorStats {
+	/** @brief Bytes of the ring. */
+	uint64_t capacity = 0;
+
+	/** @brief Bytes in use: allocated and not yet retired, including the space skipped at wraps. */
+	uint64_t usedBytes = 0;
+
+	/** @brief Most bytes ever in use at once. */
+	uint64_t peakBytes = 0;
+
+	/** @brief Successful allocations. */
+	uint64_t allocationCount = 0;
+
+	/** @brief Times the head went back to the start of the ring. */
+	uint64_t wrapCount = 0;
+
+	/** @brief Allocations that didn't fit in the free space. */
+	uint64_t failedCount = 0;
+};
+
+/**
+ * @class RingAllocator
+ * @brief Hands out aligned ranges of a fixed-size ring and recycles them by
+ * fence, a frame at a time.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Ranges are taken from the head of the ring in order. endFrame tags every
+ * range allocated since the previous call with a fence value; once the GPU
+ * reports that fence (retire), the ranges of that frame and the older ones
+ * are free again. A range never straddles the end of the ring: the space left
+ * at the end is skipped and belongs to the frame that wrapped.
+ *
+ * The allocator only does the bookkeeping of offsets and fences, with no
+ * device behind it, so its logic runs (and can be checked) on any platform.
+ * ConstantBufferRing puts a GPU buffer and GPU fences behind it.
+ */
+class
+RingAllocator {
+public:
+	/**
+	 * @brief Default constructor.
+	 */
+	RingAllocator() = default;
+
+	/**
+	 * @brief Default destructor.
+	 */
+	~RingAllocator() = default;
+
+	/**
+	 * @brief Empties the ring and sets its size.
+	 * @param capacity Bytes of the ring, rounded down to the alignment.
+	 * @param alignment Alignment of every range in bytes, a power of two.
+	 * @return bool false if the alignment isn't a power of two or the capacity is smaller than it.
+	 */
+	bool
+	init(uint64_t capacity, unsigned int alignment);
+
+	/**
+	 * @brief Takes a range from the head of the ring.
+	 * @param size Bytes of the range, rounded up to the alignment.
+	 * @param outOffset Receives the offset of the range in the ring.
+	 * @return bool false if the free space can't hold the range; retire frames and try again.
+	 */
+	bool
+	allocate(unsigned int size, uint64_t& outOffset);
+
+	/**
+	 * @brief Tags the ranges allocated since the last call with a fence value.
+	 * @param fence The value the GPU reaches once it is done with the frame;
+	 * must grow from one frame to the next.
+	 */
+	void
+	endFrame(uint64_t fence);
+
+	/**
+	 * @brief Frees the ranges of every frame whose fence is at most completedFence.
+	 * @param completedFence The last fence value the GPU reached.
+	 */
+	void
+	retire(uint64_t completedFence);
+
+	/**
+	 * @brief Checks if any ended frame still holds ranges.
+	 * @return bool true if a frame waits for its fence.
+	 */
+	bool
+	hasPendingFrames() const { return !m_frames.empty(); }
+
+	/**
+	 * @brief Gets the fence of the oldest frame that still holds ranges.
+	 * @return uint64_t The fence to wait for to free space, 0 without pending frames.
+	 */
+	uint64_t
+	getOldestFence() const { return m_frames.empty() ? 0 : m_frames.front().fence; }
+
+	/**
+	 * @brief Gets the alignment of the ranges.
+	 * @return unsigned int The alignment in bytes.
+	 */
+	unsigned int
+	getAlignment() const { return m_alignment; }
+
+	/**
+	 * @brief Gets the usage of the ring.
+	 * @return RingAllocatorStats The stats since init.
+	 */
+	const RingAllocatorStats&
+	getStats() const { return m_stats; }
+
+private:
+	/**
+	 * @brief The bytes a frame took from the tail of the ring, and its fence.
+	 */
+	struct
+	Frame {
+		uint64_t fence;
+		uint64_t bytes;
+	};
+
+	/** @brief Alignment of every range. */
+	unsigned int m_alignment = 0;
+
+	/** @brief Offset of the next range. */
+	uint64_t m_head = 0;
+
+	/** @brief Offset of the oldest range still in use. */
+	uint64_t m_tail = 0;
+
+	/** @brief Bytes taken since the last endFrame. */
+	uint64_t m_frameBytes = 0;
+
+	/** @brief The ended frames that wait for their fence, oldest first. */
+	std::deque<Frame> m_frames;
+
+	/** @brief Usage of the ring. */
+	RingAllocatorStats m_stats;
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include "Prerequisites.h"
+#include "Texture.h"
+#include "TextureStreamer.h"
+
+class Device;
+
+/**
+ * @class StreamedTextures
+ * @brief The D3D11 textures of a TextureStreamer, one per streamed id.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Every change of residency creates a new Texture with the resident levels
+ * and only then releases the old one, so a failed upload keeps the texture
+ * that was bound.
+ */
+class
+StreamedTextures : public TextureStreamingDevice {
+public:
+	/**
+	 * @brief Default constructor.
+	 */
+	StreamedTextures() = default;
+
+	/**
+	 * @brief Default destructor.
+	 */
+	~StreamedTextures() = default;
+
+	/**
+	 * @brief Sets the device that creates the textures.
+	 * @param device The graphics device, must outlive this object.
+	 */
+	void
+	init(Device& device) { m_device = &device; }
+
+	/**
+	 * @brief Releases every texture.
+	 */
+	void
+	destroy();
+
+	/**
+	 * @brief Creates the texture of an id from the levels [firstMip, last].
+	 */
+	bool
+	createTexture(StreamedTextureId id, const StagedTexture& texture, unsigned int firstMip) override;
+
+	/**
+	 * @brief Releases the texture of an id.
+	 */
+	void
+	releaseTexture(StreamedTextureId id) override;
+
+	/**
+	 * @brief Gets the texture of an id.
+	 * @param id The texture.
+	 * @return Texture* The texture, null if the id has none.
+	 */
+	Texture*
+	getTexture(StreamedTextureId id);
+
+private:
+	/** @brief Creates the textures. */
+	Device* m_device = nullptr;
+
+	/** @brief The textures, indexed by id. */
+	std::vector<Texture> m_textures;
+};
@@ -4,6 +4,7 @@
 // Forward declarations
 class Device;
 class DeviceContext;
+struct StagedTexture;
 
 /**
  * @class Texture
@@ -32,11 +33,25 @@ public:
 	 * @param device The graphics device used to create the texture resource.
 	 * @param textureName The file path of the image to load.
 	 * @param extensionType The file extension type (e.g., PNG, JPG) to guide the loading process.
+	 * DDS and KTX2 files are mapped and uploaded as stored, with their mips, arrays and cube faces.
 	 * @return HRESULT Returns S_OK if successful, otherwise an error code.
 	 */
 	HRESULT
 	init(	Device& deivce, const std::string& textureName, ExtensionType extensionType	);
 
+	/**
+	 * @brief Initializes a texture from levels already read into memory.
+	 * @note Used with TextureLoader::loadBatch, which stages the textures on
+	 * worker threads so only the resource creation happens here.
+	 * @param device The graphics device used to create the texture resource.
+	 * @param staged The format and the mip levels to upload.
+	 * @param firstMip The most detailed level to upload, TextureStreamer
+	 * uses it to keep only part of the chain resident.
+	 * @return HRESULT Returns S_OK if successful, otherwise an error code.
+	 */
+	HRESULT
+	init(Device& device, const StagedTexture& staged, unsigned int firstMip = 0);
+
 	/**
 	 * @brief Initializes a procedural texture (e.g., for a render target or depth buffer).
 	 * @param device The graphics device used to create the texture resource.
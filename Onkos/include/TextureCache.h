@@ -0,0 +1,173 @@
+#pragma once
+#include "Prerequisites.h"
+#include "Image.h"
+#include <cstdint>
+#include <memory>
+
+class MappedFile;
+
+/**
+ * @brief Identifies a .onktex file ("ONKT" in little-endian).
+ */
+static const uint32_t kTextureCacheMagic = 0x544B4E4F;
+
+/**
+ * @brief Version of the .onktex layout. Bump it whenever the layout changes.
+ */
+static const uint32_t kTextureCacheVersion = 3;
+
+/**
+ * @struct TextureCacheHeader
+ * @brief The fixed-size header at the start of every .onktex file.
+ *
+ * It is followed by one TextureCacheMip entry per level and then by the
+ * level data itself, each level starting at a 16-byte aligned offset.
+ */
+struct
+TextureCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t mipCount;
+	uint32_t reserved;
+	uint64_t sourceHash;
+};
+
+/**
+ * @struct TextureCacheMip
+ * @brief Where one mip level is stored inside a .onktex file.
+ */
+struct
+TextureCacheMip {
+	uint64_t offset;
+	uint32_t size;
+	uint32_t rowPitch;
+	uint32_t width;
+	uint32_t height;
+};
+
+/**
+ * @struct TextureSubresource
+ * @brief A pointer to the data of one mip level, ready to be uploaded.
+ */
+struct
+TextureSubresource {
+	/** @brief The first byte of the level. */
+	const void* data = nullptr;
+
+	/** @brief Bytes between two rows (of pixels or of compressed blocks). */
+	unsigned int rowPitch = 0;
+
+	/** @brief Total bytes of the level. */
+	unsigned int slicePitch = 0;
+
+	/** @brief Width of the level in pixels. */
+	unsigned int width = 0;
+
+	/** @brief Height of the level in pixels. */
+	unsigned int height = 0;
+};
+
+/**
+ * @struct CookedTexture
+ * @brief A texture mapped from a .onktex, .dds or .ktx2 file, with its mips inside the mapped file.
+ */
+struct
+CookedTexture {
+	/** @brief The pixel format of every level. */
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+
+	/**
+	 * @brief The levels of the texture, slice after slice, each slice from its
+	 * largest level to the smallest (the D3D11 subresource order).
+	 */
+	std::vector<TextureSubresource> mips;
+
+	/** @brief The number of array slices, 6 per cube. Every slice has mips.size() / arraySize levels. */
+	unsigned int arraySize = 1;
+
+	/** @brief true if every 6 slices are the faces of a cube map (+X, -X, +Y, -Y, +Z, -Z). */
+	bool cubemap = false;
+
+	/** @brief Keeps the memory behind the mips mapped. */
+	std::shared_ptr<MappedFile> file;
+};
+
+/**
+ * @class TextureCache
+ * @brief Reads and writes the cooked texture format (.onktex).
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * A .onktex file stores a complete, already decoded mip chain in its final
+ * GPU format together with the hash of the source image. Loading one maps the
+ * file and returns pointers to every level, so a texture can be created from
+ * it without decoding or copying any pixel.
+ */
+class
+TextureCache {
+public:
+	/**
+	 * @brief Default constructor.
+	 */
+	TextureCache() = default;
+
+	/**
+	 * @brief Default destructor.
+	 */
+	~TextureCache() = default;
+
+	/**
+	 * @brief Writes a mip chain to a .onktex file.
+	 * @param cachePath The path of the file to write.
+	 * @param format The format of the level data.
+	 * @param mips The levels to store, from the largest to the smallest.
+	 * @param sourceHash The ContentHash of the source image.
+	 * @return bool true if the file was written.
+	 */
+	bool
+	save(const std::string& cachePath,
+			 DXGI_FORMAT format,
+			 const std::vector<TextureSubresource>& mips,
+			 uint64_t sourceHash);
+
+	/**
+	 * @brief Maps a .onktex file and checks it was built from the expected source.
+	 * @param cachePath The path of the file to read.
+	 * @param sourceHash The expected ContentHash of the source image.
+	 * @param outTexture Receives the format and the mapped levels.
+	 * @return bool true if the file is valid for this source.
+	 */
+	bool
+	load(const std::string& cachePath, uint64_t sourceHash, CookedTexture& outTexture);
+
+	/**
+	 * @brief Maps a cooked .onktex file regardless of the source it came from.
+	 * @param cachePath The path of the file to read.
+	 * @param outTexture Receives the format and the mapped levels.
+	 * @return bool true if the file is a valid .onktex.
+	 */
+	bool
+	load(const std::string& cachePath, CookedTexture& outTexture);
+
+	/**
+	 * @brief Describes a chain of RGBA8 images as subresources, without copying them.
+	 * @param mips The levels, which must outlive the returned subresources.
+	 * @return std::vector<TextureSubresource> One subresource per level.
+	 */
+	static std::vector<TextureSubresource>
+	describe(const std::vector<Image>& mips);
+
+private:
+	/**
+	 * @brief Maps and validates a .onktex file.
+	 */
+	bool
+	loadInternal(const std::string& cachePath,
+							 bool checkHash,
+							 uint64_t sourceHash,
+							 CookedTexture& outTexture);
+};
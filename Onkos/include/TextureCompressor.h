@@ -0,0 +1,184 @@
+#pragma once
+#include "Prerequisites.h"
+#include "Image.h"
+#include "TextureCache.h"
+
+class ThreadPool;
+
+/**
+ * @enum CompressionQuality
+ * @brief Speed/quality preset of the block encoders.
+ */
+enum
+CompressionQuality {
+	COMPRESSION_NONE = 0, ///< Keep RGBA8.
+	COMPRESSION_FAST = 1, ///< Bounding-box endpoints, one pass. BC1 for opaque and BC3 for alpha.
+	COMPRESSION_HIGH = 2  ///< Principal-axis endpoints refined by least squares. BC7 for color.
+};
+
+/**
+ * @enum TextureUsage
+ * @brief What a texture holds, used to pick its compressed format.
+ */
+enum
+TextureUsage {
+	TEXTURE_USAGE_COLOR = 0,  ///< Color (sRGB) with optional alpha.
+	TEXTURE_USAGE_NORMAL = 1  ///< Tangent-space normal map, only X and Y are stored.
+};
+
+/**
+ * @struct CompressionReport
+ * @brief The cost and the quality of compressing one image.
+ */
+struct
+CompressionReport {
+	/** @brief The format the image was encoded to. */
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+
+	/** @brief Bytes of the RGBA8 input. */
+	size_t inputBytes = 0;
+
+	/** @brief Bytes of the encoded blocks. */
+	size_t outputBytes = 0;
+
+	/** @brief Seconds spent encoding. */
+	double seconds = 0.0;
+
+	/** @brief Peak signal-to-noise ratio in dB over the channels the format keeps. */
+	double psnr = 0.0;
+};
+
+/**
+ * @class TextureCompressor
+ * @brief Encodes RGBA8 images into the BC1, BC3, BC5 and BC7 block formats on the CPU.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Every format stores 4x4 texel blocks, 8 bytes for BC1 and 16 bytes for the
+ * others, so a texture takes 1/8 (BC1) or 1/4 of its RGBA8 size in memory and
+ * in bandwidth. Edge blocks of levels that aren't a multiple of 4 repeat
+ * their last row and column.
+ *
+ * - BC1: RGB, 4 colors interpolated between two RGB565 endpoints.
+ * - BC3: BC1 color plus an alpha block with 8 interpolated values.
+ * - BC5: two alpha-like blocks for the X and Y of normal maps.
+ * - BC7: written in mode 6 only (RGBA endpoints of 7 bits plus a shared bit
+ *   and 16 interpolated values), which handles color and alpha together.
+ *
+ * With a thread pool the rows of blocks are split across the workers.
+ */
+class
+TextureCompressor {
+public:
+	/**
+	 * @brief Picks the compressed format of an image.
+	 * @note Normal maps use BC5. Color uses BC1 when every texel is opaque
+	 * and BC3 otherwise with COMPRESSION_FAST, and BC7 with COMPRESSION_HIGH.
+	 * Images whose size isn't a multiple of 4 stay RGBA8, since D3D11 needs
+	 * the base level of a block-compressed texture to be made of whole blocks.
+	 * @param image The base level, checked for alpha.
+	 * @param usage What the image holds.
+	 * @param quality The preset. COMPRESSION_NONE returns RGBA8.
+	 * @return DXGI_FORMAT The format to encode to.
+	 */
+	static DXGI_FORMAT
+	chooseFormat(const Image& image, TextureUsage usage, CompressionQuality quality);
+
+	/**
+	 * @brief Guesses the usage of a texture from its file name.
+	 * @param fileName The path of the texture.
+	 * @return TextureUsage TEXTURE_USAGE_NORMAL for names ending in _n, _nrm,
+	 * _normal or _normals (before the extension), TEXTURE_USAGE_COLOR otherwise.
+	 */
+	static TextureUsage
+	guessUsage(const std::string& fileName);
+
+	/**
+	 * @brief Encodes an image into blocks.
+	 * @param image The RGBA8 texels.
+	 * @param format DXGI_FORMAT_BC1_UNORM, BC3_UNORM, BC5_UNORM or BC7_UNORM.
+	 * @param quality COMPRESSION_FAST or COMPRESSION_HIGH.
+	 * @param outBlocks Receives the blocks, row after row.
+	 * @param outReport Optional, receives the sizes, the time and the PSNR
+	 * (which costs a decode).
+	 * @param threadPool Optional, the pool that encodes the rows of blocks.
+	 * @return bool false if the format isn't a supported block format.
+	 */
+	static bool
+	compress(const Image& image,
+					 DXGI_FORMAT format,
+					 CompressionQuality quality,
+					 std::vector<unsigned char>& outBlocks,
+					 CompressionReport* outReport = nullptr,
+					 ThreadPool* threadPool = nullptr);
+
+	/**
+	 * @brief Encodes every level of a mip chain.
+	 * @param mips The levels, from the largest to the smallest.
+	 * @param format The block format.
+	 * @param quality COMPRESSION_FAST or COMPRESSION_HIGH.
+	 * @param outLevels Receives the blocks of every level.
+	 * @param outSubresources Receives the levels as subresources pointing into outLevels.
+	 * @param outReport Optional, receives the total sizes and time, and the PSNR of the base level.
+	 * @param threadPool Optional, the pool that encodes the rows of blocks.
+	 * @return bool false if the format isn't a supported block format.
+	 */
+	static bool
+	compressChain(const std::vector<Image>& mips,
+								DXGI_FORMAT format,
+								CompressionQuality quality,
+								std::vector<std::vector<unsigned char>>& outLevels,
+								std::vector<TextureSubresource>& outSubresources,
+								CompressionReport* outReport = nullptr,
+								ThreadPool* threadPool = nullptr);
+
+	/**
+	 * @brief Decodes blocks back into an RGBA8 image.
+	 * @note BC7 blocks must use mode 6, the one compress() writes. Channels a
+	 * format doesn't store are set to 0 (color) or 255 (alpha).
+	 * @param blocks The encoded blocks.
+	 * @param format The block format.
+	 * @param width Width of the image in texels.
+	 * @param height Height of the image in texels.
+	 * @param outImage Receives the texels.
+	 * @return bool false if the format or a BC7 mode isn't supported.
+	 */
+	static bool
+	decompress(const unsigned char* blocks,
+						 DXGI_FORMAT format,
+						 unsigned int width,
+						 unsigned int height,
+						 Image& outImage);
+
+	/**
+	 * @brief Computes the PSNR between two images of the same size.
+	 * @param reference The original image.
+	 * @param image The image to compare.
+	 * @param channelCount Compares channels [0, channelCount) of every texel.
+	 * @return double The PSNR in dB, 999 for identical images.
+	 */
+	static double
+	computePsnr(const Image& reference, const Image& image, unsigned int channelCount = 4);
+
+	/**
+	 * @brief Checks if a format is one of the block formats of this class.
+	 */
+	static bool
+	isBlockFormat(DXGI_FORMAT format);
+
+	/**
+	 * @brief Gets the bytes of one 4x4 block of a block format.
+	 * @return unsigned int 8 for BC1, 16 for the others.
+	 */
+	static unsigned int
+	getBlockBytes(DXGI_FORMAT format);
+
+	/**
+	 * @brief Gets the bytes of one row of blocks.
+	 * @param format A block format.
+	 * @param width Width of the level in texels.
+	 * @return unsigned int The row pitch of the level.
+	 */
+	static unsigned int
+	getRowPitch(DXGI_FORMAT format, unsigned int width);
+};
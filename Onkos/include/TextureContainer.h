@@ -0,0 +1,84 @@
+#pragma once
+#include "Prerequisites.h"
+#include "TextureCache.h"
+
+/**
+ * @class TextureContainer
+ * @brief Maps DDS and KTX2 files and exposes their levels without D3DX.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * The file is memory-mapped and the returned CookedTexture points every
+ * subresource straight into the mapping, so the data goes from the page cache
+ * to CreateTexture2D without an intermediate copy.
+ *
+ * - DDS: the legacy header (DXT1-5, ATI1/ATI2, the common RGB masks and the
+ *   D3DFMT float codes) and the DX10 header, with mips, arrays and cube maps.
+ * - KTX2: mips, arrays and cube maps of the Vulkan formats that have a DXGI
+ *   equivalent. Supercompressed (Basis, zstd) files are rejected, they need
+ *   a transcoder.
+ *
+ * Volume textures aren't supported. It has no dependency on DirectX beyond
+ * the format enum, so the offline tools can read and write the same files.
+ */
+class
+TextureContainer {
+public:
+	/**
+	 * @brief Maps a DDS or KTX2 file, recognized by its magic number.
+	 * @param fileName The path of the file.
+	 * @param outTexture Receives the format, the layout and the mapped levels.
+	 * @return bool true if the file was mapped and its layout is valid.
+	 */
+	static bool
+	load(const std::string& fileName, CookedTexture& outTexture);
+
+	/**
+	 * @brief Writes a texture as a DDS file with the DX10 header.
+	 * @note Every level must be tightly packed (the pitches computePitch
+	 * gives). The file is written next to the target and renamed over it once
+	 * complete.
+	 * @param fileName The path of the file.
+	 * @param texture The format, the layout and the levels, slice after slice.
+	 * @return bool false if the layout is invalid or the file couldn't be written.
+	 */
+	static bool
+	saveDds(const std::string& fileName, const CookedTexture& texture);
+
+	/**
+	 * @brief Checks if a path names a DDS or KTX2 file by its extension.
+	 * @param fileName The path of the file.
+	 * @return bool true for .dds and .ktx2 (any case).
+	 */
+	static bool
+	isContainerFile(const std::string& fileName);
+
+	/**
+	 * @brief Computes the tightly packed pitches of one level.
+	 * @param format The format of the level.
+	 * @param width Width of the level in texels.
+	 * @param height Height of the level in texels.
+	 * @param outRowPitch Receives the bytes of one row of texels or of 4x4 blocks.
+	 * @param outSlicePitch Receives the bytes of the whole level.
+	 * @return bool false if the format isn't one the parsers know.
+	 */
+	static bool
+	computePitch(DXGI_FORMAT format,
+							 unsigned int width,
+							 unsigned int height,
+							 uint64_t& outRowPitch,
+							 uint64_t& outSlicePitch);
+
+private:
+	/**
+	 * @brief Reads the layout of a mapped DDS file.
+	 */
+	static bool
+	parseDds(const std::string& fileName, const char* data, size_t size, CookedTexture& outTexture);
+
+	/**
+	 * @brief Reads the layout of a mapped KTX2 file.
+	 */
+	static bool
+	parseKtx2(const std::string& fileName, const char* data, size_t size, CookedTexture& outTexture);
+};
@@ -0,0 +1,345 @@
+#pragma once
+#include "Prerequisites.h"
+#include "Image.h"
+#include "MipGenerator.h"
+#include "TextureCache.h"
+#include "TextureCompressor.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+/**
+ * @struct StagedTexture
+ * @brief A texture read into CPU memory, with every level ready to be uploaded.
+ *
+ * The levels either point into a mapped .onktex, .dds or .ktx2 file (cooked)
+ * or into the images decoded here. Either way the staged texture owns the memory, so it
+ * only has to outlive the upload.
+ */
+struct
+StagedTexture {
+	/** @brief The file that was read (the .onktex, the .dds/.ktx2 or the source image). */
+	std::string fileName;
+
+	/** @brief The format and the levels to upload. Keeps the cooked file mapped. */
+	CookedTexture texture;
+
+	/** @brief The decoded levels of a source image, empty for a cooked or compressed texture. */
+	std::vector<Image> images;
+
+	/** @brief The compressed levels, when the texture was compressed while staging. */
+	std::vector<std::vector<unsigned char>> blocks;
+
+	/** @brief true if the levels come from a mapped .onktex, .dds or .ktx2 file. */
+	bool cooked = false;
+};
+
+/**
+ * @struct TextureLoadTiming
+ * @brief Where the time of one texture of a batch went.
+ */
+struct
+TextureLoadTiming {
+	/** @brief The path that was requested. */
+	std::string fileName;
+
+	/** @brief true if the texture was staged and uploaded. */
+	bool loaded = false;
+
+	/** @brief true if the levels were mapped (.onktex, .dds or .ktx2) instead of decoded. */
+	bool cooked = false;
+
+	/** @brief Seconds spent mapping or decoding the file, on a worker. */
+	double decodeSeconds = 0.0;
+
+	/** @brief Seconds spent generating the mip chain, on a worker. */
+	double mipSeconds = 0.0;
+
+	/** @brief Seconds spent compressing the levels, on a worker. */
+	double compressSeconds = 0.0;
+
+	/** @brief Seconds spent in the upload callback, on the calling thread. */
+	double uploadSeconds = 0.0;
+};
+
+/**
+ * @struct TextureBatchStats
+ * @brief The timings of the last batch loaded by a TextureLoader.
+ */
+struct
+TextureBatchStats {
+	/** @brief One entry per requested file, in request order. */
+	std::vector<TextureLoadTiming> textures;
+
+	/** @brief The number of textures staged and uploaded. */
+	size_t loadedCount = 0;
+
+	/** @brief Seconds from the call to the last upload. */
+	double totalSeconds = 0.0;
+
+	/** @brief Seconds the calling thread waited for a worker to stage a texture. */
+	double waitSeconds = 0.0;
+};
+
+/**
+ * @struct StagedBatchTexture
+ * @brief A texture of an asynchronous batch, ready to be uploaded.
+ */
+struct
+StagedBatchTexture {
+	/** @brief The position of the file in the batch. */
+	size_t index = 0;
+
+	/** @brief The staged texture, null if the file couldn't be read. */
+	std::unique_ptr<StagedTexture> texture;
+};
+
+/**
+ * @class TextureBatchRequest
+ * @brief A batch of textures being staged on the workers of a TextureLoader.
+ * @author Ricardo Rabell
+ * @date 2026-10-16
+ *
+ * Returned by TextureLoader::loadBatchAsync. The render loop polls takeStaged()
+ * between frames and uploads what it got, so decoding never stalls a frame.
+ * Like ModelLoadRequest, it never waits for the workers: the mutex only guards
+ * the hand-over of the staged textures.
+ */
+class
+TextureBatchRequest {
+public:
+	/**
+	 * @brief Constructor. Starts the clock of the batch.
+	 * @param fileCount The number of files in the batch.
+	 */
+	explicit TextureBatchRequest(size_t fileCount)
+		: m_startTime(std::chrono::high_resolution_clock::now()), m_fileCount(fileCount) {}
+
+	/**
+	 * @brief Default destructor.
+	 */
+	~TextureBatchRequest() = default;
+
+	TextureBatchRequest(const TextureBatchRequest&) = delete;
+	TextureBatchRequest& operator=(const TextureBatchRequest&) = delete;
+
+	/**
+	 * @brief Moves the textures staged since the last call into outTextures.
+	 * @note Never blocks on the workers: returns false if one holds the lock.
+	 * @param outTextures Receives the textures, in the order they finished.
+	 * @return bool true if any texture was taken.
+	 */
+	bool
+	takeStaged(std::vector<StagedBatchTexture>& outTextures);
+
+	/**
+	 * @brief Asks the workers to skip the files they haven't started.
+	 */
+	void
+	cancel() { m_canceled = true; }
+
+	/**
+	 * @brief Checks if cancel() was called.
+	 */
+	bool
+	isCanceled() const { return m_canceled; }
+
+	/**
+	 * @brief Checks if every file of the batch was staged and taken.
+	 */
+	bool
+	isFinished() const { return m_takenCount == m_fileCount; }
+
+	/**
+	 * @brief Gets the number of files in the batch.
+	 */
+	size_t
+	getFileCount() const { return m_fileCount; }
+
+	/**
+	 * @brief Gets the seconds since the batch was requested.
+	 */
+	double
+	getElapsedSeconds() const;
+
+	/**
+	 * @brief Hands a staged texture over to takeStaged.
+	 * @note Called by the workers.
+	 * @param index The position of the file in the batch.
+	 * @param texture The staged texture, null if the file couldn't be read.
+	 */
+	void
+	publish(size_t index, std::unique_ptr<StagedTexture> texture);
+
+private:
+	/** @brief When the batch was requested. */
+	std::chrono::high_resolution_clock::time_point m_startTime;
+
+	/** @brief The number of files in the batch. */
+	size_t m_fileCount;
+
+	/** @brief Textures taken by takeStaged, only touched by the polling thread. */
+	size_t m_takenCount = 0;
+
+	/** @brief Guards m_staged. */
+	std::mutex m_mutex;
+
+	/** @brief The textures staged and not taken yet. */
+	std::vector<StagedBatchTexture> m_staged;
+
+	/** @brief Set by cancel(). */
+	std::atomic<bool> m_canceled{ false };
+};
+
+/**
+ * @brief A shared handle to an asynchronous batch, held by the caller and the workers.
+ */
+using TextureBatchHandle = std::shared_ptr<TextureBatchRequest>;
+
+/**
+ * @class TextureLoader
+ * @brief Reads batches of textures on a worker pool and hands them over for upload.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Each file is staged by a worker: DDS and KTX2 files are mapped with
+ * TextureContainer, a PNG or JPG uses its cooked .onktex when there is one
+ * next to it, otherwise it is decoded with ImageDecoder and its mip chain
+ * generated with MipGenerator (and optionally compressed with
+ * TextureCompressor). Staged textures are passed to a callback on the calling
+ * thread as soon as each one is ready, so creating the GPU resources of one
+ * texture overlaps with decoding the next ones. Only a few textures per worker
+ * are staged ahead of the callback, which bounds the memory held by a large
+ * batch.
+ *
+ * It has no dependency on DirectX beyond the format enum; Texture::init
+ * creates a texture from a StagedTexture.
+ */
+class
+TextureLoader {
+public:
+	/**
+	 * @brief Called on the calling thread for every texture of a batch.
+	 * @param index The position of the file in the batch.
+	 * @param staged The staged texture, null if the file couldn't be read. It
+	 * is freed after the callback unless the callback moves it out (e.g. into
+	 * a TextureStreamer, which keeps the CPU copy).
+	 * @return bool true if the texture was uploaded.
+	 */
+	using UploadCallback = std::function<bool(size_t index, StagedTexture* staged)>;
+
+	/**
+	 * @brief Default constructor.
+	 */
+	TextureLoader() = default;
+
+	/**
+	 * @brief Default destructor.
+	 */
+	~TextureLoader() = default;
+
+	/**
+	 * @brief Stages every file of a batch on the workers and uploads them on this thread.
+	 * @note The callback receives the textures in the order they finish, not
+	 * in request order.
+	 * @param fileNames The paths of the source images.
+	 * @param upload Called once per file.
+	 * @return bool true if every texture was uploaded.
+	 */
+	bool
+	loadBatch(const std::vector<std::string>& fileNames, const UploadCallback& upload);
+
+	/**
+	 * @brief Stages every file of a batch on the workers and returns at once.
+	 * @note The settings are copied, changing them doesn't affect the batch.
+	 * getLastBatchStats() doesn't cover asynchronous batches.
+	 * @param fileNames The paths of the source images.
+	 * @return TextureBatchHandle The request, to poll with takeStaged().
+	 */
+	TextureBatchHandle
+	loadBatchAsync(const std::vector<std::string>& fileNames);
+
+	/**
+	 * @brief Reads one texture into CPU memory.
+	 * @param fileName The path of the source image, or of a .dds or .ktx2 file.
+	 * For an image, a .onktex with the same name is used instead when it exists.
+	 * @param mipSettings How to build the mip chain of a decoded image. Null
+	 * stages the base level only. Normal maps (see TextureCompressor::guessUsage)
+	 * are always filtered as linear data.
+	 * @param compression The block compression preset of a decoded image.
+	 * @param outTexture Receives the levels.
+	 * @param outTiming Optional, receives the decode and mip timings.
+	 * @return bool true if the texture was read.
+	 */
+	static bool
+	stage(const std::string& fileName,
+				const MipSettings* mipSettings,
+				CompressionQuality compression,
+				StagedTexture& outTexture,
+				TextureLoadTiming* outTiming = nullptr);
+
+	/**
+	 * @brief Sets the number of decoding threads.
+	 * @param threadCount The number of workers. 0 uses one per hardware thread.
+	 */
+	void
+	setThreadCount(unsigned int threadCount) { m_threadCount = threadCount; }
+
+	/**
+	 * @brief Gets the requested number of decoding threads.
+	 * @return unsigned int The requested number of workers (0 means automatic).
+	 */
+	unsigned int
+	getThreadCount() const { return m_threadCount; }
+
+	/**
+	 * @brief Enables or disables the mip chain of decoded images.
+	 * @param generateMips true to upload the full chain (the default), false for the base level only.
+	 */
+	void
+	setGenerateMips(bool generateMips) { m_generateMips = generateMips; }
+
+	/**
+	 * @brief Sets the filter and color space of the generated mip chains.
+	 * @param mipSettings The settings, sRGB box filter by default.
+	 */
+	void
+	setMipSettings(const MipSettings& mipSettings) { m_mipSettings = mipSettings; }
+
+	/**
+	 * @brief Sets the block compression of decoded images.
+	 * @note Cooked textures are uploaded as they were cooked.
+	 * @param compression COMPRESSION_NONE (the default) keeps RGBA8.
+	 */
+	void
+	setCompression(CompressionQuality compression) { m_compression = compression; }
+
+	/**
+	 * @brief Gets the timings of the last batch.
+	 * @return const TextureBatchStats& The stats of the last call to loadBatch.
+	 */
+	const TextureBatchStats&
+	getLastBatchStats() const { return m_lastBatchStats; }
+
+private:
+	/** @brief Requested number of decoding threads (0 = automatic). */
+	unsigned int m_threadCount = 0;
+
+	/** @brief Builds the mip chain of decoded images. */
+	bool m_generateMips = true;
+
+	/** @brief How the mip chains of decoded images are built. */
+	MipSettings m_mipSettings;
+
+	/** @brief The block compression of decoded images. */
+	CompressionQuality m_compression = COMPRESSION_NONE;
+
+	/** @brief The workers that stage the textures. */
+	ThreadPool m_threadPool;
+
+	/** @brief The timings of the last batch. */
+	TextureBatchStats m_lastBatchStats;
+};
@@ -0,0 +1,270 @@
+#pragma once
+#include "Prerequisites.h"
+#include "Image.h"
+#include "MipGenerator.h"
+#include "TextureCache.h"
+
+class ThreadPool;
+
+/**
+ * @class SkylinePacker
+ * @brief Places rectangles in a fixed-size area with the skyline bottom-left heuristic.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * The free space is tracked as the top edge of the placed rectangles (the
+ * skyline), a list of horizontal segments. A rectangle goes where its top
+ * would be lowest, then leftmost; the space below a segment is never reused,
+ * which keeps every insertion linear in the number of segments.
+ */
+class
+SkylinePacker {
+public:
+	/**
+	 * @brief Default constructor.
+	 */
+	SkylinePacker() = default;
+
+	/**
+	 * @brief Default destructor.
+	 */
+	~SkylinePacker() = default;
+
+	/**
+	 * @brief Empties the area.
+	 * @param width Width of the area.
+	 * @param height Height of the area.
+	 */
+	void
+	init(unsigned int width, unsigned int height);
+
+	/**
+	 * @brief Places a rectangle.
+	 * @param width Width of the rectangle.
+	 * @param height Height of the rectangle.
+	 * @param outX Receives the left edge of the rectangle.
+	 * @param outY Receives the top edge of the rectangle.
+	 * @return bool false if the rectangle doesn't fit anywhere.
+	 */
+	bool
+	insert(unsigned int width, unsigned int height, unsigned int& outX, unsigned int& outY);
+
+	/**
+	 * @brief Gets the area covered by the placed rectangles.
+	 * @return uint64_t The covered area.
+	 */
+	uint64_t
+	getUsedArea() const { return m_usedArea; }
+
+private:
+	/**
+	 * @brief A segment of the skyline: [x, x + width) at height y.
+	 */
+	struct
+	Segment {
+		unsigned int x;
+		unsigned int y;
+		unsigned int width;
+	};
+
+	/** @brief Width of the area. */
+	unsigned int m_width = 0;
+
+	/** @brief Height of the area. */
+	unsigned int m_height = 0;
+
+	/** @brief The segments, left to right, covering [0, m_width). */
+	std::vector<Segment> m_skyline;
+
+	/** @brief Area covered by the placed rectangles. */
+	uint64_t m_usedArea = 0;
+};
+
+/**
+ * @struct TexturePackerSettings
+ * @brief The pages of a TexturePacker and the space kept around every image.
+ */
+struct
+TexturePackerSettings {
+	/** @brief Width of every page. */
+	unsigned int pageWidth = 2048;
+
+	/** @brief Height of every page. */
+	unsigned int pageHeight = 2048;
+
+	/**
+	 * @brief Texels of gutter around every image in the base level.
+	 * @note Rounded up to the alignment (see mipCount), so the gutter is
+	 * at least one texel wide in every level. 0 packs the images edge to
+	 * edge, which only suits images that fill a page (a plain texture array).
+	 */
+	unsigned int padding = 4;
+
+	/**
+	 * @brief Levels of the pages.
+	 * @note Images are placed on multiples of 2^(mipCount - 1) texels so every
+	 * level keeps them on whole texels. More levels waste more space.
+	 */
+	unsigned int mipCount = 4;
+
+	/** @brief Pages (slices of the array) at most. */
+	unsigned int maxPages = 64;
+
+	/** @brief The filter and the color space of the levels of every image. */
+	MipSettings mipSettings;
+};
+
+/**
+ * @struct PackedTexture
+ * @brief Where an image landed and how its texture coordinates are remapped.
+ *
+ * A texture coordinate uv of the image becomes
+ * (uv * uvScale + uvOffset, slice) in the array of pages.
+ */
+struct
+PackedTexture {
+	/** @brief false if the image doesn't fit in a page or the pages ran out. */
+	bool packed = false;
+
+	/** @brief The page (slice of the array) that holds the image. */
+	unsigned int slice = 0;
+
+	/** @brief Left edge of the image in the base level, without the gutter. */
+	unsigned int x = 0;
+
+	/** @brief Top edge of the image in the base level, without the gutter. */
+	unsigned int y = 0;
+
+	/** @brief Width of the image. */
+	unsigned int width = 0;
+
+	/** @brief Height of the image. */
+	unsigned int height = 0;
+
+	/** @brief Scale of the texture coordinates (U, V). */
+	float uvScale[2] = { 1.0f, 1.0f };
+
+	/** @brief Offset of the texture coordinates (U, V). */
+	float uvOffset[2] = { 0.0f, 0.0f };
+};
+
+/**
+ * @struct TexturePackerStats
+ * @brief How well and how fast a set of images was packed.
+ */
+struct
+TexturePackerStats {
+	/** @brief Images given to the packer. */
+	size_t imageCount = 0;
+
+	/** @brief Images placed in a page. */
+	size_t packedCount = 0;
+
+	/** @brief Pages used. */
+	size_t pageCount = 0;
+
+	/** @brief Texels of the packed images in the base level. */
+	uint64_t imageTexels = 0;
+
+	/** @brief Texels of the pages in the base level. */
+	uint64_t pageTexels = 0;
+
+	/** @brief Fraction of the pages covered by images, gutters excluded. */
+	double efficiency = 0.0;
+
+	/** @brief Seconds spent placing the rectangles. */
+	double packSeconds = 0.0;
+
+	/** @brief Seconds spent filtering the levels and copying them into the pages. */
+	double copySeconds = 0.0;
+};
+
+/**
+ * @struct TextureAtlas
+ * @brief Pages of packed images, the slices of one Texture2DArray.
+ */
+struct
+TextureAtlas {
+	/** @brief Width of every page. */
+	unsigned int width = 0;
+
+	/** @brief Height of every page. */
+	unsigned int height = 0;
+
+	/** @brief The levels of every page: pages[slice][mip]. */
+	std::vector<std::vector<Image>> pages;
+
+	/** @brief The placement of every image, in the order they were given. */
+	std::vector<PackedTexture> entries;
+
+	/**
+	 * @brief Describes the pages as the subresources of an RGBA8 texture array.
+	 * @return CookedTexture The layout, pointing into pages (which must outlive it).
+	 */
+	CookedTexture
+	describe() const;
+};
+
+/**
+ * @class TexturePacker
+ * @brief Packs small images into the pages of a texture array so the objects
+ * that use them share one shader resource binding.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Images are sorted by height and placed with a SkylinePacker, first fit
+ * over the open pages. Every image is reduced on its own (so no level mixes
+ * two images) and each of its levels is copied into the same level of its
+ * page, surrounded by a gutter that repeats its edge texels. Bilinear
+ * filtering and the small levels therefore never sample a neighbour.
+ *
+ * An image keeps its own texture coordinates only within [0, 1]: wrapping
+ * (tiling) textures can't be packed. Images larger than a page aren't packed
+ * and keep their own texture.
+ */
+class
+TexturePacker {
+public:
+	/**
+	 * @brief Packs images into pages.
+	 * @param images The base level of every image, RGBA8.
+	 * @param settings The pages, the gutter and the levels.
+	 * @param outAtlas Receives the pages and the placement of every image.
+	 * @param outStats Optional, receives the efficiency and the timings.
+	 * @param threadPool Optional, the pool that reduces the images in parallel.
+	 * @return bool false if the settings are invalid or no image was packed.
+	 */
+	static bool
+	pack(const std::vector<const Image*>& images,
+			 const TexturePackerSettings& settings,
+			 TextureAtlas& outAtlas,
+			 TexturePackerStats* outStats = nullptr,
+			 ThreadPool* threadPool = nullptr);
+
+	/**
+	 * @brief Writes the placement of every image as text, one line per image:
+	 * slice, U/V offset, U/V scale and the name (last, it may hold spaces).
+	 * Unpacked images are skipped.
+	 * @param fileName The path of the layout file.
+	 * @param names The name of every image, in the order of atlas.entries.
+	 * @param atlas The packed atlas.
+	 * @return bool false if the file couldn't be written.
+	 */
+	static bool
+	saveLayout(const std::string& fileName,
+						 const std::vector<std::string>& names,
+						 const TextureAtlas& atlas);
+
+	/**
+	 * @brief Reads a layout written by saveLayout.
+	 * @param fileName The path of the layout file.
+	 * @param outNames Receives the name of every image.
+	 * @param outEntries Receives the slice and the texture coordinate remap of
+	 * every image (the texel rectangles aren't stored).
+	 * @return bool false if the file couldn't be read or is malformed.
+	 */
+	static bool
+	loadLayout(const std::string& fileName,
+						 std::vector<std::string>& outNames,
+						 std::vector<PackedTexture>& outEntries);
+};
@@ -0,0 +1,319 @@
+#pragma once
+#include "Prerequisites.h"
+#include "TextureLoader.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief Identifies a texture registered with a TextureStreamer.
+ */
+using StreamedTextureId = uint32_t;
+
+/**
+ * @brief Returned by TextureStreamer::addTexture when the texture couldn't be registered.
+ */
+static const StreamedTextureId kInvalidStreamedTexture = UINT32_MAX;
+
+/**
+ * @class TextureStreamingDevice
+ * @brief Creates and releases the GPU textures of a TextureStreamer.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * The streamer only decides which levels are resident, the device owns the
+ * resources. StreamedTextures implements it on a D3D11 Device; a fake that
+ * only records the calls is enough to exercise the streaming policy.
+ */
+class
+TextureStreamingDevice {
+public:
+	/**
+	 * @brief Virtual destructor.
+	 */
+	virtual ~TextureStreamingDevice() = default;
+
+	/**
+	 * @brief Creates the texture of an id with the levels [firstMip, last] of
+	 * every slice, replacing the one it had.
+	 * @param id The texture.
+	 * @param texture The CPU copy of every level.
+	 * @param firstMip The most detailed level to make resident.
+	 * @return bool true if the texture was created. The old one is kept otherwise.
+	 */
+	virtual bool
+	createTexture(StreamedTextureId id, const StagedTexture& texture, unsigned int firstMip) = 0;
+
+	/**
+	 * @brief Releases the texture of an id.
+	 * @param id The texture.
+	 */
+	virtual void
+	releaseTexture(StreamedTextureId id) = 0;
+};
+
+/**
+ * @struct TextureStreamingSettings
+ * @brief The memory budget and the pace of a TextureStreamer.
+ */
+struct
+TextureStreamingSettings {
+	/** @brief Bytes the resident levels of every texture may take together. */
+	uint64_t budgetBytes = 256ull * 1024 * 1024;
+
+	/** @brief Bytes uploaded per update at most (at least one texture always makes progress). */
+	uint64_t uploadBytesPerFrame = 16ull * 1024 * 1024;
+
+	/** @brief Levels this size and smaller are loaded first and never evicted. */
+	unsigned int residentTailSize = 64;
+
+	/** @brief Updates without usage feedback before a texture falls back to its tail. */
+	unsigned int unusedFrames = 120;
+};
+
+/**
+ * @struct StreamedTextureInfo
+ * @brief The residency of one streamed texture.
+ */
+struct
+StreamedTextureInfo {
+	/** @brief Width of the most detailed level of the source. */
+	unsigned int width = 0;
+
+	/** @brief Height of the most detailed level of the source. */
+	unsigned int height = 0;
+
+	/** @brief Levels of the source. */
+	unsigned int mipCount = 0;
+
+	/** @brief The most detailed resident level. */
+	unsigned int residentMip = 0;
+
+	/** @brief The level the usage feedback asks for. */
+	unsigned int wantedMip = 0;
+
+	/** @brief The level the budget allows, between wantedMip and the tail. */
+	unsigned int targetMip = 0;
+
+	/** @brief Bytes of the resident levels. */
+	uint64_t residentBytes = 0;
+
+	/** @brief The last update that received usage feedback for it. */
+	uint64_t lastUsedFrame = 0;
+
+	/** @brief Higher priorities are streamed in first and evicted last. */
+	float priority = 1.0f;
+};
+
+/**
+ * @struct TextureStreamingStats
+ * @brief The residency of every texture and what the last update did.
+ */
+struct
+TextureStreamingStats {
+	/** @brief Textures registered. */
+	size_t textureCount = 0;
+
+	/** @brief Bytes of the resident levels of every texture. */
+	uint64_t residentBytes = 0;
+
+	/** @brief Bytes every texture would take at the level its feedback asks for. */
+	uint64_t wantedBytes = 0;
+
+	/** @brief The budget of the streamer. */
+	uint64_t budgetBytes = 0;
+
+	/** @brief Textures waiting for finer levels. */
+	size_t pendingCount = 0;
+
+	/** @brief Textures recreated with finer levels by the last update. */
+	size_t uploadCount = 0;
+
+	/** @brief Bytes uploaded by the last update. */
+	uint64_t uploadedBytes = 0;
+
+	/** @brief Textures that dropped levels in the last update. */
+	size_t evictionCount = 0;
+
+	/** @brief Bytes freed by the last update. */
+	uint64_t evictedBytes = 0;
+
+	/** @brief Requests for finer levels completed since init. */
+	size_t completedRequests = 0;
+
+	/** @brief Average updates from a request to its levels being resident. */
+	double averageLatencyFrames = 0.0;
+
+	/** @brief Average seconds from a request to its levels being resident. */
+	double averageLatencySeconds = 0.0;
+
+	/** @brief Longest seconds from a request to its levels being resident. */
+	double maxLatencySeconds = 0.0;
+};
+
+/**
+ * @class TextureStreamer
+ * @brief Keeps the levels of many textures resident under a memory budget,
+ * streaming finer levels in as the screen needs them.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Every texture is registered with its CPU copy (a mapped .onktex/.dds/.ktx2
+ * or decoded levels) and starts with its small levels only (the tail, see
+ * TextureStreamingSettings::residentTailSize). Each frame the renderer reports
+ * how large every texture is on screen; update() turns that into the level
+ * each texture wants, coarsens the least recently used (then lowest priority)
+ * textures until the wanted levels fit the budget, drops the levels that no
+ * longer fit and uploads finer levels, highest priority first, within the
+ * upload limit of the frame.
+ *
+ * D3D11 textures can't grow or shrink their mip chain, so a change of
+ * residency recreates the texture from the CPU copy through a
+ * TextureStreamingDevice. Every call must come from the same thread.
+ */
+class
+TextureStreamer {
+public:
+	/**
+	 * @brief Default constructor.
+	 */
+	TextureStreamer() = default;
+
+	/**
+	 * @brief Default destructor.
+	 */
+	~TextureStreamer() = default;
+
+	/**
+	 * @brief Sets the device and the budget.
+	 * @param device Creates the textures, must outlive the streamer.
+	 * @param settings The budget and the pace.
+	 */
+	void
+	init(TextureStreamingDevice& device, const TextureStreamingSettings& settings = TextureStreamingSettings());
+
+	/**
+	 * @brief Releases every texture.
+	 */
+	void
+	destroy();
+
+	/**
+	 * @brief Registers a texture and makes its tail resident.
+	 * @param texture The CPU copy of every level, kept until the texture is removed.
+	 * @param priority Higher priorities are streamed in first and evicted last.
+	 * @return StreamedTextureId The id of the texture, kInvalidStreamedTexture
+	 * if it has no levels or its tail couldn't be created.
+	 */
+	StreamedTextureId
+	addTexture(std::unique_ptr<StagedTexture> texture, float priority = 1.0f);
+
+	/**
+	 * @brief Releases a texture and its CPU copy.
+	 * @param id The texture.
+	 */
+	void
+	removeTexture(StreamedTextureId id);
+
+	/**
+	 * @brief Reports that a texture was drawn this frame.
+	 * @note Several reports in a frame keep the most detailed level.
+	 * @param id The texture.
+	 * @param screenSize The size in pixels the texture covers on screen
+	 * (e.g. the projected diameter of the mesh it is mapped on).
+	 */
+	void
+	reportUsage(StreamedTextureId id, float screenSize);
+
+	/**
+	 * @brief Applies the feedback of the frame: evicts and uploads levels.
+	 */
+	void
+	update();
+
+	/**
+	 * @brief Changes the memory budget, applied by the next update.
+	 * @param budgetBytes Bytes the resident levels may take together.
+	 */
+	void
+	setBudget(uint64_t budgetBytes) { m_settings.budgetBytes = budgetBytes; }
+
+	/**
+	 * @brief Gets the residency of a texture.
+	 * @param id The texture.
+	 * @param outInfo Receives the residency.
+	 * @return bool false if the id isn't registered.
+	 */
+	bool
+	getTextureInfo(StreamedTextureId id, StreamedTextureInfo& outInfo) const;
+
+	/**
+	 * @brief Gets the residency of every texture and what the last update did.
+	 * @return TextureStreamingStats The stats.
+	 */
+	TextureStreamingStats
+	getStats() const;
+
+	/**
+	 * @brief Computes the level that matches a size on screen.
+	 * @param width Width of the most detailed level.
+	 * @param height Height of the most detailed level.
+	 * @param mipCount Levels of the texture.
+	 * @param screenSize Pixels the texture covers on screen.
+	 * @return unsigned int The coarsest level with at least one texel per pixel.
+	 */
+	static unsigned int
+	computeWantedMip(unsigned int width, unsigned int height, unsigned int mipCount, float screenSize);
+
+private:
+	/**
+	 * @brief The state of one registered texture.
+	 */
+	struct
+	Entry {
+		std::unique_ptr<StagedTexture> source;
+		unsigned int mipCount = 0;
+		unsigned int tailMip = 0;
+		unsigned int residentMip = 0;
+		unsigned int wantedMip = 0;
+		unsigned int targetMip = 0;
+		unsigned int frameWantedMip = 0;
+		bool usedThisFrame = false;
+		float priority = 1.0f;
+		uint64_t lastUsedFrame = 0;
+
+		/** @brief bytesFrom[m] is the size of the levels [m, mipCount) of every slice. */
+		std::vector<uint64_t> bytesFrom;
+
+		bool pending = false;
+		uint64_t requestFrame = 0;
+		std::chrono::high_resolution_clock::time_point requestTime;
+	};
+
+	/**
+	 * @brief Recreates a texture with a new most detailed level.
+	 */
+	bool
+	setResidentMip(StreamedTextureId id, Entry& entry, unsigned int mip);
+
+	/** @brief Creates the textures. */
+	TextureStreamingDevice* m_device = nullptr;
+
+	/** @brief The budget and the pace. */
+	TextureStreamingSettings m_settings;
+
+	/** @brief The registered textures, indexed by id (null once removed). */
+	std::vector<std::unique_ptr<Entry>> m_entries;
+
+	/** @brief The number of updates since init. */
+	uint64_t m_frame = 0;
+
+	/** @brief What the last update did, and the latency totals. */
+	TextureStreamingStats m_stats;
+
+	/** @brief Sum of the latencies of the completed requests, in updates. */
+	uint64_t m_latencyFrames = 0;
+
+	/** @brief Sum of the latencies of the completed requests, in seconds. */
+	double m_latencySeconds = 0.0;
+};
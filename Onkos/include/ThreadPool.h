@@ -0,0 +1,104 @@
+#pragma once
+#include "Prerequisites.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+/**
+ * @class ThreadPool
+ * @brief A fixed set of worker threads that execute CPU tasks.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * This class owns a group of worker threads that consume tasks from a shared
+ * queue. It is used by the CPU-side systems of the engine (model parsing, mesh
+ * processing, image decoding) to spread independent work across all cores.
+ * It has no dependency on DirectX.
+ */
+class
+ThreadPool {
+public:
+	/**
+	 * @brief Default constructor. The pool has no threads until init() is called.
+	 */
+	ThreadPool() = default;
+
+	/**
+	 * @brief Destructor. Waits for the queued tasks and joins the workers.
+	 */
+	~ThreadPool() { destroy(); }
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * @brief Starts the worker threads.
+	 * @param threadCount The number of workers. 0 uses one per hardware thread.
+	 */
+	void
+	init(unsigned int threadCount = 0);
+
+	/**
+	 * @brief Finishes the queued tasks and joins every worker thread.
+	 */
+	void
+	destroy();
+
+	/**
+	 * @brief Queues a task to be executed by any worker.
+	 * @note If the pool has no workers the task runs immediately on the caller.
+	 * @param task The function to execute.
+	 */
+	void
+	enqueue(std::function<void()> task);
+
+	/**
+	 * @brief Runs task(i) for every i in [0, count) and waits until all of them finish.
+	 * @note The calling thread also executes tasks while it waits. Must not be
+	 * called from inside a task of the same pool.
+	 * @param count The number of task invocations.
+	 * @param task The function to execute for each index.
+	 */
+	void
+	parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+	/**
+	 * @brief Gets the number of worker threads.
+	 * @return unsigned int The number of workers (0 if not initialized).
+	 */
+	unsigned int
+	getThreadCount() const { return static_cast<unsigned int>(m_workers.size()); }
+
+	/**
+	 * @brief Resolves a requested thread count into an actual one.
+	 * @param requested The requested count, 0 meaning "one per hardware thread".
+	 * @return unsigned int A thread count of at least 1.
+	 */
+	static unsigned int
+	resolveThreadCount(unsigned int requested);
+
+private:
+	/**
+	 * @brief The loop executed by each worker thread.
+	 */
+	void
+	workerLoop();
+
+private:
+	/** @brief The worker threads. */
+	std::vector<std::thread> m_workers;
+
+	/** @brief Tasks waiting to be executed. */
+	std::deque<std::function<void()>> m_tasks;
+
+	/** @brief Guards m_tasks and m_stopping. */
+	std::mutex m_mutex;
+
+	/** @brief Signals the workers when a task is queued or the pool stops. */
+	std::condition_variable m_taskAvailable;
+
+	/** @brief Set by destroy() to make the workers exit. */
+	bool m_stopping = false;
+};
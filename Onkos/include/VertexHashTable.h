@@ -0,0 +1,134 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @struct VertexKey
+ * @brief The attribute indices that identify a unique vertex.
+ *
+ * Holds the resolved, 0-based position, texture coordinate and normal indices
+ * of a face corner. Two corners with the same key produce the same vertex.
+ */
+struct
+VertexKey {
+	int pos;
+	int uv;
+	int nrm;
+};
+
+/**
+ * @class VertexHashTable
+ * @brief An open-addressing hash table that maps a VertexKey to a vertex index.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Used to weld identical face corners into a single vertex while a mesh is
+ * being built. The slots live in one flat array with linear probing, so a
+ * lookup never allocates and usually touches a single cache line. The table
+ * is sized up front from the number of corners, which means it never has to
+ * grow while parsing a model.
+ */
+class
+VertexHashTable {
+public:
+	/**
+	 * @brief Default constructor.
+	 */
+	VertexHashTable() = default;
+
+	/**
+	 * @brief Default destructor.
+	 */
+	~VertexHashTable() = default;
+
+	/**
+	 * @brief Allocates the table for an expected number of unique keys.
+	 * @param expectedKeys An upper bound of the keys that will be inserted
+	 * (e.g. the number of face corners of the model).
+	 */
+	void
+	init(size_t expectedKeys);
+
+	/**
+	 * @brief Releases the slots of the table.
+	 */
+	void
+	destroy();
+
+	/**
+	 * @brief Looks up a key and inserts it if it isn't in the table yet.
+	 * @param key The attribute indices of the vertex.
+	 * @param newIndex The vertex index stored if the key is inserted.
+	 * @param outIndex Receives the stored vertex index (the existing one or newIndex).
+	 * @return bool true if the key was inserted, false if it already existed.
+	 */
+	bool
+	findOrInsert(const VertexKey& key, int newIndex, int& outIndex) {
+		if ((m_count + 1) * 2 > m_slots.size()) {
+			grow();
+		}
+
+		size_t slot = hash(key) & m_mask;
+		for (;;) {
+			Slot& current = m_slots[slot];
+			if (current.index < 0) {
+				current.key = key;
+				current.index = newIndex;
+				++m_count;
+				outIndex = newIndex;
+				return true;
+			}
+			if (current.key.pos == key.pos && current.key.uv == key.uv && current.key.nrm == key.nrm) {
+				outIndex = current.index;
+				return false;
+			}
+			slot = (slot + 1) & m_mask;
+		}
+	}
+
+	/**
+	 * @brief Gets the number of keys stored in the table.
+	 * @return size_t The number of unique keys.
+	 */
+	size_t
+	size() const { return m_count; }
+
+private:
+	/**
+	 * @brief A bucket of the table. An index below zero marks an empty slot.
+	 */
+	struct
+	Slot {
+		VertexKey key;
+		int index;
+	};
+
+	/**
+	 * @brief Mixes the three indices of a key into a well distributed hash.
+	 */
+	static size_t
+	hash(const VertexKey& key) {
+		unsigned int h = static_cast<unsigned int>(key.pos) * 0x9E3779B1u;
+		h ^= static_cast<unsigned int>(key.uv) * 0x85EBCA77u;
+		h ^= static_cast<unsigned int>(key.nrm) * 0xC2B2AE3Du;
+		h ^= h >> 16;
+		h *= 0x7FEB352Du;
+		h ^= h >> 15;
+		return h;
+	}
+
+	/**
+	 * @brief Doubles the number of slots and reinserts every key.
+	 */
+	void
+	grow();
+
+private:
+	/** @brief The buckets of the table, always a power of two in size. */
+	std::vector<Slot> m_slots;
+
+	/** @brief m_slots.size() - 1, used to wrap the probe sequence. */
+	size_t m_mask = 0;
+
+	/** @brief The number of occupied slots. */
+	size_t m_count = 0;
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include "Prerequisites.h"
+
+class MeshComponent;
+
+/**
+ * @enum VertexFormat
+ * @brief The vertex layouts a MeshComponent can be uploaded with.
+ */
+enum
+VertexFormat {
+	VERTEX_FORMAT_FULL = 0,     ///< SimpleVertex, 32-bit floats.
+	VERTEX_FORMAT_QUANTIZED = 1 ///< QuantizedVertex, 16-bit positions, half-float UVs, octahedral normals.
+};
+
+/**
+ * @struct VertexElement
+ * @brief A platform-independent description of one vertex attribute.
+ *
+ * Maps one to one to a D3D11_INPUT_ELEMENT_DESC with per-vertex data in slot 0.
+ */
+struct
+VertexElement {
+	/** @brief The HLSL semantic (e.g. "POSITION"). */
+	const char* semanticName;
+
+	/** @brief The semantic index. */
+	unsigned int semanticIndex;
+
+	/** @brief The format of the attribute in the vertex buffer. */
+	DXGI_FORMAT format;
+
+	/** @brief The offset of the attribute from the start of the vertex. */
+	unsigned int alignedByteOffset;
+};
+
+/**
+ * @struct QuantizationReport
+ * @brief The precision and memory cost of quantizing a mesh.
+ */
+struct
+QuantizationReport {
+	/** @brief Largest distance between an original and a decoded position, in model units. */
+	float maxPositionError = 0.0f;
+
+	/** @brief Root mean square of the position errors, in model units. */
+	float rmsPositionError = 0.0f;
+
+	/** @brief Largest per-component error of the decoded texture coordinates. */
+	float maxTexError = 0.0f;
+
+	/** @brief Largest angle between an original and a decoded normal, in degrees. */
+	float maxNormalError = 0.0f;
+
+	/** @brief Largest angle between an original and a decoded tangent, in degrees. */
+	float maxTangentError = 0.0f;
+
+	/** @brief Size of the vertex stream before quantizing. */
+	size_t bytesBefore = 0;
+
+	/** @brief Size of the vertex stream after quantizing. */
+	size_t bytesAfter = 0;
+};
+
+/**
+ * @class VertexQuantizer
+ * @brief Encodes SimpleVertex streams into the compressed QuantizedVertex format.
+ * @author Ricardo Rabell
+ * @date 2026-10-15
+ *
+ * Positions are stored as 16-bit UNORM values relative to the bounding box of
+ * the mesh and texture coordinates as half floats. The GPU expands UNORM to
+ * [0, 1], so a quantized mesh is drawn with getDequantizeScale() and
+ * getDequantizeOffset() applied before its world transform.
+ *
+ * Normals and tangents are unit vectors, so they are folded onto an octahedron
+ * and stored as its two coordinates (16-bit SNORM for the normal, 8-bit SNORM
+ * for the tangent). The vertex shader unfolds them with decodeOctahedral().
+ */
+class
+VertexQuantizer {
+public:
+	/**
+	 * @brief Quantizes the vertices of a mesh into mesh.m_quantizedVertex.
+	 * @note Works with memory-mapped meshes, the original vertices are kept.
+	 * The bounds of the mesh are recomputed first, since they define the
+	 * quantization grid.
+	 * @param mesh The mesh to quantize.
+	 * @param outReport Optional, receives the error and size of the result.
+	 */
+	static void
+	quantize(MeshComponent& mesh, QuantizationReport* outReport = nullptr);
+
+	/**
+	 * @brief Gets the scale that maps decoded [0, 1] positions back to model space.
+	 * @param mesh A quantized mesh.
+	 * @return XMFLOAT3 The size of the bounding box of the mesh.
+	 */
+	static XMFLOAT3
+	getDequantizeScale(const MeshComponent& mesh);
+
+	/**
+	 * @brief Gets the offset added to the scaled positions to get model space.
+	 * @param mesh A quantized mesh.
+	 * @return XMFLOAT3 The minimum corner of the bounding box of the mesh.
+	 */
+	static XMFLOAT3
+	getDequantizeOffset(const MeshComponent& mesh);
+
+	/**
+	 * @brief Gets the input layout of a vertex format.
+	 * @param format The vertex format.
+	 * @return std::vector<VertexElement> One element per attribute.
+	 */
+	static std::vector<VertexElement>
+	getInputLayout(VertexFormat format);
+
+	/**
+	 * @brief Gets the size in bytes of one vertex of a format.
+	 * @param format The vertex format.
+	 * @return unsigned int The vertex stride.
+	 */
+	static unsigned int
+	getVertexStride(VertexFormat format);
+
+	/**
+	 * @brief Maps a unit vector to its octahedral coordinates.
+	 * @param v The vector to encode, it doesn't need to be normalized.
+	 * @return XMFLOAT2 Coordinates in [-1, 1].
+	 */
+	static XMFLOAT2
+	encodeOctahedral(const XMFLOAT3& v);
+
+	/**
+	 * @brief Maps octahedral coordinates back to a unit vector.
+	 * @param e Coordinates in [-1, 1].
+	 * @return XMFLOAT3 The decoded unit vector.
+	 */
+	static XMFLOAT3
+	decodeOctahedral(const XMFLOAT2& e);
+
+	/**
+	 * @brief Converts a float to an IEEE 754 half float, rounding to nearest even.
+	 * @param value The value to convert. Out of range values become infinity.
+	 * @return unsigned short The bits of the half float.
+	 */
+	static unsigned short
+	floatToHalf(float value);
+
+	/**
+	 * @brief Converts an IEEE 754 half float to a float.
+	 * @param value The bits of the half float.
+	 * @return float The converted value.
+	 */
+	static float
+	halfToFloat(unsigned short value);
+};
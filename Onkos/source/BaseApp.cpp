@@ -95,27 +95,20 @@ BaseApp::init() {
 
     // Load Resources
 
-    // Define the input layout
+    // Define the input layout of the vertex format the mesh will be uploaded with
+    const VertexFormat vertexFormat = m_useQuantizedVertices ? VERTEX_FORMAT_QUANTIZED : VERTEX_FORMAT_FULL;
     std::vector<D3D11_INPUT_ELEMENT_DESC> layout;
-    D3D11_INPUT_ELEMENT_DESC position;
-    position.SemanticName = "POSITION";
-    position.SemanticIndex = 0;
-    position.Format = DXGI_FORMAT_R32G32B32_FLOAT;
-    position.InputSlot = 0;
-    position.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT /*0*/;
-    position.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-    position.InstanceDataStepRate = 0;
-    layout.push_back(position);
-
-    D3D11_INPUT_ELEMENT_DESC texcoord;
-    texcoord.SemanticName = "TEXCOORD";
-    texcoord.SemanticIndex = 0;
-    texcoord.Format = DXGI_FORMAT_R32G32B32_FLOAT;
-    texcoord.InputSlot = 0;
-    texcoord.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT /*0*/;
-    texcoord.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-    texcoord.InstanceDataStepRate = 0;
-    layout.push_back(texcoord);
+    for (const VertexElement& element : VertexQuantizer::getInputLayout(vertexFormat)) {
+      D3D11_INPUT_ELEMENT_DESC desc;
+      desc.SemanticName = element.semanticName;
+      desc.SemanticIndex = element.semanticIndex;
+      desc.Format = element.format;
+      desc.InputSlot = 0;
+      desc.AlignedByteOffset = element.alignedByteOffset;
+      desc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+      desc.InstanceDataStepRate = 0;
+      layout.push_back(desc);
+    }
 
      // Create the Shader Program
     hr = m_shaderProgram.init(m_device, "Onkos.fx", layout);
@@ -125,30 +118,25 @@ BaseApp::init() {
       return hr;
     }
 
-    bool loadSuccess = m_modelLoader.loadModel("test.obj", m_mesh);
-
-    if (!loadSuccess)
-    {
-      ERROR("BaseApp.cpp", "init", "Failed to load model .obj");
-      return E_FAIL;
+    // The material textures start with their small levels and stream the
+    // finer ones in as they grow on screen
+    m_materialTextures.init(m_device);
+    m_textureStreamer.init(m_materialTextures);
+
+    // Every mesh and texture is created through the resource manager, the
+    // cooked mesh below included
+    m_resourceManager.init(m_device);
+
+    // The cooked mesh maps in a few milliseconds. Parsing the source file runs
+    // in the background instead, and update() uploads its meshes as they arrive
+    if (m_modelLoader.loadModel("test.onkmesh", m_mesh)) {
+      hr = uploadMesh();
+      if (FAILED(hr)) {
+        return hr;
+      }
     }
-
-    // Create vertex buffer
-    hr = m_vertexBuffer.init(m_device, m_mesh, D3D11_BIND_VERTEX_BUFFER);
-
-    if (FAILED(hr)) {
-      ERROR("Main", "InitDevice",
-        ("Failed to initialize VertexBuffer. HRESULT: " + std::to_string(hr)).c_str());
-      return hr;
-    }
-
-    // Create index buffer
-    hr = m_indexBuffer.init(m_device, m_mesh, D3D11_BIND_INDEX_BUFFER);
-
-    if (FAILED(hr)) {
-      ERROR("Main", "InitDevice",
-        ("Failed to initialize IndexBuffer. HRESULT: " + std::to_string(hr)).c_str());
-      return hr;
+    else {
+      m_meshLoad = m_modelLoader.loadModelAsync("test.obj");
     }
 
     // Set primitive topology
@@ -169,15 +157,18 @@ BaseApp::init() {
       return hr;
     }
 
-    hr = m_cbChangesEveryFrame.init(m_device, sizeof(CBChangesEveryFrame));
+    // The per-object constants are written into ranges of one dynamic buffer
+    hr = m_constantRing.init(m_device, m_deviceContext);
     if (FAILED(hr)) {
       ERROR("Main", "InitDevice",
-        ("Failed to initialize ChangesEveryFrame Buffer. HRESULT: " + std::to_string(hr)).c_str());
+        ("Failed to initialize the constant buffer ring. HRESULT: " + std::to_string(hr)).c_str());
       return hr;
     }
 
     //hr = m_textureCube.init(m_device, "seafloor", ExtensionType::DDS);
-		hr = m_textureCube.init(m_device, "Cracked2", ExtensionType::PNG);
+    // Staging prefers the texture cooked by OnkosCooker over decoding the PNG
+    m_textureCube = m_resourceManager.acquireTexture("Cracked2.png");
+    hr = m_textureCube ? S_OK : E_FAIL;
 
     // Load the Texture
     if (FAILED(hr)) {
@@ -199,6 +190,7 @@ BaseApp::init() {
 
     // Initialize the view matrix
     XMVECTOR Eye = XMVectorSet(0.0f, 3.0f, -6.0f, 0.0f);
+    XMStoreFloat3(&m_eyePosition, Eye);
     XMVECTOR At = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
     XMVECTOR Up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
     m_View = XMMatrixLookAtLH(Eye, At, Up);
@@ -215,6 +207,34 @@ BaseApp::init() {
 }
 
 void BaseApp::update(float deltaTime) {
+  // Swap in the newest mesh of the background load, if any. The stage is read
+  // first: a finished load already published its final mesh, which is taken
+  // with a blocking lock so it can't be lost when the request is released
+  if (m_meshLoad) {
+    const bool finished = m_meshLoad->isFinished();
+    if (m_meshLoad->takeMesh(m_mesh, finished) && SUCCEEDED(uploadMesh())) {
+      std::wostringstream os;
+      os << L"BaseApp::update : Mesh " << m_mesh.getIndexCount() / 3 << L" triangles at "
+         << m_meshLoad->getProgress() * 100.0f << L"%, first mesh after "
+         << m_meshLoad->getFirstMeshSeconds() << L" s\n";
+      OutputDebugStringW(os.str().c_str());
+    }
+    if (finished) {
+      if (m_meshLoad->getStage() == MODEL_LOAD_FAILED) {
+        ERROR("BaseApp.cpp", "update", "Failed to load model .obj");
+      }
+      else {
+        std::wostringstream os;
+        os << L"BaseApp::update : Model loaded in " << m_meshLoad->getTotalSeconds() << L" s\n";
+        OutputDebugStringW(os.str().c_str());
+      }
+      m_meshLoad.reset();
+    }
+  }
+
+  // Stream in the material textures the workers staged since the last frame
+  updateMaterialTextures();
+
   // Update our time
   static float t = 0.0f;
   if (m_swapChain.m_driverType == D3D_DRIVER_TYPE_REFERENCE)
@@ -248,13 +268,48 @@ void BaseApp::update(float deltaTime) {
 
   // Rotate cube around the origin
   m_World = XMMatrixRotationY(t);
-  cb.mWorld = XMMatrixTranspose(m_World);
+  cb.mWorld = XMMatrixTranspose(m_dequantize * m_World);
   cb.vMeshColor = m_vMeshColor;
-  m_cbChangesEveryFrame.update(m_deviceContext, nullptr, 0, nullptr, &cb, 0, 0);
+
+  // Pick the level of detail from the error it would show on screen, measured
+  // from the point of the bounding sphere closest to the camera
+  XMVECTOR boundsMin = XMLoadFloat3(&m_mesh.m_boundsMin);
+  XMVECTOR boundsMax = XMLoadFloat3(&m_mesh.m_boundsMax);
+  XMVECTOR center = XMVector3Transform((boundsMin + boundsMax) * 0.5f, m_World);
+  float radius = XMVectorGetX(XMVector3Length(boundsMax - boundsMin)) * 0.5f;
+  float distance = XMVectorGetX(XMVector3Length(center - XMLoadFloat3(&m_eyePosition))) - radius;
+  float pixelsPerUnit = m_window.m_height / (2.0f * tanf(XM_PIDIV4 * 0.5f));
+  m_lod = MeshSimplifier::selectLod(m_mesh, distance > 0.01f ? distance : 0.01f, pixelsPerUnit);
+
+  // Every material drawn this frame wants the level that matches the size
+  // of the mesh on screen
+  const float screenSize = 2.0f * radius * pixelsPerUnit / (distance > 0.01f ? distance : 0.01f);
+  MeshLod lod = m_mesh.getLod(m_lod);
+  for (unsigned int i = 0; i < lod.subMeshCount; ++i) {
+    const unsigned int materialId = m_mesh.m_subMeshes[lod.firstSubMesh + i].materialId;
+    if (materialId < m_materialTextureIds.size()) {
+      m_textureStreamer.reportUsage(m_materialTextureIds[materialId], screenSize);
+    }
+  }
+  m_textureStreamer.update();
+
+  const TextureStreamingStats stats = m_textureStreamer.getStats();
+  if (stats.uploadCount > 0 || stats.evictionCount > 0) {
+    std::wostringstream os;
+    os << L"BaseApp::update : Textures " << stats.residentBytes / 1024 << L"/" << stats.budgetBytes / 1024
+       << L" KB resident (" << stats.wantedBytes / 1024 << L" KB wanted), " << stats.uploadCount
+       << L" uploads, " << stats.evictionCount << L" evictions, " << stats.pendingCount
+       << L" pending, latency " << stats.averageLatencyFrames << L" frames / "
+       << stats.averageLatencySeconds << L" s on average\n";
+    OutputDebugStringW(os.str().c_str());
+  }
 }
 
 void
 BaseApp::render() {
+  // Recycle the constants of the frames the GPU finished
+  m_constantRing.beginFrame(m_deviceContext);
+
   // Set Render Target View
   float ClearColor[4] = { 0.1f, 0.1f, 0.1f, 1.0f };
   m_renderTargetView.render(m_deviceContext, m_depthStencilView, 1, ClearColor);
@@ -271,19 +326,41 @@ BaseApp::render() {
 
   // Render the cube
   // Asignar buffers Vertex e Index
-  m_vertexBuffer.render(m_deviceContext, 0, 1);
-  m_indexBuffer.render(m_deviceContext, 0, 1, false, DXGI_FORMAT_R32_UINT);
+  if (m_meshBuffers) {
+    m_meshBuffers->vertexBuffer.render(m_deviceContext, 0, 1);
+    m_meshBuffers->indexBuffer.render(m_deviceContext, 0, 1);
+  }
 
   // Asignar buffers constantes
   m_cbNeverChanges.render(m_deviceContext, 0, 1);
   m_cbChangeOnResize.render(m_deviceContext, 1, 1);
-  m_cbChangesEveryFrame.render(m_deviceContext, 2, 1);
-  m_cbChangesEveryFrame.render(m_deviceContext, 2, 1, true);
+  m_constantRing.bind(m_deviceContext, 2, &cb, sizeof(cb), true);
 
   // Asignar textura y sampler
-  m_textureCube.render(m_deviceContext, 0, 1);
+  m_textureCube->texture.render(m_deviceContext, 0, 1);
   m_samplerState.render(m_deviceContext, 0, 1);
-  m_deviceContext.DrawIndexed(m_mesh.m_numIndex, 0, 0);
+  if (m_mesh.getIndexCount() == 0 || !m_meshBuffers) {
+    // Nothing loaded yet
+  }
+  else if (m_mesh.m_subMeshes.empty()) {
+    m_deviceContext.DrawIndexed(m_mesh.m_numIndex, 0, 0);
+  }
+  else {
+    // Every submesh shares the buffers bound above. They are sorted by
+    // material, so the material state only changes between runs
+    MeshLod lod = m_mesh.getLod(m_lod);
+    unsigned int boundMaterial = UINT_MAX;
+    for (unsigned int i = 0; i < lod.subMeshCount; ++i) {
+      const SubMesh& subMesh = m_mesh.m_subMeshes[lod.firstSubMesh + i];
+      if (subMesh.materialId != boundMaterial) {
+        bindMaterial(subMesh.materialId);
+        boundMaterial = subMesh.materialId;
+      }
+      m_deviceContext.DrawIndexed(subMesh.indexCount, subMesh.startIndex, subMesh.baseVertex);
+    }
+  }
+
+  m_constantRing.endFrame(m_deviceContext);
 
   //
   // Present our back buffer to our front buffer
@@ -293,16 +370,35 @@ BaseApp::render() {
 
 void
 BaseApp::destroy() {
+  if (m_meshLoad) {
+    m_meshLoad->cancel();
+    m_meshLoad.reset();
+  }
   if (m_deviceContext.m_deviceContext) m_deviceContext.m_deviceContext->ClearState();
   
   m_samplerState.destroy();
-  m_textureCube.destroy();
+  m_textureCube.reset();
+  if (m_materialBatch) {
+    m_materialBatch->cancel();
+    m_materialBatch.reset();
+  }
+  m_textureStreamer.destroy();
+  m_materialTextures.destroy();
+  m_materialTextureIds.clear();
 
   m_cbNeverChanges.destroy();
   m_cbChangeOnResize.destroy();
-  m_cbChangesEveryFrame.destroy();
-  m_vertexBuffer.destroy();
-  m_indexBuffer.destroy();
+  const ConstantBufferRingStats ringStats = m_constantRing.getStats();
+  std::wostringstream os;
+  os << L"BaseApp::destroy : Constants " << ringStats.bindCount << L" blocks, "
+     << ringStats.bytesWritten / 1024 << L" KB, " << (ringStats.offsetBinding ? L"bound by offset, peak " : L"bound by slot, peak ")
+     << ringStats.ring.peakBytes / 1024 << L"/" << ringStats.ring.capacity / 1024 << L" KB, "
+     << ringStats.waitCount << L" waits, " << ringStats.overflowCount << L" overflows\n";
+  OutputDebugStringW(os.str().c_str());
+  m_constantRing.destroy();
+  // The shared resources are released with their last handle, before the device
+  m_meshBuffers.reset();
+  m_resourceManager.destroy();
   m_shaderProgram.destroy();
   m_depthStencil.destroy();
   m_depthStencilView.destroy();
@@ -313,6 +409,144 @@ BaseApp::destroy() {
   m_device.destroy();
 }
 
+HRESULT
+BaseApp::uploadMesh() {
+  // Compress the vertices; the decoded [0, 1] positions are mapped back to
+  // model space by m_dequantize, applied before the world matrix
+  m_dequantize = XMMatrixIdentity();
+  if (m_useQuantizedVertices) {
+    QuantizationReport report;
+    VertexQuantizer::quantize(m_mesh, &report);
+
+    XMFLOAT3 scale = VertexQuantizer::getDequantizeScale(m_mesh);
+    XMFLOAT3 offset = VertexQuantizer::getDequantizeOffset(m_mesh);
+    m_dequantize = XMMatrixScaling(scale.x, scale.y, scale.z) *
+                   XMMatrixTranslation(offset.x, offset.y, offset.z);
+
+    std::wostringstream os;
+    os << L"BaseApp::uploadMesh : Quantized vertices " << report.bytesBefore << L" -> "
+       << report.bytesAfter << L" bytes, max position error " << report.maxPositionError
+       << L", max UV error " << report.maxTexError << L", max normal error "
+       << report.maxNormalError << L" deg\n";
+    OutputDebugStringW(os.str().c_str());
+  }
+
+  // Create the vertex and index buffers, or share the ones of an identical
+  // mesh (the preview and the final mesh often match). The previous buffers
+  // are released with their handle
+  m_meshBuffers = m_resourceManager.acquireMesh(m_mesh);
+  if (!m_meshBuffers) {
+    ERROR("BaseApp", "uploadMesh", "Failed to initialize the vertex and index buffers.");
+    return E_FAIL;
+  }
+
+  // The preview and the final mesh of a load share their materials, only a
+  // new list of maps loads the textures again
+  bool mapsChanged = m_materialMaps.size() != m_mesh.m_materials.size();
+  for (size_t i = 0; i < m_mesh.m_materials.size() && !mapsChanged; ++i) {
+    mapsChanged = m_materialMaps[i] != m_mesh.m_materials[i].diffuseMap;
+  }
+  if (mapsChanged) {
+    loadMaterialTextures();
+  }
+
+  const ResourceCacheStats meshStats = m_resourceManager.getMeshStats();
+  std::wostringstream os;
+  os << L"BaseApp::uploadMesh : Shared meshes " << meshStats.liveCount << L" live ("
+     << meshStats.liveBytes << L" bytes), hit rate " << meshStats.getHitRate() * 100.0
+     << L"%, " << meshStats.bytesSaved << L" bytes saved\n";
+  OutputDebugStringW(os.str().c_str());
+  return S_OK;
+}
+
+void
+BaseApp::loadMaterialTextures() {
+  // One texture per material with a diffuse map, the others use m_textureCube
+  // until theirs is streamed in. A map that fails to load only costs its texture
+  if (m_materialBatch) {
+    m_materialBatch->cancel();
+    m_materialBatch.reset();
+  }
+  for (StreamedTextureId id : m_materialTextureIds) {
+    m_textureStreamer.removeTexture(id);
+  }
+  m_materialTextureIds.assign(m_mesh.m_materials.size(), kInvalidStreamedTexture);
+  m_materialMaps.resize(m_mesh.m_materials.size());
+  for (size_t i = 0; i < m_mesh.m_materials.size(); ++i) {
+    m_materialMaps[i] = m_mesh.m_materials[i].diffuseMap;
+  }
+
+  // The maps are decoded (or, for DDS/KTX2, mapped) on the workers and
+  // update() streams them in as they finish. Materials that share a map share
+  // its texture, so every map is decoded and streamed once
+  std::vector<std::string> fileNames;
+  std::unordered_map<std::string, size_t> mapIndices;
+  m_batchMaterialIds.clear();
+  for (size_t i = 0; i < m_materialMaps.size(); ++i) {
+    if (m_materialMaps[i].empty()) {
+      continue;
+    }
+    auto inserted = mapIndices.emplace(m_materialMaps[i], fileNames.size());
+    if (inserted.second) {
+      fileNames.push_back(m_materialMaps[i]);
+      m_batchMaterialIds.emplace_back();
+    }
+    m_batchMaterialIds[inserted.first->second].push_back(i);
+  }
+  if (!fileNames.empty()) {
+    m_materialBatch = m_textureLoader.loadBatchAsync(fileNames);
+  }
+}
+
+void
+BaseApp::updateMaterialTextures() {
+  if (!m_materialBatch) {
+    return;
+  }
+  std::vector<StagedBatchTexture> staged;
+  m_materialBatch->takeStaged(staged);
+  for (StagedBatchTexture& texture : staged) {
+    if (!texture.texture) {
+      continue;
+    }
+    // The streamer keeps the CPU copy to upload finer levels later
+    const StreamedTextureId id = m_textureStreamer.addTexture(std::move(texture.texture));
+    for (size_t materialId : m_batchMaterialIds[texture.index]) {
+      m_materialTextureIds[materialId] = id;
+    }
+  }
+
+  if (m_materialBatch->isFinished()) {
+    size_t loadedCount = 0;
+    for (const std::vector<size_t>& materialIds : m_batchMaterialIds) {
+      loadedCount += m_materialTextureIds[materialIds[0]] != kInvalidStreamedTexture ? 1 : 0;
+    }
+    std::wostringstream os;
+    os << L"BaseApp::updateMaterialTextures : " << loadedCount << L"/" << m_materialBatch->getFileCount()
+       << L" material textures in " << m_materialBatch->getElapsedSeconds() << L" s, staged on the workers\n";
+    OutputDebugStringW(os.str().c_str());
+    m_materialBatch.reset();
+  }
+}
+
+void
+BaseApp::bindMaterial(unsigned int materialId) {
+  const bool hasMaterial = materialId < m_mesh.m_materials.size();
+  Texture* streamed = materialId < m_materialTextureIds.size() ?
+    m_materialTextures.getTexture(m_materialTextureIds[materialId]) : nullptr;
+  Texture& texture = streamed ? *streamed : m_textureCube->texture;
+  texture.render(m_deviceContext, 0, 1);
+
+  // The material color tints m_vMeshColor
+  const XMFLOAT3 diffuse = hasMaterial ? m_mesh.m_materials[materialId].diffuse : XMFLOAT3(1.0f, 1.0f, 1.0f);
+  const float opacity = hasMaterial ? m_mesh.m_materials[materialId].opacity : 1.0f;
+  cb.vMeshColor = XMFLOAT4(m_vMeshColor.x * diffuse.x,
+                           m_vMeshColor.y * diffuse.y,
+                           m_vMeshColor.z * diffuse.z,
+                           opacity);
+  m_constantRing.bind(m_deviceContext, 2, &cb, sizeof(cb), true);
+}
+
 LRESULT 
 BaseApp::wndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
   switch (message)
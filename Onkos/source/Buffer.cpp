@@ -8,33 +8,49 @@ Buffer::init(Device& device, const MeshComponent& mesh, unsigned int bindFlag) {
 		ERROR("ShaderProgram", "init", "Device is null.");
 		return E_POINTER;
 	}
-	if ((bindFlag & D3D11_BIND_VERTEX_BUFFER) && mesh.m_vertex.empty()) {
+	if ((bindFlag & D3D11_BIND_VERTEX_BUFFER) && mesh.getVertexCount() == 0) {
 		ERROR("Buffer", "init", "Vertex buffer is empty");
 		return E_INVALIDARG;
 	}
-	if ((bindFlag & D3D11_BIND_INDEX_BUFFER) && mesh.m_index.empty()) {
+	if ((bindFlag & D3D11_BIND_INDEX_BUFFER) && mesh.getIndexCount() == 0) {
 		ERROR("Buffer", "init", "Index buffer is empty");
 		return E_INVALIDARG;
 	}
 
 	D3D11_BUFFER_DESC desc = {};
 	D3D11_SUBRESOURCE_DATA data = {};
+	std::vector<unsigned short> indices16;
 
 	desc.Usage = D3D11_USAGE_DEFAULT;
 	desc.CPUAccessFlags = 0;
 	m_bindFlag = bindFlag;
 
 	if (bindFlag & D3D11_BIND_VERTEX_BUFFER) {
-		m_stride = sizeof(SimpleVertex);
-		desc.ByteWidth = m_stride * static_cast<unsigned int>(mesh.m_vertex.size());
+		m_stride = VertexQuantizer::getVertexStride(mesh.getVertexFormat());
+		desc.ByteWidth = m_stride * static_cast<unsigned int>(mesh.getVertexCount());
 		desc.BindFlags = (D3D11_BIND_FLAG)bindFlag;
-		data.pSysMem = mesh.m_vertex.data();
+		if (mesh.getVertexFormat() == VERTEX_FORMAT_QUANTIZED) {
+			data.pSysMem = mesh.m_quantizedVertex.data();
+		}
+		else {
+			data.pSysMem = mesh.getVertexData();
+		}
 	}
 	else if (bindFlag & D3D11_BIND_INDEX_BUFFER) {
-		m_stride = sizeof(unsigned int);
-		desc.ByteWidth = m_stride * static_cast<unsigned int>(mesh.m_index.size());
+		m_indexFormat = mesh.getIndexFormat();
+		if (m_indexFormat == DXGI_FORMAT_R16_UINT) {
+			// Half the memory and bandwidth of 32-bit indices
+			const unsigned int* indices = mesh.getIndexData();
+			indices16.assign(indices, indices + mesh.getIndexCount());
+			m_stride = sizeof(unsigned short);
+			data.pSysMem = indices16.data();
+		}
+		else {
+			m_stride = sizeof(unsigned int);
+			data.pSysMem = mesh.getIndexData();
+		}
+		desc.ByteWidth = m_stride * static_cast<unsigned int>(mesh.getIndexCount());
 		desc.BindFlags = (D3D11_BIND_FLAG)bindFlag;
-		data.pSysMem = mesh.m_index.data();
 	}
 
 	return createBuffer(device, desc, &data);
@@ -111,7 +127,9 @@ Buffer::render(DeviceContext& deviceContext,
 		}
 		break;
 	case D3D11_BIND_INDEX_BUFFER:
-		deviceContext.m_deviceContext->IASetIndexBuffer(m_buffer, format, m_offset);
+		deviceContext.m_deviceContext->IASetIndexBuffer(m_buffer,
+			format != DXGI_FORMAT_UNKNOWN ? format : m_indexFormat,
+			m_offset);
 		break;
 	default:
 		ERROR("Buffer", "render", "Unsupported BindFlag");
@@ -0,0 +1,231 @@
+#include "ConstantBufferRing.h"
+#include "Device.h"
+#include "DeviceContext.h"
+#include <cstring>
+#include <d3d11_1.h>
+
+// Offsets and sizes of the bound ranges are counted in constants of 16 bytes,
+// and must be multiples of 16 constants
+static const unsigned int kRangeAlignment = 256;
+static const unsigned int kConstantSize = 16;
+static const unsigned int kMaxBlockSize = D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT * kConstantSize;
+
+HRESULT
+ConstantBufferRing::init(Device& device, DeviceContext& deviceContext, unsigned int capacity) {
+	if (!device.m_device || !deviceContext.m_deviceContext) {
+		ERROR("ConstantBufferRing", "init", "Device or DeviceContext is null.");
+		return E_POINTER;
+	}
+	destroy();
+	m_device = &device;
+	m_stats = ConstantBufferRingStats();
+
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if (SUCCEEDED(device.m_device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) &&
+			options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer &&
+			SUCCEEDED(deviceContext.m_deviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1),
+				reinterpret_cast<void**>(&m_deviceContext1)))) {
+		D3D11_BUFFER_DESC desc = {};
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.ByteWidth = capacity < kMaxBlockSize ? kMaxBlockSize : capacity & ~(kRangeAlignment - 1);
+		desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		HRESULT hr = device.CreateBuffer(&desc, nullptr, &m_buffer);
+		if (SUCCEEDED(hr) && m_allocator.init(desc.ByteWidth, kRangeAlignment)) {
+			m_firstMap = true;
+			m_stats.offsetBinding = true;
+			return S_OK;
+		}
+		ERROR("ConstantBufferRing", "init", "Failed to create the ring buffer, binding by slot instead.");
+		SAFE_RELEASE(m_buffer);
+		SAFE_RELEASE(m_deviceContext1);
+	}
+	return S_OK;
+}
+
+void
+ConstantBufferRing::beginFrame(DeviceContext& deviceContext) {
+	retireFrames(deviceContext, false);
+}
+
+bool
+ConstantBufferRing::bind(DeviceContext& deviceContext,
+												 unsigned int StartSlot,
+												 const void* pData,
+												 unsigned int byteWidth,
+												 bool setPixelShader) {
+	if (!deviceContext.m_deviceContext || !pData) {
+		ERROR("ConstantBufferRing", "bind", "DeviceContext or pData is null.");
+		return false;
+	}
+	if (StartSlot >= D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT || byteWidth == 0 || byteWidth > kMaxBlockSize) {
+		ERROR("ConstantBufferRing", "bind", "The slot or the size is out of range.");
+		return false;
+	}
+	++m_stats.bindCount;
+	m_stats.bytesWritten += byteWidth;
+
+	if (m_buffer) {
+		// A full ring waits for the GPU to finish the oldest frame
+		uint64_t offset = 0;
+		bool allocated = m_allocator.allocate(byteWidth, offset);
+		while (!allocated && m_allocator.hasPendingFrames()) {
+			++m_stats.waitCount;
+			retireFrames(deviceContext, true);
+			allocated = m_allocator.allocate(byteWidth, offset);
+		}
+		if (allocated) {
+			D3D11_MAPPED_SUBRESOURCE mapped = {};
+			const D3D11_MAP mapType = m_firstMap ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+			HRESULT hr = deviceContext.m_deviceContext->Map(m_buffer, 0, mapType, 0, &mapped);
+			if (FAILED(hr)) {
+				ERROR("ConstantBufferRing", "bind", "Failed to map the ring buffer.");
+				return false;
+			}
+			m_firstMap = false;
+			memcpy(static_cast<unsigned char*>(mapped.pData) + offset, pData, byteWidth);
+			deviceContext.m_deviceContext->Unmap(m_buffer, 0);
+
+			const unsigned int firstConstant = static_cast<unsigned int>(offset / kConstantSize);
+			const unsigned int numConstants = (byteWidth + kRangeAlignment - 1) / kRangeAlignment * (kRangeAlignment / kConstantSize);
+			m_deviceContext1->VSSetConstantBuffers1(StartSlot, 1, &m_buffer, &firstConstant, &numConstants);
+			if (setPixelShader) {
+				m_deviceContext1->PSSetConstantBuffers1(StartSlot, 1, &m_buffer, &firstConstant, &numConstants);
+			}
+			return true;
+		}
+		// Larger than the ring itself
+		++m_stats.overflowCount;
+	}
+	return bindDiscard(deviceContext, StartSlot, pData, byteWidth, setPixelShader);
+}
+
+void
+ConstantBufferRing::endFrame(DeviceContext& deviceContext) {
+	if (!m_buffer || !deviceContext.m_deviceContext) {
+		return;
+	}
+	ID3D11Query* query = nullptr;
+	if (!m_freeQueries.empty()) {
+		query = m_freeQueries.back();
+		m_freeQueries.pop_back();
+	}
+	else {
+		D3D11_QUERY_DESC desc = {};
+		desc.Query = D3D11_QUERY_EVENT;
+		if (FAILED(m_device->m_device->CreateQuery(&desc, &query))) {
+			// Without a fence the frame is freed at once and the next map
+			// discards the whole buffer, so the GPU keeps the memory it reads
+			ERROR("ConstantBufferRing", "endFrame", "Failed to create a fence, discarding the ring.");
+			while (!m_pendingFences.empty()) {
+				retireFrames(deviceContext, true);
+			}
+			m_allocator.endFrame(++m_fenceValue);
+			m_allocator.retire(m_fenceValue);
+			m_firstMap = true;
+			return;
+		}
+	}
+	m_allocator.endFrame(++m_fenceValue);
+	deviceContext.m_deviceContext->End(query);
+	m_pendingFences.push_back(Fence{ query, m_fenceValue });
+}
+
+void
+ConstantBufferRing::destroy() {
+	for (const Fence& fence : m_pendingFences) {
+		fence.query->Release();
+	}
+	m_pendingFences.clear();
+	for (ID3D11Query* query : m_freeQueries) {
+		query->Release();
+	}
+	m_freeQueries.clear();
+	for (unsigned int i = 0; i < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; ++i) {
+		SAFE_RELEASE(m_slotBuffers[i]);
+		m_slotSizes[i] = 0;
+	}
+	SAFE_RELEASE(m_buffer);
+	SAFE_RELEASE(m_deviceContext1);
+	m_device = nullptr;
+	m_fenceValue = 0;
+}
+
+ConstantBufferRingStats
+ConstantBufferRing::getStats() const {
+	ConstantBufferRingStats stats = m_stats;
+	stats.ring = m_allocator.getStats();
+	return stats;
+}
+
+bool
+ConstantBufferRing::bindDiscard(DeviceContext& deviceContext,
+																unsigned int StartSlot,
+																const void* pData,
+																unsigned int byteWidth,
+																bool setPixelShader) {
+	ID3D11Buffer*& buffer = m_slotBuffers[StartSlot];
+	if (!buffer || m_slotSizes[StartSlot] < byteWidth) {
+		if (!m_device) {
+			ERROR("ConstantBufferRing", "bind", "The ring isn't initialized.");
+			return false;
+		}
+		SAFE_RELEASE(buffer);
+		D3D11_BUFFER_DESC desc = {};
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.ByteWidth = (byteWidth + kRangeAlignment - 1) / kRangeAlignment * kRangeAlignment;
+		desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		if (FAILED(m_device->CreateBuffer(&desc, nullptr, &buffer))) {
+			ERROR("ConstantBufferRing", "bind", "Failed to create a slot buffer.");
+			m_slotSizes[StartSlot] = 0;
+			return false;
+		}
+		m_slotSizes[StartSlot] = desc.ByteWidth;
+	}
+
+	// The driver hands out new memory for every discard, the GPU keeps reading the old one
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(deviceContext.m_deviceContext->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+		ERROR("ConstantBufferRing", "bind", "Failed to map a slot buffer.");
+		return false;
+	}
+	memcpy(mapped.pData, pData, byteWidth);
+	deviceContext.m_deviceContext->Unmap(buffer, 0);
+
+	deviceContext.m_deviceContext->VSSetConstantBuffers(StartSlot, 1, &buffer);
+	if (setPixelShader) {
+		deviceContext.m_deviceContext->PSSetConstantBuffers(StartSlot, 1, &buffer);
+	}
+	return true;
+}
+
+void
+ConstantBufferRing::retireFrames(DeviceContext& deviceContext, bool wait) {
+	while (!m_pendingFences.empty()) {
+		const Fence fence = m_pendingFences.front();
+		BOOL done = FALSE;
+		HRESULT hr = deviceContext.m_deviceContext->GetData(fence.query, &done, sizeof(done),
+			wait ? 0 : D3D11_ASYNC_GETDATA_DONOTFLUSH);
+		if (hr == S_FALSE && wait) {
+			// Busy-waits on the oldest frame only; the next ones are polled
+			while (hr == S_FALSE) {
+				std::this_thread::yield();
+				hr = deviceContext.m_deviceContext->GetData(fence.query, &done, sizeof(done), 0);
+			}
+		}
+		if (hr != S_OK) {
+			if (FAILED(hr)) {
+				// A lost device never signals; its ranges can't be in use anymore either
+				ERROR("ConstantBufferRing", "retireFrames", "A fence failed.");
+			}
+			else {
+				break;
+			}
+		}
+		m_allocator.retire(fence.value);
+		m_freeQueries.push_back(fence.query);
+		m_pendingFences.pop_front();
+		wait = false;
+	}
+}
@@ -0,0 +1,109 @@
+#include "ContentHash.h"
+#include "MappedFile.h"
+#include <cstring>
+
+static const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+static const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t
+rotateLeft(uint64_t value, int bits) {
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t
+read64(const unsigned char* p) {
+	uint64_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline uint32_t
+read32(const unsigned char* p) {
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline uint64_t
+round64(uint64_t accumulator, uint64_t input) {
+	accumulator += input * kPrime2;
+	accumulator = rotateLeft(accumulator, 31);
+	return accumulator * kPrime1;
+}
+
+static inline uint64_t
+mergeRound(uint64_t accumulator, uint64_t value) {
+	accumulator ^= round64(0, value);
+	return accumulator * kPrime1 + kPrime4;
+}
+
+uint64_t
+ContentHash::compute(const void* data, size_t size, uint64_t seed) {
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	const unsigned char* end = p + size;
+	uint64_t hash;
+
+	if (size >= 32) {
+		// Four independent lanes keep the multipliers busy
+		uint64_t v1 = seed + kPrime1 + kPrime2;
+		uint64_t v2 = seed + kPrime2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - kPrime1;
+		const unsigned char* limit = end - 32;
+		do {
+			v1 = round64(v1, read64(p));
+			v2 = round64(v2, read64(p + 8));
+			v3 = round64(v3, read64(p + 16));
+			v4 = round64(v4, read64(p + 24));
+			p += 32;
+		} while (p <= limit);
+
+		hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+		hash = mergeRound(hash, v1);
+		hash = mergeRound(hash, v2);
+		hash = mergeRound(hash, v3);
+		hash = mergeRound(hash, v4);
+	}
+	else {
+		hash = seed + kPrime5;
+	}
+
+	hash += static_cast<uint64_t>(size);
+
+	while (p + 8 <= end) {
+		hash ^= round64(0, read64(p));
+		hash = rotateLeft(hash, 27) * kPrime1 + kPrime4;
+		p += 8;
+	}
+	if (p + 4 <= end) {
+		hash ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+		hash = rotateLeft(hash, 23) * kPrime2 + kPrime3;
+		p += 4;
+	}
+	while (p < end) {
+		hash ^= (*p) * kPrime5;
+		hash = rotateLeft(hash, 11) * kPrime1;
+		++p;
+	}
+
+	// Final avalanche
+	hash ^= hash >> 33;
+	hash *= kPrime2;
+	hash ^= hash >> 29;
+	hash *= kPrime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+bool
+ContentHash::computeFile(const std::string& fileName, uint64_t& outHash) {
+	MappedFile file;
+	if (!file.init(fileName)) {
+		return false;
+	}
+	outHash = compute(file.data(), file.size());
+	return true;
+}
@@ -0,0 +1,43 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "ImageDecoder.h"
+#include "MappedFile.h"
+#include <cstring>
+
+bool
+ImageDecoder::decodeFile(const std::string& fileName, Image& outImage) {
+	MappedFile file;
+	if (!file.init(fileName)) {
+		return false;
+	}
+	return decodeMemory(file.data(), file.size(), outImage);
+}
+
+bool
+ImageDecoder::decodeMemory(const void* data, size_t size, Image& outImage) {
+	if (!data || size == 0) {
+		ERROR("ImageDecoder", "decodeMemory", "The encoded data is empty.");
+		return false;
+	}
+
+	int width, height, channels;
+	unsigned char* pixels = stbi_load_from_memory(static_cast<const stbi_uc*>(data),
+		static_cast<int>(size),
+		&width,
+		&height,
+		&channels,
+		4); // 4 bytes por pixel (RGBA)
+	if (!pixels) {
+		ERROR("ImageDecoder", "decodeMemory",
+			("Failed to decode image: " + std::string(stbi_failure_reason())).c_str());
+		return false;
+	}
+
+	outImage.width = static_cast<unsigned int>(width);
+	outImage.height = static_cast<unsigned int>(height);
+	outImage.pixels.resize(static_cast<size_t>(width) * height * 4);
+	memcpy(outImage.pixels.data(), pixels, outImage.pixels.size());
+	stbi_image_free(pixels);
+
+	return true;
+}
@@ -0,0 +1,696 @@
+#include "ImageProcessor.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_USE_SSE2 1
+#include <emmintrin.h>
+#include <immintrin.h>
+// AVX2 is compiled for the kernels that use it only, the rest of the build keeps its target
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define IMAGE_USE_AVX2 1
+#define IMAGE_TARGET_AVX2
+#elif defined(__GNUC__)
+#define IMAGE_USE_AVX2 1
+#define IMAGE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// Targets smaller than this are resized on the calling thread
+static const size_t kMinParallelTexels = 64 * 1024;
+static const unsigned int kRowsPerBand = 16;
+
+// Resolution of the linear -> sRGB table, fine enough to round like the exact curve
+static const unsigned int kEncodeTableSize = 16384;
+
+static const float kPi = 3.14159265f;
+
+/**
+ * -1 until the first call picks the supported path.
+ */
+static std::atomic<int> g_kernelPath(-1);
+
+/**
+ * Conversions between 8-bit channels and linear floats, and between 8-bit sRGB and linear.
+ */
+struct
+ProcessorTables {
+	float srgbToLinear[256];
+	float unormToFloat[256];
+	unsigned char linearToSrgb[kEncodeTableSize];
+	int32_t srgbToLinear8[256];
+	int32_t linearToSrgb8[256];
+
+	ProcessorTables() {
+		for (int i = 0; i < 256; ++i) {
+			const float value = i / 255.0f;
+			srgbToLinear[i] = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+			unormToFloat[i] = value;
+		}
+		for (unsigned int i = 0; i < kEncodeTableSize; ++i) {
+			const float linear = static_cast<float>(i) / (kEncodeTableSize - 1);
+			const float value = linear <= 0.0031308f ? linear * 12.92f : 1.055f * powf(linear, 1.0f / 2.4f) - 0.055f;
+			linearToSrgb[i] = static_cast<unsigned char>(value * 255.0f + 0.5f);
+		}
+		for (int i = 0; i < 256; ++i) {
+			srgbToLinear8[i] = static_cast<int32_t>(srgbToLinear[i] * 255.0f + 0.5f);
+			linearToSrgb8[i] = linearToSrgb[static_cast<unsigned int>(unormToFloat[i] * (kEncodeTableSize - 1) + 0.5f)];
+		}
+	}
+};
+
+static const ProcessorTables&
+getTables() {
+	static const ProcessorTables tables;
+	return tables;
+}
+
+static bool
+detectAvx2() {
+#if IMAGE_USE_AVX2
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	// The OS must save the YMM registers too
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+#else
+	return false;
+#endif
+}
+
+//--------------------------------------------------------------------------------------
+// Resize
+//--------------------------------------------------------------------------------------
+
+static float
+sinc(float x) {
+	const float pix = kPi * x;
+	return fabsf(pix) < 1e-6f ? 1.0f : sinf(pix) / pix;
+}
+
+static float
+getFilterSupport(ResizeFilter filter) {
+	switch (filter) {
+	case RESIZE_FILTER_BOX:
+		return 0.5f;
+	case RESIZE_FILTER_TRIANGLE:
+		return 1.0f;
+	case RESIZE_FILTER_CUBIC:
+		return 2.0f;
+	default:
+		return 3.0f;
+	}
+}
+
+static float
+evaluateFilter(ResizeFilter filter, float x) {
+	x = fabsf(x);
+	switch (filter) {
+	case RESIZE_FILTER_BOX:
+		return x <= 0.5f ? 1.0f : 0.0f;
+	case RESIZE_FILTER_TRIANGLE:
+		return x < 1.0f ? 1.0f - x : 0.0f;
+	case RESIZE_FILTER_CUBIC: {
+		// Mitchell-Netravali with B = C = 1/3
+		const float b = 1.0f / 3.0f;
+		const float c = 1.0f / 3.0f;
+		if (x < 1.0f) {
+			return ((12.0f - 9.0f * b - 6.0f * c) * x * x * x + (-18.0f + 12.0f * b + 6.0f * c) * x * x + (6.0f - 2.0f * b)) / 6.0f;
+		}
+		if (x < 2.0f) {
+			return ((-b - 6.0f * c) * x * x * x + (6.0f * b + 30.0f * c) * x * x + (-12.0f * b - 48.0f * c) * x + (8.0f * b + 24.0f * c)) / 6.0f;
+		}
+		return 0.0f;
+	}
+	default:
+		return x < 3.0f ? sinc(x) * sinc(x / 3.0f) : 0.0f;
+	}
+}
+
+/**
+ * The normalized weights of one axis: target texel i reads the source texels
+ * first[i] + k for k in [0, tapCount); index holds them clamped to the edge.
+ */
+struct
+ResizeAxis {
+	std::vector<int> first;
+	std::vector<int> index;
+	std::vector<float> weights;
+	int tapCount = 0;
+
+	ResizeAxis(unsigned int sourceSize, unsigned int targetSize, ResizeFilter filter) {
+		const float scale = static_cast<float>(sourceSize) / targetSize;
+		// Shrinking widens the filter so every source texel contributes
+		const float filterScale = scale > 1.0f ? scale : 1.0f;
+		const float radius = getFilterSupport(filter) * filterScale;
+		tapCount = static_cast<int>(ceilf(2.0f * radius)) + 1;
+		first.resize(targetSize);
+		index.resize(static_cast<size_t>(targetSize) * tapCount);
+		weights.resize(static_cast<size_t>(targetSize) * tapCount);
+
+		for (unsigned int i = 0; i < targetSize; ++i) {
+			const float center = (i + 0.5f) * scale;
+			first[i] = static_cast<int>(floorf(center - radius));
+			float* tapWeights = &weights[static_cast<size_t>(i) * tapCount];
+			float sum = 0.0f;
+			for (int k = 0; k < tapCount; ++k) {
+				tapWeights[k] = evaluateFilter(filter, (first[i] + k + 0.5f - center) / filterScale);
+				sum += tapWeights[k];
+				const int sourceIndex = first[i] + k;
+				index[static_cast<size_t>(i) * tapCount + k] = sourceIndex < 0 ? 0 :
+					(sourceIndex >= static_cast<int>(sourceSize) ? static_cast<int>(sourceSize) - 1 : sourceIndex);
+			}
+			for (int k = 0; k < tapCount; ++k) {
+				tapWeights[k] = sum != 0.0f ? tapWeights[k] / sum : 0.0f;
+			}
+		}
+	}
+};
+
+/**
+ * Decodes a row of texels into four floats each.
+ */
+static void
+decodeRow(const ProcessorTables& tables, bool srgb, const unsigned char* in, unsigned int width, float* out) {
+	const float* colorTable = srgb ? tables.srgbToLinear : tables.unormToFloat;
+	for (unsigned int x = 0; x < width; ++x) {
+		out[x * 4 + 0] = colorTable[in[x * 4 + 0]];
+		out[x * 4 + 1] = colorTable[in[x * 4 + 1]];
+		out[x * 4 + 2] = colorTable[in[x * 4 + 2]];
+		out[x * 4 + 3] = tables.unormToFloat[in[x * 4 + 3]];
+	}
+}
+
+/**
+ * Filters a decoded row along x into the target width.
+ */
+static void
+filterRow(ImageKernelPath path, const ResizeAxis& axis, const float* in, unsigned int width, float* out) {
+	for (unsigned int x = 0; x < width; ++x) {
+		const int* taps = &axis.index[static_cast<size_t>(x) * axis.tapCount];
+		const float* tapWeights = &axis.weights[static_cast<size_t>(x) * axis.tapCount];
+#if IMAGE_USE_SSE2
+		if (path != IMAGE_KERNEL_SCALAR) {
+			__m128 sum = _mm_setzero_ps();
+			for (int k = 0; k < axis.tapCount; ++k) {
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(in + taps[k] * 4), _mm_set1_ps(tapWeights[k])));
+			}
+			_mm_storeu_ps(out + x * 4, sum);
+			continue;
+		}
+#endif
+		float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int k = 0; k < axis.tapCount; ++k) {
+			const float* texel = in + taps[k] * 4;
+			for (int c = 0; c < 4; ++c) {
+				sum[c] += texel[c] * tapWeights[k];
+			}
+		}
+		memcpy(out + x * 4, sum, sizeof(sum));
+	}
+}
+
+#if IMAGE_USE_AVX2
+IMAGE_TARGET_AVX2 static size_t
+accumulateRowsAvx2(const float* const* rows, const float* weights, int count, size_t size, float* out) {
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		__m256 sum = _mm256_setzero_ps();
+		for (int k = 0; k < count; ++k) {
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(rows[k] + i), _mm256_set1_ps(weights[k])));
+		}
+		_mm256_storeu_ps(out + i, sum);
+	}
+	return i;
+}
+#endif
+
+/**
+ * out[i] = sum of weights[k] * rows[k][i], the vertical pass.
+ */
+static void
+accumulateRows(ImageKernelPath path, const float* const* rows, const float* weights, int count, size_t size, float* out) {
+	size_t i = 0;
+#if IMAGE_USE_AVX2
+	if (path == IMAGE_KERNEL_AVX2) {
+		i = accumulateRowsAvx2(rows, weights, count, size, out);
+	}
+#endif
+#if IMAGE_USE_SSE2
+	if (path != IMAGE_KERNEL_SCALAR) {
+		for (; i + 4 <= size; i += 4) {
+			__m128 sum = _mm_setzero_ps();
+			for (int k = 0; k < count; ++k) {
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[k] + i), _mm_set1_ps(weights[k])));
+			}
+			_mm_storeu_ps(out + i, sum);
+		}
+	}
+#endif
+	for (; i < size; ++i) {
+		float sum = 0.0f;
+		for (int k = 0; k < count; ++k) {
+			sum += rows[k][i] * weights[k];
+		}
+		out[i] = sum;
+	}
+}
+
+static inline unsigned char
+encodeUnorm(float value) {
+	value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+	return static_cast<unsigned char>(value * 255.0f + 0.5f);
+}
+
+static inline unsigned char
+encodeSrgb(const ProcessorTables& tables, float linear) {
+	linear = linear < 0.0f ? 0.0f : (linear > 1.0f ? 1.0f : linear);
+	return tables.linearToSrgb[static_cast<unsigned int>(linear * (kEncodeTableSize - 1) + 0.5f)];
+}
+
+/**
+ * Encodes a row of four-float texels back to 8 bits.
+ */
+static void
+encodeRow(ImageKernelPath path, const ProcessorTables& tables, bool srgb, const float* in, unsigned int width, unsigned char* out) {
+	if (srgb) {
+		for (unsigned int x = 0; x < width; ++x) {
+			out[x * 4 + 0] = encodeSrgb(tables, in[x * 4 + 0]);
+			out[x * 4 + 1] = encodeSrgb(tables, in[x * 4 + 1]);
+			out[x * 4 + 2] = encodeSrgb(tables, in[x * 4 + 2]);
+			out[x * 4 + 3] = encodeUnorm(in[x * 4 + 3]);
+		}
+		return;
+	}
+
+	size_t i = 0;
+	const size_t size = static_cast<size_t>(width) * 4;
+#if IMAGE_USE_SSE2
+	// Clamp, scale and truncate like encodeUnorm, 16 channels at a time
+	if (path != IMAGE_KERNEL_SCALAR) {
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(255.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		for (; i + 16 <= size; i += 16) {
+			__m128i words[4];
+			for (int j = 0; j < 4; ++j) {
+				__m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + j * 4), zero), one);
+				words[j] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+			}
+			const __m128i low = _mm_packs_epi32(words[0], words[1]);
+			const __m128i high = _mm_packs_epi32(words[2], words[3]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+		}
+	}
+#endif
+	for (; i < size; ++i) {
+		out[i] = encodeUnorm(in[i]);
+	}
+}
+
+/**
+ * Resizes the target rows [firstRow, lastRow). The horizontal pass covers
+ * only the source rows those target rows read.
+ */
+static void
+resizeRows(ImageKernelPath path,
+					 const Image& source,
+					 Image& target,
+					 const ResizeAxis& horizontal,
+					 const ResizeAxis& vertical,
+					 bool srgb,
+					 unsigned int firstRow,
+					 unsigned int lastRow) {
+	const ProcessorTables& tables = getTables();
+	const int sourceFirst = vertical.first[firstRow];
+	const int sourceLast = vertical.first[lastRow - 1] + vertical.tapCount;
+	const size_t rowSize = static_cast<size_t>(target.width) * 4;
+	std::vector<float> rows(static_cast<size_t>(sourceLast - sourceFirst) * rowSize);
+	std::vector<float> decoded(static_cast<size_t>(source.width) * 4);
+
+	for (int sy = sourceFirst; sy < sourceLast; ++sy) {
+		const int clamped = sy < 0 ? 0 : (sy >= static_cast<int>(source.height) ? static_cast<int>(source.height) - 1 : sy);
+		decodeRow(tables, srgb, source.pixels.data() + static_cast<size_t>(clamped) * source.getRowPitch(),
+			source.width, decoded.data());
+		filterRow(path, horizontal, decoded.data(), target.width, &rows[static_cast<size_t>(sy - sourceFirst) * rowSize]);
+	}
+
+	std::vector<const float*> tapRows(vertical.tapCount);
+	std::vector<float> sum(rowSize);
+	for (unsigned int y = firstRow; y < lastRow; ++y) {
+		for (int k = 0; k < vertical.tapCount; ++k) {
+			tapRows[k] = &rows[static_cast<size_t>(vertical.first[y] + k - sourceFirst) * rowSize];
+		}
+		accumulateRows(path, tapRows.data(), &vertical.weights[static_cast<size_t>(y) * vertical.tapCount],
+			vertical.tapCount, rowSize, sum.data());
+		encodeRow(path, tables, srgb, sum.data(), target.width,
+			target.pixels.data() + static_cast<size_t>(y) * target.getRowPitch());
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Per-texel kernels
+//--------------------------------------------------------------------------------------
+
+#if IMAGE_USE_AVX2
+IMAGE_TARGET_AVX2 static size_t
+convertColorSpaceAvx2(const int32_t* table, unsigned char* pixels, size_t texelCount) {
+	const __m256i byteMask = _mm256_set1_epi32(0xFF);
+	const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+	size_t i = 0;
+	for (; i + 8 <= texelCount; i += 8) {
+		__m256i* texels = reinterpret_cast<__m256i*>(pixels + i * 4);
+		const __m256i value = _mm256_loadu_si256(texels);
+		const __m256i r = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), _mm256_and_si256(value, byteMask), 4);
+		const __m256i g = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table),
+			_mm256_and_si256(_mm256_srli_epi32(value, 8), byteMask), 4);
+		const __m256i b = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table),
+			_mm256_and_si256(_mm256_srli_epi32(value, 16), byteMask), 4);
+		__m256i result = _mm256_and_si256(value, alphaMask);
+		result = _mm256_or_si256(result, r);
+		result = _mm256_or_si256(result, _mm256_slli_epi32(g, 8));
+		result = _mm256_or_si256(result, _mm256_slli_epi32(b, 16));
+		_mm256_storeu_si256(texels, result);
+	}
+	return i;
+}
+
+IMAGE_TARGET_AVX2 static size_t
+premultiplyAlphaAvx2(unsigned char* pixels, size_t texelCount) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i rounding = _mm256_set1_epi16(128);
+	// Alpha is multiplied by 255, which leaves it unchanged
+	const __m256i colorMask = _mm256_set1_epi64x(0x0000FFFFFFFFFFFFll);
+	const __m256i alphaOne = _mm256_set1_epi64x(0x00FF000000000000ll);
+	size_t i = 0;
+	for (; i + 8 <= texelCount; i += 8) {
+		__m256i* texels = reinterpret_cast<__m256i*>(pixels + i * 4);
+		const __m256i value = _mm256_loadu_si256(texels);
+		__m256i halves[2] = { _mm256_unpacklo_epi8(value, zero), _mm256_unpackhi_epi8(value, zero) };
+		for (__m256i& half : halves) {
+			__m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(half, 0xFF), 0xFF);
+			alpha = _mm256_or_si256(_mm256_and_si256(alpha, colorMask), alphaOne);
+			const __m256i product = _mm256_add_epi16(_mm256_mullo_epi16(half, alpha), rounding);
+			half = _mm256_srli_epi16(_mm256_add_epi16(product, _mm256_srli_epi16(product, 8)), 8);
+		}
+		_mm256_storeu_si256(texels, _mm256_packus_epi16(halves[0], halves[1]));
+	}
+	return i;
+}
+
+IMAGE_TARGET_AVX2 static size_t
+packChannelsAvx2(const unsigned char* const sources[4], const ChannelSource channels[4], unsigned char* out, size_t texelCount) {
+	const __m256i byteMask = _mm256_set1_epi32(0xFF);
+	__m256i constant = _mm256_setzero_si256();
+	for (int c = 0; c < 4; ++c) {
+		if (channels[c] == CHANNEL_ONE) {
+			constant = _mm256_or_si256(constant, _mm256_set1_epi32(0xFF << (c * 8)));
+		}
+	}
+	size_t i = 0;
+	for (; i + 8 <= texelCount; i += 8) {
+		// Every source is read before the output is written, which may be one of them
+		__m256i result = constant;
+		for (int c = 0; c < 4; ++c) {
+			if (channels[c] > CHANNEL_A) {
+				continue;
+			}
+			const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sources[c] + i * 4));
+			const __m256i channel = _mm256_and_si256(_mm256_srl_epi32(value, _mm_cvtsi32_si128(channels[c] * 8)), byteMask);
+			result = _mm256_or_si256(result, _mm256_sll_epi32(channel, _mm_cvtsi32_si128(c * 8)));
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 4), result);
+	}
+	return i;
+}
+
+IMAGE_TARGET_AVX2 static size_t
+findTranslucentAvx2(const unsigned char* pixels, size_t texelCount) {
+	const __m256i colorMask = _mm256_set1_epi32(0x00FFFFFF);
+	const __m256i ones = _mm256_set1_epi32(-1);
+	size_t i = 0;
+	for (; i + 8 <= texelCount; i += 8) {
+		const __m256i value = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i * 4)), colorMask);
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(value, ones)) != -1) {
+			return i;
+		}
+	}
+	return i;
+}
+#endif
+
+ImageKernelPath
+ImageProcessor::getKernelPath() {
+	int path = g_kernelPath.load(std::memory_order_relaxed);
+	if (path < 0) {
+		path = getSupportedKernelPath();
+		g_kernelPath.store(path, std::memory_order_relaxed);
+	}
+	return static_cast<ImageKernelPath>(path);
+}
+
+ImageKernelPath
+ImageProcessor::getSupportedKernelPath() {
+	static const ImageKernelPath supported = detectAvx2() ? IMAGE_KERNEL_AVX2 :
+#if IMAGE_USE_SSE2
+		IMAGE_KERNEL_SSE2;
+#else
+		IMAGE_KERNEL_SCALAR;
+#endif
+	return supported;
+}
+
+void
+ImageProcessor::setKernelPath(ImageKernelPath path) {
+	g_kernelPath.store(std::min(path, getSupportedKernelPath()), std::memory_order_relaxed);
+}
+
+bool
+ImageProcessor::resize(const Image& source,
+											 Image& target,
+											 unsigned int width,
+											 unsigned int height,
+											 const ResizeSettings& settings,
+											 ThreadPool* threadPool) {
+	if (source.empty() || width == 0 || height == 0 || &source == &target) {
+		ERROR("ImageProcessor", "resize", "The source is empty, a size is 0 or the target is the source.");
+		return false;
+	}
+	target.width = width;
+	target.height = height;
+	target.pixels.resize(static_cast<size_t>(width) * height * 4);
+
+	const ImageKernelPath path = getKernelPath();
+	const ResizeAxis horizontal(source.width, width, settings.filter);
+	const ResizeAxis vertical(source.height, height, settings.filter);
+	const unsigned int bandCount = (height + kRowsPerBand - 1) / kRowsPerBand;
+	auto band = [&](size_t i) {
+		const unsigned int first = static_cast<unsigned int>(i) * kRowsPerBand;
+		const unsigned int last = first + kRowsPerBand < height ? first + kRowsPerBand : height;
+		resizeRows(path, source, target, horizontal, vertical, settings.srgb, first, last);
+	};
+	if (threadPool && threadPool->getThreadCount() > 0 && bandCount > 1 &&
+			static_cast<size_t>(width) * height >= kMinParallelTexels) {
+		threadPool->parallelFor(bandCount, band);
+	}
+	else {
+		for (unsigned int i = 0; i < bandCount; ++i) {
+			band(i);
+		}
+	}
+	return true;
+}
+
+void
+ImageProcessor::convertColorSpace(Image& image, bool toLinear) {
+	const ProcessorTables& tables = getTables();
+	const int32_t* table = toLinear ? tables.srgbToLinear8 : tables.linearToSrgb8;
+	const size_t texelCount = image.pixels.size() / 4;
+	unsigned char* pixels = image.pixels.data();
+
+	size_t i = 0;
+#if IMAGE_USE_AVX2
+	if (getKernelPath() == IMAGE_KERNEL_AVX2) {
+		i = convertColorSpaceAvx2(table, pixels, texelCount);
+	}
+#endif
+	// SSE2 has no gather, a table lookup per channel is as fast as it gets
+	for (; i < texelCount; ++i) {
+		unsigned char* texel = pixels + i * 4;
+		texel[0] = static_cast<unsigned char>(table[texel[0]]);
+		texel[1] = static_cast<unsigned char>(table[texel[1]]);
+		texel[2] = static_cast<unsigned char>(table[texel[2]]);
+	}
+}
+
+void
+ImageProcessor::premultiplyAlpha(Image& image) {
+	const size_t texelCount = image.pixels.size() / 4;
+	unsigned char* pixels = image.pixels.data();
+	const ImageKernelPath path = getKernelPath();
+
+	size_t i = 0;
+#if IMAGE_USE_AVX2
+	if (path == IMAGE_KERNEL_AVX2) {
+		i = premultiplyAlphaAvx2(pixels, texelCount);
+	}
+#endif
+#if IMAGE_USE_SSE2
+	// Two texels per register of 16-bit channels; the alpha of each texel is
+	// broadcast to its channels and replaced by 255 in the alpha lane
+	if (path != IMAGE_KERNEL_SCALAR) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rounding = _mm_set1_epi16(128);
+		const __m128i colorMask = _mm_set_epi32(0x0000FFFF, static_cast<int>(0xFFFFFFFFu), 0x0000FFFF, static_cast<int>(0xFFFFFFFFu));
+		const __m128i alphaOne = _mm_set_epi32(0x00FF0000, 0, 0x00FF0000, 0);
+		for (; i + 4 <= texelCount; i += 4) {
+			__m128i* texels = reinterpret_cast<__m128i*>(pixels + i * 4);
+			const __m128i value = _mm_loadu_si128(texels);
+			__m128i halves[2] = { _mm_unpacklo_epi8(value, zero), _mm_unpackhi_epi8(value, zero) };
+			for (__m128i& half : halves) {
+				__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(half, 0xFF), 0xFF);
+				alpha = _mm_or_si128(_mm_and_si128(alpha, colorMask), alphaOne);
+				const __m128i product = _mm_add_epi16(_mm_mullo_epi16(half, alpha), rounding);
+				half = _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+			}
+			_mm_storeu_si128(texels, _mm_packus_epi16(halves[0], halves[1]));
+		}
+	}
+#endif
+	// (x + 128 + ((x + 128) >> 8)) >> 8 is x / 255 rounded to nearest for x <= 255 * 255
+	for (; i < texelCount; ++i) {
+		unsigned char* texel = pixels + i * 4;
+		for (int c = 0; c < 3; ++c) {
+			const unsigned int product = texel[c] * texel[3] + 128u;
+			texel[c] = static_cast<unsigned char>((product + (product >> 8)) >> 8);
+		}
+	}
+}
+
+bool
+ImageProcessor::packChannels(const Image* const sources[4], const ChannelSource channels[4], Image& outImage) {
+	const Image* reference = nullptr;
+	for (int c = 0; c < 4; ++c) {
+		if (channels[c] > CHANNEL_A) {
+			continue;
+		}
+		if (!sources[c] || (reference && (sources[c]->width != reference->width || sources[c]->height != reference->height))) {
+			ERROR("ImageProcessor", "packChannels", "A source is missing or its size differs from the others.");
+			return false;
+		}
+		reference = sources[c];
+	}
+	if (reference && &outImage != reference) {
+		const unsigned int width = reference->width;
+		const unsigned int height = reference->height;
+		outImage.width = width;
+		outImage.height = height;
+		outImage.pixels.resize(static_cast<size_t>(width) * height * 4);
+	}
+
+	const unsigned char* data[4] = {};
+	for (int c = 0; c < 4; ++c) {
+		data[c] = channels[c] <= CHANNEL_A ? sources[c]->pixels.data() : nullptr;
+	}
+	const size_t texelCount = outImage.pixels.size() / 4;
+	unsigned char* out = outImage.pixels.data();
+	const ImageKernelPath path = getKernelPath();
+
+	size_t i = 0;
+#if IMAGE_USE_AVX2
+	if (path == IMAGE_KERNEL_AVX2) {
+		i = packChannelsAvx2(data, channels, out, texelCount);
+	}
+#endif
+#if IMAGE_USE_SSE2
+	// Each channel is shifted down to the low byte of its 32-bit texel,
+	// masked and shifted up to its output position
+	if (path != IMAGE_KERNEL_SCALAR) {
+		const __m128i byteMask = _mm_set1_epi32(0xFF);
+		__m128i constant = _mm_setzero_si128();
+		for (int c = 0; c < 4; ++c) {
+			if (channels[c] == CHANNEL_ONE) {
+				constant = _mm_or_si128(constant, _mm_set1_epi32(0xFF << (c * 8)));
+			}
+		}
+		for (; i + 4 <= texelCount; i += 4) {
+			__m128i result = constant;
+			for (int c = 0; c < 4; ++c) {
+				if (channels[c] > CHANNEL_A) {
+					continue;
+				}
+				const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data[c] + i * 4));
+				const __m128i channel = _mm_and_si128(_mm_srl_epi32(value, _mm_cvtsi32_si128(channels[c] * 8)), byteMask);
+				result = _mm_or_si128(result, _mm_sll_epi32(channel, _mm_cvtsi32_si128(c * 8)));
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), result);
+		}
+	}
+#endif
+	for (; i < texelCount; ++i) {
+		unsigned char texel[4];
+		for (int c = 0; c < 4; ++c) {
+			texel[c] = channels[c] == CHANNEL_ZERO ? 0 :
+				(channels[c] == CHANNEL_ONE ? 255 : data[c][i * 4 + channels[c]]);
+		}
+		memcpy(out + i * 4, texel, 4);
+	}
+	return true;
+}
+
+void
+ImageProcessor::swizzle(Image& image, const ChannelSource channels[4]) {
+	const Image* const sources[4] = { &image, &image, &image, &image };
+	packChannels(sources, channels, image);
+}
+
+bool
+ImageProcessor::isOpaque(const Image& image) {
+	const size_t texelCount = image.pixels.size() / 4;
+	const unsigned char* pixels = image.pixels.data();
+	const ImageKernelPath path = getKernelPath();
+
+	size_t i = 0;
+#if IMAGE_USE_AVX2
+	if (path == IMAGE_KERNEL_AVX2) {
+		i = findTranslucentAvx2(pixels, texelCount);
+	}
+#endif
+#if IMAGE_USE_SSE2
+	if (path != IMAGE_KERNEL_SCALAR) {
+		const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i ones = _mm_set1_epi32(-1);
+		for (; i + 4 <= texelCount; i += 4) {
+			const __m128i value = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4)), colorMask);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(value, ones)) != 0xFFFF) {
+				break;
+			}
+		}
+	}
+#endif
+	for (; i < texelCount; ++i) {
+		if (pixels[i * 4 + 3] != 255) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,113 @@
+#include "MappedFile.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool
+MappedFile::init(const std::string& fileName) {
+	destroy();
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(fileName.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+		nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		ERROR("MappedFile", "init", ("The file couldn't be opened: " + fileName).c_str());
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize)) {
+		ERROR("MappedFile", "init", "Failed to query the file size.");
+		CloseHandle(file);
+		return false;
+	}
+	m_fileHandle = file;
+
+	// An empty file can't be mapped, but it is still a valid (empty) input
+	if (fileSize.QuadPart == 0) {
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		ERROR("MappedFile", "init", "Failed to create the file mapping.");
+		destroy();
+		return false;
+	}
+	m_mappingHandle = mapping;
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		ERROR("MappedFile", "init", "Failed to map a view of the file.");
+		destroy();
+		return false;
+	}
+
+	m_data = static_cast<const char*>(view);
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		ERROR("MappedFile", "init", ("The file couldn't be opened: " + fileName).c_str());
+		return false;
+	}
+
+	struct stat fileStat = {};
+	if (fstat(fd, &fileStat) != 0) {
+		ERROR("MappedFile", "init", "Failed to query the file size.");
+		close(fd);
+		return false;
+	}
+
+	if (fileStat.st_size == 0) {
+		close(fd);
+		return true;
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file
+	close(fd);
+	if (view == MAP_FAILED) {
+		ERROR("MappedFile", "init", "Failed to map the file.");
+		return false;
+	}
+	madvise(view, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+
+	m_data = static_cast<const char*>(view);
+	m_size = static_cast<size_t>(fileStat.st_size);
+#endif
+
+	return true;
+}
+
+void
+MappedFile::destroy() {
+#if defined(_WIN32)
+	if (m_data) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mappingHandle) {
+		CloseHandle(static_cast<HANDLE>(m_mappingHandle));
+	}
+	if (m_fileHandle) {
+		CloseHandle(static_cast<HANDLE>(m_fileHandle));
+	}
+#else
+	if (m_data) {
+		munmap(const_cast<char*>(m_data), m_size);
+	}
+#endif
+	m_data = nullptr;
+	m_size = 0;
+	m_fileHandle = nullptr;
+	m_mappingHandle = nullptr;
+}
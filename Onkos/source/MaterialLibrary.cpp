@@ -0,0 +1,115 @@
+#include "MaterialLibrary.h"
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+/**
+ * Reads the last word of a map statement, the file name after any options.
+ */
+static std::string
+readMapPath(std::istringstream& line, const std::string& directory) {
+	std::string word;
+	std::string path;
+	while (line >> word) {
+		path = word;
+	}
+	return path.empty() ? path : directory + path;
+}
+
+static XMFLOAT3
+readColor(std::istringstream& line) {
+	float r = 0.0f, g = 0.0f, b = 0.0f;
+	line >> r;
+	// A single value is a gray
+	if (!(line >> g >> b)) {
+		g = b = r;
+	}
+	return XMFLOAT3(r, g, b);
+}
+
+bool
+MaterialLibrary::load(const std::string& fileName, std::vector<Material>& materials) {
+	std::ifstream file(fileName);
+	if (!file.is_open()) {
+		ERROR("MaterialLibrary", "load", ("The file couldn't be opened: " + fileName).c_str());
+		return false;
+	}
+
+	const std::string directory = getDirectory(fileName);
+	Material* current = nullptr;
+	std::string text;
+
+	while (std::getline(file, text)) {
+		std::istringstream line(text);
+		std::string keyword;
+		if (!(line >> keyword) || keyword[0] == '#') {
+			continue;
+		}
+
+		if (keyword == "newmtl") {
+			std::string name;
+			std::getline(line >> std::ws, name);
+			while (!name.empty() && isspace(static_cast<unsigned char>(name.back()))) {
+				name.pop_back();
+			}
+
+			// Statements of materials the mesh doesn't use are skipped
+			current = nullptr;
+			for (Material& material : materials) {
+				if (material.name == name) {
+					current = &material;
+					break;
+				}
+			}
+		}
+		else if (!current) {
+			continue;
+		}
+		else if (keyword == "Ka") {
+			current->ambient = readColor(line);
+		}
+		else if (keyword == "Kd") {
+			current->diffuse = readColor(line);
+		}
+		else if (keyword == "Ks") {
+			current->specular = readColor(line);
+		}
+		else if (keyword == "Ke") {
+			current->emissive = readColor(line);
+		}
+		else if (keyword == "Ns") {
+			line >> current->shininess;
+		}
+		else if (keyword == "d") {
+			line >> current->opacity;
+		}
+		else if (keyword == "Tr") {
+			float transparency = 0.0f;
+			line >> transparency;
+			current->opacity = 1.0f - transparency;
+		}
+		else if (keyword == "illum") {
+			line >> current->illumination;
+		}
+		else if (keyword == "map_Kd") {
+			current->diffuseMap = readMapPath(line, directory);
+		}
+		else if (keyword == "map_Ks") {
+			current->specularMap = readMapPath(line, directory);
+		}
+		else if (keyword == "norm" || keyword == "map_Bump" || keyword == "map_bump" || keyword == "bump") {
+			current->normalMap = readMapPath(line, directory);
+		}
+		else if (keyword == "map_d") {
+			current->opacityMap = readMapPath(line, directory);
+		}
+	}
+
+	return true;
+}
+
+std::string
+MaterialLibrary::getDirectory(const std::string& path) {
+	const size_t separator = path.find_last_of("/\\");
+	return separator == std::string::npos ? std::string() : path.substr(0, separator + 1);
+}
@@ -0,0 +1,282 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// Arrays start at multiples of this, so mapped pointers are suitably aligned
+static const uint64_t kMeshCacheAlignment = 16;
+
+static inline uint64_t
+alignOffset(uint64_t offset) {
+	return (offset + kMeshCacheAlignment - 1) & ~(kMeshCacheAlignment - 1);
+}
+
+static void
+writePadding(std::ofstream& file, uint64_t from, uint64_t to) {
+	static const char zeros[kMeshCacheAlignment] = {};
+	file.write(zeros, static_cast<std::streamsize>(to - from));
+}
+
+bool
+MeshCache::save(const std::string& cachePath,
+								const MeshComponent& mesh,
+								uint64_t sourceHash,
+								const MeshCacheSettings& settings) {
+	const size_t vertexCount = mesh.getVertexCount();
+	const size_t indexCount = mesh.getIndexCount();
+
+	MeshCacheHeader header = {};
+	header.magic = kMeshCacheMagic;
+	header.version = kMeshCacheVersion;
+	header.headerSize = sizeof(MeshCacheHeader);
+	header.vertexStride = sizeof(SimpleVertex);
+	header.sourceHash = sourceHash;
+	header.vertexCount = static_cast<uint32_t>(vertexCount);
+	header.indexCount = static_cast<uint32_t>(indexCount);
+	header.vertexOffset = alignOffset(sizeof(MeshCacheHeader));
+	header.indexOffset = alignOffset(header.vertexOffset + vertexCount * sizeof(SimpleVertex));
+	header.boundsMin[0] = mesh.m_boundsMin.x;
+	header.boundsMin[1] = mesh.m_boundsMin.y;
+	header.boundsMin[2] = mesh.m_boundsMin.z;
+	header.boundsMax[0] = mesh.m_boundsMax.x;
+	header.boundsMax[1] = mesh.m_boundsMax.y;
+	header.boundsMax[2] = mesh.m_boundsMax.z;
+	header.subMeshCount = static_cast<uint32_t>(mesh.m_subMeshes.size());
+	header.subMeshOffset = alignOffset(header.indexOffset + indexCount * sizeof(unsigned int));
+	header.lodCount = static_cast<uint32_t>(mesh.m_lods.size());
+	header.lodOffset = alignOffset(header.subMeshOffset + mesh.m_subMeshes.size() * sizeof(MeshCacheSubMesh));
+	header.indexFormat = static_cast<uint32_t>(mesh.getIndexFormat());
+
+	std::string names;
+	for (const std::string& library : mesh.m_materialLibraries) {
+		names.append(library).push_back('\0');
+	}
+	for (const Material& material : mesh.m_materials) {
+		names.append(material.name).push_back('\0');
+	}
+	for (const std::string& object : mesh.m_objectNames) {
+		names.append(object).push_back('\0');
+	}
+	header.libraryCount = static_cast<uint32_t>(mesh.m_materialLibraries.size());
+	header.materialCount = static_cast<uint32_t>(mesh.m_materials.size());
+	header.objectCount = static_cast<uint32_t>(mesh.m_objectNames.size());
+	header.nameBytes = static_cast<uint32_t>(names.size());
+	header.nameOffset = alignOffset(header.lodOffset + mesh.m_lods.size() * sizeof(MeshCacheLod));
+	header.optimized = settings.optimizeMesh ? 1 : 0;
+	header.lodLevelCount = settings.lodLevelCount;
+
+	std::vector<MeshCacheSubMesh> subMeshes(mesh.m_subMeshes.size());
+	for (size_t i = 0; i < subMeshes.size(); ++i) {
+		subMeshes[i].startIndex = mesh.m_subMeshes[i].startIndex;
+		subMeshes[i].indexCount = mesh.m_subMeshes[i].indexCount;
+		subMeshes[i].baseVertex = mesh.m_subMeshes[i].baseVertex;
+		subMeshes[i].materialId = mesh.m_subMeshes[i].materialId;
+		subMeshes[i].objectId = mesh.m_subMeshes[i].objectId;
+		subMeshes[i].reserved = 0;
+	}
+
+	std::vector<MeshCacheLod> lods(mesh.m_lods.size());
+	for (size_t i = 0; i < lods.size(); ++i) {
+		lods[i].firstSubMesh = mesh.m_lods[i].firstSubMesh;
+		lods[i].subMeshCount = mesh.m_lods[i].subMeshCount;
+		lods[i].error = mesh.m_lods[i].error;
+		lods[i].reserved = 0;
+	}
+
+	const std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			ERROR("MeshCache", "save", ("The file couldn't be created: " + tempPath).c_str());
+			return false;
+		}
+
+		const uint64_t vertexBytes = vertexCount * sizeof(SimpleVertex);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		writePadding(file, sizeof(header), header.vertexOffset);
+		file.write(reinterpret_cast<const char*>(mesh.getVertexData()), static_cast<std::streamsize>(vertexBytes));
+		writePadding(file, header.vertexOffset + vertexBytes, header.indexOffset);
+		const uint64_t indexBytes = indexCount * sizeof(unsigned int);
+		file.write(reinterpret_cast<const char*>(mesh.getIndexData()), static_cast<std::streamsize>(indexBytes));
+		writePadding(file, header.indexOffset + indexBytes, header.subMeshOffset);
+		const uint64_t subMeshBytes = subMeshes.size() * sizeof(MeshCacheSubMesh);
+		file.write(reinterpret_cast<const char*>(subMeshes.data()), static_cast<std::streamsize>(subMeshBytes));
+		writePadding(file, header.subMeshOffset + subMeshBytes, header.lodOffset);
+		const uint64_t lodBytes = lods.size() * sizeof(MeshCacheLod);
+		file.write(reinterpret_cast<const char*>(lods.data()), static_cast<std::streamsize>(lodBytes));
+		writePadding(file, header.lodOffset + lodBytes, header.nameOffset);
+		file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+		if (!file.good()) {
+			ERROR("MeshCache", "save", "Failed to write the mesh cache.");
+			file.close();
+			std::remove(tempPath.c_str());
+			return false;
+		}
+	}
+
+	// Replace the old cache only once the new one is complete. The rename
+	// overwrites it in one step (MoveFileEx with MOVEFILE_REPLACE_EXISTING on
+	// Windows), so there is never a moment without a valid cache
+	std::error_code error;
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error) {
+		ERROR("MeshCache", "save", ("Failed to rename the mesh cache: " + cachePath).c_str());
+		std::remove(tempPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool
+MeshCache::load(const std::string& cachePath,
+								uint64_t sourceHash,
+								const MeshCacheSettings& settings,
+								MeshComponent& outMesh) {
+	return loadInternal(cachePath, true, sourceHash, settings, outMesh);
+}
+
+bool
+MeshCache::load(const std::string& cachePath, MeshComponent& outMesh) {
+	return loadInternal(cachePath, false, 0, MeshCacheSettings(), outMesh);
+}
+
+bool
+MeshCache::loadInternal(const std::string& cachePath,
+												bool checkHash,
+												uint64_t sourceHash,
+												const MeshCacheSettings& settings,
+												MeshComponent& outMesh) {
+	std::ifstream probe(cachePath, std::ios::binary);
+	if (!probe.is_open()) {
+		// No cache yet, not an error
+		return false;
+	}
+	probe.close();
+
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	if (!file->init(cachePath) || file->size() < sizeof(MeshCacheHeader)) {
+		return false;
+	}
+
+	MeshCacheHeader header;
+	memcpy(&header, file->data(), sizeof(header));
+
+	if (header.magic != kMeshCacheMagic ||
+			header.version != kMeshCacheVersion ||
+			header.headerSize != sizeof(MeshCacheHeader) ||
+			header.vertexStride != sizeof(SimpleVertex)) {
+		// Written by another version of the engine
+		return false;
+	}
+	if (checkHash && header.sourceHash != sourceHash) {
+		// The source asset changed since the cache was written
+		return false;
+	}
+	if (checkHash && ((header.optimized != 0) != settings.optimizeMesh ||
+			header.lodLevelCount != settings.lodLevelCount)) {
+		// Built with other settings, the arrays would differ
+		return false;
+	}
+
+	const uint64_t vertexBytes = static_cast<uint64_t>(header.vertexCount) * sizeof(SimpleVertex);
+	const uint64_t indexBytes = static_cast<uint64_t>(header.indexCount) * sizeof(unsigned int);
+	const uint64_t subMeshBytes = static_cast<uint64_t>(header.subMeshCount) * sizeof(MeshCacheSubMesh);
+	const uint64_t lodBytes = static_cast<uint64_t>(header.lodCount) * sizeof(MeshCacheLod);
+	if (header.vertexOffset % kMeshCacheAlignment != 0 ||
+			header.indexOffset % kMeshCacheAlignment != 0 ||
+			header.subMeshOffset % kMeshCacheAlignment != 0 ||
+			header.lodOffset % kMeshCacheAlignment != 0 ||
+			header.nameOffset % kMeshCacheAlignment != 0 ||
+			header.vertexOffset + vertexBytes > file->size() ||
+			header.indexOffset + indexBytes > file->size() ||
+			header.subMeshOffset + subMeshBytes > file->size() ||
+			header.lodOffset + lodBytes > file->size() ||
+			header.nameOffset + header.nameBytes > file->size()) {
+		ERROR("MeshCache", "load", ("The mesh cache is corrupted: " + cachePath).c_str());
+		return false;
+	}
+
+	outMesh.destroy();
+	outMesh.m_vertexView = reinterpret_cast<const SimpleVertex*>(file->data() + header.vertexOffset);
+	outMesh.m_indexView = reinterpret_cast<const unsigned int*>(file->data() + header.indexOffset);
+	outMesh.m_numVertex = static_cast<int>(header.vertexCount);
+	outMesh.m_numIndex = static_cast<int>(header.indexCount);
+	outMesh.m_boundsMin = XMFLOAT3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+	outMesh.m_boundsMax = XMFLOAT3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+	outMesh.m_mappedFile = file;
+	outMesh.m_indexFormat = header.indexFormat == DXGI_FORMAT_R16_UINT ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+	outMesh.m_subMeshes.resize(header.subMeshCount);
+	for (uint32_t i = 0; i < header.subMeshCount; ++i) {
+		MeshCacheSubMesh entry;
+		memcpy(&entry, file->data() + header.subMeshOffset + i * sizeof(MeshCacheSubMesh), sizeof(entry));
+		if (static_cast<uint64_t>(entry.startIndex) + entry.indexCount > header.indexCount) {
+			ERROR("MeshCache", "load", ("The mesh cache is corrupted: " + cachePath).c_str());
+			outMesh.destroy();
+			return false;
+		}
+		outMesh.m_subMeshes[i].startIndex = entry.startIndex;
+		outMesh.m_subMeshes[i].indexCount = entry.indexCount;
+		outMesh.m_subMeshes[i].baseVertex = entry.baseVertex;
+		outMesh.m_subMeshes[i].materialId = entry.materialId;
+		outMesh.m_subMeshes[i].objectId = entry.objectId;
+	}
+
+	outMesh.m_lods.resize(header.lodCount);
+	for (uint32_t i = 0; i < header.lodCount; ++i) {
+		MeshCacheLod entry;
+		memcpy(&entry, file->data() + header.lodOffset + i * sizeof(MeshCacheLod), sizeof(entry));
+		if (static_cast<uint64_t>(entry.firstSubMesh) + entry.subMeshCount > header.subMeshCount) {
+			ERROR("MeshCache", "load", ("The mesh cache is corrupted: " + cachePath).c_str());
+			outMesh.destroy();
+			return false;
+		}
+		outMesh.m_lods[i].firstSubMesh = entry.firstSubMesh;
+		outMesh.m_lods[i].subMeshCount = entry.subMeshCount;
+		outMesh.m_lods[i].error = entry.error;
+	}
+
+	// Split the name table, it must hold exactly the names the header counts
+	std::vector<std::string> names;
+	const char* name = file->data() + header.nameOffset;
+	const char* namesEnd = name + header.nameBytes;
+	while (name < namesEnd) {
+		const char* nameEnd = static_cast<const char*>(memchr(name, '\0', namesEnd - name));
+		if (!nameEnd) {
+			break;
+		}
+		names.emplace_back(name, nameEnd);
+		name = nameEnd + 1;
+	}
+	if (name != namesEnd ||
+			names.size() != static_cast<uint64_t>(header.libraryCount) + header.materialCount + header.objectCount) {
+		ERROR("MeshCache", "load", ("The mesh cache is corrupted: " + cachePath).c_str());
+		outMesh.destroy();
+		return false;
+	}
+
+	auto nextName = names.begin();
+	outMesh.m_materialLibraries.assign(nextName, nextName + header.libraryCount);
+	nextName += header.libraryCount;
+	outMesh.m_materials.resize(header.materialCount);
+	for (Material& material : outMesh.m_materials) {
+		material.name = *nextName++;
+	}
+	outMesh.m_objectNames.assign(nextName, names.end());
+
+	return true;
+}
+
+std::string
+MeshCache::getCachePath(const std::string& sourcePath) {
+	size_t separator = sourcePath.find_last_of("/\\");
+	size_t dot = sourcePath.find_last_of('.');
+	if (dot == std::string::npos || (separator != std::string::npos && dot < separator)) {
+		return sourcePath + ".onkmesh";
+	}
+	return sourcePath.substr(0, dot) + ".onkmesh";
+}
@@ -0,0 +1,85 @@
+#include "MeshComponent.h"
+#include "MappedFile.h"
+
+void
+MeshComponent::destroy() {
+	m_vertex.clear();
+	m_index.clear();
+	m_subMeshes.clear();
+	m_lods.clear();
+	m_materials.clear();
+	m_materialLibraries.clear();
+	m_objectNames.clear();
+	m_quantizedVertex.clear();
+	m_meshlets.clear();
+	m_vertexView = nullptr;
+	m_indexView = nullptr;
+	m_mappedFile.reset();
+	m_numVertex = 0;
+	m_numIndex = 0;
+	m_indexFormat = DXGI_FORMAT_UNKNOWN;
+}
+
+void
+MeshComponent::materialize() {
+	if (!m_mappedFile) {
+		return;
+	}
+
+	m_vertex.assign(m_vertexView, m_vertexView + m_numVertex);
+	m_index.assign(m_indexView, m_indexView + m_numIndex);
+	m_vertexView = nullptr;
+	m_indexView = nullptr;
+	m_mappedFile.reset();
+}
+
+void
+MeshComponent::computeBounds() {
+	const SimpleVertex* vertices = getVertexData();
+	const size_t vertexCount = getVertexCount();
+
+	if (vertexCount == 0) {
+		m_boundsMin = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		m_boundsMax = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		return;
+	}
+
+	XMFLOAT3 minimum = vertices[0].Pos;
+	XMFLOAT3 maximum = vertices[0].Pos;
+	for (size_t i = 1; i < vertexCount; ++i) {
+		const XMFLOAT3& p = vertices[i].Pos;
+		minimum.x = p.x < minimum.x ? p.x : minimum.x;
+		minimum.y = p.y < minimum.y ? p.y : minimum.y;
+		minimum.z = p.z < minimum.z ? p.z : minimum.z;
+		maximum.x = p.x > maximum.x ? p.x : maximum.x;
+		maximum.y = p.y > maximum.y ? p.y : maximum.y;
+		maximum.z = p.z > maximum.z ? p.z : maximum.z;
+	}
+	m_boundsMin = minimum;
+	m_boundsMax = maximum;
+}
+
+MeshLod
+MeshComponent::getLod(size_t lod) const {
+	if (m_lods.empty()) {
+		MeshLod whole;
+		whole.subMeshCount = static_cast<unsigned int>(m_subMeshes.size());
+		return whole;
+	}
+	return m_lods[lod < m_lods.size() ? lod : m_lods.size() - 1];
+}
+
+DXGI_FORMAT
+MeshComponent::getIndexFormat() const {
+	if (m_indexFormat != DXGI_FORMAT_UNKNOWN) {
+		return m_indexFormat;
+	}
+	const unsigned int* indices = getIndexData();
+	const size_t indexCount = getIndexCount();
+
+	unsigned int maximum = 0;
+	for (size_t i = 0; i < indexCount; ++i) {
+		maximum = indices[i] > maximum ? indices[i] : maximum;
+	}
+	return maximum < kMaxIndex16Vertices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+}
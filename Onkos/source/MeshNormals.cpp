@@ -0,0 +1,245 @@
+#include "MeshNormals.h"
+#include "ThreadPool.h"
+#include <cmath>
+
+static inline XMFLOAT3
+subtract(const XMFLOAT3& a, const XMFLOAT3& b) {
+	return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+static inline float
+dot(const XMFLOAT3& a, const XMFLOAT3& b) {
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline XMFLOAT3
+cross(const XMFLOAT3& a, const XMFLOAT3& b) {
+	return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+static inline void
+addScaled(XMFLOAT3& sum, const XMFLOAT3& v, float scale) {
+	sum.x += v.x * scale;
+	sum.y += v.y * scale;
+	sum.z += v.z * scale;
+}
+
+/**
+ * Normalizes a vector, returning false (and leaving it untouched) if it has no length.
+ */
+static inline bool
+normalize(XMFLOAT3& v) {
+	const float length = std::sqrt(dot(v, v));
+	if (!(length > 1e-20f)) {
+		return false;
+	}
+	v = XMFLOAT3(v.x / length, v.y / length, v.z / length);
+	return true;
+}
+
+/**
+ * The angle between the two edges leaving corner c of a triangle.
+ */
+static inline float
+cornerAngle(const XMFLOAT3* p, int c) {
+	XMFLOAT3 e1 = subtract(p[(c + 1) % 3], p[c]);
+	XMFLOAT3 e2 = subtract(p[(c + 2) % 3], p[c]);
+	if (!normalize(e1) || !normalize(e2)) {
+		return 0.0f;
+	}
+	float cosine = dot(e1, e2);
+	cosine = cosine < -1.0f ? -1.0f : (cosine > 1.0f ? 1.0f : cosine);
+	return std::acos(cosine);
+}
+
+/**
+ * The number of vertex ranges a mesh is split into, independent of the thread count.
+ */
+static size_t
+getPartitionCount(size_t triangleCount) {
+	size_t count = triangleCount / kNormalMinTrianglesPerPartition;
+	count = count < 1 ? 1 : count;
+	return count > kNormalMaxPartitions ? kNormalMaxPartitions : count;
+}
+
+static void
+runPartitions(ThreadPool* threadPool, size_t count, const std::function<void(size_t)>& task) {
+	if (threadPool && threadPool->getThreadCount() > 0) {
+		threadPool->parallelFor(count, task);
+		return;
+	}
+	for (size_t i = 0; i < count; ++i) {
+		task(i);
+	}
+}
+
+static bool
+validateIndices(const unsigned int* indices, size_t indexCount, size_t baseVertex, size_t vertexCount) {
+	for (size_t i = 0; i < indexCount; ++i) {
+		if (indices[i] < baseVertex || indices[i] - baseVertex >= vertexCount) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * The corners of every group (a vertex, or a position id when groupOf is given), as
+ * corner numbers t * 3 + c in triangle order: the corners of group g are
+ * corners[offsets[g], offsets[g + 1]). Built by a counting sort, so every group
+ * adds its contributions in the same order as a serial pass over the triangles.
+ */
+static void
+buildCornerLists(const unsigned int* indices,
+								 size_t cornerCount,
+								 size_t baseVertex,
+								 const unsigned int* groupOf,
+								 size_t groupCount,
+								 std::vector<unsigned int>& offsets,
+								 std::vector<unsigned int>& corners) {
+	// Counted two slots ahead, so filling moves each start to the start of the next group
+	offsets.assign(groupCount + 2, 0);
+	for (size_t i = 0; i < cornerCount; ++i) {
+		const size_t vertex = indices[i] - baseVertex;
+		++offsets[(groupOf ? groupOf[vertex] : vertex) + 2];
+	}
+	for (size_t g = 2; g < offsets.size(); ++g) {
+		offsets[g] += offsets[g - 1];
+	}
+	corners.resize(cornerCount);
+	for (size_t i = 0; i < cornerCount; ++i) {
+		const size_t vertex = indices[i] - baseVertex;
+		corners[offsets[(groupOf ? groupOf[vertex] : vertex) + 1]++] = static_cast<unsigned int>(i);
+	}
+}
+
+bool
+MeshNormals::computeNormals(SimpleVertex* vertices,
+														size_t vertexCount,
+														const unsigned int* indices,
+														size_t indexCount,
+														unsigned int baseVertex,
+														const unsigned int* positionIds,
+														size_t positionCount,
+														ThreadPool* threadPool) {
+	const size_t triangleCount = indexCount / 3;
+	if (!validateIndices(indices, triangleCount * 3, baseVertex, vertexCount)) {
+		ERROR("MeshNormals", "computeNormals", "Index out of range.");
+		return false;
+	}
+	const size_t groupCount = positionIds ? positionCount : vertexCount;
+	if (positionIds && !validateIndices(positionIds, vertexCount, 0, positionCount)) {
+		ERROR("MeshNormals", "computeNormals", "Position id out of range.");
+		return false;
+	}
+
+	std::vector<unsigned int> offsets;
+	std::vector<unsigned int> corners;
+	buildCornerLists(indices, triangleCount * 3, baseVertex, positionIds, groupCount, offsets, corners);
+
+	// Groups of several vertices are summed once and then copied to each of them
+	std::vector<XMFLOAT3> groupNormals(positionIds ? groupCount : 0);
+	const SimpleVertex* base = vertices - baseVertex;
+	const size_t partitionCount = getPartitionCount(triangleCount);
+	runPartitions(threadPool, partitionCount, [&](size_t partition) {
+		const size_t end = groupCount * (partition + 1) / partitionCount;
+		for (size_t g = groupCount * partition / partitionCount; g < end; ++g) {
+			XMFLOAT3 sum(0.0f, 0.0f, 0.0f);
+			for (unsigned int k = offsets[g]; k < offsets[g + 1]; ++k) {
+				const unsigned int* triangle = indices + corners[k] / 3 * 3;
+				const XMFLOAT3 p[3] = { base[triangle[0]].Pos, base[triangle[1]].Pos, base[triangle[2]].Pos };
+				XMFLOAT3 normal = cross(subtract(p[1], p[0]), subtract(p[2], p[0]));
+				if (normalize(normal)) {
+					addScaled(sum, normal, cornerAngle(p, corners[k] % 3));
+				}
+			}
+			// Unused or only degenerate triangles, any unit vector will do
+			const XMFLOAT3 normal = normalize(sum) ? sum : XMFLOAT3(0.0f, 1.0f, 0.0f);
+			(positionIds ? groupNormals[g] : vertices[g].Norm) = normal;
+		}
+	});
+
+	if (positionIds) {
+		for (size_t v = 0; v < vertexCount; ++v) {
+			vertices[v].Norm = groupNormals[positionIds[v]];
+		}
+	}
+	return true;
+}
+
+bool
+MeshNormals::computeTangents(SimpleVertex* vertices,
+														 size_t vertexCount,
+														 const unsigned int* indices,
+														 size_t indexCount,
+														 unsigned int baseVertex,
+														 ThreadPool* threadPool) {
+	const size_t triangleCount = indexCount / 3;
+	if (!validateIndices(indices, triangleCount * 3, baseVertex, vertexCount)) {
+		ERROR("MeshNormals", "computeTangents", "Index out of range.");
+		return false;
+	}
+
+	std::vector<unsigned int> offsets;
+	std::vector<unsigned int> corners;
+	buildCornerLists(indices, triangleCount * 3, baseVertex, nullptr, vertexCount, offsets, corners);
+
+	// Each vertex only writes its own Tangent, and only reads the positions, UVs and normals
+	const SimpleVertex* base = vertices - baseVertex;
+	const size_t partitionCount = getPartitionCount(triangleCount);
+	runPartitions(threadPool, partitionCount, [&](size_t partition) {
+		const size_t end = vertexCount * (partition + 1) / partitionCount;
+		for (size_t v = vertexCount * partition / partitionCount; v < end; ++v) {
+			const XMFLOAT3 n = vertices[v].Norm;
+			XMFLOAT3 tangentSum(0.0f, 0.0f, 0.0f);
+			XMFLOAT3 bitangentSum(0.0f, 0.0f, 0.0f);
+
+			for (unsigned int k = offsets[v]; k < offsets[v + 1]; ++k) {
+				const unsigned int* triangle = indices + corners[k] / 3 * 3;
+				const SimpleVertex* t[3] = { &base[triangle[0]], &base[triangle[1]], &base[triangle[2]] };
+				const XMFLOAT3 p[3] = { t[0]->Pos, t[1]->Pos, t[2]->Pos };
+				const XMFLOAT3 e1 = subtract(p[1], p[0]);
+				const XMFLOAT3 e2 = subtract(p[2], p[0]);
+				const float du1 = t[1]->Tex.x - t[0]->Tex.x;
+				const float dv1 = t[1]->Tex.y - t[0]->Tex.y;
+				const float du2 = t[2]->Tex.x - t[0]->Tex.x;
+				const float dv2 = t[2]->Tex.y - t[0]->Tex.y;
+				const float area = du1 * dv2 - du2 * dv1;
+				if (area == 0.0f) {
+					// No UV gradient, the triangle says nothing about the tangent
+					continue;
+				}
+
+				// Only the directions matter, the sign of the UV area carries the handedness
+				const float sign = area > 0.0f ? 1.0f : -1.0f;
+				const float angle = cornerAngle(p, corners[k] % 3);
+				XMFLOAT3 tangent((e1.x * dv2 - e2.x * dv1) * sign,
+					(e1.y * dv2 - e2.y * dv1) * sign,
+					(e1.z * dv2 - e2.z * dv1) * sign);
+				addScaled(tangent, n, -dot(n, tangent));
+				if (normalize(tangent)) {
+					addScaled(tangentSum, tangent, angle);
+				}
+				XMFLOAT3 bitangent((e2.x * du1 - e1.x * du2) * sign,
+					(e2.y * du1 - e1.y * du2) * sign,
+					(e2.z * du1 - e1.z * du2) * sign);
+				addScaled(bitangent, n, -dot(n, bitangent));
+				if (normalize(bitangent)) {
+					addScaled(bitangentSum, bitangent, angle);
+				}
+			}
+
+			XMFLOAT3 tangent = tangentSum;
+			addScaled(tangent, n, -dot(n, tangent));
+			if (!normalize(tangent)) {
+				// Any direction in the plane of the normal
+				tangent = std::fabs(n.x) < 0.9f ? XMFLOAT3(1.0f, 0.0f, 0.0f) : XMFLOAT3(0.0f, 1.0f, 0.0f);
+				addScaled(tangent, n, -dot(n, tangent));
+				normalize(tangent);
+			}
+			const float handedness = dot(cross(n, tangent), bitangentSum) < 0.0f ? -1.0f : 1.0f;
+			vertices[v].Tangent = XMFLOAT4(tangent.x, tangent.y, tangent.z, handedness);
+		}
+	});
+	return true;
+}
@@ -0,0 +1,734 @@
+#include "MeshOptimizer.h"
+#include "MeshComponent.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// Tuning values from Forsyth's paper
+static const unsigned int kForsythCacheSize = 32;
+static const unsigned int kForsythMaxValence = 32;
+static const float kCacheDecayPower = 1.5f;
+static const float kLastTriangleScore = 0.75f;
+static const float kValenceBoostScale = 2.0f;
+static const float kValenceBoostPower = 0.5f;
+
+/**
+ * @brief Precomputed vertex scores by cache position and by remaining triangles.
+ */
+struct
+ForsythScoreTable {
+	float cache[kForsythCacheSize];
+	float valence[kForsythMaxValence + 1];
+
+	ForsythScoreTable() {
+		for (unsigned int i = 0; i < kForsythCacheSize; ++i) {
+			if (i < 3) {
+				// The vertices of the last triangle get a fixed score so the next
+				// triangle doesn't always reuse the same edge
+				cache[i] = kLastTriangleScore;
+			}
+			else {
+				const float scale = 1.0f - static_cast<float>(i - 3) / (kForsythCacheSize - 3);
+				cache[i] = std::pow(scale, kCacheDecayPower);
+			}
+		}
+
+		valence[0] = 0.0f;
+		for (unsigned int i = 1; i <= kForsythMaxValence; ++i) {
+			valence[i] = kValenceBoostScale * std::pow(static_cast<float>(i), -kValenceBoostPower);
+		}
+	}
+
+	float
+	score(int cachePosition, unsigned int remaining) const {
+		if (remaining == 0) {
+			// No triangle left to emit, the vertex doesn't matter anymore
+			return -1.0f;
+		}
+		float result = valence[remaining < kForsythMaxValence ? remaining : kForsythMaxValence];
+		if (cachePosition >= 0) {
+			result += cache[cachePosition];
+		}
+		return result;
+	}
+};
+
+static const ForsythScoreTable&
+getScoreTable() {
+	static const ForsythScoreTable table;
+	return table;
+}
+
+// Resolution of each view rasterized by analyzeOverdraw
+static const int kOverdrawViewport = 256;
+
+static inline const float*
+getPosition(const float* positions, size_t positionStride, unsigned int vertex) {
+	return reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + vertex * positionStride);
+}
+
+static bool
+validateIndices(const unsigned int* indices, size_t indexCount, size_t vertexCount, const char* method) {
+	for (size_t i = 0; i < indexCount; ++i) {
+		if (indices[i] >= vertexCount) {
+			ERROR("MeshOptimizer", method, "Index out of range.");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool
+MeshOptimizer::optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount) {
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) {
+		return true;
+	}
+
+	if (!validateIndices(indices, triangleCount * 3, vertexCount, "optimizeVertexCache")) {
+		return false;
+	}
+
+	const ForsythScoreTable& table = getScoreTable();
+
+	// Triangles of every vertex in one flat array (CSR layout). The live
+	// triangles of vertex v are adjacency[offsets[v]] .. + remaining[v]
+	std::vector<unsigned int> remaining(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; ++i) {
+		++remaining[indices[i]];
+	}
+	std::vector<unsigned int> offsets(vertexCount, 0);
+	unsigned int offset = 0;
+	for (size_t v = 0; v < vertexCount; ++v) {
+		offsets[v] = offset;
+		offset += remaining[v];
+	}
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	{
+		std::vector<unsigned int> fill(offsets);
+		for (size_t t = 0; t < triangleCount; ++t) {
+			for (size_t c = 0; c < 3; ++c) {
+				adjacency[fill[indices[t * 3 + c]]++] = static_cast<unsigned int>(t);
+			}
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v) {
+		vertexScore[v] = table.score(-1, remaining[v]);
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	long long bestTriangle = -1;
+	float bestScore = -1.0f;
+	for (size_t t = 0; t < triangleCount; ++t) {
+		const float score = vertexScore[indices[t * 3]] +
+			vertexScore[indices[t * 3 + 1]] +
+			vertexScore[indices[t * 3 + 2]];
+		if (score > bestScore) {
+			bestScore = score;
+			bestTriangle = static_cast<long long>(t);
+		}
+	}
+
+	// The LRU cache holds kForsythCacheSize entries plus the 3 vertices that
+	// may be pushed out by the triangle being added
+	unsigned int cache[kForsythCacheSize + 3];
+	unsigned int nextCache[kForsythCacheSize + 3];
+	unsigned int cacheCount = 0;
+
+	std::vector<unsigned int> output(triangleCount * 3);
+	size_t searchCursor = 0;
+
+	for (size_t outTriangle = 0; outTriangle < triangleCount; ++outTriangle) {
+		if (bestTriangle < 0) {
+			// Dead end: no triangle touches the cache, restart from the next unused one
+			while (emitted[searchCursor]) {
+				++searchCursor;
+			}
+			bestTriangle = static_cast<long long>(searchCursor);
+		}
+
+		const size_t triangle = static_cast<size_t>(bestTriangle);
+		const unsigned int* corners = indices + triangle * 3;
+		output[outTriangle * 3] = corners[0];
+		output[outTriangle * 3 + 1] = corners[1];
+		output[outTriangle * 3 + 2] = corners[2];
+		emitted[triangle] = true;
+
+		// Remove the triangle from the live lists of its vertices
+		for (size_t c = 0; c < 3; ++c) {
+			const unsigned int v = corners[c];
+			unsigned int* live = adjacency.data() + offsets[v];
+			for (unsigned int i = 0; i < remaining[v]; ++i) {
+				if (live[i] == triangle) {
+					live[i] = live[remaining[v] - 1];
+					break;
+				}
+			}
+			--remaining[v];
+		}
+
+		// The triangle's vertices move to the front of the cache
+		unsigned int nextCount = 0;
+		nextCache[nextCount++] = corners[0];
+		nextCache[nextCount++] = corners[1];
+		nextCache[nextCount++] = corners[2];
+		for (unsigned int i = 0; i < cacheCount; ++i) {
+			const unsigned int v = cache[i];
+			if (v != corners[0] && v != corners[1] && v != corners[2]) {
+				nextCache[nextCount++] = v;
+			}
+		}
+
+		// Rescore every vertex that was in the cache, including the ones evicted now
+		for (unsigned int i = 0; i < nextCount; ++i) {
+			const unsigned int v = nextCache[i];
+			cachePosition[v] = i < kForsythCacheSize ? static_cast<int>(i) : -1;
+			vertexScore[v] = table.score(cachePosition[v], remaining[v]);
+		}
+
+		// Only the triangles of those vertices changed score, pick the best among them
+		bestTriangle = -1;
+		bestScore = -1.0f;
+		for (unsigned int i = 0; i < nextCount; ++i) {
+			const unsigned int v = nextCache[i];
+			const unsigned int* live = adjacency.data() + offsets[v];
+			for (unsigned int j = 0; j < remaining[v]; ++j) {
+				const unsigned int t = live[j];
+				const float score = vertexScore[indices[t * 3]] +
+					vertexScore[indices[t * 3 + 1]] +
+					vertexScore[indices[t * 3 + 2]];
+				if (score > bestScore) {
+					bestScore = score;
+					bestTriangle = static_cast<long long>(t);
+				}
+			}
+		}
+
+		cacheCount = nextCount < kForsythCacheSize ? nextCount : kForsythCacheSize;
+		for (unsigned int i = 0; i < cacheCount; ++i) {
+			cache[i] = nextCache[i];
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+	return true;
+}
+
+VertexCacheStats
+MeshOptimizer::analyzeVertexCache(const unsigned int* indices,
+																	size_t indexCount,
+																	size_t vertexCount,
+																	unsigned int cacheSize) {
+	VertexCacheStats stats;
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0 || vertexCount == 0 || cacheSize == 0) {
+		return stats;
+	}
+
+	// A vertex is in the FIFO cache if fewer than cacheSize misses happened
+	// since it was last loaded. Stamps start far enough back to all be misses
+	std::vector<unsigned int> loadedAt(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	unsigned int timestamp = cacheSize + 1;
+	size_t referencedCount = 0;
+
+	for (size_t i = 0; i < triangleCount * 3; ++i) {
+		const unsigned int v = indices[i];
+		if (v >= vertexCount) {
+			continue;
+		}
+		if (!referenced[v]) {
+			referenced[v] = true;
+			++referencedCount;
+		}
+		if (timestamp - loadedAt[v] > cacheSize) {
+			loadedAt[v] = timestamp++;
+			++stats.verticesTransformed;
+		}
+	}
+
+	stats.acmr = static_cast<float>(stats.verticesTransformed) / triangleCount;
+	stats.atvr = referencedCount > 0 ?
+		static_cast<float>(stats.verticesTransformed) / referencedCount : 0.0f;
+	return stats;
+}
+
+bool
+MeshOptimizer::optimizeOverdraw(unsigned int* indices,
+																size_t indexCount,
+																const float* positions,
+																size_t positionStride,
+																size_t vertexCount,
+																float threshold) {
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) {
+		return true;
+	}
+	if (!validateIndices(indices, triangleCount * 3, vertexCount, "optimizeOverdraw")) {
+		return false;
+	}
+
+	const float targetAcmr = threshold *
+		analyzeVertexCache(indices, triangleCount * 3, vertexCount).acmr;
+
+	// Two FIFO caches: one follows the current order to find the hard
+	// boundaries, the other starts cold at every cluster to measure its ACMR
+	// when drawn on its own
+	std::vector<unsigned int> orderLoadedAt(vertexCount, 0);
+	std::vector<unsigned int> clusterLoadedAt(vertexCount, 0);
+	unsigned int orderTime = kVertexCacheSimSize + 1;
+	unsigned int clusterTime = kVertexCacheSimSize + 1;
+
+	std::vector<size_t> clusterStarts(1, 0);
+	unsigned int clusterMisses = 0;
+	size_t clusterTriangles = 0;
+
+	for (size_t t = 0; t < triangleCount; ++t) {
+		const unsigned int* corners = indices + t * 3;
+
+		unsigned int orderMisses = 0;
+		for (size_t c = 0; c < 3; ++c) {
+			if (orderTime - orderLoadedAt[corners[c]] > kVertexCacheSimSize) {
+				orderLoadedAt[corners[c]] = orderTime++;
+				++orderMisses;
+			}
+		}
+
+		// A triangle that misses all three vertices starts with a cold cache anyway
+		if (orderMisses == 3 && clusterTriangles > 0) {
+			clusterStarts.push_back(t);
+			clusterMisses = 0;
+			clusterTriangles = 0;
+			clusterTime += kVertexCacheSimSize + 1;
+		}
+
+		for (size_t c = 0; c < 3; ++c) {
+			if (clusterTime - clusterLoadedAt[corners[c]] > kVertexCacheSimSize) {
+				clusterLoadedAt[corners[c]] = clusterTime++;
+				++clusterMisses;
+			}
+		}
+		++clusterTriangles;
+
+		// Cut as soon as the cluster has paid for its own cold start
+		if (t + 1 < triangleCount && clusterMisses <= targetAcmr * clusterTriangles) {
+			clusterStarts.push_back(t + 1);
+			clusterMisses = 0;
+			clusterTriangles = 0;
+			// Makes every vertex a miss for the next cluster
+			clusterTime += kVertexCacheSimSize + 1;
+		}
+	}
+	clusterStarts.push_back(triangleCount);
+
+	const size_t clusterCount = clusterStarts.size() - 1;
+	if (clusterCount < 2) {
+		return true;
+	}
+
+	// Area-weighted centroid and normal of every cluster and of the whole mesh
+	std::vector<float> clusterData(clusterCount * 7, 0.0f);
+	float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+	float meshArea = 0.0f;
+
+	for (size_t cluster = 0; cluster < clusterCount; ++cluster) {
+		float* data = clusterData.data() + cluster * 7;
+		for (size_t t = clusterStarts[cluster]; t < clusterStarts[cluster + 1]; ++t) {
+			const float* p0 = getPosition(positions, positionStride, indices[t * 3]);
+			const float* p1 = getPosition(positions, positionStride, indices[t * 3 + 1]);
+			const float* p2 = getPosition(positions, positionStride, indices[t * 3 + 2]);
+
+			const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			const float normal[3] = {
+				e1[1] * e2[2] - e1[2] * e2[1],
+				e1[2] * e2[0] - e1[0] * e2[2],
+				e1[0] * e2[1] - e1[1] * e2[0] };
+			const float area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+			for (int k = 0; k < 3; ++k) {
+				const float center = (p0[k] + p1[k] + p2[k]) / 3.0f;
+				data[k] += center * area;
+				data[3 + k] += normal[k];
+				meshCentroid[k] += center * area;
+			}
+			data[6] += area;
+			meshArea += area;
+		}
+	}
+	if (meshArea <= 0.0f) {
+		return true;
+	}
+	for (int k = 0; k < 3; ++k) {
+		meshCentroid[k] /= meshArea;
+	}
+
+	// Clusters on the outside facing outwards are drawn first
+	std::vector<float> sortKeys(clusterCount, 0.0f);
+	for (size_t cluster = 0; cluster < clusterCount; ++cluster) {
+		const float* data = clusterData.data() + cluster * 7;
+		const float normalLength = std::sqrt(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]);
+		if (data[6] <= 0.0f || normalLength <= 0.0f) {
+			continue;
+		}
+		float key = 0.0f;
+		for (int k = 0; k < 3; ++k) {
+			key += (data[k] / data[6] - meshCentroid[k]) * (data[3 + k] / normalLength);
+		}
+		sortKeys[cluster] = key;
+	}
+
+	std::vector<size_t> order(clusterCount);
+	for (size_t i = 0; i < clusterCount; ++i) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(),
+		[&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<unsigned int> output;
+	output.reserve(triangleCount * 3);
+	for (size_t cluster : order) {
+		output.insert(output.end(),
+			indices + clusterStarts[cluster] * 3,
+			indices + clusterStarts[cluster + 1] * 3);
+	}
+	std::copy(output.begin(), output.end(), indices);
+	return true;
+}
+
+size_t
+MeshOptimizer::buildVertexFetchRemap(const unsigned int* indices,
+																		 size_t indexCount,
+																		 size_t vertexCount,
+																		 std::vector<unsigned int>& outRemap) {
+	outRemap.assign(vertexCount, kUnusedVertex);
+	unsigned int nextVertex = 0;
+	for (size_t i = 0; i < indexCount; ++i) {
+		const unsigned int v = indices[i];
+		if (v < vertexCount && outRemap[v] == kUnusedVertex) {
+			outRemap[v] = nextVertex++;
+		}
+	}
+	return nextVertex;
+}
+
+void
+MeshOptimizer::remapIndices(unsigned int* indices, size_t indexCount, const std::vector<unsigned int>& remap) {
+	for (size_t i = 0; i < indexCount; ++i) {
+		indices[i] = remap[indices[i]];
+	}
+}
+
+VertexFetchStats
+MeshOptimizer::analyzeVertexFetch(const unsigned int* indices,
+																	size_t indexCount,
+																	size_t vertexCount,
+																	size_t vertexSize) {
+	VertexFetchStats stats;
+	if (indexCount == 0 || vertexCount == 0 || vertexSize == 0) {
+		return stats;
+	}
+
+	// Direct-mapped cache of lines in front of a FIFO post-transform cache
+	std::vector<size_t> lineTags(kVertexFetchLineCount, 0);
+	std::vector<unsigned int> loadedAt(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	unsigned int timestamp = kVertexCacheSimSize + 1;
+	size_t referencedCount = 0;
+
+	for (size_t i = 0; i < indexCount; ++i) {
+		const unsigned int v = indices[i];
+		if (v >= vertexCount) {
+			continue;
+		}
+		if (!referenced[v]) {
+			referenced[v] = true;
+			++referencedCount;
+		}
+		if (timestamp - loadedAt[v] <= kVertexCacheSimSize) {
+			continue;
+		}
+		loadedAt[v] = timestamp++;
+
+		const size_t firstLine = (v * vertexSize) / kVertexFetchLineSize;
+		const size_t lastLine = (v * vertexSize + vertexSize - 1) / kVertexFetchLineSize;
+		for (size_t line = firstLine; line <= lastLine; ++line) {
+			// Tags are stored plus one so 0 means empty
+			size_t& tag = lineTags[line % kVertexFetchLineCount];
+			if (tag != line + 1) {
+				tag = line + 1;
+				stats.bytesFetched += kVertexFetchLineSize;
+			}
+		}
+	}
+
+	stats.overfetch = referencedCount > 0 ?
+		static_cast<float>(stats.bytesFetched) / (referencedCount * vertexSize) : 0.0f;
+	return stats;
+}
+
+OverdrawStats
+MeshOptimizer::analyzeOverdraw(const unsigned int* indices,
+															 size_t indexCount,
+															 const float* positions,
+															 size_t positionStride,
+															 size_t vertexCount) {
+	OverdrawStats stats;
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0 || vertexCount == 0) {
+		return stats;
+	}
+
+	float boundsMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (size_t i = 0; i < triangleCount * 3; ++i) {
+		if (indices[i] >= vertexCount) {
+			return stats;
+		}
+		const float* p = getPosition(positions, positionStride, indices[i]);
+		for (int k = 0; k < 3; ++k) {
+			boundsMin[k] = p[k] < boundsMin[k] ? p[k] : boundsMin[k];
+			boundsMax[k] = p[k] > boundsMax[k] ? p[k] : boundsMax[k];
+		}
+	}
+	float extent = 0.0f;
+	for (int k = 0; k < 3; ++k) {
+		extent = boundsMax[k] - boundsMin[k] > extent ? boundsMax[k] - boundsMin[k] : extent;
+	}
+	if (extent <= 0.0f) {
+		return stats;
+	}
+	const float scale = kOverdrawViewport / extent;
+
+	std::vector<float> depthBuffer(kOverdrawViewport * kOverdrawViewport);
+
+	// Orthographic views along +X, -X, +Y, -Y, +Z and -Z
+	for (int view = 0; view < 6; ++view) {
+		const int axis = view / 2;
+		const int axisU = (axis + 1) % 3;
+		const int axisV = (axis + 2) % 3;
+		const float depthSign = (view & 1) ? -1.0f : 1.0f;
+		std::fill(depthBuffer.begin(), depthBuffer.end(), FLT_MAX);
+
+		for (size_t t = 0; t < triangleCount; ++t) {
+			float x[3], y[3], z[3];
+			for (int c = 0; c < 3; ++c) {
+				const float* p = getPosition(positions, positionStride, indices[t * 3 + c]);
+				x[c] = (p[axisU] - boundsMin[axisU]) * scale;
+				y[c] = (p[axisV] - boundsMin[axisV]) * scale;
+				z[c] = p[axis] * depthSign;
+			}
+
+			float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+			if (std::fabs(area) < 1e-12f) {
+				continue;
+			}
+			// No culling: both windings are rasterized the same way
+			const float sign = area > 0.0f ? 1.0f : -1.0f;
+			area *= sign;
+
+			int minX = static_cast<int>(std::floor(std::min(x[0], std::min(x[1], x[2]))));
+			int maxX = static_cast<int>(std::ceil(std::max(x[0], std::max(x[1], x[2]))));
+			int minY = static_cast<int>(std::floor(std::min(y[0], std::min(y[1], y[2]))));
+			int maxY = static_cast<int>(std::ceil(std::max(y[0], std::max(y[1], y[2]))));
+			minX = minX < 0 ? 0 : minX;
+			minY = minY < 0 ? 0 : minY;
+			maxX = maxX > kOverdrawViewport - 1 ? kOverdrawViewport - 1 : maxX;
+			maxY = maxY > kOverdrawViewport - 1 ? kOverdrawViewport - 1 : maxY;
+
+			for (int py = minY; py <= maxY; ++py) {
+				const float sy = py + 0.5f;
+				for (int px = minX; px <= maxX; ++px) {
+					const float sx = px + 0.5f;
+					const float w0 = sign * ((x[2] - x[1]) * (sy - y[1]) - (y[2] - y[1]) * (sx - x[1]));
+					const float w1 = sign * ((x[0] - x[2]) * (sy - y[2]) - (y[0] - y[2]) * (sx - x[2]));
+					const float w2 = sign * ((x[1] - x[0]) * (sy - y[0]) - (y[1] - y[0]) * (sx - x[0]));
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+						continue;
+					}
+					const float depth = (w0 * z[0] + w1 * z[1] + w2 * z[2]) / area;
+					float& stored = depthBuffer[py * kOverdrawViewport + px];
+					if (depth < stored) {
+						stored = depth;
+						++stats.pixelsShaded;
+					}
+				}
+			}
+		}
+
+		for (float depth : depthBuffer) {
+			if (depth != FLT_MAX) {
+				++stats.pixelsCovered;
+			}
+		}
+	}
+
+	stats.overdraw = stats.pixelsCovered > 0 ?
+		static_cast<float>(stats.pixelsShaded) / stats.pixelsCovered : 0.0f;
+	return stats;
+}
+
+bool
+MeshOptimizer::optimizeMesh(MeshComponent& mesh) {
+	mesh.materialize();
+	if (mesh.m_index.empty() || mesh.m_vertex.empty()) {
+		return true;
+	}
+
+	unsigned int* indices = mesh.m_index.data();
+	const size_t indexCount = mesh.m_index.size();
+	if (mesh.m_subMeshes.empty()) {
+		if (!optimizeVertexCache(indices, indexCount, mesh.m_vertex.size())) {
+			return false;
+		}
+		optimizeOverdraw(indices, indexCount, &mesh.m_vertex[0].Pos.x, sizeof(SimpleVertex), mesh.m_vertex.size());
+	}
+	else {
+		// Triangles only move inside their submesh. Each one is optimized on a
+		// compact copy numbering just its own vertices, so the cost of a pass
+		// depends on the size of the submesh and not of the whole mesh
+		std::vector<unsigned int> local(mesh.m_vertex.size(), kUnusedVertex);
+		std::vector<unsigned int> used;
+		std::vector<XMFLOAT3> positions;
+		std::vector<unsigned int> rangeIndices;
+
+		for (const SubMesh& subMesh : mesh.m_subMeshes) {
+			unsigned int* range = indices + subMesh.startIndex;
+			if (static_cast<size_t>(subMesh.startIndex) + subMesh.indexCount > indexCount ||
+					!validateIndices(range, subMesh.indexCount, mesh.m_vertex.size(), "optimizeMesh")) {
+				return false;
+			}
+
+			used.clear();
+			positions.clear();
+			rangeIndices.resize(subMesh.indexCount);
+			for (unsigned int i = 0; i < subMesh.indexCount; ++i) {
+				const unsigned int v = range[i];
+				if (local[v] == kUnusedVertex) {
+					local[v] = static_cast<unsigned int>(used.size());
+					used.push_back(v);
+					positions.push_back(mesh.m_vertex[v].Pos);
+				}
+				rangeIndices[i] = local[v];
+			}
+
+			optimizeVertexCache(rangeIndices.data(), rangeIndices.size(), used.size());
+			if (!positions.empty()) {
+				optimizeOverdraw(rangeIndices.data(), rangeIndices.size(), &positions[0].x, sizeof(XMFLOAT3), used.size());
+			}
+
+			for (unsigned int i = 0; i < subMesh.indexCount; ++i) {
+				range[i] = used[rangeIndices[i]];
+			}
+			for (unsigned int v : used) {
+				local[v] = kUnusedVertex;
+			}
+		}
+	}
+
+	// Fetch order last, it only renumbers the vertices the final order uses
+	std::vector<unsigned int> remap;
+	const size_t vertexCount = buildVertexFetchRemap(indices, indexCount, mesh.m_vertex.size(), remap);
+	remapIndices(indices, indexCount, remap);
+	remapVertices(mesh.m_vertex, remap, vertexCount);
+
+	mesh.m_numVertex = static_cast<int>(mesh.m_vertex.size());
+	mesh.m_numIndex = static_cast<int>(mesh.m_index.size());
+	return true;
+}
+
+void
+MeshOptimizer::splitIndex16(MeshComponent& mesh) {
+	mesh.materialize();
+
+	// The ranges to split: the current submeshes, or the whole index array
+	std::vector<SubMesh> ranges;
+	ranges.swap(mesh.m_subMeshes);
+	if (ranges.empty()) {
+		SubMesh whole;
+		whole.indexCount = static_cast<unsigned int>(mesh.m_index.size() - mesh.m_index.size() % 3);
+		if (whole.indexCount > 0) {
+			ranges.push_back(whole);
+		}
+	}
+
+	// Either way every index fits in 16 bits afterwards, so Buffer::init doesn't scan them
+	mesh.m_indexFormat = DXGI_FORMAT_R16_UINT;
+	if (mesh.m_vertex.size() <= kMaxIndex16Vertices) {
+		mesh.m_subMeshes.swap(ranges);
+		return;
+	}
+
+	// Local index of every original vertex in the current submesh
+	std::vector<unsigned int> local(mesh.m_vertex.size(), kUnusedVertex);
+	std::vector<unsigned int> used;
+	used.reserve(kMaxIndex16Vertices);
+
+	std::vector<SimpleVertex> vertices;
+	vertices.reserve(mesh.m_vertex.size());
+
+	// First output submesh of every input range, to remap the levels of detail
+	std::vector<unsigned int> firstSplit(ranges.size() + 1);
+
+	for (size_t r = 0; r < ranges.size(); ++r) {
+		firstSplit[r] = static_cast<unsigned int>(mesh.m_subMeshes.size());
+		const size_t end = static_cast<size_t>(ranges[r].startIndex) + ranges[r].indexCount;
+
+		// Every range starts a new submesh so ranges stay separately drawable
+		for (unsigned int v : used) {
+			local[v] = kUnusedVertex;
+		}
+		used.clear();
+		SubMesh current = ranges[r];
+		current.baseVertex = static_cast<int>(vertices.size());
+
+		for (size_t i = ranges[r].startIndex; i + 3 <= end; i += 3) {
+			unsigned int* corners = mesh.m_index.data() + i;
+
+			size_t newVertices = 0;
+			for (size_t c = 0; c < 3; ++c) {
+				const bool repeated = (c > 0 && corners[c] == corners[0]) || (c > 1 && corners[c] == corners[1]);
+				if (!repeated && local[corners[c]] == kUnusedVertex) {
+					++newVertices;
+				}
+			}
+
+			if (used.size() + newVertices > kMaxIndex16Vertices) {
+				current.indexCount = static_cast<unsigned int>(i) - current.startIndex;
+				mesh.m_subMeshes.push_back(current);
+				for (unsigned int v : used) {
+					local[v] = kUnusedVertex;
+				}
+				used.clear();
+				current.startIndex = static_cast<unsigned int>(i);
+				current.baseVertex = static_cast<int>(vertices.size());
+			}
+
+			for (size_t c = 0; c < 3; ++c) {
+				const unsigned int v = corners[c];
+				if (local[v] == kUnusedVertex) {
+					local[v] = static_cast<unsigned int>(used.size());
+					used.push_back(v);
+					vertices.push_back(mesh.m_vertex[v]);
+				}
+				corners[c] = local[v];
+			}
+		}
+		current.indexCount = static_cast<unsigned int>((end - current.startIndex) / 3 * 3);
+		mesh.m_subMeshes.push_back(current);
+	}
+	firstSplit[ranges.size()] = static_cast<unsigned int>(mesh.m_subMeshes.size());
+
+	for (MeshLod& lod : mesh.m_lods) {
+		const unsigned int first = firstSplit[lod.firstSubMesh];
+		lod.subMeshCount = firstSplit[lod.firstSubMesh + lod.subMeshCount] - first;
+		lod.firstSubMesh = first;
+	}
+
+	mesh.m_vertex.swap(vertices);
+	mesh.m_numVertex = static_cast<int>(mesh.m_vertex.size());
+	mesh.m_numIndex = static_cast<int>(mesh.m_index.size());
+}
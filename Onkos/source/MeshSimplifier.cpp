@@ -0,0 +1,668 @@
+#include "MeshSimplifier.h"
+#include "MeshComponent.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+// Weight of the planes that hold open borders in place, relative to the faces
+static const double kBorderWeight = 10.0;
+
+// A level that keeps more than this fraction of the previous one ends the chain
+static const float kLodMinReduction = 0.85f;
+
+/**
+ * @brief How a position may move during simplification.
+ */
+enum
+VertexKind {
+	VERTEX_MANIFOLD = 0, ///< Interior, collapses onto any neighbour.
+	VERTEX_BORDER = 1,   ///< On one open border, collapses along it.
+	VERTEX_SEAM = 2,     ///< On one UV seam (two wedges), collapses along it.
+	VERTEX_LOCKED = 3    ///< Corner of borders or seams, never moves.
+};
+
+/**
+ * @brief How two triangles meet along an edge.
+ */
+enum
+EdgeKind {
+	EDGE_INTERIOR = 0, ///< The same two vertices on both sides.
+	EDGE_BORDER = 1,   ///< No triangle on the other side.
+	EDGE_SEAM = 2      ///< The other side uses other vertices at the same positions.
+};
+
+/**
+ * @brief A symmetric 4x4 matrix summing squared distances to planes.
+ */
+struct
+Quadric {
+	double a00 = 0.0, a11 = 0.0, a22 = 0.0, a01 = 0.0, a02 = 0.0, a12 = 0.0;
+	double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+	double c = 0.0;
+	double weight = 0.0;
+};
+
+/**
+ * @brief Moving vertex v onto vertex t, with the cost of doing so.
+ */
+struct
+Collapse {
+	unsigned int v;
+	unsigned int t;
+	double cost;
+};
+
+/**
+ * @brief The triangles around each vertex, in compressed rows.
+ */
+struct
+TriangleAdjacency {
+	std::vector<unsigned int> offsets;
+	std::vector<unsigned int> triangles;
+};
+
+static void
+addPlane(Quadric& q, double nx, double ny, double nz, double d, double w) {
+	q.a00 += w * nx * nx;
+	q.a11 += w * ny * ny;
+	q.a22 += w * nz * nz;
+	q.a01 += w * nx * ny;
+	q.a02 += w * nx * nz;
+	q.a12 += w * ny * nz;
+	q.b0 += w * nx * d;
+	q.b1 += w * ny * d;
+	q.b2 += w * nz * d;
+	q.c += w * d * d;
+}
+
+static void
+addQuadric(Quadric& q, const Quadric& other) {
+	q.a00 += other.a00;
+	q.a11 += other.a11;
+	q.a22 += other.a22;
+	q.a01 += other.a01;
+	q.a02 += other.a02;
+	q.a12 += other.a12;
+	q.b0 += other.b0;
+	q.b1 += other.b1;
+	q.b2 += other.b2;
+	q.c += other.c;
+	q.weight += other.weight;
+}
+
+/**
+ * @brief Weighted mean squared distance from a point to the planes of a quadric.
+ */
+static double
+evaluate(const Quadric& q, const XMFLOAT3& p) {
+	const double x = p.x;
+	const double y = p.y;
+	const double z = p.z;
+	const double r = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+		2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+		2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+	const double error = r > 0.0 ? r : 0.0;
+	return q.weight > 0.0 ? error / q.weight : error;
+}
+
+static inline XMFLOAT3
+cross(const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c) {
+	const float e1x = b.x - a.x, e1y = b.y - a.y, e1z = b.z - a.z;
+	const float e2x = c.x - a.x, e2y = c.y - a.y, e2z = c.z - a.z;
+	return XMFLOAT3(e1y * e2z - e1z * e2y, e1z * e2x - e1x * e2z, e1x * e2y - e1y * e2x);
+}
+
+/**
+ * @brief Gives vertices with the same position the same position id and links
+ * them in a ring (nextWedge), so UV seams are seen as one surface.
+ * @return size_t The number of distinct positions.
+ */
+static size_t
+buildPositionGroups(const SimpleVertex* vertices,
+										size_t vertexCount,
+										std::vector<unsigned int>& positionId,
+										std::vector<unsigned int>& nextWedge) {
+	std::vector<unsigned int> order(vertexCount);
+	std::iota(order.begin(), order.end(), 0u);
+	std::sort(order.begin(), order.end(), [vertices](unsigned int a, unsigned int b) {
+		const XMFLOAT3& pa = vertices[a].Pos;
+		const XMFLOAT3& pb = vertices[b].Pos;
+		if (pa.x != pb.x) return pa.x < pb.x;
+		if (pa.y != pb.y) return pa.y < pb.y;
+		if (pa.z != pb.z) return pa.z < pb.z;
+		return a < b;
+	});
+
+	positionId.assign(vertexCount, 0);
+	nextWedge.assign(vertexCount, 0);
+	size_t positionCount = 0;
+	size_t groupStart = 0;
+	for (size_t i = 1; i <= vertexCount; ++i) {
+		const bool groupEnds = i == vertexCount ||
+			vertices[order[i]].Pos.x != vertices[order[groupStart]].Pos.x ||
+			vertices[order[i]].Pos.y != vertices[order[groupStart]].Pos.y ||
+			vertices[order[i]].Pos.z != vertices[order[groupStart]].Pos.z;
+		if (!groupEnds) {
+			continue;
+		}
+		for (size_t k = groupStart; k < i; ++k) {
+			positionId[order[k]] = static_cast<unsigned int>(positionCount);
+			nextWedge[order[k]] = order[k + 1 < i ? k + 1 : groupStart];
+		}
+		++positionCount;
+		groupStart = i;
+	}
+	return positionCount;
+}
+
+static void
+buildAdjacency(const std::vector<unsigned int>& indices, size_t vertexCount, TriangleAdjacency& adjacency) {
+	adjacency.offsets.assign(vertexCount + 1, 0);
+	for (unsigned int index : indices) {
+		++adjacency.offsets[index + 1];
+	}
+	for (size_t v = 0; v < vertexCount; ++v) {
+		adjacency.offsets[v + 1] += adjacency.offsets[v];
+	}
+
+	adjacency.triangles.resize(indices.size());
+	std::vector<unsigned int> cursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+	for (size_t i = 0; i < indices.size(); ++i) {
+		adjacency.triangles[cursor[indices[i]]++] = static_cast<unsigned int>(i / 3);
+	}
+}
+
+/**
+ * @brief Tests if a triangle has the directed edge a -> b.
+ */
+static bool
+hasHalfEdge(const std::vector<unsigned int>& indices,
+						const TriangleAdjacency& adjacency,
+						unsigned int a,
+						unsigned int b) {
+	for (unsigned int k = adjacency.offsets[a]; k < adjacency.offsets[a + 1]; ++k) {
+		const unsigned int* corners = &indices[adjacency.triangles[k] * 3];
+		for (int c = 0; c < 3; ++c) {
+			if (corners[c] == a && corners[(c + 1) % 3] == b) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Tests if a triangle has a directed edge from any wedge of a to any wedge of b.
+ */
+static bool
+hasPositionEdge(const std::vector<unsigned int>& indices,
+								const TriangleAdjacency& adjacency,
+								const std::vector<unsigned int>& positionId,
+								const std::vector<unsigned int>& nextWedge,
+								unsigned int a,
+								unsigned int b) {
+	unsigned int wedge = a;
+	do {
+		for (unsigned int k = adjacency.offsets[wedge]; k < adjacency.offsets[wedge + 1]; ++k) {
+			const unsigned int* corners = &indices[adjacency.triangles[k] * 3];
+			for (int c = 0; c < 3; ++c) {
+				if (corners[c] == wedge && positionId[corners[(c + 1) % 3]] == positionId[b]) {
+					return true;
+				}
+			}
+		}
+		wedge = nextWedge[wedge];
+	} while (wedge != a);
+	return false;
+}
+
+static EdgeKind
+classifyEdge(const std::vector<unsigned int>& indices,
+						 const TriangleAdjacency& adjacency,
+						 const std::vector<unsigned int>& positionId,
+						 const std::vector<unsigned int>& nextWedge,
+						 unsigned int a,
+						 unsigned int b) {
+	if (!hasPositionEdge(indices, adjacency, positionId, nextWedge, b, a)) {
+		return EDGE_BORDER;
+	}
+	return hasHalfEdge(indices, adjacency, b, a) ? EDGE_INTERIOR : EDGE_SEAM;
+}
+
+/**
+ * @brief Finds the wedge of a position that shares a triangle with a vertex.
+ */
+static unsigned int
+findWedge(const std::vector<unsigned int>& indices,
+					const TriangleAdjacency& adjacency,
+					const std::vector<unsigned int>& positionId,
+					unsigned int vertex,
+					unsigned int position) {
+	for (unsigned int k = adjacency.offsets[vertex]; k < adjacency.offsets[vertex + 1]; ++k) {
+		const unsigned int* corners = &indices[adjacency.triangles[k] * 3];
+		for (int c = 0; c < 3; ++c) {
+			if (positionId[corners[c]] == position) {
+				return corners[c];
+			}
+		}
+	}
+	return kUnusedVertex;
+}
+
+/**
+ * @brief Tests if moving every wedge of v to the position of t turns a triangle over.
+ */
+static bool
+flipsTriangle(const SimpleVertex* vertices,
+							const std::vector<unsigned int>& indices,
+							const TriangleAdjacency& adjacency,
+							const std::vector<unsigned int>& positionId,
+							const std::vector<unsigned int>& nextWedge,
+							unsigned int v,
+							unsigned int t) {
+	unsigned int wedge = v;
+	do {
+		for (unsigned int k = adjacency.offsets[wedge]; k < adjacency.offsets[wedge + 1]; ++k) {
+			const unsigned int* corners = &indices[adjacency.triangles[k] * 3];
+			XMFLOAT3 before[3];
+			XMFLOAT3 after[3];
+			bool degenerates = false;
+			for (int c = 0; c < 3; ++c) {
+				degenerates = degenerates || positionId[corners[c]] == positionId[t];
+				before[c] = vertices[corners[c]].Pos;
+				after[c] = corners[c] == wedge ? vertices[t].Pos : before[c];
+			}
+			if (degenerates) {
+				// Removed by the collapse
+				continue;
+			}
+
+			const XMFLOAT3 n0 = cross(before[0], before[1], before[2]);
+			const XMFLOAT3 n1 = cross(after[0], after[1], after[2]);
+			if (n0.x * n1.x + n0.y * n1.y + n0.z * n1.z <= 0.0f) {
+				return true;
+			}
+		}
+		wedge = nextWedge[wedge];
+	} while (wedge != v);
+	return false;
+}
+
+/**
+ * @brief Removes triangles with two corners at the same position.
+ */
+static void
+removeDegenerates(const std::vector<unsigned int>& positionId, std::vector<unsigned int>& indices) {
+	size_t write = 0;
+	for (size_t i = 0; i + 3 <= indices.size(); i += 3) {
+		const unsigned int p0 = positionId[indices[i]];
+		const unsigned int p1 = positionId[indices[i + 1]];
+		const unsigned int p2 = positionId[indices[i + 2]];
+		if (p0 == p1 || p1 == p2 || p0 == p2) {
+			continue;
+		}
+		indices[write++] = indices[i];
+		indices[write++] = indices[i + 1];
+		indices[write++] = indices[i + 2];
+	}
+	indices.resize(write);
+}
+
+bool
+MeshSimplifier::simplify(const SimpleVertex* vertices,
+												 size_t vertexCount,
+												 const unsigned int* indices,
+												 size_t indexCount,
+												 size_t targetIndexCount,
+												 std::vector<unsigned int>& outIndices,
+												 float* outError) {
+	const size_t triangleIndexCount = indexCount - indexCount % 3;
+	for (size_t i = 0; i < triangleIndexCount; ++i) {
+		if (indices[i] >= vertexCount) {
+			ERROR("MeshSimplifier", "simplify", "Index out of range.");
+			return false;
+		}
+	}
+
+	outIndices.assign(indices, indices + triangleIndexCount);
+	if (outError) {
+		*outError = 0.0f;
+	}
+
+	std::vector<unsigned int> positionId;
+	std::vector<unsigned int> nextWedge;
+	const size_t positionCount = buildPositionGroups(vertices, vertexCount, positionId, nextWedge);
+	removeDegenerates(positionId, outIndices);
+
+	// Every position starts with the planes of the triangles around it
+	std::vector<Quadric> quadrics(positionCount);
+	for (size_t i = 0; i < outIndices.size(); i += 3) {
+		const XMFLOAT3& p0 = vertices[outIndices[i]].Pos;
+		const XMFLOAT3 n = cross(p0, vertices[outIndices[i + 1]].Pos, vertices[outIndices[i + 2]].Pos);
+		const double length = std::sqrt(static_cast<double>(n.x) * n.x + static_cast<double>(n.y) * n.y +
+			static_cast<double>(n.z) * n.z);
+		if (length <= 0.0) {
+			continue;
+		}
+		const double nx = n.x / length, ny = n.y / length, nz = n.z / length;
+		const double d = -(nx * p0.x + ny * p0.y + nz * p0.z);
+		const double area = length * 0.5;
+		for (int c = 0; c < 3; ++c) {
+			Quadric& q = quadrics[positionId[outIndices[i + c]]];
+			addPlane(q, nx, ny, nz, d, area);
+			q.weight += area;
+		}
+	}
+
+	TriangleAdjacency adjacency;
+	std::vector<unsigned char> kind(positionCount);
+	std::vector<unsigned int> borderOut(positionCount);
+	std::vector<unsigned int> borderIn(positionCount);
+	std::vector<unsigned int> seamEdges(positionCount);
+	std::vector<unsigned int> wedgeCount(positionCount);
+	std::vector<unsigned char> locked(positionCount);
+	std::vector<unsigned int> collapseTo(vertexCount);
+	std::vector<Collapse> candidates;
+	std::iota(collapseTo.begin(), collapseTo.end(), 0u);
+
+	for (size_t v = 0; v < vertexCount; ++v) {
+		++wedgeCount[positionId[v]];
+	}
+
+	double maxCost = 0.0;
+	bool firstPass = true;
+
+	while (outIndices.size() > targetIndexCount) {
+		buildAdjacency(outIndices, vertexCount, adjacency);
+
+		// Classify the positions by the borders and seams that reach them
+		std::fill(borderOut.begin(), borderOut.end(), 0u);
+		std::fill(borderIn.begin(), borderIn.end(), 0u);
+		std::fill(seamEdges.begin(), seamEdges.end(), 0u);
+		for (size_t i = 0; i < outIndices.size(); ++i) {
+			const unsigned int a = outIndices[i];
+			const unsigned int b = outIndices[i - i % 3 + (i + 1) % 3];
+			const EdgeKind edge = classifyEdge(outIndices, adjacency, positionId, nextWedge, a, b);
+			if (edge == EDGE_BORDER) {
+				++borderOut[positionId[a]];
+				++borderIn[positionId[b]];
+
+				if (firstPass) {
+					// A plane through the border, perpendicular to its triangle, keeps it in place
+					const unsigned int c = outIndices[i - i % 3 + (i + 2) % 3];
+					const XMFLOAT3& pa = vertices[a].Pos;
+					const XMFLOAT3& pb = vertices[b].Pos;
+					const XMFLOAT3 n = cross(pa, pb, vertices[c].Pos);
+					const double ex = pb.x - pa.x, ey = pb.y - pa.y, ez = pb.z - pa.z;
+					double px = ey * n.z - ez * n.y, py = ez * n.x - ex * n.z, pz = ex * n.y - ey * n.x;
+					const double length = std::sqrt(px * px + py * py + pz * pz);
+					if (length > 0.0) {
+						px /= length;
+						py /= length;
+						pz /= length;
+						const double d = -(px * pa.x + py * pa.y + pz * pa.z);
+						const double w = (ex * ex + ey * ey + ez * ez) * kBorderWeight;
+						addPlane(quadrics[positionId[a]], px, py, pz, d, w);
+						addPlane(quadrics[positionId[b]], px, py, pz, d, w);
+					}
+				}
+			}
+			else if (edge == EDGE_SEAM) {
+				++seamEdges[positionId[a]];
+				++seamEdges[positionId[b]];
+			}
+		}
+		firstPass = false;
+
+		for (size_t p = 0; p < positionCount; ++p) {
+			const bool border = borderOut[p] > 0 || borderIn[p] > 0;
+			if (wedgeCount[p] == 1 && !border && seamEdges[p] == 0) {
+				kind[p] = VERTEX_MANIFOLD;
+			}
+			else if (wedgeCount[p] == 1 && borderOut[p] == 1 && borderIn[p] == 1 && seamEdges[p] == 0) {
+				kind[p] = VERTEX_BORDER;
+			}
+			else if (wedgeCount[p] == 2 && !border && seamEdges[p] == 4) {
+				// Two seam edges, each seen from both sides
+				kind[p] = VERTEX_SEAM;
+			}
+			else {
+				kind[p] = VERTEX_LOCKED;
+			}
+		}
+
+		// Every allowed collapse along the edges of the triangles
+		candidates.clear();
+		for (size_t i = 0; i < outIndices.size(); ++i) {
+			const unsigned int a = outIndices[i];
+			const unsigned int b = outIndices[i - i % 3 + (i + 1) % 3];
+			const EdgeKind edge = classifyEdge(outIndices, adjacency, positionId, nextWedge, a, b);
+
+			for (int direction = 0; direction < 2; ++direction) {
+				// Interior and seam edges are seen from both sides, so each side adds one direction
+				if (direction == 1 && edge != EDGE_BORDER) {
+					break;
+				}
+				const unsigned int v = direction == 0 ? a : b;
+				const unsigned int t = direction == 0 ? b : a;
+				const unsigned char vertexKind = kind[positionId[v]];
+				const bool allowed = vertexKind == VERTEX_MANIFOLD ||
+					(vertexKind == VERTEX_BORDER && edge == EDGE_BORDER) ||
+					(vertexKind == VERTEX_SEAM && edge == EDGE_SEAM);
+				if (allowed) {
+					candidates.push_back({ v, t, evaluate(quadrics[positionId[v]], vertices[t].Pos) });
+				}
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) {
+			return x.cost < y.cost;
+		});
+
+		// Cheapest first; the neighbourhood of a collapse is locked until the next pass
+		std::fill(locked.begin(), locked.end(), static_cast<unsigned char>(0));
+		size_t triangleCount = outIndices.size() / 3;
+		const size_t targetTriangleCount = targetIndexCount / 3;
+		size_t collapseCount = 0;
+
+		for (const Collapse& collapse : candidates) {
+			if (triangleCount <= targetTriangleCount) {
+				break;
+			}
+			const unsigned int pv = positionId[collapse.v];
+			const unsigned int pt = positionId[collapse.t];
+			if (locked[pv] || locked[pt]) {
+				continue;
+			}
+
+			// Each wedge of v moves onto the wedge of t on its side of the seam
+			bool valid = true;
+			unsigned int wedge = collapse.v;
+			do {
+				const unsigned int target = wedge == collapse.v ?
+					collapse.t : findWedge(outIndices, adjacency, positionId, wedge, pt);
+				valid = valid && target != kUnusedVertex;
+				wedge = nextWedge[wedge];
+			} while (wedge != collapse.v);
+			if (!valid || flipsTriangle(vertices, outIndices, adjacency, positionId, nextWedge, collapse.v, collapse.t)) {
+				continue;
+			}
+
+			wedge = collapse.v;
+			do {
+				collapseTo[wedge] = wedge == collapse.v ?
+					collapse.t : findWedge(outIndices, adjacency, positionId, wedge, pt);
+				for (unsigned int k = adjacency.offsets[wedge]; k < adjacency.offsets[wedge + 1]; ++k) {
+					const unsigned int* corners = &outIndices[adjacency.triangles[k] * 3];
+					bool removed = false;
+					for (int c = 0; c < 3; ++c) {
+						locked[positionId[corners[c]]] = 1;
+						removed = removed || positionId[corners[c]] == pt;
+					}
+					triangleCount -= removed ? 1 : 0;
+				}
+				wedge = nextWedge[wedge];
+			} while (wedge != collapse.v);
+
+			addQuadric(quadrics[pt], quadrics[pv]);
+			maxCost = collapse.cost > maxCost ? collapse.cost : maxCost;
+			++collapseCount;
+		}
+
+		if (collapseCount == 0) {
+			break;
+		}
+
+		for (unsigned int& index : outIndices) {
+			index = collapseTo[index];
+		}
+		std::iota(collapseTo.begin(), collapseTo.end(), 0u);
+		removeDegenerates(positionId, outIndices);
+	}
+
+	if (outError) {
+		*outError = static_cast<float>(std::sqrt(maxCost));
+	}
+	return true;
+}
+
+bool
+MeshSimplifier::buildLodChain(MeshComponent& mesh, unsigned int levelCount, float triangleRatio) {
+	if (!mesh.m_lods.empty()) {
+		ERROR("MeshSimplifier", "buildLodChain", "The mesh already has levels of detail.");
+		return false;
+	}
+	for (const SubMesh& subMesh : mesh.m_subMeshes) {
+		if (subMesh.baseVertex != 0) {
+			ERROR("MeshSimplifier", "buildLodChain", "The mesh was already split for 16-bit indices.");
+			return false;
+		}
+	}
+
+	mesh.materialize();
+	std::vector<SubMesh> base = mesh.m_subMeshes;
+	if (base.empty()) {
+		SubMesh whole;
+		whole.indexCount = static_cast<unsigned int>(mesh.m_index.size());
+		base.push_back(whole);
+	}
+	mesh.m_subMeshes = base;
+
+	MeshLod full;
+	full.subMeshCount = static_cast<unsigned int>(base.size());
+	mesh.m_lods.push_back(full);
+
+	size_t previousIndexCount = 0;
+	for (const SubMesh& subMesh : base) {
+		previousIndexCount += subMesh.indexCount;
+	}
+
+	for (const SubMesh& subMesh : base) {
+		if (static_cast<size_t>(subMesh.startIndex) + subMesh.indexCount > mesh.m_index.size()) {
+			ERROR("MeshSimplifier", "buildLodChain", "Submesh out of range.");
+			return false;
+		}
+		for (unsigned int i = 0; i < subMesh.indexCount; ++i) {
+			if (mesh.m_index[subMesh.startIndex + i] >= mesh.m_vertex.size()) {
+				ERROR("MeshSimplifier", "buildLodChain", "Index out of range.");
+				return false;
+			}
+		}
+	}
+
+	// Every submesh is simplified on a compact copy numbering just its own
+	// vertices, so a level costs the size of its submeshes and not submeshes
+	// times the whole mesh. The copy keeps the order of the vertices, which
+	// keeps the ties of the simplifier and thus the result the same
+	std::vector<unsigned int> local(mesh.m_vertex.size(), kUnusedVertex);
+	std::vector<unsigned int> used;
+	std::vector<SimpleVertex> subVertices;
+	std::vector<unsigned int> subIndices;
+
+	std::vector<unsigned int> levelIndices;
+	std::vector<SubMesh> levelSubMeshes;
+	std::vector<unsigned int> simplified;
+	double keep = 1.0;
+
+	for (unsigned int level = 1; level <= levelCount; ++level) {
+		keep *= triangleRatio;
+		levelIndices.clear();
+		levelSubMeshes.clear();
+		MeshLod lod;
+		lod.error = mesh.m_lods.back().error;
+
+		// Every level starts from the full mesh, so its error is measured against it
+		for (const SubMesh& subMesh : base) {
+			const size_t targetIndexCount = static_cast<size_t>(subMesh.indexCount / 3 * keep) * 3;
+			const unsigned int* first = mesh.m_index.data() + subMesh.startIndex;
+			used.clear();
+			for (unsigned int i = 0; i < subMesh.indexCount; ++i) {
+				if (local[first[i]] == kUnusedVertex) {
+					local[first[i]] = 0;
+					used.push_back(first[i]);
+				}
+			}
+			std::sort(used.begin(), used.end());
+			subVertices.resize(used.size());
+			for (size_t v = 0; v < used.size(); ++v) {
+				local[used[v]] = static_cast<unsigned int>(v);
+				subVertices[v] = mesh.m_vertex[used[v]];
+			}
+			subIndices.resize(subMesh.indexCount);
+			for (unsigned int i = 0; i < subMesh.indexCount; ++i) {
+				subIndices[i] = local[first[i]];
+			}
+			for (unsigned int v : used) {
+				local[v] = kUnusedVertex;
+			}
+
+			float error = 0.0f;
+			if (!simplify(subVertices.data(), subVertices.size(), subIndices.data(), subIndices.size(), targetIndexCount,
+					simplified, &error)) {
+				return false;
+			}
+			MeshOptimizer::optimizeVertexCache(simplified.data(), simplified.size(), used.size());
+			for (unsigned int& index : simplified) {
+				index = used[index];
+			}
+
+			SubMesh range = subMesh;
+			range.startIndex = static_cast<unsigned int>(mesh.m_index.size() + levelIndices.size());
+			range.indexCount = static_cast<unsigned int>(simplified.size());
+			levelSubMeshes.push_back(range);
+			levelIndices.insert(levelIndices.end(), simplified.begin(), simplified.end());
+			lod.error = error > lod.error ? error : lod.error;
+		}
+
+		if (levelIndices.empty() || levelIndices.size() > previousIndexCount * kLodMinReduction) {
+			break;
+		}
+
+		lod.firstSubMesh = static_cast<unsigned int>(mesh.m_subMeshes.size());
+		lod.subMeshCount = static_cast<unsigned int>(levelSubMeshes.size());
+		mesh.m_lods.push_back(lod);
+		mesh.m_subMeshes.insert(mesh.m_subMeshes.end(), levelSubMeshes.begin(), levelSubMeshes.end());
+		mesh.m_index.insert(mesh.m_index.end(), levelIndices.begin(), levelIndices.end());
+		previousIndexCount = levelIndices.size();
+	}
+
+	mesh.m_numIndex = static_cast<int>(mesh.m_index.size());
+	return true;
+}
+
+size_t
+MeshSimplifier::selectLod(const MeshComponent& mesh, float distance, float pixelsPerUnit, float maxPixelError) {
+	if (distance <= 0.0f) {
+		return 0;
+	}
+
+	// Errors grow with the level, so the first visible one ends the search
+	size_t selected = 0;
+	for (size_t lod = 1; lod < mesh.getLodCount(); ++lod) {
+		if (mesh.getLod(lod).error * pixelsPerUnit / distance > maxPixelError) {
+			break;
+		}
+		selected = lod;
+	}
+	return selected;
+}
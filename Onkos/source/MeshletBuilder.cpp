@@ -0,0 +1,251 @@
+#include "MeshletBuilder.h"
+#include "MeshComponent.h"
+#include <cmath>
+
+// Marks a vertex that isn't in the meshlet being filled
+static const unsigned char kNotInMeshlet = 0xFF;
+
+// Below this cone spread (cosine) a meshlet is treated as never backfacing
+static const float kMinConeSpread = 0.1f;
+
+/**
+ * @brief The meshlet being filled.
+ */
+struct
+MeshletScratch {
+	unsigned int vertices[kMeshletMaxVertices];
+	unsigned int vertexCount = 0;
+	unsigned char triangles[kMeshletMaxTriangles * 3];
+	unsigned int triangleCount = 0;
+};
+
+static inline float
+distanceSquared(const XMFLOAT3& a, const XMFLOAT3& b) {
+	const float dx = a.x - b.x;
+	const float dy = a.y - b.y;
+	const float dz = a.z - b.z;
+	return dx * dx + dy * dy + dz * dz;
+}
+
+/**
+ * @brief Ritter's bounding sphere of the vertices of a meshlet.
+ */
+static void
+computeSphere(const SimpleVertex* vertices, const MeshletScratch& scratch, XMFLOAT3& outCenter, float& outRadius) {
+	// Start from the most distant pair among the extreme points of each axis
+	unsigned int extremes[6] = {};
+	for (unsigned int i = 1; i < scratch.vertexCount; ++i) {
+		const XMFLOAT3& p = vertices[scratch.vertices[i]].Pos;
+		if (p.x < vertices[scratch.vertices[extremes[0]]].Pos.x) extremes[0] = i;
+		if (p.x > vertices[scratch.vertices[extremes[1]]].Pos.x) extremes[1] = i;
+		if (p.y < vertices[scratch.vertices[extremes[2]]].Pos.y) extremes[2] = i;
+		if (p.y > vertices[scratch.vertices[extremes[3]]].Pos.y) extremes[3] = i;
+		if (p.z < vertices[scratch.vertices[extremes[4]]].Pos.z) extremes[4] = i;
+		if (p.z > vertices[scratch.vertices[extremes[5]]].Pos.z) extremes[5] = i;
+	}
+
+	unsigned int axis = 0;
+	float widest = -1.0f;
+	for (unsigned int k = 0; k < 3; ++k) {
+		const float d = distanceSquared(vertices[scratch.vertices[extremes[k * 2]]].Pos,
+			vertices[scratch.vertices[extremes[k * 2 + 1]]].Pos);
+		if (d > widest) {
+			widest = d;
+			axis = k;
+		}
+	}
+
+	const XMFLOAT3& a = vertices[scratch.vertices[extremes[axis * 2]]].Pos;
+	const XMFLOAT3& b = vertices[scratch.vertices[extremes[axis * 2 + 1]]].Pos;
+	XMFLOAT3 center((a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f, (a.z + b.z) * 0.5f);
+	float radius = std::sqrt(widest) * 0.5f;
+
+	// Grow the sphere just enough to include every point outside of it
+	for (unsigned int i = 0; i < scratch.vertexCount; ++i) {
+		const XMFLOAT3& p = vertices[scratch.vertices[i]].Pos;
+		const float d = std::sqrt(distanceSquared(p, center));
+		if (d > radius) {
+			const float grownRadius = (radius + d) * 0.5f;
+			const float shift = (grownRadius - radius) / d;
+			center.x += (p.x - center.x) * shift;
+			center.y += (p.y - center.y) * shift;
+			center.z += (p.z - center.z) * shift;
+			radius = grownRadius;
+		}
+	}
+
+	// Absorb the rounding of the incremental updates
+	for (unsigned int i = 0; i < scratch.vertexCount; ++i) {
+		const float d = std::sqrt(distanceSquared(vertices[scratch.vertices[i]].Pos, center));
+		radius = d > radius ? d : radius;
+	}
+
+	outCenter = center;
+	outRadius = radius;
+}
+
+/**
+ * @brief The cone that contains the face normals of a meshlet.
+ * @note Normals follow the clockwise front faces of Direct3D.
+ */
+static void
+computeCone(const SimpleVertex* vertices, const MeshletScratch& scratch, XMFLOAT3& outAxis, float& outCutoff) {
+	std::vector<XMFLOAT3> normals;
+	normals.reserve(scratch.triangleCount);
+	XMFLOAT3 sum(0.0f, 0.0f, 0.0f);
+
+	for (unsigned int t = 0; t < scratch.triangleCount; ++t) {
+		const XMFLOAT3& p0 = vertices[scratch.vertices[scratch.triangles[t * 3]]].Pos;
+		const XMFLOAT3& p1 = vertices[scratch.vertices[scratch.triangles[t * 3 + 1]]].Pos;
+		const XMFLOAT3& p2 = vertices[scratch.vertices[scratch.triangles[t * 3 + 2]]].Pos;
+		const XMFLOAT3 e1(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z);
+		const XMFLOAT3 e2(p2.x - p0.x, p2.y - p0.y, p2.z - p0.z);
+		XMFLOAT3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+
+		const float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+		if (length <= 0.0f) {
+			// Degenerate triangles are never rasterized, they don't widen the cone
+			continue;
+		}
+		n = XMFLOAT3(n.x / length, n.y / length, n.z / length);
+		normals.push_back(n);
+		sum = XMFLOAT3(sum.x + n.x, sum.y + n.y, sum.z + n.z);
+	}
+
+	outAxis = XMFLOAT3(0.0f, 0.0f, 1.0f);
+	outCutoff = 1.0f;
+	const float sumLength = std::sqrt(sum.x * sum.x + sum.y * sum.y + sum.z * sum.z);
+	if (normals.empty() || sumLength <= 0.0f) {
+		return;
+	}
+	outAxis = XMFLOAT3(sum.x / sumLength, sum.y / sumLength, sum.z / sumLength);
+
+	float minimumDot = 1.0f;
+	for (const XMFLOAT3& n : normals) {
+		const float d = n.x * outAxis.x + n.y * outAxis.y + n.z * outAxis.z;
+		minimumDot = d < minimumDot ? d : minimumDot;
+	}
+	if (minimumDot <= kMinConeSpread) {
+		return;
+	}
+	outCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+}
+
+static void
+flushMeshlet(const SimpleVertex* vertices,
+						 MeshletScratch& scratch,
+						 std::vector<unsigned char>& localIndex,
+						 MeshletData& out) {
+	if (scratch.triangleCount == 0) {
+		return;
+	}
+
+	out.vertexOffset.push_back(static_cast<unsigned int>(out.vertexIndices.size()));
+	out.vertexCount.push_back(static_cast<unsigned char>(scratch.vertexCount));
+	out.triangleOffset.push_back(static_cast<unsigned int>(out.triangleIndices.size()));
+	out.triangleCount.push_back(static_cast<unsigned char>(scratch.triangleCount));
+	out.vertexIndices.insert(out.vertexIndices.end(), scratch.vertices, scratch.vertices + scratch.vertexCount);
+	out.triangleIndices.insert(out.triangleIndices.end(), scratch.triangles, scratch.triangles + scratch.triangleCount * 3);
+
+	XMFLOAT3 center;
+	float radius;
+	computeSphere(vertices, scratch, center, radius);
+	out.centerX.push_back(center.x);
+	out.centerY.push_back(center.y);
+	out.centerZ.push_back(center.z);
+	out.radius.push_back(radius);
+
+	XMFLOAT3 axis;
+	float cutoff;
+	computeCone(vertices, scratch, axis, cutoff);
+	out.coneAxisX.push_back(axis.x);
+	out.coneAxisY.push_back(axis.y);
+	out.coneAxisZ.push_back(axis.z);
+	out.coneCutoff.push_back(cutoff);
+
+	for (unsigned int i = 0; i < scratch.vertexCount; ++i) {
+		localIndex[scratch.vertices[i]] = kNotInMeshlet;
+	}
+	scratch.vertexCount = 0;
+	scratch.triangleCount = 0;
+}
+
+void
+MeshletBuilder::build(const MeshComponent& mesh, MeshletData& outMeshlets) {
+	outMeshlets.clear();
+
+	const SimpleVertex* vertices = mesh.getVertexData();
+	const unsigned int* indices = mesh.getIndexData();
+	const size_t vertexCount = mesh.getVertexCount();
+	const size_t indexCount = mesh.getIndexCount();
+
+	// Only the full resolution level, the simplified ones reuse its vertices
+	const MeshLod full = mesh.getLod(0);
+	std::vector<SubMesh> ranges(mesh.m_subMeshes.begin() + full.firstSubMesh,
+		mesh.m_subMeshes.begin() + full.firstSubMesh + full.subMeshCount);
+	if (ranges.empty()) {
+		SubMesh whole;
+		whole.indexCount = static_cast<unsigned int>(indexCount);
+		ranges.push_back(whole);
+	}
+
+	std::vector<unsigned char> localIndex(vertexCount, kNotInMeshlet);
+	MeshletScratch scratch;
+
+	for (const SubMesh& range : ranges) {
+		const size_t end = static_cast<size_t>(range.startIndex) + range.indexCount;
+		if (end > indexCount) {
+			ERROR("MeshletBuilder", "build", "A submesh is out of the index range.");
+			continue;
+		}
+
+		for (size_t i = range.startIndex; i + 3 <= end; i += 3) {
+			unsigned int corners[3];
+			bool valid = true;
+			for (size_t c = 0; c < 3; ++c) {
+				corners[c] = indices[i + c] + range.baseVertex;
+				valid = valid && corners[c] < vertexCount;
+			}
+			if (!valid) {
+				ERROR("MeshletBuilder", "build", "Index out of range.");
+				continue;
+			}
+
+			unsigned int newVertices = 0;
+			for (size_t c = 0; c < 3; ++c) {
+				const bool repeated = (c > 0 && corners[c] == corners[0]) || (c > 1 && corners[c] == corners[1]);
+				if (!repeated && localIndex[corners[c]] == kNotInMeshlet) {
+					++newVertices;
+				}
+			}
+			if (scratch.vertexCount + newVertices > kMeshletMaxVertices ||
+					scratch.triangleCount + 1 > kMeshletMaxTriangles) {
+				flushMeshlet(vertices, scratch, localIndex, outMeshlets);
+			}
+
+			for (size_t c = 0; c < 3; ++c) {
+				if (localIndex[corners[c]] == kNotInMeshlet) {
+					localIndex[corners[c]] = static_cast<unsigned char>(scratch.vertexCount);
+					scratch.vertices[scratch.vertexCount++] = corners[c];
+				}
+				scratch.triangles[scratch.triangleCount * 3 + c] = localIndex[corners[c]];
+			}
+			++scratch.triangleCount;
+		}
+
+		// Meshlets don't cross submeshes
+		flushMeshlet(vertices, scratch, localIndex, outMeshlets);
+	}
+}
+
+bool
+MeshletBuilder::isBackfacing(const MeshletData& meshlets, size_t meshlet, const XMFLOAT3& cameraPosition) {
+	const float dx = meshlets.centerX[meshlet] - cameraPosition.x;
+	const float dy = meshlets.centerY[meshlet] - cameraPosition.y;
+	const float dz = meshlets.centerZ[meshlet] - cameraPosition.z;
+	const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+	const float alignment = dx * meshlets.coneAxisX[meshlet] +
+		dy * meshlets.coneAxisY[meshlet] +
+		dz * meshlets.coneAxisZ[meshlet];
+	return alignment >= meshlets.coneCutoff[meshlet] * distance + meshlets.radius[meshlet];
+}
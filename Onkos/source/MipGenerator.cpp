@@ -0,0 +1,382 @@
+#include "MipGenerator.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Kaiser filter of NVTT: 3 target texels of radius, alpha 4
+static const float kKaiserWidth = 3.0f;
+static const float kKaiserAlpha = 4.0f;
+
+// Levels smaller than this are filtered on the calling thread
+static const size_t kMinParallelTexels = 64 * 1024;
+static const unsigned int kRowsPerBand = 16;
+
+// Resolution of the linear -> sRGB table, fine enough to round like the exact curve
+static const unsigned int kEncodeTableSize = 16384;
+
+/**
+ * A texel with four float channels, one SSE register when available.
+ */
+struct
+Texel {
+#if MIP_USE_SSE2
+	__m128 v;
+
+	static Texel
+	zero() { return Texel{ _mm_setzero_ps() }; }
+
+	static Texel
+	load(const float* channels) { return Texel{ _mm_loadu_ps(channels) }; }
+
+	void
+	store(float* channels) const { _mm_storeu_ps(channels, v); }
+
+	void
+	addScaled(const Texel& texel, float weight) { v = _mm_add_ps(v, _mm_mul_ps(texel.v, _mm_set1_ps(weight))); }
+#else
+	float v[4];
+
+	static Texel
+	zero() { return Texel{ { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+
+	static Texel
+	load(const float* channels) { return Texel{ { channels[0], channels[1], channels[2], channels[3] } }; }
+
+	void
+	store(float* channels) const {
+		for (int c = 0; c < 4; ++c) {
+			channels[c] = v[c];
+		}
+	}
+
+	void
+	addScaled(const Texel& texel, float weight) {
+		for (int c = 0; c < 4; ++c) {
+			v[c] += texel.v[c] * weight;
+		}
+	}
+#endif
+};
+
+/**
+ * Conversions between 8-bit channels and linear floats.
+ */
+struct
+ColorTables {
+	float srgbToLinear[256];
+	float unormToFloat[256];
+	unsigned char linearToSrgb[kEncodeTableSize];
+
+	ColorTables() {
+		for (int i = 0; i < 256; ++i) {
+			const float value = i / 255.0f;
+			srgbToLinear[i] = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+			unormToFloat[i] = value;
+		}
+		for (unsigned int i = 0; i < kEncodeTableSize; ++i) {
+			const float linear = static_cast<float>(i) / (kEncodeTableSize - 1);
+			const float value = linear <= 0.0031308f ? linear * 12.92f : 1.055f * powf(linear, 1.0f / 2.4f) - 0.055f;
+			linearToSrgb[i] = static_cast<unsigned char>(value * 255.0f + 0.5f);
+		}
+	}
+};
+
+static const ColorTables&
+getColorTables() {
+	static const ColorTables tables;
+	return tables;
+}
+
+static inline unsigned char
+encodeUnorm(float value) {
+	value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+	return static_cast<unsigned char>(value * 255.0f + 0.5f);
+}
+
+static inline unsigned char
+encodeSrgb(const ColorTables& tables, float linear) {
+	linear = linear < 0.0f ? 0.0f : (linear > 1.0f ? 1.0f : linear);
+	return tables.linearToSrgb[static_cast<unsigned int>(linear * (kEncodeTableSize - 1) + 0.5f)];
+}
+
+static inline Texel
+decodeTexel(const float* colorTable, const float* alphaTable, const unsigned char* texel) {
+	const float channels[4] = { colorTable[texel[0]], colorTable[texel[1]], colorTable[texel[2]], alphaTable[texel[3]] };
+	return Texel::load(channels);
+}
+
+static inline void
+encodeTexel(const ColorTables& tables, bool srgb, const Texel& texel, unsigned char* out) {
+	float channels[4];
+	texel.store(channels);
+	for (int c = 0; c < 3; ++c) {
+		out[c] = srgb ? encodeSrgb(tables, channels[c]) : encodeUnorm(channels[c]);
+	}
+	out[3] = encodeUnorm(channels[3]);
+}
+
+/**
+ * Runs rows(first, last) over bands of target rows, on the pool for large levels.
+ */
+static void
+runRowBands(ThreadPool* threadPool,
+						const Image& target,
+						const std::function<void(unsigned int, unsigned int)>& rows) {
+	const unsigned int bandCount = (target.height + kRowsPerBand - 1) / kRowsPerBand;
+	auto band = [&](size_t i) {
+		const unsigned int first = static_cast<unsigned int>(i) * kRowsPerBand;
+		const unsigned int last = first + kRowsPerBand < target.height ? first + kRowsPerBand : target.height;
+		rows(first, last);
+	};
+	if (threadPool && threadPool->getThreadCount() > 0 && bandCount > 1 &&
+			static_cast<size_t>(target.width) * target.height >= kMinParallelTexels) {
+		threadPool->parallelFor(bandCount, band);
+		return;
+	}
+	for (unsigned int i = 0; i < bandCount; ++i) {
+		band(i);
+	}
+}
+
+/**
+ * 2x2 average of 8-bit channels, rounded to nearest.
+ */
+static void
+reduceBoxUnorm(const Image& source, Image& target, unsigned int firstRow, unsigned int lastRow) {
+	const unsigned int sourcePitch = source.getRowPitch();
+	for (unsigned int y = firstRow; y < lastRow; ++y) {
+		const unsigned int y0 = y * 2;
+		const unsigned int y1 = y0 + 1 < source.height ? y0 + 1 : y0;
+		const unsigned char* row0 = source.pixels.data() + static_cast<size_t>(y0) * sourcePitch;
+		const unsigned char* row1 = source.pixels.data() + static_cast<size_t>(y1) * sourcePitch;
+		unsigned char* out = target.pixels.data() + static_cast<size_t>(y) * target.getRowPitch();
+
+		unsigned int x = 0;
+#if MIP_USE_SSE2
+		// Two target texels from four source texels of each row. A source row
+		// of one texel has no right neighbour and takes the scalar path
+		if (source.width > 1) {
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i rounding = _mm_set1_epi16(2);
+			for (; x + 2 <= target.width; x += 2) {
+				const __m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+				const __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+				const __m128i sumLeft = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+				const __m128i sumRight = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+				// Add each even texel to the odd one next to it
+				const __m128i pairLeft = _mm_add_epi16(sumLeft, _mm_srli_si128(sumLeft, 8));
+				const __m128i pairRight = _mm_add_epi16(sumRight, _mm_srli_si128(sumRight, 8));
+				__m128i sum = _mm_unpacklo_epi64(pairLeft, pairRight);
+				sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(sum, zero));
+			}
+		}
+#endif
+		for (; x < target.width; ++x) {
+			const unsigned int x0 = x * 2 * 4;
+			const unsigned int x1 = (x * 2 + 1 < source.width ? x * 2 + 1 : x * 2) * 4;
+			for (unsigned int c = 0; c < 4; ++c) {
+				unsigned int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+				out[x * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+/**
+ * 2x2 average of the colors in linear space. Alpha is averaged like reduceBoxUnorm.
+ */
+static void
+reduceBoxSrgb(const Image& source, Image& target, unsigned int firstRow, unsigned int lastRow) {
+	const ColorTables& tables = getColorTables();
+	const unsigned int sourcePitch = source.getRowPitch();
+	for (unsigned int y = firstRow; y < lastRow; ++y) {
+		const unsigned int y0 = y * 2;
+		const unsigned int y1 = y0 + 1 < source.height ? y0 + 1 : y0;
+		const unsigned char* row0 = source.pixels.data() + static_cast<size_t>(y0) * sourcePitch;
+		const unsigned char* row1 = source.pixels.data() + static_cast<size_t>(y1) * sourcePitch;
+		unsigned char* out = target.pixels.data() + static_cast<size_t>(y) * target.getRowPitch();
+
+		for (unsigned int x = 0; x < target.width; ++x) {
+			const unsigned int x0 = x * 2 * 4;
+			const unsigned int x1 = (x * 2 + 1 < source.width ? x * 2 + 1 : x * 2) * 4;
+			Texel sum = Texel::zero();
+			sum.addScaled(decodeTexel(tables.srgbToLinear, tables.unormToFloat, row0 + x0), 0.25f);
+			sum.addScaled(decodeTexel(tables.srgbToLinear, tables.unormToFloat, row0 + x1), 0.25f);
+			sum.addScaled(decodeTexel(tables.srgbToLinear, tables.unormToFloat, row1 + x0), 0.25f);
+			sum.addScaled(decodeTexel(tables.srgbToLinear, tables.unormToFloat, row1 + x1), 0.25f);
+			encodeTexel(tables, true, sum, out + x * 4);
+
+			const unsigned int alpha = row0[x0 + 3] + row0[x1 + 3] + row1[x0 + 3] + row1[x1 + 3];
+			out[x * 4 + 3] = static_cast<unsigned char>((alpha + 2) / 4);
+		}
+	}
+}
+
+/**
+ * Zeroth order modified Bessel function of the first kind.
+ */
+static float
+bessel0(float x) {
+	const float halfSquared = x * x * 0.25f;
+	float sum = 1.0f;
+	float term = 1.0f;
+	for (int k = 1; k < 32 && term > sum * 1e-8f; ++k) {
+		term *= halfSquared / static_cast<float>(k * k);
+		sum += term;
+	}
+	return sum;
+}
+
+static float
+evaluateKaiser(float x) {
+	const float t = x / kKaiserWidth;
+	if (t * t >= 1.0f) {
+		return 0.0f;
+	}
+	const float pix = 3.14159265f * x;
+	const float sinc = fabsf(pix) < 1e-6f ? 1.0f : sinf(pix) / pix;
+	return sinc * bessel0(kKaiserAlpha * sqrtf(1.0f - t * t)) / bessel0(kKaiserAlpha);
+}
+
+/**
+ * The normalized Kaiser weights of one axis: target texel i reads the source
+ * texels first[i] + k for k in [0, tapCount), clamped to the edge.
+ */
+struct
+AxisFilter {
+	std::vector<int> first;
+	std::vector<float> weights;
+	int tapCount = 0;
+
+	AxisFilter(unsigned int sourceSize, unsigned int targetSize) {
+		const float scale = static_cast<float>(sourceSize) / targetSize;
+		const float radius = kKaiserWidth * scale;
+		tapCount = static_cast<int>(ceilf(2.0f * radius)) + 1;
+		first.resize(targetSize);
+		weights.resize(static_cast<size_t>(targetSize) * tapCount);
+
+		for (unsigned int i = 0; i < targetSize; ++i) {
+			const float center = (i + 0.5f) * scale;
+			first[i] = static_cast<int>(floorf(center - radius));
+			float* tapWeights = &weights[static_cast<size_t>(i) * tapCount];
+			float sum = 0.0f;
+			for (int k = 0; k < tapCount; ++k) {
+				tapWeights[k] = evaluateKaiser((first[i] + k + 0.5f - center) / scale);
+				sum += tapWeights[k];
+			}
+			for (int k = 0; k < tapCount; ++k) {
+				tapWeights[k] /= sum;
+			}
+		}
+	}
+
+	static int
+	clamp(int index, unsigned int size) {
+		return index < 0 ? 0 : (index >= static_cast<int>(size) ? static_cast<int>(size) - 1 : index);
+	}
+};
+
+/**
+ * Separable Kaiser reduction of the target rows [firstRow, lastRow). The
+ * horizontal pass covers only the source rows those target rows read.
+ */
+static void
+reduceKaiser(const Image& source,
+						 Image& target,
+						 const AxisFilter& horizontal,
+						 const AxisFilter& vertical,
+						 bool srgb,
+						 unsigned int firstRow,
+						 unsigned int lastRow) {
+	const ColorTables& tables = getColorTables();
+	const float* colorTable = srgb ? tables.srgbToLinear : tables.unormToFloat;
+
+	const int sourceFirst = vertical.first[firstRow];
+	const int sourceLast = vertical.first[lastRow - 1] + vertical.tapCount;
+	std::vector<float> rows(static_cast<size_t>(sourceLast - sourceFirst) * target.width * 4);
+
+	for (int sy = sourceFirst; sy < sourceLast; ++sy) {
+		const unsigned char* in = source.pixels.data() +
+			static_cast<size_t>(AxisFilter::clamp(sy, source.height)) * source.getRowPitch();
+		float* out = &rows[static_cast<size_t>(sy - sourceFirst) * target.width * 4];
+		for (unsigned int x = 0; x < target.width; ++x) {
+			const float* tapWeights = &horizontal.weights[static_cast<size_t>(x) * horizontal.tapCount];
+			Texel sum = Texel::zero();
+			for (int k = 0; k < horizontal.tapCount; ++k) {
+				const int sx = AxisFilter::clamp(horizontal.first[x] + k, source.width);
+				sum.addScaled(decodeTexel(colorTable, tables.unormToFloat, in + sx * 4), tapWeights[k]);
+			}
+			sum.store(out + x * 4);
+		}
+	}
+
+	for (unsigned int y = firstRow; y < lastRow; ++y) {
+		const float* tapWeights = &vertical.weights[static_cast<size_t>(y) * vertical.tapCount];
+		unsigned char* out = target.pixels.data() + static_cast<size_t>(y) * target.getRowPitch();
+		for (unsigned int x = 0; x < target.width; ++x) {
+			Texel sum = Texel::zero();
+			for (int k = 0; k < vertical.tapCount; ++k) {
+				const size_t row = static_cast<size_t>(vertical.first[y] + k - sourceFirst);
+				sum.addScaled(Texel::load(&rows[(row * target.width + x) * 4]), tapWeights[k]);
+			}
+			encodeTexel(tables, srgb, sum, out + x * 4);
+		}
+	}
+}
+
+unsigned int
+MipGenerator::getMipCount(unsigned int width, unsigned int height) {
+	unsigned int levels = 1;
+	while (width > 1 || height > 1) {
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+		++levels;
+	}
+	return levels;
+}
+
+void
+MipGenerator::generate(std::vector<Image>& mips, const MipSettings& settings, ThreadPool* threadPool) {
+	if (mips.empty() || mips[0].empty()) {
+		ERROR("MipGenerator", "generate", "The base level is empty.");
+		return;
+	}
+
+	const unsigned int mipCount = getMipCount(mips[0].width, mips[0].height);
+	mips.resize(mipCount);
+
+	for (unsigned int level = 1; level < mipCount; ++level) {
+		reduce(mips[level - 1], mips[level], settings, threadPool);
+	}
+}
+
+void
+MipGenerator::reduce(const Image& source, Image& target, const MipSettings& settings, ThreadPool* threadPool) {
+	target.width = source.width > 1 ? source.width / 2 : 1;
+	target.height = source.height > 1 ? source.height / 2 : 1;
+	target.pixels.resize(static_cast<size_t>(target.width) * target.height * 4);
+
+	if (settings.filter == MIP_FILTER_KAISER) {
+		const AxisFilter horizontal(source.width, target.width);
+		const AxisFilter vertical(source.height, target.height);
+		runRowBands(threadPool, target, [&](unsigned int firstRow, unsigned int lastRow) {
+			reduceKaiser(source, target, horizontal, vertical, settings.srgb, firstRow, lastRow);
+		});
+	}
+	else if (settings.srgb) {
+		runRowBands(threadPool, target, [&](unsigned int firstRow, unsigned int lastRow) {
+			reduceBoxSrgb(source, target, firstRow, lastRow);
+		});
+	}
+	else {
+		runRowBands(threadPool, target, [&](unsigned int firstRow, unsigned int lastRow) {
+			reduceBoxUnorm(source, target, firstRow, lastRow);
+		});
+	}
+}
@@ -0,0 +1,75 @@
+#include "ModelLoadRequest.h"
+
+bool
+ModelLoadRequest::takeMesh(MeshComponent& outMesh, bool wait) {
+	std::unique_ptr<MeshComponent> mesh;
+	{
+		// Only a pointer swap happens under the lock
+		std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+		if (wait) {
+			lock.lock();
+		}
+		else {
+			lock.try_lock();
+		}
+		if (!lock.owns_lock() || !m_published) {
+			return false;
+		}
+		mesh.swap(m_published);
+	}
+	outMesh = std::move(*mesh);
+	return true;
+}
+
+ModelLoadStats
+ModelLoadRequest::getStats() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+void
+ModelLoadRequest::setProgress(ModelLoadStage stage, float progress) {
+	int currentStage = m_stage.load();
+	while (currentStage < stage && !m_stage.compare_exchange_weak(currentStage, stage)) {
+	}
+	float currentProgress = m_progress.load();
+	while (currentProgress < progress && !m_progress.compare_exchange_weak(currentProgress, progress)) {
+	}
+}
+
+void
+ModelLoadRequest::publish(const MeshComponent& mesh) {
+	store(std::unique_ptr<MeshComponent>(new MeshComponent(mesh)));
+}
+
+void
+ModelLoadRequest::finish(MeshComponent& mesh, ModelLoadStage stage, const ModelLoadStats& stats) {
+	if (stage == MODEL_LOAD_DONE) {
+		std::unique_ptr<MeshComponent> finalMesh(new MeshComponent());
+		*finalMesh = std::move(mesh);
+		store(std::move(finalMesh));
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stats = stats;
+	}
+	m_totalSeconds = getElapsedSeconds();
+	setProgress(stage, stage == MODEL_LOAD_DONE ? 1.0f : m_progress.load());
+}
+
+void
+ModelLoadRequest::store(std::unique_ptr<MeshComponent> mesh) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		// A mesh nobody took yet is replaced by the newer one
+		m_published.swap(mesh);
+	}
+	if (m_firstMeshSeconds < 0.0) {
+		m_firstMeshSeconds = getElapsedSeconds();
+	}
+}
+
+double
+ModelLoadRequest::getElapsedSeconds() const {
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - m_startTime).count();
+}
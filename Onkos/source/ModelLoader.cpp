@@ -1,119 +1,914 @@
 #include "ModelLoader.h"
-#include <fstream>
+#include "ContentHash.h"
+#include "MappedFile.h"
+#include "MaterialLibrary.h"
+#include "MeshCache.h"
+#include "MeshNormals.h"
+#include "ModelLoadRequest.h"
+#include "PolygonTriangulator.h"
+#include "VertexHashTable.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <unordered_map>
 
-bool 
+// Exact powers of ten representable in a double, used by the fast float path
+static const double kPowersOfTen[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Written exponents are clamped to this, far past the range of a float, so they can't overflow
+static const int kMaxExponent = 100000;
+
+static inline bool
+isBlank(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline bool
+isDigit(char c) {
+	return static_cast<unsigned char>(c - '0') < 10;
+}
+
+static inline const char*
+skipBlanks(const char* cursor, const char* end) {
+	while (cursor < end && isBlank(*cursor)) {
+		++cursor;
+	}
+	return cursor;
+}
+
+/**
+ * Scans a decimal integer with an optional sign.
+ * Returns the position after the last digit, or nullptr if there were no digits
+ * or the value doesn't fit in an int (past INT_MAX either way).
+ */
+static inline const char*
+scanInt(const char* cursor, const char* end, int& outValue) {
+	bool negative = false;
+	if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+		negative = (*cursor == '-');
+		++cursor;
+	}
+	if (cursor >= end || !isDigit(*cursor)) {
+		return nullptr;
+	}
+
+	int value = 0;
+	while (cursor < end && isDigit(*cursor)) {
+		const int digit = *cursor - '0';
+		if (value > (INT_MAX - digit) / 10) {
+			return nullptr;
+		}
+		value = value * 10 + digit;
+		++cursor;
+	}
+	outValue = negative ? -value : value;
+	return cursor;
+}
+
+/**
+ * Scans a floating point number ([sign] digits [. digits] [e [sign] digits]).
+ * Mantissas of up to 15 significant digits with exponents up to 22 are computed
+ * in double precision, which rounds once there and again to float, so the
+ * result may differ from strtof in the last bit; anything else falls back to strtof.
+ * Returns the position after the number, or nullptr if no number was found.
+ */
+static const char*
+scanFloat(const char* cursor, const char* end, float& outValue) {
+	const char* start = cursor;
+	bool negative = false;
+	if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+		negative = (*cursor == '-');
+		++cursor;
+	}
+
+	unsigned long long mantissa = 0;
+	int significantDigits = 0;
+	int exponent = 0;
+	bool anyDigit = false;
+
+	while (cursor < end && isDigit(*cursor)) {
+		anyDigit = true;
+		if (mantissa != 0 || *cursor != '0') {
+			if (significantDigits < 19) {
+				mantissa = mantissa * 10 + (*cursor - '0');
+			}
+			else {
+				++exponent;
+			}
+			++significantDigits;
+		}
+		++cursor;
+	}
+	if (cursor < end && *cursor == '.') {
+		++cursor;
+		while (cursor < end && isDigit(*cursor)) {
+			anyDigit = true;
+			if (mantissa != 0 || *cursor != '0') {
+				if (significantDigits < 19) {
+					mantissa = mantissa * 10 + (*cursor - '0');
+					--exponent;
+				}
+				++significantDigits;
+			}
+			else {
+				--exponent;
+			}
+			++cursor;
+		}
+	}
+	if (!anyDigit) {
+		return nullptr;
+	}
+
+	if (cursor < end && (*cursor == 'e' || *cursor == 'E')) {
+		// Exponents past any float are clamped, strtof reads the text itself and gives inf or 0
+		const char* exponentCursor = cursor + 1;
+		bool negativeExponent = false;
+		if (exponentCursor < end && (*exponentCursor == '-' || *exponentCursor == '+')) {
+			negativeExponent = (*exponentCursor == '-');
+			++exponentCursor;
+		}
+		if (exponentCursor < end && isDigit(*exponentCursor)) {
+			int exponentValue = 0;
+			while (exponentCursor < end && isDigit(*exponentCursor)) {
+				exponentValue = std::min(exponentValue * 10 + (*exponentCursor - '0'), kMaxExponent);
+				++exponentCursor;
+			}
+			exponent += negativeExponent ? -exponentValue : exponentValue;
+			cursor = exponentCursor;
+		}
+	}
+
+	if (significantDigits <= 15 && exponent >= -22 && exponent <= 22) {
+		double value = static_cast<double>(mantissa);
+		value = exponent < 0 ? value / kPowersOfTen[-exponent] : value * kPowersOfTen[exponent];
+		outValue = static_cast<float>(negative ? -value : value);
+		return cursor;
+	}
+
+	// Slow path: let the standard library round long or extreme numbers
+	char buffer[128];
+	size_t length = static_cast<size_t>(cursor - start);
+	if (length >= sizeof(buffer)) {
+		length = sizeof(buffer) - 1;
+	}
+	memcpy(buffer, start, length);
+	buffer[length] = '\0';
+	outValue = std::strtof(buffer, nullptr);
+	return cursor;
+}
+
+/**
+ * Scans the next whitespace-separated float of a line, storing 0 if it is missing.
+ */
+static inline const char*
+nextFloat(const char* cursor, const char* end, float& outValue) {
+	cursor = skipBlanks(cursor, end);
+	const char* next = scanFloat(cursor, end, outValue);
+	if (!next) {
+		outValue = 0.0f;
+		return cursor;
+	}
+	return next;
+}
+
+// Files smaller than this are never split, the threads wouldn't pay for themselves
+static const size_t kMinChunkBytes = 1 << 20;
+
+// Chunks per thread, so threads that finish early can pick up more work
+static const size_t kChunksPerThread = 4;
+
+// Rough share of the work done at the end of each step, for ModelLoadRequest::getProgress
+static const float kProgressParsed = 0.4f;
+static const float kProgressMerged = 0.5f;
+static const float kProgressPreview = 0.6f;
+static const float kProgressOptimized = 0.8f;
+static const float kProgressSimplified = 0.95f;
+
+// Corner index of an attribute the corner doesn't have (e.g. the t of "p//n")
+static const int kMissingIndex = -1;
+
+/**
+ * An o, g or usemtl statement and the face of its chunk it applies from.
+ */
+struct
+ObjNameChange {
+	unsigned int face;
+	bool material;
+	std::string name;
+};
+
+/**
+ * Everything parsed from one newline-aligned range of the file.
+ */
+struct
+ObjChunk {
+	std::vector<XMFLOAT3> positions;
+	std::vector<XMFLOAT2> uvs;
+	std::vector<XMFLOAT3> normals;
+	std::vector<VertexKey> corners;
+	std::vector<unsigned int> faceSizes;
+
+	// Attributes given with negative (relative) indices: corner * 3 + attribute
+	// (0 = p, 1 = t, 2 = n). They are resolved within the chunk and still need
+	// the number of attributes of the previous chunks
+	std::vector<unsigned int> relativeIndices;
+
+	// Object and material names in file order, they are resolved to ids serially
+	std::vector<ObjNameChange> names;
+	std::vector<std::string> libraries;
+
+	bool missingNormals = false;
+	bool failed = false;
+};
+
+/**
+ * Turns an OBJ index into a 0-based one: positive indices count from the start
+ * of the file, negative ones back from the last attribute read so far (count
+ * is the number read in this chunk), 0 means the attribute is missing.
+ */
+static inline int
+resolveIndex(int value, size_t count) {
+	return value > 0 ? value - 1 : (value < 0 ? static_cast<int>(count) + value : kMissingIndex);
+}
+
+/**
+ * Reads the rest of a line without the blanks around it.
+ */
+static inline std::string
+readName(const char* cursor, const char* end) {
+	cursor = skipBlanks(cursor, end);
+	while (end > cursor && isBlank(end[-1])) {
+		--end;
+	}
+	return std::string(cursor, end);
+}
+
+/**
+ * Gets the id of a name, adding it to the names of the mesh on first use.
+ */
+template<typename T, typename GetName>
+static unsigned int
+getNameId(std::unordered_map<std::string, unsigned int>& ids,
+					std::vector<T>& names,
+					const std::string& name,
+					GetName getName) {
+	auto found = ids.find(name);
+	if (found != ids.end()) {
+		return found->second;
+	}
+	const unsigned int id = static_cast<unsigned int>(names.size());
+	ids.emplace(name, id);
+	names.emplace_back();
+	getName(names.back()) = name;
+	return id;
+}
+
+/**
+ * Scans a face corner in any of the OBJ forms "p", "p/t", "p//n" and "p/t/n".
+ * Missing attributes are left at 0. Returns nullptr if the corner is malformed.
+ */
+static inline const char*
+scanCorner(const char* cursor, const char* end, VertexKey& outCorner) {
+	outCorner.pos = outCorner.uv = outCorner.nrm = 0;
+	cursor = scanInt(cursor, end, outCorner.pos);
+	if (!cursor || cursor == end || *cursor != '/') {
+		return cursor;
+	}
+
+	++cursor;
+	if (cursor < end && *cursor != '/') {
+		cursor = scanInt(cursor, end, outCorner.uv);
+		if (!cursor || cursor == end || *cursor != '/') {
+			return cursor;
+		}
+	}
+	if (cursor < end && *cursor == '/') {
+		return scanInt(cursor + 1, end, outCorner.nrm);
+	}
+	return nullptr;
+}
+
+bool
 ModelLoader::loadModel(const std::string& fileName, MeshComponent& outMesh) {
-	std::ifstream file(fileName);
+	return loadModelInternal(fileName, outMesh, nullptr);
+}
+
+ModelLoadHandle
+ModelLoader::loadModelAsync(const std::string& fileName) {
+	ModelLoadHandle request = std::make_shared<ModelLoadRequest>();
+	if (m_asyncPool.getThreadCount() == 0) {
+		m_asyncPool.init(1);
+	}
+
+	// The load runs on its own loader with a copy of the settings, so this one
+	// stays usable while it runs
+	const unsigned int threadCount = m_threadCount;
+	const bool useMeshCache = m_useMeshCache;
+	const bool optimizeMesh = m_optimizeMesh;
+	const unsigned int lodLevelCount = m_lodLevelCount;
+	m_asyncPool.enqueue([=]() {
+		ModelLoader loader;
+		loader.m_threadCount = threadCount;
+		loader.m_useMeshCache = useMeshCache;
+		loader.m_optimizeMesh = optimizeMesh;
+		loader.m_lodLevelCount = lodLevelCount;
+
+		MeshComponent mesh;
+		const bool loaded = !request->isCanceled() && loader.loadModelInternal(fileName, mesh, request.get());
+		request->finish(mesh,
+			loaded ? MODEL_LOAD_DONE : (request->isCanceled() ? MODEL_LOAD_CANCELED : MODEL_LOAD_FAILED),
+			loader.getLastLoadStats());
+	});
+	return request;
+}
+
+bool
+ModelLoader::loadModelInternal(const std::string& fileName, MeshComponent& outMesh, ModelLoadRequest* request) {
+	auto startTime = std::chrono::high_resolution_clock::now();
+	m_lastLoadStats = ModelLoadStats();
+	if (request) {
+		request->setProgress(MODEL_LOAD_PARSING, 0.0f);
+	}
+
+	// Assets cooked offline are mapped as they are, there is no source to check
+	const size_t extension = fileName.find_last_of('.');
+	if (extension != std::string::npos && fileName.compare(extension, std::string::npos, ".onkmesh") == 0) {
+		MeshCache cookedMesh;
+		if (!cookedMesh.load(fileName, outMesh)) {
+			ERROR("ModelLoader.cpp", "loadModel", ("Invalid cooked mesh: " + fileName).c_str());
+			return false;
+		}
+		loadMaterials(fileName, outMesh);
+		m_lastLoadStats.cacheHit = true;
+		m_lastLoadStats.parseSeconds = std::chrono::duration<double>(
+			std::chrono::high_resolution_clock::now() - startTime).count();
+		return true;
+	}
 
-	if (!file.is_open()) {
+	MappedFile file;
+	if (!file.init(fileName)) {
 		ERROR("ModelLoader.cpp", "loadModel", "The file couldn't be opened.");
-		
+
 		return false;
 	}
 
-	std::string line;
+	const char* fileBegin = file.data();
+	const char* fileEnd = fileBegin + file.size();
+
+	// A cache describes a whole file, so it's only used to fill an empty mesh
+	outMesh.materialize();
+	const bool useCache = m_useMeshCache && outMesh.m_vertex.empty() && outMesh.m_index.empty();
+	const std::string cachePath = MeshCache::getCachePath(fileName);
+	uint64_t sourceHash = 0;
+	MeshCache meshCache;
+	MeshCacheSettings cacheSettings;
+	cacheSettings.optimizeMesh = m_optimizeMesh;
+	cacheSettings.lodLevelCount = m_lodLevelCount;
+
+	if (useCache) {
+		sourceHash = ContentHash::compute(fileBegin, file.size());
+		m_lastLoadStats.hashSeconds = std::chrono::duration<double>(
+			std::chrono::high_resolution_clock::now() - startTime).count();
+
+		if (meshCache.load(cachePath, sourceHash, cacheSettings, outMesh)) {
+			loadMaterials(fileName, outMesh);
+			std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+			m_lastLoadStats.fileBytes = file.size();
+			m_lastLoadStats.cacheHit = true;
+			m_lastLoadStats.parseSeconds = elapsed.count();
+			return true;
+		}
+	}
+
+	// Split the file into chunks that start right after a newline
+	auto scanTime = std::chrono::high_resolution_clock::now();
+	unsigned int threadCount = ThreadPool::resolveThreadCount(m_threadCount);
+	size_t chunkCount = 1;
+	if (threadCount > 1 && file.size() >= 2 * kMinChunkBytes) {
+		chunkCount = threadCount * kChunksPerThread;
+		if (chunkCount > file.size() / kMinChunkBytes) {
+			chunkCount = file.size() / kMinChunkBytes;
+		}
+	}
+
+	std::vector<const char*> boundaries(chunkCount + 1);
+	boundaries[0] = fileBegin;
+	boundaries[chunkCount] = fileEnd;
+	for (size_t i = 1; i < chunkCount; ++i) {
+		const char* split = fileBegin + file.size() * i / chunkCount;
+		if (split < boundaries[i - 1]) {
+			split = boundaries[i - 1];
+		}
+		const char* newline = static_cast<const char*>(memchr(split, '\n', fileEnd - split));
+		boundaries[i] = newline ? newline + 1 : fileEnd;
+	}
+
+	std::vector<ObjChunk> chunks(chunkCount);
+	if (chunkCount > 1) {
+		// The calling thread also parses, so it counts as one of the threads
+		if (m_threadPool.getThreadCount() != threadCount - 1) {
+			m_threadPool.init(threadCount - 1);
+		}
+		std::atomic<size_t> parsedChunks(0);
+		m_threadPool.parallelFor(chunkCount, [&](size_t i) {
+			parseChunk(boundaries[i], boundaries[i + 1], chunks[i]);
+			if (request) {
+				request->setProgress(MODEL_LOAD_PARSING, kProgressParsed * ++parsedChunks / chunkCount);
+			}
+		});
+	}
+	else {
+		parseChunk(fileBegin, fileEnd, chunks[0]);
+	}
+	if (request) {
+		if (request->isCanceled()) {
+			return false;
+		}
+		request->setProgress(MODEL_LOAD_PARSING, kProgressParsed);
+	}
+
+	auto mergeTime = std::chrono::high_resolution_clock::now();
+	m_lastLoadStats.scanSeconds = std::chrono::duration<double>(mergeTime - scanTime).count();
+
+	// Concatenate the attributes in file order so global 1-based indices resolve directly
+	size_t totalPositions = 0, totalUvs = 0, totalNormals = 0, totalCorners = 0, totalFaces = 0;
+	bool missingNormals = false;
+	for (ObjChunk& chunk : chunks) {
+		if (chunk.failed) {
+			ERROR("ModelLoader.cpp", "loadModel", "Malformed face vertex, expected 'p', 'p/t', 'p//n' or 'p/t/n'.");
+			return false;
+		}
+
+		// Negative indices were resolved inside the chunk, offset them by the attributes before it
+		const int bases[3] = {
+			static_cast<int>(totalPositions), static_cast<int>(totalUvs), static_cast<int>(totalNormals) };
+		for (unsigned int relative : chunk.relativeIndices) {
+			VertexKey& corner = chunk.corners[relative / 3];
+			int& index = relative % 3 == 0 ? corner.pos : (relative % 3 == 1 ? corner.uv : corner.nrm);
+			index += bases[relative % 3];
+			if (index < 0) {
+				ERROR("ModelLoader.cpp", "loadModel", "Relative face index before the start of the file.");
+				return false;
+			}
+		}
+
+		missingNormals = missingNormals || chunk.missingNormals;
+		totalPositions += chunk.positions.size();
+		totalUvs += chunk.uvs.size();
+		totalNormals += chunk.normals.size();
+		totalCorners += chunk.corners.size();
+		totalFaces += chunk.faceSizes.size();
+	}
+
 	std::vector<XMFLOAT3> tempVertexes;
 	std::vector<XMFLOAT2> tempUvs;
 	std::vector<XMFLOAT3> tempNormals;
-	std::map<std::string, int> uniqueVertexes;
+	tempVertexes.reserve(totalPositions);
+	tempUvs.reserve(totalUvs);
+	tempNormals.reserve(totalNormals);
+	for (const ObjChunk& chunk : chunks) {
+		tempVertexes.insert(tempVertexes.end(), chunk.positions.begin(), chunk.positions.end());
+		tempUvs.insert(tempUvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+		tempNormals.insert(tempNormals.end(), chunk.normals.begin(), chunk.normals.end());
+	}
 
-	while (std::getline(file, line)) {
-		std::stringstream streamLine(line);
-		std::string prefix;
-		streamLine >> prefix;
+	// Without vn records (or if any corner lacks one) the normals are generated,
+	// smoothed over the OBJ position index of each vertex so they stay
+	// continuous across UV seams
+	const bool hasNormals = !tempNormals.empty() && !missingNormals;
+	std::vector<unsigned int> vertexPositions;
+	if (!hasNormals) {
+		vertexPositions.reserve(totalCorners / 4);
+	}
 
-		if (prefix == "vt") {
-			parseVec2(streamLine, tempUvs);
-		}
-		else if (prefix == "vn") {
-			parseVec3(streamLine, tempNormals);
+	// Weld corners on their parsed indices, sized so the table never has to grow
+	VertexHashTable uniqueVertexes;
+	uniqueVertexes.init(totalCorners);
+	outMesh.m_vertex.reserve(outMesh.m_vertex.size() + totalCorners / 4);
+	// A face of n corners becomes n - 2 triangles
+	const size_t totalTriangles = totalCorners > 2 * totalFaces ? totalCorners - 2 * totalFaces : 0;
+	outMesh.m_index.reserve(outMesh.m_index.size() + totalTriangles * 3);
+
+	// Reused by every face, they only grow when a face is larger than all before it
+	PolygonTriangulator triangulator;
+	std::vector<unsigned int> faceIndexes;
+	std::vector<XMFLOAT3> facePoints;
+	std::vector<unsigned int> faceTriangles;
+
+	// The faces of one object with one material form a part, with ids given in
+	// order of first use after the names the mesh already has. Runs are the
+	// consecutive indices of a part, in file order
+	auto getMaterialName = [](Material& material) -> std::string& { return material.name; };
+	auto getObjectName = [](std::string& name) -> std::string& { return name; };
+	std::unordered_map<std::string, unsigned int> materialIds;
+	std::unordered_map<std::string, unsigned int> objectIds;
+	for (size_t i = 0; i < outMesh.m_materials.size(); ++i) {
+		materialIds.emplace(outMesh.m_materials[i].name, static_cast<unsigned int>(i));
+	}
+	for (size_t i = 0; i < outMesh.m_objectNames.size(); ++i) {
+		objectIds.emplace(outMesh.m_objectNames[i], static_cast<unsigned int>(i));
+	}
+
+	std::map<std::pair<unsigned int, unsigned int>, unsigned int> partIds;
+	std::vector<SubMesh> parts;
+	std::vector<std::pair<unsigned int, size_t>> runs;
+	auto startRun = [&](unsigned int materialId, unsigned int objectId, size_t firstIndex) {
+		auto inserted = partIds.emplace(std::make_pair(materialId, objectId), static_cast<unsigned int>(parts.size()));
+		if (inserted.second) {
+			SubMesh part;
+			part.materialId = materialId;
+			part.objectId = objectId;
+			parts.push_back(part);
 		}
-		else if (prefix == "v") {
-			parseVec3(streamLine, tempVertexes);
+		if (runs.empty() || runs.back().first != inserted.first->second) {
+			runs.emplace_back(inserted.first->second, firstIndex);
 		}
-		else if (prefix == "f") {
+	};
+
+	// Indices already in the mesh keep their submeshes
+	if (!outMesh.m_index.empty() && outMesh.m_subMeshes.empty()) {
+		startRun(getNameId(materialIds, outMesh.m_materials, std::string(), getMaterialName),
+			getNameId(objectIds, outMesh.m_objectNames, std::string(), getObjectName), 0);
+	}
+	for (const SubMesh& subMesh : outMesh.m_subMeshes) {
+		startRun(subMesh.materialId, subMesh.objectId, subMesh.startIndex);
+	}
 
-			std::string chunk;
-			std::vector<int> faceIndexes;
+	for (const ObjChunk& chunk : chunks) {
+		for (const std::string& library : chunk.libraries) {
+			if (std::find(outMesh.m_materialLibraries.begin(), outMesh.m_materialLibraries.end(), library) ==
+					outMesh.m_materialLibraries.end()) {
+				outMesh.m_materialLibraries.push_back(library);
+			}
+		}
+	}
 
-			// For each vertex in the face (the entire line after 'f ')
-			while (streamLine >> chunk) {
-				
-				int finalIndex = 0;
+	// The triangles of this file are contiguous until the parts are gathered below
+	const size_t firstVertex = outMesh.m_vertex.size();
+	const size_t firstIndex = outMesh.m_index.size();
+	outMesh.m_indexFormat = DXGI_FORMAT_UNKNOWN;
 
-				if (uniqueVertexes.count(chunk)) {
-					// Vertex already exists, use the existing index
-					finalIndex = uniqueVertexes[chunk];
-				}
-				else {
+	// Faces before any o/g or usemtl have no name
+	std::string materialName;
+	std::string objectName;
+	bool nameChanged = true;
 
-					int posIdx, txtIdx, nrmIdx;
+	// Resolve the corners serially in file order, this keeps the output deterministic
+	for (const ObjChunk& chunk : chunks) {
+		const VertexKey* corner = chunk.corners.data();
+		size_t nextName = 0;
 
-					// Extract position, texture, and normal indices from the line of the vertex data
-					std::stringstream ss_vertexData(chunk);
-					std::string idxData;
+		for (size_t face = 0; face < chunk.faceSizes.size(); ++face) {
+			const unsigned int faceSize = chunk.faceSizes[face];
+			for (; nextName < chunk.names.size() && chunk.names[nextName].face == face; ++nextName) {
+				(chunk.names[nextName].material ? materialName : objectName) = chunk.names[nextName].name;
+				nameChanged = true;
+			}
+			if (nameChanged) {
+				startRun(getNameId(materialIds, outMesh.m_materials, materialName, getMaterialName),
+					getNameId(objectIds, outMesh.m_objectNames, objectName, getObjectName), outMesh.m_index.size());
+				nameChanged = false;
+			}
 
-					std::getline(ss_vertexData, idxData, '/');
-					posIdx = std::stoi(idxData) - 1;
+			if (faceIndexes.size() < faceSize) {
+				faceIndexes.resize(faceSize);
+				facePoints.resize(faceSize);
+				faceTriangles.resize(faceSize * 3);
+			}
 
-					std::getline(ss_vertexData, idxData, '/');
-					txtIdx = std::stoi(idxData) - 1;
+			// For each vertex in the face
+			for (unsigned int c = 0; c < faceSize; ++c, ++corner) {
+				int finalIndex = 0;
+				int newIndex = static_cast<int>(outMesh.m_vertex.size());
 
-					std::getline(ss_vertexData, idxData, '/');
-					nrmIdx = std::stoi(idxData) - 1;
+				// A vertex that already exists keeps its index
+				if (uniqueVertexes.findOrInsert(*corner, newIndex, finalIndex)) {
+					if (corner->pos < 0 || corner->pos >= static_cast<int>(tempVertexes.size()) ||
+							corner->uv >= static_cast<int>(tempUvs.size()) ||
+							(hasNormals && corner->nrm >= static_cast<int>(tempNormals.size()))) {
+						ERROR("ModelLoader.cpp", "loadModel", "Face vertex references missing data.");
+						return false;
+					}
 
 					SimpleVertex newVertex;
-					newVertex.Pos = tempVertexes[posIdx];
-					newVertex.Tex = tempUvs[txtIdx];
-					//newVertex.Norm = tempNormals[nrm_idx];
+					newVertex.Pos = tempVertexes[corner->pos];
+					newVertex.Tex = corner->uv != kMissingIndex ? tempUvs[corner->uv] : XMFLOAT2(0.0f, 0.0f);
+					newVertex.Norm = hasNormals ? tempNormals[corner->nrm] : XMFLOAT3(0.0f, 0.0f, 0.0f);
+					newVertex.Tangent = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+					if (!hasNormals) {
+						vertexPositions.push_back(static_cast<unsigned int>(corner->pos));
+					}
 
 					outMesh.m_vertex.push_back(newVertex);
-
-					int newIndex = static_cast<int>(outMesh.m_vertex.size()) - 1;
-					uniqueVertexes[chunk] = newIndex;
-
-					finalIndex = newIndex;
 				}
-				// Add the index to the temporal face vector
-				faceIndexes.push_back(finalIndex);
+				// Add the index to the temporal face array
+				faceIndexes[c] = finalIndex;
+				facePoints[c] = outMesh.m_vertex[finalIndex].Pos;
 			}
-			// Triangulate the face (assuming it's a quad or triangle)
-			if (faceIndexes.size() == 3) {
-				for (int idx : faceIndexes) {
-					outMesh.m_index.push_back(idx);
+			// Triangulate the face: triangles as they are, larger polygons as a
+			// fan when convex and by ear clipping when concave
+			if (faceSize == 3) {
+				for (size_t i = 0; i < 3; i++) {
+					outMesh.m_index.push_back(faceIndexes[i]);
 				}
 			}
-			else if (faceIndexes.size() == 4) {
-				for (int i = 0; i < 3; i++) {
-					outMesh.m_index.push_back(faceIndexes[i]);
+			else if (faceSize > 3) {
+				const size_t triangleCount = triangulator.triangulate(facePoints.data(), faceSize, faceTriangles.data());
+				for (size_t i = 0; i < triangleCount * 3; i++) {
+					outMesh.m_index.push_back(faceIndexes[faceTriangles[i]]);
 				}
-				outMesh.m_index.push_back(faceIndexes[0]);
-				outMesh.m_index.push_back(faceIndexes[2]);
-				outMesh.m_index.push_back(faceIndexes[3]);
 			}
 		}
+
+		// Names after the last face carry over to the next chunk
+		for (; nextName < chunk.names.size(); ++nextName) {
+			(chunk.names[nextName].material ? materialName : objectName) = chunk.names[nextName].name;
+			nameChanged = true;
+		}
+	}
+
+	if (request) {
+		if (request->isCanceled()) {
+			return false;
+		}
+		request->setProgress(MODEL_LOAD_PARSING, kProgressMerged);
+	}
+
+	auto normalTime = std::chrono::high_resolution_clock::now();
+	m_lastLoadStats.mergeSeconds = std::chrono::duration<double>(normalTime - mergeTime).count();
+
+	// Large meshes generate their normals and tangents on the parsing threads
+	ThreadPool* threadPool = nullptr;
+	if (threadCount > 1 && totalFaces >= 2 * kNormalMinTrianglesPerPartition) {
+		if (m_threadPool.getThreadCount() != threadCount - 1) {
+			m_threadPool.init(threadCount - 1);
+		}
+		threadPool = &m_threadPool;
+	}
+	// Only the vertices and triangles of this file, a mesh it is appended to keeps its own
+	SimpleVertex* newVertices = outMesh.m_vertex.data() + firstVertex;
+	const size_t newVertexCount = outMesh.m_vertex.size() - firstVertex;
+	const unsigned int* newIndices = outMesh.m_index.data() + firstIndex;
+	const size_t newIndexCount = outMesh.m_index.size() - firstIndex;
+	if (!hasNormals && !MeshNormals::computeNormals(newVertices, newVertexCount, newIndices, newIndexCount,
+			static_cast<unsigned int>(firstVertex), vertexPositions.data(), tempVertexes.size(), threadPool)) {
+		return false;
+	}
+	if (!MeshNormals::computeTangents(newVertices, newVertexCount, newIndices, newIndexCount,
+			static_cast<unsigned int>(firstVertex), threadPool)) {
+		return false;
+	}
+	m_lastLoadStats.generatedNormals = !hasNormals;
+	m_lastLoadStats.normalSeconds = std::chrono::duration<double>(
+		std::chrono::high_resolution_clock::now() - normalTime).count();
+
+	// One submesh per part, sorted by material so each material is bound once per level
+	std::vector<unsigned int> partOrder(parts.size());
+	for (size_t i = 0; i < runs.size(); ++i) {
+		const size_t end = i + 1 < runs.size() ? runs[i + 1].second : outMesh.m_index.size();
+		parts[runs[i].first].indexCount += static_cast<unsigned int>(end - runs[i].second);
+	}
+	for (size_t i = 0; i < partOrder.size(); ++i) {
+		partOrder[i] = static_cast<unsigned int>(i);
+	}
+	std::stable_sort(partOrder.begin(), partOrder.end(), [&](unsigned int a, unsigned int b) {
+		return parts[a].materialId != parts[b].materialId ?
+			parts[a].materialId < parts[b].materialId : parts[a].objectId < parts[b].objectId;
+	});
+
+	unsigned int nextStart = 0;
+	bool inOrder = runs.size() == parts.size();
+	for (size_t i = 0; i < partOrder.size(); ++i) {
+		parts[partOrder[i]].startIndex = nextStart;
+		nextStart += parts[partOrder[i]].indexCount;
+		inOrder = inOrder && runs[i].first == partOrder[i];
+	}
+
+	// Gather the runs of each part together, unless every part already is a single run in order
+	if (!inOrder) {
+		std::vector<unsigned int> sorted(outMesh.m_index.size());
+		std::vector<unsigned int> cursors(parts.size());
+		for (size_t i = 0; i < parts.size(); ++i) {
+			cursors[i] = parts[i].startIndex;
+		}
+		for (size_t i = 0; i < runs.size(); ++i) {
+			const size_t end = i + 1 < runs.size() ? runs[i + 1].second : outMesh.m_index.size();
+			std::copy(outMesh.m_index.begin() + runs[i].second, outMesh.m_index.begin() + end,
+				sorted.begin() + cursors[runs[i].first]);
+			cursors[runs[i].first] += static_cast<unsigned int>(end - runs[i].second);
+		}
+		outMesh.m_index.swap(sorted);
+	}
+
+	outMesh.m_subMeshes.clear();
+	for (unsigned int part : partOrder) {
+		if (parts[part].indexCount > 0) {
+			outMesh.m_subMeshes.push_back(parts[part]);
+		}
+	}
+
+	// The welded mesh can already be drawn, publish it before the slow passes
+	if (request) {
+		if (request->isCanceled()) {
+			return false;
+		}
+		if (m_optimizeMesh || m_lodLevelCount > 0) {
+			outMesh.m_numVertex = static_cast<int>(outMesh.m_vertex.size());
+			outMesh.m_numIndex = static_cast<int>(outMesh.m_index.size());
+			outMesh.computeBounds();
+			request->publish(outMesh);
+		}
+		request->setProgress(MODEL_LOAD_PROCESSING, kProgressPreview);
+	}
+
+	// The analyzers are full passes over the indices, they only run to report what the optimization did
+	auto optimizeTime = std::chrono::high_resolution_clock::now();
+	if (m_optimizeMesh) {
+		m_lastLoadStats.cacheBefore = MeshOptimizer::analyzeVertexCache(
+			outMesh.m_index.data(), outMesh.m_index.size(), outMesh.m_vertex.size());
+		m_lastLoadStats.fetchBefore = MeshOptimizer::analyzeVertexFetch(
+			outMesh.m_index.data(), outMesh.m_index.size(), outMesh.m_vertex.size(), sizeof(SimpleVertex));
+		if (!MeshOptimizer::optimizeMesh(outMesh)) {
+			ERROR("ModelLoader.cpp", "loadModel", "Failed to optimize the mesh.");
+			return false;
+		}
+		m_lastLoadStats.cacheAfter = MeshOptimizer::analyzeVertexCache(
+			outMesh.m_index.data(), outMesh.m_index.size(), outMesh.m_vertex.size());
+		m_lastLoadStats.fetchAfter = MeshOptimizer::analyzeVertexFetch(
+			outMesh.m_index.data(), outMesh.m_index.size(), outMesh.m_vertex.size(), sizeof(SimpleVertex));
+	}
+
+	if (request) {
+		if (request->isCanceled()) {
+			return false;
+		}
+		request->setProgress(MODEL_LOAD_PROCESSING, kProgressOptimized);
+	}
+
+	auto simplifyTime = std::chrono::high_resolution_clock::now();
+	if (m_lodLevelCount > 0 && !MeshSimplifier::buildLodChain(outMesh, m_lodLevelCount)) {
+		ERROR("ModelLoader.cpp", "loadModel", "Failed to build the levels of detail.");
+		return false;
+	}
+	std::chrono::duration<double> simplifying = std::chrono::high_resolution_clock::now() - simplifyTime;
+	m_lastLoadStats.simplifySeconds = simplifying.count();
+	if (request) {
+		if (request->isCanceled()) {
+			return false;
+		}
+		request->setProgress(MODEL_LOAD_PROCESSING, kProgressSimplified);
 	}
 
+	// Last, it makes the indices relative to the base vertex of each submesh
+	MeshOptimizer::splitIndex16(outMesh);
+	std::chrono::duration<double> optimizing = std::chrono::high_resolution_clock::now() - optimizeTime;
+
 	outMesh.m_numVertex = static_cast<int>(outMesh.m_vertex.size());
 	outMesh.m_numIndex = static_cast<int>(outMesh.m_index.size());
+	outMesh.computeBounds();
 
-	file.close();
+	auto endTime = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> elapsed = endTime - startTime;
+	m_lastLoadStats.fileBytes = file.size();
+	m_lastLoadStats.parseSeconds = elapsed.count();
+	m_lastLoadStats.optimizeSeconds = optimizing.count();
+	m_lastLoadStats.threadCount = chunkCount > 1 ? threadCount : 1;
+	m_lastLoadStats.chunkCount = static_cast<unsigned int>(chunkCount);
+	m_lastLoadStats.megabytesPerSecond = elapsed.count() > 0.0 ?
+		(file.size() / (1024.0 * 1024.0)) / elapsed.count() : 0.0;
 
+	// A failed write only costs a re-parse on the next run
+	if (useCache && !meshCache.save(cachePath, outMesh, sourceHash, cacheSettings)) {
+		ERROR("ModelLoader.cpp", "loadModel", "Failed to write the mesh cache.");
+	}
+
+	loadMaterials(fileName, outMesh);
 	return true;
 }
 
-void 
-ModelLoader::parseVec2(std::stringstream& streamLine, std::vector<XMFLOAT2>& outVector) {
+void
+ModelLoader::loadMaterials(const std::string& fileName, MeshComponent& outMesh) {
+	// A missing library only leaves its materials with the default values
+	const std::string directory = MaterialLibrary::getDirectory(fileName);
+	for (const std::string& library : outMesh.m_materialLibraries) {
+		MaterialLibrary::load(directory + library, outMesh.m_materials);
+	}
+}
+
+void
+ModelLoader::parseChunk(const char* begin, const char* end, ObjChunk& outChunk) {
+	const char* cursor = begin;
+
+	while (cursor < end) {
+		const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+		if (!lineEnd) {
+			lineEnd = end;
+		}
+
+		const char* prefix = skipBlanks(cursor, lineEnd);
+		const char* prefixEnd = prefix;
+		while (prefixEnd < lineEnd && !isBlank(*prefixEnd)) {
+			++prefixEnd;
+		}
+		const size_t prefixLength = static_cast<size_t>(prefixEnd - prefix);
+
+		if (prefixLength == 2 && prefix[0] == 'v' && prefix[1] == 't') {
+			parseVec2(prefixEnd, lineEnd, outChunk.uvs);
+		}
+		else if (prefixLength == 2 && prefix[0] == 'v' && prefix[1] == 'n') {
+			parseVec3(prefixEnd, lineEnd, outChunk.normals);
+		}
+		else if (prefixLength == 1 && prefix[0] == 'v') {
+			parseVec3(prefixEnd, lineEnd, outChunk.positions);
+		}
+		else if (prefixLength == 1 && prefix[0] == 'f') {
+			unsigned int faceSize = 0;
+
+			const char* chunk = skipBlanks(prefixEnd, lineEnd);
+			while (chunk < lineEnd) {
+				const char* chunkEnd = chunk;
+				while (chunkEnd < lineEnd && !isBlank(*chunkEnd)) {
+					++chunkEnd;
+				}
+
+				// Extract position, texture, and normal indices from the chunk
+				VertexKey corner;
+				if (scanCorner(chunk, chunkEnd, corner) != chunkEnd || corner.pos == 0) {
+					outChunk.failed = true;
+					return;
+				}
+
+				// Negative indices are rare, one test keeps the common case a straight line
+				if ((corner.pos | corner.uv | corner.nrm) < 0) {
+					const unsigned int cornerIndex = static_cast<unsigned int>(outChunk.corners.size()) * 3;
+					if (corner.pos < 0) outChunk.relativeIndices.push_back(cornerIndex);
+					if (corner.uv < 0) outChunk.relativeIndices.push_back(cornerIndex + 1);
+					if (corner.nrm < 0) outChunk.relativeIndices.push_back(cornerIndex + 2);
+				}
+				outChunk.missingNormals = outChunk.missingNormals || corner.nrm == 0;
+
+				// OBJ indices are 1-based
+				corner.pos = resolveIndex(corner.pos, outChunk.positions.size());
+				corner.uv = resolveIndex(corner.uv, outChunk.uvs.size());
+				corner.nrm = resolveIndex(corner.nrm, outChunk.normals.size());
+
+				outChunk.corners.push_back(corner);
+				++faceSize;
+
+				chunk = skipBlanks(chunkEnd, lineEnd);
+			}
+
+			outChunk.faceSizes.push_back(faceSize);
+		}
+		else if (prefixLength == 1 && (prefix[0] == 'o' || prefix[0] == 'g')) {
+			outChunk.names.push_back({ static_cast<unsigned int>(outChunk.faceSizes.size()), false,
+				readName(prefixEnd, lineEnd) });
+		}
+		else if (prefixLength == 6 && memcmp(prefix, "usemtl", 6) == 0) {
+			outChunk.names.push_back({ static_cast<unsigned int>(outChunk.faceSizes.size()), true,
+				readName(prefixEnd, lineEnd) });
+		}
+		else if (prefixLength == 6 && memcmp(prefix, "mtllib", 6) == 0) {
+			// Several libraries may be listed on one line
+			const char* name = skipBlanks(prefixEnd, lineEnd);
+			while (name < lineEnd) {
+				const char* nameEnd = name;
+				while (nameEnd < lineEnd && !isBlank(*nameEnd)) {
+					++nameEnd;
+				}
+				outChunk.libraries.emplace_back(name, nameEnd);
+				name = skipBlanks(nameEnd, lineEnd);
+			}
+		}
+
+		cursor = lineEnd + 1;
+	}
+}
+
+const char*
+ModelLoader::parseVec2(const char* cursor, const char* end, std::vector<XMFLOAT2>& outVector) {
 	XMFLOAT2 uv;
-	streamLine >> uv.x >> uv.y;
+	cursor = nextFloat(cursor, end, uv.x);
+	cursor = nextFloat(cursor, end, uv.y);
 
 	outVector.push_back(uv);
+	return cursor;
 }
 
-void 
-ModelLoader::parseVec3(std::stringstream& streamLine, std::vector<XMFLOAT3>& outVector) {
+const char*
+ModelLoader::parseVec3(const char* cursor, const char* end, std::vector<XMFLOAT3>& outVector) {
 	XMFLOAT3 pos;
-	streamLine >> pos.x >> pos.y >> pos.z;
+	cursor = nextFloat(cursor, end, pos.x);
+	cursor = nextFloat(cursor, end, pos.y);
+	cursor = nextFloat(cursor, end, pos.z);
 
 	outVector.push_back(pos);
+	return cursor;
 }
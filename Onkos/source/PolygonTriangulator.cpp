@@ -0,0 +1,139 @@
+#include "PolygonTriangulator.h"
+#include <cmath>
+
+/**
+ * Twice the signed area of the 2D triangle a, b, c.
+ */
+static inline float
+cross2(const XMFLOAT2& a, const XMFLOAT2& b, const XMFLOAT2& c) {
+	return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+/**
+ * Tests if p is inside or on the edges of the triangle a, b, c of the given orientation.
+ */
+static inline bool
+isInsideTriangle(const XMFLOAT2& p, const XMFLOAT2& a, const XMFLOAT2& b, const XMFLOAT2& c, float orientation) {
+	return cross2(a, b, p) * orientation >= 0.0f &&
+		cross2(b, c, p) * orientation >= 0.0f &&
+		cross2(c, a, p) * orientation >= 0.0f;
+}
+
+size_t
+PolygonTriangulator::triangulate(const XMFLOAT3* points, size_t cornerCount, unsigned int* outTriangles) {
+	if (cornerCount < 3) {
+		return 0;
+	}
+	if (cornerCount == 3) {
+		outTriangles[0] = 0;
+		outTriangles[1] = 1;
+		outTriangles[2] = 2;
+		return 1;
+	}
+
+	// Newell's normal is robust for concave and slightly non-planar polygons
+	float nx = 0.0f, ny = 0.0f, nz = 0.0f;
+	for (size_t i = 0; i < cornerCount; ++i) {
+		const XMFLOAT3& a = points[i];
+		const XMFLOAT3& b = points[(i + 1) % cornerCount];
+		nx += (a.y - b.y) * (a.z + b.z);
+		ny += (a.z - b.z) * (a.x + b.x);
+		nz += (a.x - b.x) * (a.y + b.y);
+	}
+
+	// Drop the axis the normal points along, the projection keeps the most area
+	m_projected.resize(cornerCount);
+	const float ax = std::fabs(nx), ay = std::fabs(ny), az = std::fabs(nz);
+	for (size_t i = 0; i < cornerCount; ++i) {
+		const XMFLOAT3& p = points[i];
+		if (az >= ax && az >= ay) {
+			m_projected[i] = XMFLOAT2(p.x, p.y);
+		}
+		else if (ax >= ay) {
+			m_projected[i] = XMFLOAT2(p.y, p.z);
+		}
+		else {
+			m_projected[i] = XMFLOAT2(p.z, p.x);
+		}
+	}
+
+	float area = 0.0f;
+	for (size_t i = 0; i < cornerCount; ++i) {
+		const XMFLOAT2& a = m_projected[i];
+		const XMFLOAT2& b = m_projected[(i + 1) % cornerCount];
+		area += a.x * b.y - b.x * a.y;
+	}
+	const float orientation = area < 0.0f ? -1.0f : 1.0f;
+
+	// Convex polygons (the common case) are a fan from the first corner
+	bool convex = true;
+	for (size_t i = 0; i < cornerCount && convex; ++i) {
+		const XMFLOAT2& prev = m_projected[(i + cornerCount - 1) % cornerCount];
+		const XMFLOAT2& next = m_projected[(i + 1) % cornerCount];
+		convex = cross2(prev, m_projected[i], next) * orientation >= 0.0f;
+	}
+	if (convex) {
+		for (size_t t = 0; t + 2 < cornerCount; ++t) {
+			outTriangles[t * 3] = 0;
+			outTriangles[t * 3 + 1] = static_cast<unsigned int>(t + 1);
+			outTriangles[t * 3 + 2] = static_cast<unsigned int>(t + 2);
+		}
+		return cornerCount - 2;
+	}
+
+	m_remaining.resize(cornerCount);
+	for (size_t i = 0; i < cornerCount; ++i) {
+		m_remaining[i] = static_cast<unsigned int>(i);
+	}
+
+	size_t written = 0;
+	size_t start = 0;
+	while (m_remaining.size() > 3) {
+		const size_t count = m_remaining.size();
+		size_t ear = start % count;
+
+		for (size_t k = 0; k < count; ++k) {
+			const size_t current = (start + k) % count;
+			const unsigned int prev = m_remaining[(current + count - 1) % count];
+			const unsigned int corner = m_remaining[current];
+			const unsigned int next = m_remaining[(current + 1) % count];
+			const XMFLOAT2& a = m_projected[prev];
+			const XMFLOAT2& b = m_projected[corner];
+			const XMFLOAT2& c = m_projected[next];
+			if (cross2(a, b, c) * orientation <= 0.0f) {
+				// Reflex or flat corner, not an ear
+				continue;
+			}
+
+			// Only reflex corners can be inside the ear of a simple polygon
+			bool empty = true;
+			for (size_t j = 0; j < count && empty; ++j) {
+				const unsigned int other = m_remaining[j];
+				if (other == prev || other == corner || other == next) {
+					continue;
+				}
+				const XMFLOAT2& p = m_projected[other];
+				const bool reflex = cross2(m_projected[m_remaining[(j + count - 1) % count]], p,
+					m_projected[m_remaining[(j + 1) % count]]) * orientation <= 0.0f;
+				empty = !reflex || !isInsideTriangle(p, a, b, c, orientation);
+			}
+			if (empty) {
+				ear = current;
+				break;
+			}
+		}
+
+		// Without an ear (degenerate or self-intersecting input) the search
+		// corner is clipped anyway, so the loop always ends
+		outTriangles[written++] = m_remaining[(ear + count - 1) % count];
+		outTriangles[written++] = m_remaining[ear];
+		outTriangles[written++] = m_remaining[(ear + 1) % count];
+		m_remaining.erase(m_remaining.begin() + ear);
+		start = ear;
+	}
+
+	outTriangles[written++] = m_remaining[0];
+	outTriangles[written++] = m_remaining[1];
+	outTriangles[written++] = m_remaining[2];
+	return cornerCount - 2;
+}
@@ -0,0 +1,282 @@
+#include "ResourceManager.h"
+#include "ContentHash.h"
+#include "Device.h"
+#include <algorithm>
+
+/**
+ * Makes the paths of the same file compare equal: forward slashes and, since
+ * the file system is case-insensitive on Windows, lower case.
+ */
+static std::string
+normalizePath(const std::string& fileName) {
+	std::string path = fileName;
+	for (char& c : path) {
+		c = c == '\\' ? '/' : static_cast<char>(tolower(static_cast<unsigned char>(c)));
+	}
+	return path;
+}
+
+/**
+ * Finds a live resource in a lookup table, dropping the entry if it was released.
+ */
+template<typename Key, typename T>
+static std::shared_ptr<T>
+findLive(std::unordered_map<Key, std::weak_ptr<T>>& table, const Key& key) {
+	auto it = table.find(key);
+	if (it == table.end()) {
+		return nullptr;
+	}
+	std::shared_ptr<T> resource = it->second.lock();
+	if (!resource) {
+		table.erase(it);
+	}
+	return resource;
+}
+
+/**
+ * Removes the entries of released resources from a lookup table.
+ */
+template<typename Key, typename T>
+static void
+collectTable(std::unordered_map<Key, std::weak_ptr<T>>& table) {
+	for (auto it = table.begin(); it != table.end();) {
+		it = it->second.expired() ? table.erase(it) : std::next(it);
+	}
+}
+
+/**
+ * Adds the live resources of a table (each resource is in it once) to the stats.
+ */
+template<typename T>
+static void
+countLive(const std::unordered_map<uint64_t, std::weak_ptr<T>>& table, ResourceCacheStats& stats) {
+	stats.liveCount = 0;
+	stats.liveBytes = 0;
+	for (const auto& entry : table) {
+		if (std::shared_ptr<T> resource = entry.second.lock()) {
+			++stats.liveCount;
+			stats.liveBytes += resource->bytes;
+		}
+	}
+}
+
+void
+ResourceManager::destroy() {
+	m_texturesByPath.clear();
+	m_texturesByFile.clear();
+	m_texturesByData.clear();
+	m_meshesByPath.clear();
+	m_meshesByFile.clear();
+	m_meshesByData.clear();
+	m_textureStats = ResourceCacheStats();
+	m_meshStats = ResourceCacheStats();
+}
+
+TextureHandle
+ResourceManager::acquireTexture(const std::string& fileName) {
+	const std::string path = normalizePath(fileName);
+	if (TextureHandle texture = findLive(m_texturesByPath, path)) {
+		++m_textureStats.pathHits;
+		m_textureStats.bytesSaved += texture->bytes;
+		return texture;
+	}
+
+	// A copy of a loaded file is found before decoding it. The source may be
+	// missing when only its cooked .onktex ships, it is staged anyway
+	uint64_t fileHash = 0;
+	const bool hashed = ContentHash::computeFile(fileName, fileHash);
+	if (hashed) {
+		if (TextureHandle texture = findLive(m_texturesByFile, fileHash)) {
+			++m_textureStats.fileHits;
+			m_textureStats.bytesSaved += texture->bytes;
+			m_texturesByPath[path] = texture;
+			return texture;
+		}
+	}
+
+	MipSettings mipSettings;
+	StagedTexture staged;
+	if (!TextureLoader::stage(fileName, &mipSettings, COMPRESSION_NONE, staged)) {
+		ERROR("ResourceManager", "acquireTexture", ("Failed to load texture: " + fileName).c_str());
+		++m_textureStats.failures;
+		return nullptr;
+	}
+
+	TextureHandle texture = internTexture(staged);
+	if (texture) {
+		m_texturesByPath[path] = texture;
+		if (hashed) {
+			m_texturesByFile[fileHash] = texture;
+		}
+	}
+	return texture;
+}
+
+TextureHandle
+ResourceManager::acquireTexture(const StagedTexture& staged) {
+	return internTexture(staged);
+}
+
+MeshHandle
+ResourceManager::acquireMesh(const std::string& fileName) {
+	const std::string path = normalizePath(fileName);
+	if (MeshHandle mesh = findLive(m_meshesByPath, path)) {
+		++m_meshStats.pathHits;
+		m_meshStats.bytesSaved += mesh->bytes;
+		return mesh;
+	}
+
+	// A copy of a loaded file is found before parsing it
+	uint64_t fileHash = 0;
+	const bool hashed = ContentHash::computeFile(fileName, fileHash);
+	if (hashed) {
+		MeshHandle mesh = findLive(m_meshesByFile, fileHash);
+		if (mesh && mesh->mesh.getIndexCount() > 0) {
+			++m_meshStats.fileHits;
+			m_meshStats.bytesSaved += mesh->bytes;
+			m_meshesByPath[path] = mesh;
+			return mesh;
+		}
+	}
+
+	MeshComponent loaded;
+	if (!m_modelLoader.loadModel(fileName, loaded)) {
+		ERROR("ResourceManager", "acquireMesh", ("Failed to load model: " + fileName).c_str());
+		++m_meshStats.failures;
+		return nullptr;
+	}
+
+	MeshHandle mesh = internMesh(loaded);
+	if (mesh) {
+		// Buffers created from memory don't keep the CPU mesh a file request expects
+		if (mesh->mesh.getIndexCount() == 0) {
+			mesh->mesh = std::move(loaded);
+		}
+		m_meshesByPath[path] = mesh;
+		if (hashed) {
+			m_meshesByFile[fileHash] = mesh;
+		}
+	}
+	return mesh;
+}
+
+MeshHandle
+ResourceManager::acquireMesh(const MeshComponent& mesh) {
+	return internMesh(mesh);
+}
+
+void
+ResourceManager::collect() {
+	collectTable(m_texturesByPath);
+	collectTable(m_texturesByFile);
+	collectTable(m_texturesByData);
+	collectTable(m_meshesByPath);
+	collectTable(m_meshesByFile);
+	collectTable(m_meshesByData);
+}
+
+ResourceCacheStats
+ResourceManager::getTextureStats() const {
+	ResourceCacheStats stats = m_textureStats;
+	countLive(m_texturesByData, stats);
+	return stats;
+}
+
+ResourceCacheStats
+ResourceManager::getMeshStats() const {
+	ResourceCacheStats stats = m_meshStats;
+	countLive(m_meshesByData, stats);
+	return stats;
+}
+
+uint64_t
+ResourceManager::hashTexture(const CookedTexture& texture) {
+	const uint32_t layout[3] = {
+		static_cast<uint32_t>(texture.format),
+		texture.arraySize,
+		texture.cubemap ? 1u : 0u
+	};
+	uint64_t hash = ContentHash::compute(layout, sizeof(layout));
+	for (const TextureSubresource& level : texture.mips) {
+		const uint32_t size[3] = { level.width, level.height, level.rowPitch };
+		hash = ContentHash::compute(size, sizeof(size), hash);
+		hash = ContentHash::compute(level.data, level.slicePitch, hash);
+	}
+	return hash;
+}
+
+uint64_t
+ResourceManager::hashMesh(const MeshComponent& mesh) {
+	const uint32_t format = static_cast<uint32_t>(mesh.getVertexFormat());
+	uint64_t hash = ContentHash::compute(&format, sizeof(format));
+	if (mesh.getVertexFormat() == VERTEX_FORMAT_QUANTIZED) {
+		hash = ContentHash::compute(mesh.m_quantizedVertex.data(),
+			mesh.m_quantizedVertex.size() * sizeof(QuantizedVertex), hash);
+	}
+	else {
+		hash = ContentHash::compute(mesh.getVertexData(), mesh.getVertexCount() * sizeof(SimpleVertex), hash);
+	}
+	return ContentHash::compute(mesh.getIndexData(), mesh.getIndexCount() * sizeof(unsigned int), hash);
+}
+
+TextureHandle
+ResourceManager::internTexture(const StagedTexture& staged) {
+	if (!m_device) {
+		ERROR("ResourceManager", "internTexture", "The manager has no device, call init first.");
+		++m_textureStats.failures;
+		return nullptr;
+	}
+
+	uint64_t bytes = 0;
+	for (const TextureSubresource& level : staged.texture.mips) {
+		bytes += level.slicePitch;
+	}
+	const uint64_t dataHash = hashTexture(staged.texture);
+	if (TextureHandle texture = findLive(m_texturesByData, dataHash)) {
+		++m_textureStats.dataHits;
+		m_textureStats.bytesSaved += texture->bytes;
+		return texture;
+	}
+
+	TextureHandle texture = std::make_shared<SharedTexture>();
+	if (FAILED(texture->texture.init(*m_device, staged))) {
+		++m_textureStats.failures;
+		return nullptr;
+	}
+	texture->dataHash = dataHash;
+	texture->bytes = bytes;
+	m_texturesByData[dataHash] = texture;
+	++m_textureStats.misses;
+	return texture;
+}
+
+MeshHandle
+ResourceManager::internMesh(const MeshComponent& mesh) {
+	if (!m_device) {
+		ERROR("ResourceManager", "internMesh", "The manager has no device, call init first.");
+		++m_meshStats.failures;
+		return nullptr;
+	}
+
+	const uint64_t dataHash = hashMesh(mesh);
+	if (MeshHandle shared = findLive(m_meshesByData, dataHash)) {
+		++m_meshStats.dataHits;
+		m_meshStats.bytesSaved += shared->bytes;
+		return shared;
+	}
+
+	MeshHandle shared = std::make_shared<SharedMesh>();
+	if (FAILED(shared->vertexBuffer.init(*m_device, mesh, D3D11_BIND_VERTEX_BUFFER)) ||
+			FAILED(shared->indexBuffer.init(*m_device, mesh, D3D11_BIND_INDEX_BUFFER))) {
+		++m_meshStats.failures;
+		return nullptr;
+	}
+	const uint64_t vertexBytes = mesh.getVertexFormat() == VERTEX_FORMAT_QUANTIZED ?
+		mesh.m_quantizedVertex.size() * sizeof(QuantizedVertex) : mesh.getVertexCount() * sizeof(SimpleVertex);
+	const uint64_t indexBytes = mesh.getIndexCount() * (mesh.getIndexFormat() == DXGI_FORMAT_R16_UINT ? 2 : 4);
+	shared->bytes = vertexBytes + indexBytes;
+	shared->dataHash = dataHash;
+	m_meshesByData[dataHash] = shared;
+	++m_meshStats.misses;
+	return shared;
+}
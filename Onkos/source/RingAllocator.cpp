@@ -0,0 +1,83 @@
+#include "RingAllocator.h"
+
+bool
+RingAllocator::init(uint64_t capacity, unsigned int alignment) {
+	m_frames.clear();
+	m_head = 0;
+	m_tail = 0;
+	m_frameBytes = 0;
+	m_stats = RingAllocatorStats();
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0 || capacity < alignment) {
+		ERROR("RingAllocator", "init", "The alignment must be a power of two no larger than the capacity.");
+		m_alignment = 0;
+		return false;
+	}
+	m_alignment = alignment;
+	m_stats.capacity = capacity & ~static_cast<uint64_t>(alignment - 1);
+	return true;
+}
+
+bool
+RingAllocator::allocate(unsigned int size, uint64_t& outOffset) {
+	if (m_alignment == 0 || size == 0) {
+		return false;
+	}
+	const uint64_t alignedSize = (static_cast<uint64_t>(size) + m_alignment - 1) & ~static_cast<uint64_t>(m_alignment - 1);
+	const uint64_t capacity = m_stats.capacity;
+
+	// Every range is free: start over so the largest range fits
+	if (m_stats.usedBytes == 0) {
+		m_head = 0;
+		m_tail = 0;
+	}
+
+	uint64_t skipped = 0;
+	if (m_stats.usedBytes == 0 || m_head > m_tail) {
+		// The free space is [head, capacity) and then [0, tail)
+		if (alignedSize > capacity - m_head) {
+			if (alignedSize > m_tail) {
+				++m_stats.failedCount;
+				return false;
+			}
+			skipped = capacity - m_head;
+		}
+	}
+	else if (alignedSize > m_tail - m_head) {
+		// The free space is [head, tail), none when the ring is full
+		++m_stats.failedCount;
+		return false;
+	}
+
+	if (skipped > 0) {
+		m_head = 0;
+		++m_stats.wrapCount;
+	}
+	outOffset = m_head;
+	m_head += alignedSize;
+	if (m_head == capacity) {
+		m_head = 0;
+	}
+	m_frameBytes += skipped + alignedSize;
+	m_stats.usedBytes += skipped + alignedSize;
+	m_stats.peakBytes = m_stats.usedBytes > m_stats.peakBytes ? m_stats.usedBytes : m_stats.peakBytes;
+	++m_stats.allocationCount;
+	return true;
+}
+
+void
+RingAllocator::endFrame(uint64_t fence) {
+	if (m_frameBytes > 0) {
+		m_frames.push_back(Frame{ fence, m_frameBytes });
+		m_frameBytes = 0;
+	}
+}
+
+void
+RingAllocator::retire(uint64_t completedFence) {
+	// Frames take their bytes in order from the tail, so they are freed in order too
+	while (!m_frames.empty() && m_frames.front().fence <= completedFence) {
+		m_tail = (m_tail + m_frames.front().bytes) % m_stats.capacity;
+		m_stats.usedBytes -= m_frames.front().bytes;
+		m_frames.pop_front();
+	}
+}
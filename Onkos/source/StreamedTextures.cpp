@@ -0,0 +1,46 @@
+#include "StreamedTextures.h"
+#include "Device.h"
+#include "TextureLoader.h"
+
+void
+StreamedTextures::destroy() {
+	for (Texture& texture : m_textures) {
+		texture.destroy();
+	}
+	m_textures.clear();
+}
+
+bool
+StreamedTextures::createTexture(StreamedTextureId id, const StagedTexture& texture, unsigned int firstMip) {
+	if (!m_device) {
+		ERROR("StreamedTextures", "createTexture", "Device is null.");
+		return false;
+	}
+
+	Texture resident;
+	if (FAILED(resident.init(*m_device, texture, firstMip))) {
+		return false;
+	}
+	if (id >= m_textures.size()) {
+		m_textures.resize(id + 1);
+	}
+	m_textures[id].destroy();
+	m_textures[id] = resident;
+	return true;
+}
+
+void
+StreamedTextures::releaseTexture(StreamedTextureId id) {
+	if (id < m_textures.size()) {
+		m_textures[id].destroy();
+		m_textures[id] = Texture();
+	}
+}
+
+Texture*
+StreamedTextures::getTexture(StreamedTextureId id) {
+	if (id >= m_textures.size() || !m_textures[id].m_textureFromImg) {
+		return nullptr;
+	}
+	return &m_textures[id];
+}
@@ -1,8 +1,11 @@
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
 #include "Texture.h"
 #include "Device.h"
 #include "DeviceContext.h"
+#include "ImageDecoder.h"
+#include "MipGenerator.h"
+#include "TextureCache.h"
+#include "TextureContainer.h"
+#include "TextureLoader.h"
 
 HRESULT
 Texture::init(Device& device,
@@ -20,121 +23,63 @@ Texture::init(Device& device,
   HRESULT hr = S_OK;
 
   switch (extensionType) {
-  case DDS: {
-    m_textureName = textureName + ".dds";
-
-    // Cargar textura DDS
-    hr = D3DX11CreateShaderResourceViewFromFile(
-      device.m_device,
-      m_textureName.c_str(),
-      nullptr,
-      nullptr,
-      &m_textureFromImg,
-      nullptr
-    );
+  case DDS:
+  case KTX2: {
+    m_textureName = textureName + (extensionType == DDS ? ".dds" : ".ktx2");
+
+    // The subresources point into the mapped file, nothing is copied
+    StagedTexture staged;
+    staged.fileName = m_textureName;
+    if (!TextureContainer::load(m_textureName, staged.texture)) {
+      ERROR("Texture", "init",
+        ("Failed to load texture container. Verify filepath: " + m_textureName).c_str());
+      return E_FAIL;
+    }
 
+    hr = init(device, staged);
     if (FAILED(hr)) {
-      ERROR("Texture", "init",
-        ("Failed to load DDS texture. Verify filepath: " + m_textureName).c_str());
       return hr;
     }
     break;
   }
 
-  case PNG: {
-    m_textureName = textureName + ".png";
-    int width, height, channels;
-    unsigned char* data = stbi_load(m_textureName.c_str(), &width, &height, &channels, 4); // 4 bytes por pixel (RGBA)
-    if (!data) {
+  case PNG:
+  case JPG: {
+    m_textureName = textureName + (extensionType == PNG ? ".png" : ".jpg");
+
+    // Upload the full mip chain so minified textures don't alias
+    StagedTexture staged;
+    staged.fileName = m_textureName;
+    staged.images.resize(1);
+    if (!ImageDecoder::decodeFile(m_textureName, staged.images[0])) {
       ERROR("Texture", "init",
-        ("Failed to load PNG texture: " + std::string(stbi_failure_reason())).c_str());
+        ("Failed to load texture. Verify filepath: " + m_textureName).c_str());
       return E_FAIL;
     }
+    MipGenerator::generate(staged.images);
+    staged.texture.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    staged.texture.mips = TextureCache::describe(staged.images);
 
-    // Crear descripci?n de textura
-    D3D11_TEXTURE2D_DESC textureDesc = {};
-    textureDesc.Width = width;
-    textureDesc.Height = height;
-    textureDesc.MipLevels = 1;
-    textureDesc.ArraySize = 1;
-    textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    textureDesc.SampleDesc.Count = 1;
-    textureDesc.Usage = D3D11_USAGE_DEFAULT;
-    textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-
-    // Crear datos de subrecarga
-    D3D11_SUBRESOURCE_DATA initData = {};
-    initData.pSysMem = data;
-    initData.SysMemPitch = width * 4;
-
-    hr = device.CreateTexture2D(&textureDesc, &initData, &m_texture);
-    stbi_image_free(data); // Liberar los datos de imagen inmediatamente
-
-    if (FAILED(hr)) {
-      ERROR("Texture", "init", "Failed to create texture from PNG data");
-      return hr;
-    }
-
-    // Crear vista del recurso de la textura
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Format = textureDesc.Format;
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = 1;
-
-    hr = device.m_device->CreateShaderResourceView(m_texture, &srvDesc, &m_textureFromImg);
-    SAFE_RELEASE(m_texture); // Liberar textura intermedia
-
+    hr = init(device, staged);
     if (FAILED(hr)) {
-      ERROR("Texture", "init", "Failed to create shader resource view for PNG texture");
       return hr;
     }
     break;
   }
-  case JPG: {
-    m_textureName = textureName + ".jpg";
-    int width, height, channels;
-    unsigned char* data = stbi_load(m_textureName.c_str(), &width, &height, &channels, 4); // 4 bytes por pixel (RGBA)
-    if (!data) {
+  case ONKTEX: {
+    m_textureName = textureName + ".onktex";
+
+    // The mip chain is used straight from the mapped file, nothing is decoded
+    StagedTexture staged;
+    TextureCache textureCache;
+    if (!textureCache.load(m_textureName, staged.texture)) {
       ERROR("Texture", "init",
-        ("Failed to load JPG texture: " + std::string(stbi_failure_reason())).c_str());
+        ("Failed to load cooked texture. Verify filepath: " + m_textureName).c_str());
       return E_FAIL;
     }
 
-    // Crear descripci?n de textura
-    D3D11_TEXTURE2D_DESC textureDesc = {};
-    textureDesc.Width = width;
-    textureDesc.Height = height;
-    textureDesc.MipLevels = 1;
-    textureDesc.ArraySize = 1;
-    textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    textureDesc.SampleDesc.Count = 1;
-    textureDesc.Usage = D3D11_USAGE_DEFAULT;
-    textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-
-    // Crear datos de subrecarga
-    D3D11_SUBRESOURCE_DATA initData = {};
-    initData.pSysMem = data;
-    initData.SysMemPitch = width * 4;
-
-    hr = device.CreateTexture2D(&textureDesc, &initData, &m_texture);
-    stbi_image_free(data); // Liberar los datos de imagen inmediatamente
-
-    if (FAILED(hr)) {
-      ERROR("Texture", "init", "Failed to create texture from PNG data");
-      return hr;
-    }
-
-    // Crear vista del recurso de la textura
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Format = textureDesc.Format;
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = 1;
-
-    hr = device.m_device->CreateShaderResourceView(m_texture, &srvDesc, &m_textureFromImg);
-    SAFE_RELEASE(m_texture); // Liberar textura intermedia
-
+    hr = init(device, staged);
     if (FAILED(hr)) {
-      ERROR("Texture", "init", "Failed to create shader resource view for JPG texture");
       return hr;
     }
     break;
@@ -147,6 +92,88 @@ Texture::init(Device& device,
   return hr;
 }
 
+HRESULT
+Texture::init(Device& device, const StagedTexture& staged, unsigned int firstMip) {
+  if (!device.m_device) {
+    ERROR("Texture", "init", "Device is null.");
+    return E_POINTER;
+  }
+  const CookedTexture& cooked = staged.texture;
+  if (cooked.mips.empty() || cooked.arraySize == 0 || cooked.mips.size() % cooked.arraySize != 0 ||
+      (cooked.cubemap && cooked.arraySize % 6 != 0)) {
+    ERROR("Texture", "init", "The staged texture has no levels or an invalid array layout.");
+    return E_INVALIDARG;
+  }
+  const UINT sourceMipLevels = static_cast<UINT>(cooked.mips.size() / cooked.arraySize);
+  if (firstMip >= sourceMipLevels) {
+    ERROR("Texture", "init", "The first mip is past the last level of the staged texture.");
+    return E_INVALIDARG;
+  }
+  const UINT mipLevels = sourceMipLevels - firstMip;
+  if (!staged.fileName.empty()) {
+    m_textureName = staged.fileName;
+  }
+
+  D3D11_TEXTURE2D_DESC textureDesc = {};
+  textureDesc.Width = cooked.mips[firstMip].width;
+  textureDesc.Height = cooked.mips[firstMip].height;
+  textureDesc.MipLevels = mipLevels;
+  textureDesc.ArraySize = cooked.arraySize;
+  textureDesc.Format = cooked.format;
+  textureDesc.SampleDesc.Count = 1;
+  textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+  textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+  textureDesc.MiscFlags = cooked.cubemap ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+  // Skip the levels finer than firstMip in every slice
+  std::vector<D3D11_SUBRESOURCE_DATA> initData(static_cast<size_t>(mipLevels) * cooked.arraySize);
+  for (UINT slice = 0; slice < cooked.arraySize; ++slice) {
+    for (UINT mip = 0; mip < mipLevels; ++mip) {
+      const TextureSubresource& level = cooked.mips[slice * sourceMipLevels + firstMip + mip];
+      D3D11_SUBRESOURCE_DATA& data = initData[slice * mipLevels + mip];
+      data.pSysMem = level.data;
+      data.SysMemPitch = level.rowPitch;
+      data.SysMemSlicePitch = level.slicePitch;
+    }
+  }
+
+  HRESULT hr = device.CreateTexture2D(&textureDesc, initData.data(), &m_texture);
+  if (FAILED(hr)) {
+    ERROR("Texture", "init", ("Failed to create texture from staged data: " + m_textureName).c_str());
+    return hr;
+  }
+
+  D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+  srvDesc.Format = textureDesc.Format;
+  if (cooked.cubemap && cooked.arraySize == 6) {
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+    srvDesc.TextureCube.MipLevels = mipLevels;
+  }
+  else if (cooked.cubemap) {
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBEARRAY;
+    srvDesc.TextureCubeArray.MipLevels = mipLevels;
+    srvDesc.TextureCubeArray.NumCubes = cooked.arraySize / 6;
+  }
+  else if (cooked.arraySize > 1) {
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    srvDesc.Texture2DArray.MipLevels = mipLevels;
+    srvDesc.Texture2DArray.ArraySize = cooked.arraySize;
+  }
+  else {
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = mipLevels;
+  }
+
+  hr = device.m_device->CreateShaderResourceView(m_texture, &srvDesc, &m_textureFromImg);
+  SAFE_RELEASE(m_texture); // Liberar textura intermedia
+
+  if (FAILED(hr)) {
+    ERROR("Texture", "init", "Failed to create shader resource view for staged texture");
+    return hr;
+  }
+  return S_OK;
+}
+
 HRESULT
 Texture::init(Device& device,
   unsigned int width,
@@ -0,0 +1,168 @@
+#include "TextureCache.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// Levels start at multiples of this, so mapped pointers are suitably aligned
+static const uint64_t kTextureCacheAlignment = 16;
+
+static inline uint64_t
+alignOffset(uint64_t offset) {
+	return (offset + kTextureCacheAlignment - 1) & ~(kTextureCacheAlignment - 1);
+}
+
+bool
+TextureCache::save(const std::string& cachePath,
+									 DXGI_FORMAT format,
+									 const std::vector<TextureSubresource>& mips,
+									 uint64_t sourceHash) {
+	if (mips.empty()) {
+		ERROR("TextureCache", "save", "The texture has no mip levels.");
+		return false;
+	}
+
+	TextureCacheHeader header = {};
+	header.magic = kTextureCacheMagic;
+	header.version = kTextureCacheVersion;
+	header.headerSize = sizeof(TextureCacheHeader);
+	header.format = static_cast<uint32_t>(format);
+	header.width = mips[0].width;
+	header.height = mips[0].height;
+	header.mipCount = static_cast<uint32_t>(mips.size());
+	header.sourceHash = sourceHash;
+
+	std::vector<TextureCacheMip> table(mips.size());
+	uint64_t offset = alignOffset(sizeof(TextureCacheHeader) + table.size() * sizeof(TextureCacheMip));
+	for (size_t i = 0; i < mips.size(); ++i) {
+		table[i].offset = offset;
+		table[i].size = mips[i].slicePitch;
+		table[i].rowPitch = mips[i].rowPitch;
+		table[i].width = mips[i].width;
+		table[i].height = mips[i].height;
+		offset = alignOffset(offset + mips[i].slicePitch);
+	}
+
+	const std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			ERROR("TextureCache", "save", ("The file couldn't be created: " + tempPath).c_str());
+			return false;
+		}
+
+		static const char zeros[kTextureCacheAlignment] = {};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(table.data()),
+			static_cast<std::streamsize>(table.size() * sizeof(TextureCacheMip)));
+
+		uint64_t written = sizeof(header) + table.size() * sizeof(TextureCacheMip);
+		for (size_t i = 0; i < mips.size(); ++i) {
+			file.write(zeros, static_cast<std::streamsize>(table[i].offset - written));
+			file.write(static_cast<const char*>(mips[i].data), mips[i].slicePitch);
+			written = table[i].offset + mips[i].slicePitch;
+		}
+
+		if (!file.good()) {
+			ERROR("TextureCache", "save", "Failed to write the texture cache.");
+			file.close();
+			std::remove(tempPath.c_str());
+			return false;
+		}
+	}
+
+	// Replace the old file only once the new one is complete, in one step
+	std::error_code error;
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error) {
+		ERROR("TextureCache", "save", ("Failed to rename the texture cache: " + cachePath).c_str());
+		std::remove(tempPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool
+TextureCache::load(const std::string& cachePath, uint64_t sourceHash, CookedTexture& outTexture) {
+	return loadInternal(cachePath, true, sourceHash, outTexture);
+}
+
+bool
+TextureCache::load(const std::string& cachePath, CookedTexture& outTexture) {
+	return loadInternal(cachePath, false, 0, outTexture);
+}
+
+std::vector<TextureSubresource>
+TextureCache::describe(const std::vector<Image>& mips) {
+	std::vector<TextureSubresource> subresources(mips.size());
+	for (size_t i = 0; i < mips.size(); ++i) {
+		subresources[i].data = mips[i].pixels.data();
+		subresources[i].rowPitch = mips[i].getRowPitch();
+		subresources[i].slicePitch = static_cast<unsigned int>(mips[i].pixels.size());
+		subresources[i].width = mips[i].width;
+		subresources[i].height = mips[i].height;
+	}
+	return subresources;
+}
+
+bool
+TextureCache::loadInternal(const std::string& cachePath,
+													 bool checkHash,
+													 uint64_t sourceHash,
+													 CookedTexture& outTexture) {
+	std::ifstream probe(cachePath, std::ios::binary);
+	if (!probe.is_open()) {
+		// Not cooked yet, not an error
+		return false;
+	}
+	probe.close();
+
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	if (!file->init(cachePath) || file->size() < sizeof(TextureCacheHeader)) {
+		return false;
+	}
+
+	TextureCacheHeader header;
+	memcpy(&header, file->data(), sizeof(header));
+	if (header.magic != kTextureCacheMagic ||
+			header.version != kTextureCacheVersion ||
+			header.headerSize != sizeof(TextureCacheHeader) ||
+			header.mipCount == 0) {
+		return false;
+	}
+	if (checkHash && header.sourceHash != sourceHash) {
+		// The source image changed since the texture was cooked
+		return false;
+	}
+
+	const uint64_t tableEnd = sizeof(TextureCacheHeader) + static_cast<uint64_t>(header.mipCount) * sizeof(TextureCacheMip);
+	if (tableEnd > file->size()) {
+		ERROR("TextureCache", "load", ("The texture cache is corrupted: " + cachePath).c_str());
+		return false;
+	}
+
+	std::vector<TextureSubresource> mips(header.mipCount);
+	for (uint32_t i = 0; i < header.mipCount; ++i) {
+		TextureCacheMip entry;
+		memcpy(&entry, file->data() + sizeof(TextureCacheHeader) + i * sizeof(TextureCacheMip), sizeof(entry));
+		if (entry.offset % kTextureCacheAlignment != 0 || entry.offset + entry.size > file->size()) {
+			ERROR("TextureCache", "load", ("The texture cache is corrupted: " + cachePath).c_str());
+			return false;
+		}
+		mips[i].data = file->data() + entry.offset;
+		mips[i].rowPitch = entry.rowPitch;
+		mips[i].slicePitch = entry.size;
+		mips[i].width = entry.width;
+		mips[i].height = entry.height;
+	}
+
+	outTexture.format = static_cast<DXGI_FORMAT>(header.format);
+	outTexture.mips.swap(mips);
+	outTexture.arraySize = 1;
+	outTexture.cubemap = false;
+	outTexture.file = file;
+
+	return true;
+}
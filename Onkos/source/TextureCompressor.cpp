@@ -0,0 +1,926 @@
+#include "TextureCompressor.h"
+#include "ImageProcessor.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Images smaller than this are encoded on the calling thread
+static const size_t kMinParallelBlocks = 1024;
+static const unsigned int kBlockRowsPerTask = 4;
+
+// Least-squares passes of the high quality preset
+static const int kRefineIterations = 2;
+
+// Interpolation weights of 4-bit BC7 indices, out of 64
+static const int kBc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+/**
+ * Reads the 4x4 texels of a block, repeating the last row and column past the edge.
+ */
+static void
+loadBlock(const Image& image, unsigned int blockX, unsigned int blockY, unsigned char texels[64]) {
+	for (unsigned int y = 0; y < 4; ++y) {
+		const unsigned int sy = blockY * 4 + y < image.height ? blockY * 4 + y : image.height - 1;
+		const unsigned char* row = image.pixels.data() + static_cast<size_t>(sy) * image.getRowPitch();
+		for (unsigned int x = 0; x < 4; ++x) {
+			const unsigned int sx = blockX * 4 + x < image.width ? blockX * 4 + x : image.width - 1;
+			memcpy(texels + (y * 4 + x) * 4, row + sx * 4, 4);
+		}
+	}
+}
+
+static void
+storeBlock(Image& image, unsigned int blockX, unsigned int blockY, const unsigned char texels[64]) {
+	for (unsigned int y = 0; y < 4 && blockY * 4 + y < image.height; ++y) {
+		unsigned char* row = image.pixels.data() + static_cast<size_t>(blockY * 4 + y) * image.getRowPitch();
+		for (unsigned int x = 0; x < 4 && blockX * 4 + x < image.width; ++x) {
+			memcpy(row + (blockX * 4 + x) * 4, texels + (y * 4 + x) * 4, 4);
+		}
+	}
+}
+
+static inline int
+clampInt(int value, int low, int high) {
+	return value < low ? low : (value > high ? high : value);
+}
+
+/**
+ * The principal axis of a set of points with channelCount channels, by power iteration.
+ */
+static void
+computePrincipalAxis(const float* points, int pointCount, int channelCount, const float* mean, float* axis) {
+	float covariance[4][4] = {};
+	for (int i = 0; i < pointCount; ++i) {
+		for (int a = 0; a < channelCount; ++a) {
+			for (int b = a; b < channelCount; ++b) {
+				covariance[a][b] += (points[i * 4 + a] - mean[a]) * (points[i * 4 + b] - mean[b]);
+			}
+		}
+	}
+	for (int a = 0; a < channelCount; ++a) {
+		for (int b = 0; b < a; ++b) {
+			covariance[a][b] = covariance[b][a];
+		}
+	}
+
+	for (int c = 0; c < channelCount; ++c) {
+		axis[c] = 1.0f;
+	}
+	for (int iteration = 0; iteration < 8; ++iteration) {
+		float next[4] = {};
+		float length = 0.0f;
+		for (int a = 0; a < channelCount; ++a) {
+			for (int b = 0; b < channelCount; ++b) {
+				next[a] += covariance[a][b] * axis[b];
+			}
+			length = fabsf(next[a]) > length ? fabsf(next[a]) : length;
+		}
+		if (length < 1e-8f) {
+			break;
+		}
+		for (int c = 0; c < channelCount; ++c) {
+			axis[c] = next[c] / length;
+		}
+	}
+}
+
+/**
+ * The end points of a block: the extremes of the texels along the principal
+ * axis (high quality) or the corners of the bounding box on the diagonal that
+ * follows the correlation of the channels (fast).
+ */
+static void
+findEndpoints(const float* points, int channelCount, CompressionQuality quality, float* low, float* high) {
+	float mean[4] = {};
+	float minimum[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+	float maximum[4] = {};
+	for (int i = 0; i < 16; ++i) {
+		for (int c = 0; c < channelCount; ++c) {
+			const float value = points[i * 4 + c];
+			mean[c] += value / 16.0f;
+			minimum[c] = value < minimum[c] ? value : minimum[c];
+			maximum[c] = value > maximum[c] ? value : maximum[c];
+		}
+	}
+
+	if (quality == COMPRESSION_HIGH) {
+		float axis[4];
+		computePrincipalAxis(points, 16, channelCount, mean, axis);
+		float lowest = 1e30f, highest = -1e30f;
+		for (int i = 0; i < 16; ++i) {
+			float t = 0.0f;
+			for (int c = 0; c < channelCount; ++c) {
+				t += (points[i * 4 + c] - mean[c]) * axis[c];
+			}
+			lowest = t < lowest ? t : lowest;
+			highest = t > highest ? t : highest;
+		}
+		float axisLength = 0.0f;
+		for (int c = 0; c < channelCount; ++c) {
+			axisLength += axis[c] * axis[c];
+		}
+		axisLength = axisLength > 1e-8f ? axisLength : 1.0f;
+		for (int c = 0; c < channelCount; ++c) {
+			low[c] = clampInt(static_cast<int>(mean[c] + axis[c] * lowest / axisLength + 0.5f), 0, 255);
+			high[c] = clampInt(static_cast<int>(mean[c] + axis[c] * highest / axisLength + 0.5f), 0, 255);
+		}
+		return;
+	}
+
+	// The channel with the widest range decides the direction of the others
+	int reference = 0;
+	for (int c = 1; c < channelCount; ++c) {
+		if (maximum[c] - minimum[c] > maximum[reference] - minimum[reference]) {
+			reference = c;
+		}
+	}
+	for (int c = 0; c < channelCount; ++c) {
+		float covariance = 0.0f;
+		for (int i = 0; i < 16; ++i) {
+			covariance += (points[i * 4 + c] - mean[c]) * (points[i * 4 + reference] - mean[reference]);
+		}
+		// Inset the box a little, the extremes are rarely worth their error elsewhere
+		const float inset = (maximum[c] - minimum[c]) / 16.0f;
+		low[c] = minimum[c] + inset;
+		high[c] = maximum[c] - inset;
+		if (covariance < 0.0f) {
+			const float swap = low[c];
+			low[c] = high[c];
+			high[c] = swap;
+		}
+	}
+}
+
+/**
+ * Solves the end points that best fit the texels for fixed interpolation
+ * weights (0 picks low, 1 picks high). Returns false if they are degenerate.
+ */
+static bool
+solveEndpoints(const float* points, const float* weights, int channelCount, float* low, float* high) {
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[4] = {}, bx[4] = {};
+	for (int i = 0; i < 16; ++i) {
+		const float b = weights[i];
+		const float a = 1.0f - b;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (int c = 0; c < channelCount; ++c) {
+			ax[c] += a * points[i * 4 + c];
+			bx[c] += b * points[i * 4 + c];
+		}
+	}
+	const float determinant = aa * bb - ab * ab;
+	if (fabsf(determinant) < 1e-6f) {
+		return false;
+	}
+	for (int c = 0; c < channelCount; ++c) {
+		low[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+		high[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+		low[c] = low[c] < 0.0f ? 0.0f : (low[c] > 255.0f ? 255.0f : low[c]);
+		high[c] = high[c] < 0.0f ? 0.0f : (high[c] > 255.0f ? 255.0f : high[c]);
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// BC1 color blocks
+//--------------------------------------------------------------------------------------
+
+static inline uint16_t
+packColor565(const float* color) {
+	const int r = clampInt(static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+	const int g = clampInt(static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+	const int b = clampInt(static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static inline void
+unpackColor565(uint16_t color, int* rgb) {
+	const int r = color >> 11, g = (color >> 5) & 63, b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+/**
+ * The 4 colors of a BC1 block. Three-color blocks (c0 <= c1) are only
+ * decoded, the encoder always writes four colors.
+ */
+static void
+buildColorPalette(uint16_t color0, uint16_t color1, bool fourColors, int palette[4][4]) {
+	unpackColor565(color0, palette[0]);
+	unpackColor565(color1, palette[1]);
+	palette[0][3] = palette[1][3] = 255;
+	for (int c = 0; c < 3; ++c) {
+		if (fourColors) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		else {
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+	palette[2][3] = 255;
+	palette[3][3] = fourColors ? 255 : 0;
+}
+
+/**
+ * Picks the nearest palette entry of every texel, returns the squared error.
+ */
+static int
+assignColorIndices(const float* points, const int palette[4][4], int* indices) {
+	int total = 0;
+	for (int i = 0; i < 16; ++i) {
+		int best = 0, bestError = INT32_MAX;
+		for (int p = 0; p < 4; ++p) {
+			int error = 0;
+			for (int c = 0; c < 3; ++c) {
+				const int d = static_cast<int>(points[i * 4 + c]) - palette[p][c];
+				error += d * d;
+			}
+			if (error < bestError) {
+				bestError = error;
+				best = p;
+			}
+		}
+		indices[i] = best;
+		total += bestError;
+	}
+	return total;
+}
+
+/**
+ * Quantizes a pair of end points and indexes the block, returns the squared error.
+ */
+static int
+fitColorBlock(const float* points, const float* low, const float* high, uint16_t& color0, uint16_t& color1, int* indices) {
+	color0 = packColor565(high);
+	color1 = packColor565(low);
+	// Four-color blocks need color0 > color1
+	if (color0 < color1) {
+		const uint16_t swap = color0;
+		color0 = color1;
+		color1 = swap;
+	}
+	int palette[4][4];
+	buildColorPalette(color0, color1, true, palette);
+	if (color0 == color1) {
+		// Decoded as three colors, every texel takes the first one
+		int error = 0;
+		for (int i = 0; i < 16; ++i) {
+			indices[i] = 0;
+			for (int c = 0; c < 3; ++c) {
+				const int d = static_cast<int>(points[i * 4 + c]) - palette[0][c];
+				error += d * d;
+			}
+		}
+		return error;
+	}
+	return assignColorIndices(points, palette, indices);
+}
+
+static void
+encodeColorBlock(const unsigned char* texels, CompressionQuality quality, unsigned char* out) {
+	float points[64];
+	for (int i = 0; i < 64; ++i) {
+		points[i] = texels[i];
+	}
+
+	float low[4], high[4];
+	findEndpoints(points, 3, quality, low, high);
+	uint16_t color0, color1;
+	int indices[16];
+	int error = fitColorBlock(points, low, high, color0, color1, indices);
+
+	if (quality == COMPRESSION_HIGH) {
+		static const float kIndexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+		for (int iteration = 0; iteration < kRefineIterations && error > 0; ++iteration) {
+			// Weights of color1 for the current indices; color0 is the high end point
+			float weights[16];
+			for (int i = 0; i < 16; ++i) {
+				weights[i] = 1.0f - kIndexWeights[indices[i]];
+			}
+			if (!solveEndpoints(points, weights, 3, low, high)) {
+				break;
+			}
+			uint16_t refined0, refined1;
+			int refinedIndices[16];
+			const int refinedError = fitColorBlock(points, low, high, refined0, refined1, refinedIndices);
+			if (refinedError >= error) {
+				break;
+			}
+			error = refinedError;
+			color0 = refined0;
+			color1 = refined1;
+			memcpy(indices, refinedIndices, sizeof(indices));
+		}
+	}
+
+	uint32_t bits = 0;
+	for (int i = 0; i < 16; ++i) {
+		bits |= static_cast<uint32_t>(indices[i]) << (i * 2);
+	}
+	out[0] = static_cast<unsigned char>(color0 & 0xFF);
+	out[1] = static_cast<unsigned char>(color0 >> 8);
+	out[2] = static_cast<unsigned char>(color1 & 0xFF);
+	out[3] = static_cast<unsigned char>(color1 >> 8);
+	for (int i = 0; i < 4; ++i) {
+		out[4 + i] = static_cast<unsigned char>(bits >> (i * 8));
+	}
+}
+
+static void
+decodeColorBlock(const unsigned char* block, bool alwaysFourColors, unsigned char* texels) {
+	const uint16_t color0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+	const uint16_t color1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+	int palette[4][4];
+	buildColorPalette(color0, color1, alwaysFourColors || color0 > color1, palette);
+	const uint32_t bits = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+	for (int i = 0; i < 16; ++i) {
+		const int* color = palette[(bits >> (i * 2)) & 3];
+		for (int c = 0; c < 4; ++c) {
+			texels[i * 4 + c] = static_cast<unsigned char>(color[c]);
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// BC4 single channel blocks (the alpha of BC3, each channel of BC5)
+//--------------------------------------------------------------------------------------
+
+static void
+buildChannelPalette(int value0, int value1, int palette[8]) {
+	palette[0] = value0;
+	palette[1] = value1;
+	if (value0 > value1) {
+		for (int i = 1; i < 7; ++i) {
+			palette[i + 1] = ((7 - i) * value0 + i * value1) / 7;
+		}
+	}
+	else {
+		for (int i = 1; i < 5; ++i) {
+			palette[i + 1] = ((5 - i) * value0 + i * value1) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+static int
+fitChannelBlock(const int* values, int value0, int value1, int* indices) {
+	int palette[8];
+	buildChannelPalette(value0, value1, palette);
+	int total = 0;
+	for (int i = 0; i < 16; ++i) {
+		int best = 0, bestError = INT32_MAX;
+		for (int p = 0; p < 8; ++p) {
+			const int d = values[i] - palette[p];
+			if (d * d < bestError) {
+				bestError = d * d;
+				best = p;
+			}
+		}
+		indices[i] = best;
+		total += bestError;
+	}
+	return total;
+}
+
+static void
+encodeChannelBlock(const unsigned char* texels, int channel, CompressionQuality quality, unsigned char* out) {
+	int values[16];
+	int minimum = 255, maximum = 0;
+	int innerMinimum = 255, innerMaximum = 0;
+	for (int i = 0; i < 16; ++i) {
+		values[i] = texels[i * 4 + channel];
+		minimum = values[i] < minimum ? values[i] : minimum;
+		maximum = values[i] > maximum ? values[i] : maximum;
+		if (values[i] != 0 && values[i] != 255) {
+			innerMinimum = values[i] < innerMinimum ? values[i] : innerMinimum;
+			innerMaximum = values[i] > innerMaximum ? values[i] : innerMaximum;
+		}
+	}
+
+	// Eight interpolated values between the extremes
+	int value0 = maximum, value1 = minimum;
+	int indices[16];
+	int error = fitChannelBlock(values, value0, value1, indices);
+
+	if (quality == COMPRESSION_HIGH && error > 0) {
+		int candidate[16];
+		// Six values plus exact 0 and 255, for blocks with both extremes
+		if (innerMinimum <= innerMaximum) {
+			const int candidateError = fitChannelBlock(values, innerMinimum, innerMaximum, candidate);
+			if (candidateError < error) {
+				error = candidateError;
+				value0 = innerMinimum;
+				value1 = innerMaximum;
+				memcpy(indices, candidate, sizeof(indices));
+			}
+		}
+		// Nudge the end points of the eight-value fit
+		for (int d0 = -2; d0 <= 2; ++d0) {
+			for (int d1 = -2; d1 <= 2; ++d1) {
+				const int v0 = clampInt(maximum + d0, 0, 255);
+				const int v1 = clampInt(minimum + d1, 0, 255);
+				if (v0 <= v1) {
+					continue;
+				}
+				const int candidateError = fitChannelBlock(values, v0, v1, candidate);
+				if (candidateError < error) {
+					error = candidateError;
+					value0 = v0;
+					value1 = v1;
+					memcpy(indices, candidate, sizeof(indices));
+				}
+			}
+		}
+	}
+
+	out[0] = static_cast<unsigned char>(value0);
+	out[1] = static_cast<unsigned char>(value1);
+	uint64_t bits = 0;
+	for (int i = 0; i < 16; ++i) {
+		bits |= static_cast<uint64_t>(indices[i]) << (i * 3);
+	}
+	for (int i = 0; i < 6; ++i) {
+		out[2 + i] = static_cast<unsigned char>(bits >> (i * 8));
+	}
+}
+
+static void
+decodeChannelBlock(const unsigned char* block, int channel, unsigned char* texels) {
+	int palette[8];
+	buildChannelPalette(block[0], block[1], palette);
+	uint64_t bits = 0;
+	for (int i = 0; i < 6; ++i) {
+		bits |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+	}
+	for (int i = 0; i < 16; ++i) {
+		texels[i * 4 + channel] = static_cast<unsigned char>(palette[(bits >> (i * 3)) & 7]);
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// BC7 mode 6 blocks
+//--------------------------------------------------------------------------------------
+
+/**
+ * Writes and reads the bits of a 128-bit block, least significant first.
+ */
+struct
+BlockBits {
+	unsigned char* data;
+	unsigned int position = 0;
+
+	void
+	write(uint32_t value, unsigned int count) {
+		for (unsigned int i = 0; i < count; ++i, ++position) {
+			if (value & (1u << i)) {
+				data[position >> 3] |= static_cast<unsigned char>(1u << (position & 7));
+			}
+		}
+	}
+
+	uint32_t
+	read(unsigned int count) {
+		uint32_t value = 0;
+		for (unsigned int i = 0; i < count; ++i, ++position) {
+			value |= static_cast<uint32_t>((data[position >> 3] >> (position & 7)) & 1) << i;
+		}
+		return value;
+	}
+};
+
+/**
+ * A mode 6 end point: 7 bits per channel and the shared low bit.
+ */
+struct
+Bc7Endpoint {
+	int channels[4];
+	int pBit;
+
+	int
+	expand(int c) const { return (channels[c] << 1) | pBit; }
+};
+
+static Bc7Endpoint
+quantizeBc7Endpoint(const float* value, int pBit) {
+	Bc7Endpoint endpoint;
+	endpoint.pBit = pBit;
+	for (int c = 0; c < 4; ++c) {
+		endpoint.channels[c] = clampInt(static_cast<int>((value[c] - pBit) * 0.5f + 0.5f), 0, 127);
+	}
+	return endpoint;
+}
+
+static int
+fitBc7Block(const float* points, const Bc7Endpoint& e0, const Bc7Endpoint& e1, bool exhaustive, int* indices) {
+	int palette[16][4];
+	for (int w = 0; w < 16; ++w) {
+		for (int c = 0; c < 4; ++c) {
+			palette[w][c] = ((64 - kBc7Weights[w]) * e0.expand(c) + kBc7Weights[w] * e1.expand(c) + 32) >> 6;
+		}
+	}
+
+	float axis[4];
+	float axisLength = 0.0f;
+	for (int c = 0; c < 4; ++c) {
+		axis[c] = static_cast<float>(e1.expand(c) - e0.expand(c));
+		axisLength += axis[c] * axis[c];
+	}
+
+	int total = 0;
+	for (int i = 0; i < 16; ++i) {
+		int first = 0, last = 15;
+		if (!exhaustive && axisLength > 0.0f) {
+			// Project on the segment and only check the neighbouring weights
+			float t = 0.0f;
+			for (int c = 0; c < 4; ++c) {
+				t += (points[i * 4 + c] - e0.expand(c)) * axis[c];
+			}
+			const int guess = clampInt(static_cast<int>(t / axisLength * 15.0f + 0.5f), 0, 15);
+			first = guess > 0 ? guess - 1 : 0;
+			last = guess < 15 ? guess + 1 : 15;
+		}
+		int best = first, bestError = INT32_MAX;
+		for (int w = first; w <= last; ++w) {
+			int error = 0;
+			for (int c = 0; c < 4; ++c) {
+				const int d = static_cast<int>(points[i * 4 + c]) - palette[w][c];
+				error += d * d;
+			}
+			if (error < bestError) {
+				bestError = error;
+				best = w;
+			}
+		}
+		indices[i] = best;
+		total += bestError;
+	}
+	return total;
+}
+
+/**
+ * Tries the shared bits of both end points (all four pairs for high quality),
+ * keeps the best fit.
+ */
+static int
+fitBc7Endpoints(const float* points, const float* low, const float* high, CompressionQuality quality,
+								Bc7Endpoint& e0, Bc7Endpoint& e1, int* indices) {
+	const bool exhaustive = quality == COMPRESSION_HIGH;
+	int bestError = INT32_MAX;
+	for (int pair = 0; pair < 4; ++pair) {
+		int p0 = pair & 1, p1 = pair >> 1;
+		if (!exhaustive) {
+			// The shared bit of the odd-or-even majority of the channels
+			int odd0 = 0, odd1 = 0;
+			for (int c = 0; c < 4; ++c) {
+				odd0 += static_cast<int>(low[c] + 0.5f) & 1;
+				odd1 += static_cast<int>(high[c] + 0.5f) & 1;
+			}
+			p0 = odd0 > 2 ? 1 : 0;
+			p1 = odd1 > 2 ? 1 : 0;
+		}
+		const Bc7Endpoint candidate0 = quantizeBc7Endpoint(low, p0);
+		const Bc7Endpoint candidate1 = quantizeBc7Endpoint(high, p1);
+		int candidateIndices[16];
+		const int error = fitBc7Block(points, candidate0, candidate1, exhaustive, candidateIndices);
+		// The first candidate is always taken, so the outputs are set even if no error is finite (NaN texels)
+		if (pair == 0 || error < bestError) {
+			bestError = error;
+			e0 = candidate0;
+			e1 = candidate1;
+			memcpy(indices, candidateIndices, sizeof(candidateIndices));
+		}
+		if (!exhaustive) {
+			break;
+		}
+	}
+	return bestError;
+}
+
+static void
+encodeBc7Block(const unsigned char* texels, CompressionQuality quality, unsigned char* out) {
+	float points[64];
+	for (int i = 0; i < 64; ++i) {
+		points[i] = texels[i];
+	}
+
+	float low[4], high[4];
+	findEndpoints(points, 4, quality, low, high);
+	Bc7Endpoint e0, e1;
+	int indices[16];
+	int error = fitBc7Endpoints(points, low, high, quality, e0, e1, indices);
+
+	if (quality == COMPRESSION_HIGH) {
+		for (int iteration = 0; iteration < kRefineIterations && error > 0; ++iteration) {
+			float weights[16];
+			for (int i = 0; i < 16; ++i) {
+				weights[i] = kBc7Weights[indices[i]] / 64.0f;
+			}
+			if (!solveEndpoints(points, weights, 4, low, high)) {
+				break;
+			}
+			Bc7Endpoint refined0, refined1;
+			int refinedIndices[16];
+			const int refinedError = fitBc7Endpoints(points, low, high, quality, refined0, refined1, refinedIndices);
+			if (refinedError >= error) {
+				break;
+			}
+			error = refinedError;
+			e0 = refined0;
+			e1 = refined1;
+			memcpy(indices, refinedIndices, sizeof(indices));
+		}
+	}
+
+	// The first index is stored without its top bit, so it must be below 8
+	if (indices[0] >= 8) {
+		const Bc7Endpoint swap = e0;
+		e0 = e1;
+		e1 = swap;
+		for (int i = 0; i < 16; ++i) {
+			indices[i] = 15 - indices[i];
+		}
+	}
+
+	memset(out, 0, 16);
+	BlockBits bits = { out };
+	bits.write(1u << 6, 7);
+	for (int c = 0; c < 4; ++c) {
+		bits.write(static_cast<uint32_t>(e0.channels[c]), 7);
+		bits.write(static_cast<uint32_t>(e1.channels[c]), 7);
+	}
+	bits.write(static_cast<uint32_t>(e0.pBit), 1);
+	bits.write(static_cast<uint32_t>(e1.pBit), 1);
+	bits.write(static_cast<uint32_t>(indices[0]), 3);
+	for (int i = 1; i < 16; ++i) {
+		bits.write(static_cast<uint32_t>(indices[i]), 4);
+	}
+}
+
+static bool
+decodeBc7Block(const unsigned char* block, unsigned char* texels) {
+	BlockBits bits = { const_cast<unsigned char*>(block) };
+	if (bits.read(7) != (1u << 6)) {
+		return false;
+	}
+	Bc7Endpoint e0, e1;
+	for (int c = 0; c < 4; ++c) {
+		e0.channels[c] = static_cast<int>(bits.read(7));
+		e1.channels[c] = static_cast<int>(bits.read(7));
+	}
+	e0.pBit = static_cast<int>(bits.read(1));
+	e1.pBit = static_cast<int>(bits.read(1));
+	for (int i = 0; i < 16; ++i) {
+		const int w = kBc7Weights[bits.read(i == 0 ? 3 : 4)];
+		for (int c = 0; c < 4; ++c) {
+			texels[i * 4 + c] = static_cast<unsigned char>(((64 - w) * e0.expand(c) + w * e1.expand(c) + 32) >> 6);
+		}
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// TextureCompressor
+//--------------------------------------------------------------------------------------
+
+bool
+TextureCompressor::isBlockFormat(DXGI_FORMAT format) {
+	return format == DXGI_FORMAT_BC1_UNORM || format == DXGI_FORMAT_BC3_UNORM ||
+		format == DXGI_FORMAT_BC5_UNORM || format == DXGI_FORMAT_BC7_UNORM;
+}
+
+unsigned int
+TextureCompressor::getBlockBytes(DXGI_FORMAT format) {
+	return format == DXGI_FORMAT_BC1_UNORM ? 8 : 16;
+}
+
+unsigned int
+TextureCompressor::getRowPitch(DXGI_FORMAT format, unsigned int width) {
+	return (width + 3) / 4 * getBlockBytes(format);
+}
+
+DXGI_FORMAT
+TextureCompressor::chooseFormat(const Image& image, TextureUsage usage, CompressionQuality quality) {
+	if (quality == COMPRESSION_NONE || image.empty() || image.width % 4 != 0 || image.height % 4 != 0) {
+		return DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+	if (usage == TEXTURE_USAGE_NORMAL) {
+		return DXGI_FORMAT_BC5_UNORM;
+	}
+	if (quality == COMPRESSION_HIGH) {
+		return DXGI_FORMAT_BC7_UNORM;
+	}
+	return ImageProcessor::isOpaque(image) ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC3_UNORM;
+}
+
+TextureUsage
+TextureCompressor::guessUsage(const std::string& fileName) {
+	const size_t separator = fileName.find_last_of("/\\");
+	std::string name = fileName.substr(separator == std::string::npos ? 0 : separator + 1);
+	const size_t dot = name.find_last_of('.');
+	name = name.substr(0, dot);
+	for (char& c : name) {
+		c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+	}
+
+	static const char* kNormalSuffixes[] = { "_n", "_nrm", "_normal", "_normals" };
+	for (const char* suffix : kNormalSuffixes) {
+		const size_t length = strlen(suffix);
+		if (name.size() > length && name.compare(name.size() - length, length, suffix) == 0) {
+			return TEXTURE_USAGE_NORMAL;
+		}
+	}
+	return TEXTURE_USAGE_COLOR;
+}
+
+bool
+TextureCompressor::compress(const Image& image,
+														DXGI_FORMAT format,
+														CompressionQuality quality,
+														std::vector<unsigned char>& outBlocks,
+														CompressionReport* outReport,
+														ThreadPool* threadPool) {
+	if (!isBlockFormat(format)) {
+		ERROR("TextureCompressor", "compress", "The format isn't a supported block format.");
+		return false;
+	}
+	if (image.empty()) {
+		ERROR("TextureCompressor", "compress", "The image is empty.");
+		return false;
+	}
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	const unsigned int blocksWide = (image.width + 3) / 4;
+	const unsigned int blocksHigh = (image.height + 3) / 4;
+	const unsigned int blockBytes = getBlockBytes(format);
+	outBlocks.assign(static_cast<size_t>(blocksWide) * blocksHigh * blockBytes, 0);
+
+	auto encodeRows = [&](size_t task) {
+		const unsigned int firstRow = static_cast<unsigned int>(task) * kBlockRowsPerTask;
+		const unsigned int lastRow = firstRow + kBlockRowsPerTask < blocksHigh ? firstRow + kBlockRowsPerTask : blocksHigh;
+		unsigned char texels[64];
+		for (unsigned int by = firstRow; by < lastRow; ++by) {
+			for (unsigned int bx = 0; bx < blocksWide; ++bx) {
+				loadBlock(image, bx, by, texels);
+				unsigned char* out = &outBlocks[(static_cast<size_t>(by) * blocksWide + bx) * blockBytes];
+				switch (format) {
+				case DXGI_FORMAT_BC1_UNORM:
+					encodeColorBlock(texels, quality, out);
+					break;
+				case DXGI_FORMAT_BC3_UNORM:
+					encodeChannelBlock(texels, 3, quality, out);
+					encodeColorBlock(texels, quality, out + 8);
+					break;
+				case DXGI_FORMAT_BC5_UNORM:
+					encodeChannelBlock(texels, 0, quality, out);
+					encodeChannelBlock(texels, 1, quality, out + 8);
+					break;
+				default:
+					encodeBc7Block(texels, quality, out);
+					break;
+				}
+			}
+		}
+	};
+
+	const size_t taskCount = (blocksHigh + kBlockRowsPerTask - 1) / kBlockRowsPerTask;
+	if (threadPool && threadPool->getThreadCount() > 0 && taskCount > 1 &&
+			static_cast<size_t>(blocksWide) * blocksHigh >= kMinParallelBlocks) {
+		threadPool->parallelFor(taskCount, encodeRows);
+	}
+	else {
+		for (size_t task = 0; task < taskCount; ++task) {
+			encodeRows(task);
+		}
+	}
+
+	if (outReport) {
+		outReport->format = format;
+		outReport->inputBytes = image.pixels.size();
+		outReport->outputBytes = outBlocks.size();
+		outReport->seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+		Image decoded;
+		decompress(outBlocks.data(), format, image.width, image.height, decoded);
+		outReport->psnr = computePsnr(image, decoded,
+			format == DXGI_FORMAT_BC1_UNORM ? 3 : (format == DXGI_FORMAT_BC5_UNORM ? 2 : 4));
+	}
+	return true;
+}
+
+bool
+TextureCompressor::compressChain(const std::vector<Image>& mips,
+																 DXGI_FORMAT format,
+																 CompressionQuality quality,
+																 std::vector<std::vector<unsigned char>>& outLevels,
+																 std::vector<TextureSubresource>& outSubresources,
+																 CompressionReport* outReport,
+																 ThreadPool* threadPool) {
+	outLevels.assign(mips.size(), std::vector<unsigned char>());
+	outSubresources.assign(mips.size(), TextureSubresource());
+	CompressionReport total;
+	for (size_t level = 0; level < mips.size(); ++level) {
+		CompressionReport report;
+		// Only the base level pays for the PSNR decode
+		CompressionReport* levelReport = outReport ? &report : nullptr;
+		if (!compress(mips[level], format, quality, outLevels[level], levelReport, threadPool)) {
+			return false;
+		}
+		if (level == 0) {
+			total.psnr = report.psnr;
+		}
+		total.inputBytes += mips[level].pixels.size();
+		total.outputBytes += outLevels[level].size();
+		total.seconds += report.seconds;
+
+		TextureSubresource& subresource = outSubresources[level];
+		subresource.data = outLevels[level].data();
+		subresource.rowPitch = getRowPitch(format, mips[level].width);
+		subresource.slicePitch = static_cast<unsigned int>(outLevels[level].size());
+		subresource.width = mips[level].width;
+		subresource.height = mips[level].height;
+	}
+	if (outReport) {
+		total.format = format;
+		*outReport = total;
+	}
+	return true;
+}
+
+bool
+TextureCompressor::decompress(const unsigned char* blocks,
+															DXGI_FORMAT format,
+															unsigned int width,
+															unsigned int height,
+															Image& outImage) {
+	if (!isBlockFormat(format)) {
+		ERROR("TextureCompressor", "decompress", "The format isn't a supported block format.");
+		return false;
+	}
+
+	outImage.width = width;
+	outImage.height = height;
+	outImage.pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+	const unsigned int blocksWide = (width + 3) / 4;
+	const unsigned int blocksHigh = (height + 3) / 4;
+	const unsigned int blockBytes = getBlockBytes(format);
+
+	bool supported = true;
+	unsigned char texels[64];
+	for (unsigned int by = 0; by < blocksHigh; ++by) {
+		for (unsigned int bx = 0; bx < blocksWide; ++bx) {
+			const unsigned char* block = blocks + (static_cast<size_t>(by) * blocksWide + bx) * blockBytes;
+			switch (format) {
+			case DXGI_FORMAT_BC1_UNORM:
+				decodeColorBlock(block, false, texels);
+				break;
+			case DXGI_FORMAT_BC3_UNORM:
+				decodeColorBlock(block + 8, true, texels);
+				decodeChannelBlock(block, 3, texels);
+				break;
+			case DXGI_FORMAT_BC5_UNORM:
+				memset(texels, 0, sizeof(texels));
+				decodeChannelBlock(block, 0, texels);
+				decodeChannelBlock(block + 8, 1, texels);
+				for (int i = 0; i < 16; ++i) {
+					texels[i * 4 + 3] = 255;
+				}
+				break;
+			default:
+				if (!decodeBc7Block(block, texels)) {
+					memset(texels, 0, sizeof(texels));
+					supported = false;
+				}
+				break;
+			}
+			storeBlock(outImage, bx, by, texels);
+		}
+	}
+	if (!supported) {
+		ERROR("TextureCompressor", "decompress", "Only mode 6 BC7 blocks can be decoded.");
+	}
+	return supported;
+}
+
+double
+TextureCompressor::computePsnr(const Image& reference, const Image& image, unsigned int channelCount) {
+	if (reference.width != image.width || reference.height != image.height || reference.empty()) {
+		return 0.0;
+	}
+	double squaredError = 0.0;
+	for (size_t i = 0; i < reference.pixels.size(); i += 4) {
+		for (unsigned int c = 0; c < channelCount; ++c) {
+			const double d = static_cast<double>(reference.pixels[i + c]) - image.pixels[i + c];
+			squaredError += d * d;
+		}
+	}
+	const double meanError = squaredError / (static_cast<double>(reference.pixels.size() / 4) * channelCount);
+	return meanError <= 0.0 ? 999.0 : 10.0 * log10(255.0 * 255.0 / meanError);
+}
@@ -0,0 +1,640 @@
+#include "TextureContainer.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// "DDS " in little-endian
+static const uint32_t kDdsMagic = 0x20534444;
+
+// The 12 bytes every KTX2 file starts with
+static const unsigned char kKtx2Identifier[12] = {
+	0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+
+// DDS_PIXELFORMAT flags
+static const uint32_t kDdpfAlphaPixels = 0x1;
+static const uint32_t kDdpfFourCC = 0x4;
+static const uint32_t kDdpfRgb = 0x40;
+static const uint32_t kDdpfLuminance = 0x20000;
+
+// DDS_HEADER flags and caps
+static const uint32_t kDdsdCaps = 0x1;
+static const uint32_t kDdsdHeight = 0x2;
+static const uint32_t kDdsdWidth = 0x4;
+static const uint32_t kDdsdPixelFormat = 0x1000;
+static const uint32_t kDdsdMipMapCount = 0x20000;
+static const uint32_t kDdsCapsComplex = 0x8;
+static const uint32_t kDdsCapsTexture = 0x1000;
+static const uint32_t kDdsCapsMipMap = 0x400000;
+static const uint32_t kDdsCaps2Cubemap = 0x200;
+static const uint32_t kDdsCaps2AllFaces = 0xFC00;
+static const uint32_t kDdsCaps2Volume = 0x200000;
+
+// DDS_HEADER_DXT10 values
+static const uint32_t kDdsDimensionTexture1D = 2;
+static const uint32_t kDdsDimensionTexture2D = 3;
+static const uint32_t kDdsMiscTextureCube = 0x4;
+
+/**
+ * The pixel format block of a DDS header.
+ */
+struct
+DdsPixelFormat {
+	uint32_t size;
+	uint32_t flags;
+	uint32_t fourCC;
+	uint32_t rgbBitCount;
+	uint32_t rBitMask;
+	uint32_t gBitMask;
+	uint32_t bBitMask;
+	uint32_t aBitMask;
+};
+
+/**
+ * The header that follows the magic of a DDS file.
+ */
+struct
+DdsHeader {
+	uint32_t size;
+	uint32_t flags;
+	uint32_t height;
+	uint32_t width;
+	uint32_t pitchOrLinearSize;
+	uint32_t depth;
+	uint32_t mipMapCount;
+	uint32_t reserved1[11];
+	DdsPixelFormat pixelFormat;
+	uint32_t caps;
+	uint32_t caps2;
+	uint32_t caps3;
+	uint32_t caps4;
+	uint32_t reserved2;
+};
+
+/**
+ * The extended header of a DDS file whose four-character code is "DX10".
+ */
+struct
+DdsHeaderDx10 {
+	uint32_t dxgiFormat;
+	uint32_t resourceDimension;
+	uint32_t miscFlag;
+	uint32_t arraySize;
+	uint32_t miscFlags2;
+};
+
+/**
+ * The header at the start of a KTX2 file, with its index.
+ */
+struct
+Ktx2Header {
+	unsigned char identifier[12];
+	uint32_t vkFormat;
+	uint32_t typeSize;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t pixelDepth;
+	uint32_t layerCount;
+	uint32_t faceCount;
+	uint32_t levelCount;
+	uint32_t supercompressionScheme;
+	uint32_t dfdByteOffset;
+	uint32_t dfdByteLength;
+	uint32_t kvdByteOffset;
+	uint32_t kvdByteLength;
+	uint64_t sgdByteOffset;
+	uint64_t sgdByteLength;
+};
+
+static_assert(sizeof(DdsHeader) == 124 && sizeof(DdsHeaderDx10) == 20, "DDS headers must match the file layout");
+static_assert(sizeof(Ktx2Header) == 80, "The KTX2 header must match the file layout");
+
+/**
+ * Where one level of a KTX2 file is stored.
+ */
+struct
+Ktx2Level {
+	uint64_t byteOffset;
+	uint64_t byteLength;
+	uint64_t uncompressedByteLength;
+};
+
+/**
+ * Bytes per texel, or per 4x4 block for the block formats.
+ */
+struct
+FormatLayout {
+	DXGI_FORMAT format;
+	unsigned int bytes;
+	bool block;
+};
+
+static const FormatLayout kFormatLayouts[] = {
+	{ DXGI_FORMAT_R32G32B32A32_FLOAT, 16, false },
+	{ DXGI_FORMAT_R32G32B32_FLOAT, 12, false },
+	{ DXGI_FORMAT_R16G16B16A16_FLOAT, 8, false },
+	{ DXGI_FORMAT_R16G16B16A16_UNORM, 8, false },
+	{ DXGI_FORMAT_R32G32_FLOAT, 8, false },
+	{ DXGI_FORMAT_R10G10B10A2_UNORM, 4, false },
+	{ DXGI_FORMAT_R11G11B10_FLOAT, 4, false },
+	{ DXGI_FORMAT_R8G8B8A8_UNORM, 4, false },
+	{ DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 4, false },
+	{ DXGI_FORMAT_R8G8B8A8_SNORM, 4, false },
+	{ DXGI_FORMAT_R16G16_FLOAT, 4, false },
+	{ DXGI_FORMAT_R16G16_SNORM, 4, false },
+	{ DXGI_FORMAT_R32_FLOAT, 4, false },
+	{ DXGI_FORMAT_R8G8_UNORM, 2, false },
+	{ DXGI_FORMAT_R16_FLOAT, 2, false },
+	{ DXGI_FORMAT_R8_UNORM, 1, false },
+	{ DXGI_FORMAT_B5G6R5_UNORM, 2, false },
+	{ DXGI_FORMAT_B8G8R8A8_UNORM, 4, false },
+	{ DXGI_FORMAT_B8G8R8X8_UNORM, 4, false },
+	{ DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, 4, false },
+	{ DXGI_FORMAT_BC1_UNORM, 8, true },
+	{ DXGI_FORMAT_BC1_UNORM_SRGB, 8, true },
+	{ DXGI_FORMAT_BC2_UNORM, 16, true },
+	{ DXGI_FORMAT_BC2_UNORM_SRGB, 16, true },
+	{ DXGI_FORMAT_BC3_UNORM, 16, true },
+	{ DXGI_FORMAT_BC3_UNORM_SRGB, 16, true },
+	{ DXGI_FORMAT_BC4_UNORM, 8, true },
+	{ DXGI_FORMAT_BC4_SNORM, 8, true },
+	{ DXGI_FORMAT_BC5_UNORM, 16, true },
+	{ DXGI_FORMAT_BC5_SNORM, 16, true },
+	{ DXGI_FORMAT_BC6H_UF16, 16, true },
+	{ DXGI_FORMAT_BC6H_SF16, 16, true },
+	{ DXGI_FORMAT_BC7_UNORM, 16, true },
+	{ DXGI_FORMAT_BC7_UNORM_SRGB, 16, true }
+};
+
+/**
+ * A Vulkan format of a KTX2 file and its DXGI equivalent.
+ */
+struct
+VulkanFormat {
+	uint32_t vkFormat;
+	DXGI_FORMAT format;
+};
+
+static const VulkanFormat kVulkanFormats[] = {
+	{ 4, DXGI_FORMAT_B5G6R5_UNORM },          // R5G6B5_UNORM_PACK16
+	{ 9, DXGI_FORMAT_R8_UNORM },
+	{ 16, DXGI_FORMAT_R8G8_UNORM },
+	{ 37, DXGI_FORMAT_R8G8B8A8_UNORM },
+	{ 38, DXGI_FORMAT_R8G8B8A8_SNORM },
+	{ 43, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB },
+	{ 44, DXGI_FORMAT_B8G8R8A8_UNORM },
+	{ 50, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB },
+	{ 64, DXGI_FORMAT_R10G10B10A2_UNORM },    // A2B10G10R10_UNORM_PACK32
+	{ 76, DXGI_FORMAT_R16_FLOAT },
+	{ 83, DXGI_FORMAT_R16G16_FLOAT },
+	{ 91, DXGI_FORMAT_R16G16B16A16_UNORM },
+	{ 97, DXGI_FORMAT_R16G16B16A16_FLOAT },
+	{ 100, DXGI_FORMAT_R32_FLOAT },
+	{ 103, DXGI_FORMAT_R32G32_FLOAT },
+	{ 106, DXGI_FORMAT_R32G32B32_FLOAT },
+	{ 109, DXGI_FORMAT_R32G32B32A32_FLOAT },
+	{ 122, DXGI_FORMAT_R11G11B10_FLOAT },     // B10G11R11_UFLOAT_PACK32
+	{ 131, DXGI_FORMAT_BC1_UNORM },           // BC1_RGB_UNORM_BLOCK
+	{ 132, DXGI_FORMAT_BC1_UNORM_SRGB },
+	{ 133, DXGI_FORMAT_BC1_UNORM },           // BC1_RGBA_UNORM_BLOCK
+	{ 134, DXGI_FORMAT_BC1_UNORM_SRGB },
+	{ 135, DXGI_FORMAT_BC2_UNORM },
+	{ 136, DXGI_FORMAT_BC2_UNORM_SRGB },
+	{ 137, DXGI_FORMAT_BC3_UNORM },
+	{ 138, DXGI_FORMAT_BC3_UNORM_SRGB },
+	{ 139, DXGI_FORMAT_BC4_UNORM },
+	{ 140, DXGI_FORMAT_BC4_SNORM },
+	{ 141, DXGI_FORMAT_BC5_UNORM },
+	{ 142, DXGI_FORMAT_BC5_SNORM },
+	{ 143, DXGI_FORMAT_BC6H_UF16 },
+	{ 144, DXGI_FORMAT_BC6H_SF16 },
+	{ 145, DXGI_FORMAT_BC7_UNORM },
+	{ 146, DXGI_FORMAT_BC7_UNORM_SRGB }
+};
+
+static inline uint32_t
+makeFourCC(char a, char b, char c, char d) {
+	return static_cast<uint32_t>(static_cast<unsigned char>(a)) |
+		(static_cast<uint32_t>(static_cast<unsigned char>(b)) << 8) |
+		(static_cast<uint32_t>(static_cast<unsigned char>(c)) << 16) |
+		(static_cast<uint32_t>(static_cast<unsigned char>(d)) << 24);
+}
+
+static inline unsigned int
+getLevelSize(unsigned int size, unsigned int level) {
+	return std::max(1u, size >> level);
+}
+
+/**
+ * Gets the number of levels of a full chain down to 1x1.
+ */
+static unsigned int
+getFullMipCount(unsigned int width, unsigned int height) {
+	unsigned int count = 1;
+	for (unsigned int size = std::max(width, height); size > 1; size >>= 1) {
+		++count;
+	}
+	return count;
+}
+
+/**
+ * Maps the pixel format of a DDS file without a DX10 header to DXGI.
+ */
+static DXGI_FORMAT
+getLegacyDdsFormat(const DdsPixelFormat& pf) {
+	if (pf.flags & kDdpfFourCC) {
+		switch (pf.fourCC) {
+		case 0x31545844: // DXT1
+			return DXGI_FORMAT_BC1_UNORM;
+		case 0x32545844: // DXT2
+		case 0x33545844: // DXT3
+			return DXGI_FORMAT_BC2_UNORM;
+		case 0x34545844: // DXT4
+		case 0x35545844: // DXT5
+			return DXGI_FORMAT_BC3_UNORM;
+		case 0x31495441: // ATI1
+		case 0x55344342: // BC4U
+			return DXGI_FORMAT_BC4_UNORM;
+		case 0x53344342: // BC4S
+			return DXGI_FORMAT_BC4_SNORM;
+		case 0x32495441: // ATI2
+		case 0x55354342: // BC5U
+			return DXGI_FORMAT_BC5_UNORM;
+		case 0x53354342: // BC5S
+			return DXGI_FORMAT_BC5_SNORM;
+		// D3DFORMAT codes stored as four-character codes
+		case 36:
+			return DXGI_FORMAT_R16G16B16A16_UNORM;
+		case 111:
+			return DXGI_FORMAT_R16_FLOAT;
+		case 112:
+			return DXGI_FORMAT_R16G16_FLOAT;
+		case 113:
+			return DXGI_FORMAT_R16G16B16A16_FLOAT;
+		case 114:
+			return DXGI_FORMAT_R32_FLOAT;
+		case 115:
+			return DXGI_FORMAT_R32G32_FLOAT;
+		case 116:
+			return DXGI_FORMAT_R32G32B32A32_FLOAT;
+		default:
+			return DXGI_FORMAT_UNKNOWN;
+		}
+	}
+
+	if (pf.flags & kDdpfRgb) {
+		if (pf.rgbBitCount == 32) {
+			if (pf.rBitMask == 0x000000FF && pf.gBitMask == 0x0000FF00 && pf.bBitMask == 0x00FF0000) {
+				return DXGI_FORMAT_R8G8B8A8_UNORM;
+			}
+			if (pf.rBitMask == 0x00FF0000 && pf.gBitMask == 0x0000FF00 && pf.bBitMask == 0x000000FF) {
+				return (pf.flags & kDdpfAlphaPixels) && pf.aBitMask == 0xFF000000 ?
+					DXGI_FORMAT_B8G8R8A8_UNORM : DXGI_FORMAT_B8G8R8X8_UNORM;
+			}
+			if (pf.rBitMask == 0x000003FF && pf.gBitMask == 0x000FFC00 && pf.bBitMask == 0x3FF00000) {
+				return DXGI_FORMAT_R10G10B10A2_UNORM;
+			}
+		}
+		else if (pf.rgbBitCount == 16 &&
+						 pf.rBitMask == 0xF800 && pf.gBitMask == 0x07E0 && pf.bBitMask == 0x001F) {
+			return DXGI_FORMAT_B5G6R5_UNORM;
+		}
+		return DXGI_FORMAT_UNKNOWN;
+	}
+
+	if (pf.flags & kDdpfLuminance) {
+		if (pf.rgbBitCount == 8 && pf.rBitMask == 0xFF) {
+			return DXGI_FORMAT_R8_UNORM;
+		}
+		if (pf.rgbBitCount == 16 && pf.rBitMask == 0x00FF && pf.aBitMask == 0xFF00) {
+			return DXGI_FORMAT_R8G8_UNORM;
+		}
+	}
+	return DXGI_FORMAT_UNKNOWN;
+}
+
+bool
+TextureContainer::load(const std::string& fileName, CookedTexture& outTexture) {
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	if (!file->init(fileName)) {
+		ERROR("TextureContainer", "load", ("The file couldn't be mapped: " + fileName).c_str());
+		return false;
+	}
+
+	uint32_t magic = 0;
+	if (file->size() >= sizeof(magic)) {
+		memcpy(&magic, file->data(), sizeof(magic));
+	}
+
+	CookedTexture texture;
+	bool parsed = false;
+	if (magic == kDdsMagic && file->size() >= sizeof(magic) + sizeof(DdsHeader)) {
+		parsed = parseDds(fileName, file->data(), file->size(), texture);
+	}
+	else if (file->size() >= sizeof(Ktx2Header) &&
+					 memcmp(file->data(), kKtx2Identifier, sizeof(kKtx2Identifier)) == 0) {
+		parsed = parseKtx2(fileName, file->data(), file->size(), texture);
+	}
+	else {
+		ERROR("TextureContainer", "load", ("Not a DDS or KTX2 file: " + fileName).c_str());
+	}
+	if (!parsed) {
+		return false;
+	}
+
+	texture.file = file;
+	outTexture = texture;
+	return true;
+}
+
+bool
+TextureContainer::saveDds(const std::string& fileName, const CookedTexture& texture) {
+	const unsigned int arraySize = texture.arraySize;
+	if (texture.mips.empty() || arraySize == 0 || texture.mips.size() % arraySize != 0 ||
+			(texture.cubemap && arraySize % 6 != 0)) {
+		ERROR("TextureContainer", "saveDds", ("The texture has no valid layout: " + fileName).c_str());
+		return false;
+	}
+	const unsigned int mipCount = static_cast<unsigned int>(texture.mips.size() / arraySize);
+	const unsigned int width = texture.mips[0].width;
+	const unsigned int height = texture.mips[0].height;
+	for (size_t i = 0; i < texture.mips.size(); ++i) {
+		const TextureSubresource& mip = texture.mips[i];
+		const unsigned int level = static_cast<unsigned int>(i % mipCount);
+		uint64_t rowPitch;
+		uint64_t slicePitch;
+		if (!computePitch(texture.format, mip.width, mip.height, rowPitch, slicePitch) ||
+				mip.width != getLevelSize(width, level) || mip.height != getLevelSize(height, level) ||
+				mip.rowPitch != rowPitch || mip.slicePitch != slicePitch || !mip.data) {
+			ERROR("TextureContainer", "saveDds", ("The levels aren't tightly packed: " + fileName).c_str());
+			return false;
+		}
+	}
+
+	DdsHeader header = {};
+	header.size = sizeof(DdsHeader);
+	header.flags = kDdsdCaps | kDdsdHeight | kDdsdWidth | kDdsdPixelFormat | kDdsdMipMapCount;
+	header.height = height;
+	header.width = width;
+	header.pitchOrLinearSize = texture.mips[0].rowPitch;
+	header.depth = 1;
+	header.mipMapCount = mipCount;
+	header.pixelFormat.size = sizeof(DdsPixelFormat);
+	header.pixelFormat.flags = kDdpfFourCC;
+	header.pixelFormat.fourCC = makeFourCC('D', 'X', '1', '0');
+	header.caps = kDdsCapsTexture | (mipCount > 1 || arraySize > 1 ? kDdsCapsComplex : 0) |
+		(mipCount > 1 ? kDdsCapsMipMap : 0);
+
+	DdsHeaderDx10 dx10 = {};
+	dx10.dxgiFormat = static_cast<uint32_t>(texture.format);
+	dx10.resourceDimension = kDdsDimensionTexture2D;
+	dx10.miscFlag = texture.cubemap ? kDdsMiscTextureCube : 0;
+	dx10.arraySize = texture.cubemap ? arraySize / 6 : arraySize;
+
+	const std::string tempPath = fileName + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			ERROR("TextureContainer", "saveDds", ("The file couldn't be created: " + tempPath).c_str());
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(&kDdsMagic), sizeof(kDdsMagic));
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(&dx10), sizeof(dx10));
+		for (const TextureSubresource& mip : texture.mips) {
+			file.write(static_cast<const char*>(mip.data), mip.slicePitch);
+		}
+		if (!file.good()) {
+			ERROR("TextureContainer", "saveDds", ("Failed to write the DDS file: " + tempPath).c_str());
+			file.close();
+			std::remove(tempPath.c_str());
+			return false;
+		}
+	}
+
+	// Replace the old file only once the new one is complete, in one step
+	std::error_code error;
+	std::filesystem::rename(tempPath, fileName, error);
+	if (error) {
+		ERROR("TextureContainer", "saveDds", ("Failed to rename the DDS file: " + fileName).c_str());
+		std::remove(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool
+TextureContainer::isContainerFile(const std::string& fileName) {
+	const size_t dot = fileName.find_last_of('.');
+	if (dot == std::string::npos) {
+		return false;
+	}
+	std::string extension = fileName.substr(dot + 1);
+	for (char& c : extension) {
+		c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+	}
+	return extension == "dds" || extension == "ktx2";
+}
+
+bool
+TextureContainer::computePitch(DXGI_FORMAT format,
+															 unsigned int width,
+															 unsigned int height,
+															 uint64_t& outRowPitch,
+															 uint64_t& outSlicePitch) {
+	for (const FormatLayout& layout : kFormatLayouts) {
+		if (layout.format != format) {
+			continue;
+		}
+		if (layout.block) {
+			outRowPitch = static_cast<uint64_t>((width + 3) / 4) * layout.bytes;
+			outSlicePitch = outRowPitch * ((height + 3) / 4);
+		}
+		else {
+			outRowPitch = static_cast<uint64_t>(width) * layout.bytes;
+			outSlicePitch = outRowPitch * height;
+		}
+		return true;
+	}
+	return false;
+}
+
+bool
+TextureContainer::parseDds(const std::string& fileName, const char* data, size_t size, CookedTexture& outTexture) {
+	DdsHeader header;
+	memcpy(&header, data + sizeof(uint32_t), sizeof(header));
+	if (header.size != sizeof(DdsHeader) || header.pixelFormat.size != sizeof(DdsPixelFormat)) {
+		ERROR("TextureContainer", "parseDds", ("The DDS header is corrupted: " + fileName).c_str());
+		return false;
+	}
+
+	uint64_t offset = sizeof(uint32_t) + sizeof(DdsHeader);
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	unsigned int arraySize = 1;
+	bool cubemap = false;
+	unsigned int height = header.height;
+
+	if ((header.pixelFormat.flags & kDdpfFourCC) && header.pixelFormat.fourCC == makeFourCC('D', 'X', '1', '0')) {
+		if (size < offset + sizeof(DdsHeaderDx10)) {
+			ERROR("TextureContainer", "parseDds", ("The DDS header is corrupted: " + fileName).c_str());
+			return false;
+		}
+		DdsHeaderDx10 dx10;
+		memcpy(&dx10, data + offset, sizeof(dx10));
+		offset += sizeof(DdsHeaderDx10);
+
+		if (dx10.resourceDimension == kDdsDimensionTexture1D) {
+			height = 1;
+		}
+		else if (dx10.resourceDimension != kDdsDimensionTexture2D) {
+			ERROR("TextureContainer", "parseDds", ("Volume textures aren't supported: " + fileName).c_str());
+			return false;
+		}
+		format = static_cast<DXGI_FORMAT>(dx10.dxgiFormat);
+		arraySize = std::max(1u, dx10.arraySize);
+		if (dx10.miscFlag & kDdsMiscTextureCube) {
+			cubemap = true;
+			arraySize *= 6;
+		}
+	}
+	else {
+		if (header.caps2 & kDdsCaps2Volume) {
+			ERROR("TextureContainer", "parseDds", ("Volume textures aren't supported: " + fileName).c_str());
+			return false;
+		}
+		if (header.caps2 & kDdsCaps2Cubemap) {
+			if ((header.caps2 & kDdsCaps2AllFaces) != kDdsCaps2AllFaces) {
+				ERROR("TextureContainer", "parseDds", ("Cube maps without every face aren't supported: " + fileName).c_str());
+				return false;
+			}
+			cubemap = true;
+			arraySize = 6;
+		}
+		format = getLegacyDdsFormat(header.pixelFormat);
+	}
+
+	const unsigned int width = header.width;
+	const unsigned int mipCount = (header.flags & kDdsdMipMapCount) && header.mipMapCount > 0 ? header.mipMapCount : 1;
+	uint64_t rowPitch;
+	uint64_t slicePitch;
+	if (!computePitch(format, 1, 1, rowPitch, slicePitch)) {
+		ERROR("TextureContainer", "parseDds", ("The pixel format of the DDS isn't supported: " + fileName).c_str());
+		return false;
+	}
+	if (width == 0 || height == 0 || mipCount > getFullMipCount(width, height)) {
+		ERROR("TextureContainer", "parseDds", ("The DDS header is corrupted: " + fileName).c_str());
+		return false;
+	}
+
+	// Every slice stores its whole chain before the next slice, like D3D11 subresources
+	std::vector<TextureSubresource> mips(static_cast<size_t>(arraySize) * mipCount);
+	for (unsigned int slice = 0; slice < arraySize; ++slice) {
+		for (unsigned int level = 0; level < mipCount; ++level) {
+			TextureSubresource& mip = mips[slice * mipCount + level];
+			mip.width = getLevelSize(width, level);
+			mip.height = getLevelSize(height, level);
+			computePitch(format, mip.width, mip.height, rowPitch, slicePitch);
+			if (offset + slicePitch > size) {
+				ERROR("TextureContainer", "parseDds", ("The DDS file is truncated: " + fileName).c_str());
+				return false;
+			}
+			mip.data = data + offset;
+			mip.rowPitch = static_cast<unsigned int>(rowPitch);
+			mip.slicePitch = static_cast<unsigned int>(slicePitch);
+			offset += slicePitch;
+		}
+	}
+
+	outTexture.format = format;
+	outTexture.mips.swap(mips);
+	outTexture.arraySize = arraySize;
+	outTexture.cubemap = cubemap;
+	return true;
+}
+
+bool
+TextureContainer::parseKtx2(const std::string& fileName, const char* data, size_t size, CookedTexture& outTexture) {
+	Ktx2Header header;
+	memcpy(&header, data, sizeof(header));
+
+	if (header.supercompressionScheme != 0) {
+		ERROR("TextureContainer", "parseKtx2", ("Supercompressed KTX2 files aren't supported: " + fileName).c_str());
+		return false;
+	}
+	if (header.pixelDepth > 1) {
+		ERROR("TextureContainer", "parseKtx2", ("Volume textures aren't supported: " + fileName).c_str());
+		return false;
+	}
+	if (header.faceCount != 1 && header.faceCount != 6) {
+		ERROR("TextureContainer", "parseKtx2", ("The KTX2 header is corrupted: " + fileName).c_str());
+		return false;
+	}
+
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	for (const VulkanFormat& entry : kVulkanFormats) {
+		if (entry.vkFormat == header.vkFormat) {
+			format = entry.format;
+			break;
+		}
+	}
+	if (format == DXGI_FORMAT_UNKNOWN) {
+		ERROR("TextureContainer", "parseKtx2", ("The pixel format of the KTX2 isn't supported: " + fileName).c_str());
+		return false;
+	}
+
+	const unsigned int width = header.pixelWidth;
+	const unsigned int height = std::max(1u, header.pixelHeight);
+	const unsigned int layerCount = std::max(1u, header.layerCount);
+	const unsigned int faceCount = header.faceCount;
+	// A level count of 0 asks the loader to generate the mips, only the base level is stored
+	const unsigned int mipCount = std::max(1u, header.levelCount);
+	if (width == 0 || mipCount > getFullMipCount(width, height)) {
+		ERROR("TextureContainer", "parseKtx2", ("The KTX2 header is corrupted: " + fileName).c_str());
+		return false;
+	}
+
+	const uint64_t indexOffset = sizeof(Ktx2Header);
+	if (indexOffset + static_cast<uint64_t>(mipCount) * sizeof(Ktx2Level) > size) {
+		ERROR("TextureContainer", "parseKtx2", ("The KTX2 file is truncated: " + fileName).c_str());
+		return false;
+	}
+
+	// Levels store layer after layer and face after face; D3D11 wants slice after slice
+	const unsigned int arraySize = layerCount * faceCount;
+	std::vector<TextureSubresource> mips(static_cast<size_t>(arraySize) * mipCount);
+	for (unsigned int level = 0; level < mipCount; ++level) {
+		Ktx2Level entry;
+		memcpy(&entry, data + indexOffset + level * sizeof(Ktx2Level), sizeof(entry));
+
+		const unsigned int levelWidth = getLevelSize(width, level);
+		const unsigned int levelHeight = getLevelSize(height, level);
+		uint64_t rowPitch;
+		uint64_t slicePitch;
+		if (!computePitch(format, levelWidth, levelHeight, rowPitch, slicePitch)) {
+			ERROR("TextureContainer", "parseKtx2", ("Unsupported format in the KTX2 file: " + fileName).c_str());
+			return false;
+		}
+		if (entry.byteLength < slicePitch * arraySize || entry.byteOffset + entry.byteLength > size) {
+			ERROR("TextureContainer", "parseKtx2", ("The KTX2 file is truncated: " + fileName).c_str());
+			return false;
+		}
+
+		for (unsigned int slice = 0; slice < arraySize; ++slice) {
+			TextureSubresource& mip = mips[slice * mipCount + level];
+			mip.data = data + entry.byteOffset + slice * slicePitch;
+			mip.rowPitch = static_cast<unsigned int>(rowPitch);
+			mip.slicePitch = static_cast<unsigned int>(slicePitch);
+			mip.width = levelWidth;
+			mip.height = levelHeight;
+		}
+	}
+
+	outTexture.format = format;
+	outTexture.mips.swap(mips);
+	outTexture.arraySize = arraySize;
+	outTexture.cubemap = faceCount == 6;
+	return true;
+}
@@ -0,0 +1,229 @@
+#include "TextureLoader.h"
+#include "ImageDecoder.h"
+#include "MipGenerator.h"
+#include "TextureContainer.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+// Textures staged ahead of the upload callback, per worker
+static const size_t kStagedPerThread = 2;
+
+static double
+getSecondsSince(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+bool
+TextureLoader::stage(const std::string& fileName,
+										 const MipSettings* mipSettings,
+										 CompressionQuality compression,
+										 StagedTexture& outTexture,
+										 TextureLoadTiming* outTiming) {
+	auto decodeTime = std::chrono::high_resolution_clock::now();
+	outTexture = StagedTexture();
+
+	// DDS and KTX2 files are already in their GPU layout, they are mapped as they are
+	if (TextureContainer::isContainerFile(fileName)) {
+		outTexture.fileName = fileName;
+		outTexture.cooked = true;
+		if (!TextureContainer::load(fileName, outTexture.texture)) {
+			return false;
+		}
+		if (outTiming) {
+			outTiming->cooked = true;
+			outTiming->decodeSeconds = getSecondsSince(decodeTime);
+		}
+		return true;
+	}
+
+	// Prefer the texture cooked by OnkosCooker next to the source image
+	const size_t dot = fileName.find_last_of('.');
+	const size_t separator = fileName.find_last_of("/\\");
+	const std::string baseName = dot == std::string::npos || (separator != std::string::npos && dot < separator) ?
+		fileName : fileName.substr(0, dot);
+	TextureCache textureCache;
+	if (textureCache.load(baseName + ".onktex", outTexture.texture)) {
+		outTexture.fileName = baseName + ".onktex";
+		outTexture.cooked = true;
+		if (outTiming) {
+			outTiming->cooked = true;
+			outTiming->decodeSeconds = getSecondsSince(decodeTime);
+		}
+		return true;
+	}
+
+	outTexture.fileName = fileName;
+	outTexture.images.resize(1);
+	if (!ImageDecoder::decodeFile(fileName, outTexture.images[0])) {
+		return false;
+	}
+	auto mipTime = std::chrono::high_resolution_clock::now();
+	if (outTiming) {
+		outTiming->decodeSeconds = std::chrono::duration<double>(mipTime - decodeTime).count();
+	}
+
+	const TextureUsage usage = TextureCompressor::guessUsage(fileName);
+	if (mipSettings) {
+		MipSettings settings = *mipSettings;
+		settings.srgb = settings.srgb && usage != TEXTURE_USAGE_NORMAL;
+		MipGenerator::generate(outTexture.images, settings);
+	}
+	outTexture.texture.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	outTexture.texture.mips = TextureCache::describe(outTexture.images);
+	auto compressTime = std::chrono::high_resolution_clock::now();
+	if (outTiming) {
+		outTiming->mipSeconds = std::chrono::duration<double>(compressTime - mipTime).count();
+	}
+
+	const DXGI_FORMAT format = TextureCompressor::chooseFormat(outTexture.images[0], usage, compression);
+	if (TextureCompressor::isBlockFormat(format) &&
+			TextureCompressor::compressChain(outTexture.images, format, compression,
+				outTexture.blocks, outTexture.texture.mips)) {
+		outTexture.texture.format = format;
+		outTexture.images.clear();
+		if (outTiming) {
+			outTiming->compressSeconds = getSecondsSince(compressTime);
+		}
+	}
+	return true;
+}
+
+bool
+TextureLoader::loadBatch(const std::vector<std::string>& fileNames, const UploadCallback& upload) {
+	auto startTime = std::chrono::high_resolution_clock::now();
+	m_lastBatchStats = TextureBatchStats();
+	m_lastBatchStats.textures.resize(fileNames.size());
+	for (size_t i = 0; i < fileNames.size(); ++i) {
+		m_lastBatchStats.textures[i].fileName = fileNames[i];
+	}
+	if (fileNames.empty()) {
+		return true;
+	}
+
+	// The calling thread uploads while every worker decodes
+	const unsigned int threadCount = ThreadPool::resolveThreadCount(m_threadCount);
+	if (m_threadPool.getThreadCount() != threadCount) {
+		m_threadPool.init(threadCount);
+	}
+
+	std::vector<std::unique_ptr<StagedTexture>> staged(fileNames.size());
+	std::vector<char> succeeded(fileNames.size(), 0);
+	std::deque<size_t> ready;
+	std::mutex mutex;
+	std::condition_variable readyChanged;
+
+	const MipSettings* mipSettings = m_generateMips ? &m_mipSettings : nullptr;
+	const CompressionQuality compression = m_compression;
+	std::vector<TextureLoadTiming>& timings = m_lastBatchStats.textures;
+	auto enqueueStage = [&](size_t index) {
+		m_threadPool.enqueue([&, index]() {
+			std::unique_ptr<StagedTexture> texture(new StagedTexture());
+			const bool ok = stage(fileNames[index], mipSettings, compression, *texture, &timings[index]);
+			std::lock_guard<std::mutex> lock(mutex);
+			staged[index] = std::move(texture);
+			succeeded[index] = ok;
+			ready.push_back(index);
+			readyChanged.notify_one();
+		});
+	};
+
+	// Keep a bounded window of textures staged ahead of the uploads
+	const size_t window = threadCount * kStagedPerThread;
+	size_t queued = 0;
+	for (; queued < fileNames.size() && queued < window; ++queued) {
+		enqueueStage(queued);
+	}
+
+	bool allLoaded = true;
+	for (size_t uploaded = 0; uploaded < fileNames.size(); ++uploaded) {
+		size_t index;
+		std::unique_ptr<StagedTexture> texture;
+		bool ok;
+		{
+			auto waitTime = std::chrono::high_resolution_clock::now();
+			std::unique_lock<std::mutex> lock(mutex);
+			readyChanged.wait(lock, [&]() { return !ready.empty(); });
+			m_lastBatchStats.waitSeconds += getSecondsSince(waitTime);
+			index = ready.front();
+			ready.pop_front();
+			texture.swap(staged[index]);
+			ok = succeeded[index] != 0;
+		}
+		if (queued < fileNames.size()) {
+			enqueueStage(queued++);
+		}
+
+		auto uploadTime = std::chrono::high_resolution_clock::now();
+		TextureLoadTiming& timing = timings[index];
+		timing.loaded = upload(index, ok ? texture.get() : nullptr) && ok;
+		timing.uploadSeconds = getSecondsSince(uploadTime);
+		if (timing.loaded) {
+			++m_lastBatchStats.loadedCount;
+		}
+		else {
+			allLoaded = false;
+		}
+	}
+
+	m_lastBatchStats.totalSeconds = getSecondsSince(startTime);
+	return allLoaded;
+}
+
+TextureBatchHandle
+TextureLoader::loadBatchAsync(const std::vector<std::string>& fileNames) {
+	TextureBatchHandle request = std::make_shared<TextureBatchRequest>(fileNames.size());
+	const unsigned int threadCount = ThreadPool::resolveThreadCount(m_threadCount);
+	if (m_threadPool.getThreadCount() != threadCount) {
+		m_threadPool.init(threadCount);
+	}
+
+	// Every task holds the request and its own copy of the settings, so the
+	// caller may drop the handle or change the loader while they run
+	const bool generateMips = m_generateMips;
+	const MipSettings mipSettings = m_mipSettings;
+	const CompressionQuality compression = m_compression;
+	for (size_t i = 0; i < fileNames.size(); ++i) {
+		const std::string fileName = fileNames[i];
+		m_threadPool.enqueue([=]() {
+			std::unique_ptr<StagedTexture> texture;
+			if (!request->isCanceled()) {
+				texture.reset(new StagedTexture());
+				if (!stage(fileName, generateMips ? &mipSettings : nullptr, compression, *texture)) {
+					texture.reset();
+				}
+			}
+			request->publish(i, std::move(texture));
+		});
+	}
+	return request;
+}
+
+bool
+TextureBatchRequest::takeStaged(std::vector<StagedBatchTexture>& outTextures) {
+	std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+	if (!lock.owns_lock() || m_staged.empty()) {
+		return false;
+	}
+	m_takenCount += m_staged.size();
+	for (StagedBatchTexture& staged : m_staged) {
+		outTextures.push_back(std::move(staged));
+	}
+	m_staged.clear();
+	return true;
+}
+
+double
+TextureBatchRequest::getElapsedSeconds() const {
+	return getSecondsSince(m_startTime);
+}
+
+void
+TextureBatchRequest::publish(size_t index, std::unique_ptr<StagedTexture> texture) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_staged.emplace_back();
+	m_staged.back().index = index;
+	m_staged.back().texture = std::move(texture);
+}
@@ -0,0 +1,316 @@
+#include "TexturePacker.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+static inline unsigned int
+roundUp(unsigned int value, unsigned int alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * Copies an image into a page level with a gutter of its edge texels on every side.
+ */
+static void
+copyWithGutter(const Image& source, Image& page, unsigned int x, unsigned int y, unsigned int gutter) {
+	const int lastColumn = static_cast<int>(source.width) - 1;
+	const int lastRow = static_cast<int>(source.height) - 1;
+	const int firstX = std::max(0, static_cast<int>(x) - static_cast<int>(gutter));
+	const int firstY = std::max(0, static_cast<int>(y) - static_cast<int>(gutter));
+	const int endX = std::min(static_cast<int>(page.width), static_cast<int>(x + source.width + gutter));
+	const int endY = std::min(static_cast<int>(page.height), static_cast<int>(y + source.height + gutter));
+
+	for (int row = firstY; row < endY; ++row) {
+		const int sourceRow = std::min(std::max(row - static_cast<int>(y), 0), lastRow);
+		const unsigned char* sourceLine = &source.pixels[static_cast<size_t>(sourceRow) * source.getRowPitch()];
+		unsigned char* pageLine = &page.pixels[static_cast<size_t>(row) * page.getRowPitch()];
+
+		// Left gutter, the row itself, right gutter
+		const int left = std::min(static_cast<int>(x), endX);
+		for (int column = firstX; column < left; ++column) {
+			memcpy(pageLine + column * 4, sourceLine, 4);
+		}
+		memcpy(pageLine + x * 4, sourceLine, source.getRowPitch());
+		for (int column = static_cast<int>(x + source.width); column < endX; ++column) {
+			memcpy(pageLine + column * 4, sourceLine + lastColumn * 4, 4);
+		}
+	}
+}
+
+void
+SkylinePacker::init(unsigned int width, unsigned int height) {
+	m_width = width;
+	m_height = height;
+	m_skyline.assign(1, Segment{ 0, 0, width });
+	m_usedArea = 0;
+}
+
+bool
+SkylinePacker::insert(unsigned int width, unsigned int height, unsigned int& outX, unsigned int& outY) {
+	if (width == 0 || height == 0 || width > m_width || height > m_height) {
+		return false;
+	}
+
+	// The rectangle rests on the highest segment under it; keep the lowest top, then the leftmost
+	size_t best = m_skyline.size();
+	unsigned int bestY = 0;
+	unsigned int bestTop = UINT_MAX;
+	for (size_t i = 0; i < m_skyline.size(); ++i) {
+		const unsigned int x = m_skyline[i].x;
+		if (x + width > m_width) {
+			break;
+		}
+		unsigned int y = 0;
+		unsigned int remaining = width;
+		for (size_t j = i; remaining > 0; ++j) {
+			y = std::max(y, m_skyline[j].y);
+			remaining -= std::min(remaining, m_skyline[j].width);
+		}
+		if (y + height <= m_height && y + height < bestTop) {
+			best = i;
+			bestY = y;
+			bestTop = y + height;
+		}
+	}
+	if (best == m_skyline.size()) {
+		return false;
+	}
+
+	outX = m_skyline[best].x;
+	outY = bestY;
+	m_skyline.insert(m_skyline.begin() + best, Segment{ outX, bestTop, width });
+
+	// The new segment covers the start of the ones after it
+	const unsigned int end = outX + width;
+	for (size_t i = best + 1; i < m_skyline.size();) {
+		Segment& segment = m_skyline[i];
+		if (segment.x >= end) {
+			break;
+		}
+		const unsigned int covered = end - segment.x;
+		if (segment.width <= covered) {
+			m_skyline.erase(m_skyline.begin() + i);
+			continue;
+		}
+		segment.x += covered;
+		segment.width -= covered;
+		break;
+	}
+
+	// Neighbours at the same height become one segment
+	for (size_t i = 0; i + 1 < m_skyline.size();) {
+		if (m_skyline[i].y == m_skyline[i + 1].y) {
+			m_skyline[i].width += m_skyline[i + 1].width;
+			m_skyline.erase(m_skyline.begin() + i + 1);
+		}
+		else {
+			++i;
+		}
+	}
+
+	m_usedArea += static_cast<uint64_t>(width) * height;
+	return true;
+}
+
+CookedTexture
+TextureAtlas::describe() const {
+	CookedTexture texture;
+	texture.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	for (const std::vector<Image>& page : pages) {
+		const std::vector<TextureSubresource> levels = TextureCache::describe(page);
+		texture.mips.insert(texture.mips.end(), levels.begin(), levels.end());
+	}
+	texture.arraySize = static_cast<unsigned int>(pages.size());
+	texture.cubemap = false;
+	return texture;
+}
+
+bool
+TexturePacker::pack(const std::vector<const Image*>& images,
+										const TexturePackerSettings& settings,
+										TextureAtlas& outAtlas,
+										TexturePackerStats* outStats,
+										ThreadPool* threadPool) {
+	outAtlas = TextureAtlas();
+	if (settings.pageWidth == 0 || settings.pageHeight == 0 || settings.maxPages == 0) {
+		ERROR("TexturePacker", "pack", "The pages must have a size and a count.");
+		return false;
+	}
+	const unsigned int mipCount = std::max(1u,
+		std::min(settings.mipCount, MipGenerator::getMipCount(settings.pageWidth, settings.pageHeight)));
+	const unsigned int alignment = 1u << (mipCount - 1);
+	const unsigned int padding = roundUp(settings.padding, alignment);
+
+	TexturePackerStats stats;
+	stats.imageCount = images.size();
+	auto packStart = std::chrono::high_resolution_clock::now();
+
+	// Tallest first, the order the skyline wastes the least space with
+	std::vector<size_t> order(images.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		if (images[a]->height != images[b]->height) {
+			return images[a]->height > images[b]->height;
+		}
+		return images[a]->width > images[b]->width;
+	});
+
+	outAtlas.width = settings.pageWidth;
+	outAtlas.height = settings.pageHeight;
+	outAtlas.entries.resize(images.size());
+	std::vector<SkylinePacker> packers;
+	for (size_t index : order) {
+		const Image& image = *images[index];
+		PackedTexture& entry = outAtlas.entries[index];
+		entry.width = image.width;
+		entry.height = image.height;
+		if (image.empty()) {
+			continue;
+		}
+
+		const unsigned int cellWidth = roundUp(image.width + 2 * padding, alignment);
+		const unsigned int cellHeight = roundUp(image.height + 2 * padding, alignment);
+		unsigned int x = 0;
+		unsigned int y = 0;
+		size_t slice = 0;
+		while (slice < packers.size() && !packers[slice].insert(cellWidth, cellHeight, x, y)) {
+			++slice;
+		}
+		if (slice == packers.size()) {
+			if (packers.size() == settings.maxPages) {
+				continue;
+			}
+			packers.emplace_back();
+			packers.back().init(settings.pageWidth, settings.pageHeight);
+			if (!packers.back().insert(cellWidth, cellHeight, x, y)) {
+				packers.pop_back();
+				continue;
+			}
+		}
+
+		entry.packed = true;
+		entry.slice = static_cast<unsigned int>(slice);
+		entry.x = x + padding;
+		entry.y = y + padding;
+		entry.uvScale[0] = static_cast<float>(image.width) / settings.pageWidth;
+		entry.uvScale[1] = static_cast<float>(image.height) / settings.pageHeight;
+		entry.uvOffset[0] = static_cast<float>(entry.x) / settings.pageWidth;
+		entry.uvOffset[1] = static_cast<float>(entry.y) / settings.pageHeight;
+		++stats.packedCount;
+		stats.imageTexels += static_cast<uint64_t>(image.width) * image.height;
+	}
+	auto copyStart = std::chrono::high_resolution_clock::now();
+	stats.packSeconds = std::chrono::duration<double>(copyStart - packStart).count();
+
+	outAtlas.pages.resize(packers.size());
+	for (std::vector<Image>& page : outAtlas.pages) {
+		page.resize(mipCount);
+		for (unsigned int level = 0; level < mipCount; ++level) {
+			page[level].width = std::max(1u, settings.pageWidth >> level);
+			page[level].height = std::max(1u, settings.pageHeight >> level);
+			page[level].pixels.assign(static_cast<size_t>(page[level].getRowPitch()) * page[level].height, 0);
+		}
+	}
+
+	// Every image is reduced on its own and its cell is exclusive at every
+	// level, so the images are copied in parallel
+	auto copyImage = [&](size_t index) {
+		const PackedTexture& entry = outAtlas.entries[index];
+		if (!entry.packed) {
+			return;
+		}
+		std::vector<Image>& page = outAtlas.pages[entry.slice];
+		Image reduced[2];
+		const Image* level = images[index];
+		for (unsigned int mip = 0; mip < mipCount; ++mip) {
+			if (mip > 0) {
+				Image& target = reduced[mip & 1];
+				MipGenerator::reduce(*level, target, settings.mipSettings);
+				level = &target;
+			}
+			copyWithGutter(*level, page[mip], entry.x >> mip, entry.y >> mip, padding >> mip);
+		}
+	};
+	if (threadPool && threadPool->getThreadCount() > 0 && images.size() > 1) {
+		threadPool->parallelFor(images.size(), copyImage);
+	}
+	else {
+		for (size_t i = 0; i < images.size(); ++i) {
+			copyImage(i);
+		}
+	}
+	stats.copySeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - copyStart).count();
+
+	stats.pageCount = outAtlas.pages.size();
+	stats.pageTexels = static_cast<uint64_t>(settings.pageWidth) * settings.pageHeight * stats.pageCount;
+	stats.efficiency = stats.pageTexels > 0 ? static_cast<double>(stats.imageTexels) / stats.pageTexels : 0.0;
+	if (outStats) {
+		*outStats = stats;
+	}
+	if (stats.packedCount == 0) {
+		ERROR("TexturePacker", "pack", "No image fits in a page.");
+		return false;
+	}
+	return true;
+}
+
+bool
+TexturePacker::saveLayout(const std::string& fileName,
+													const std::vector<std::string>& names,
+													const TextureAtlas& atlas) {
+	std::ofstream file(fileName, std::ios::trunc);
+	if (!file.is_open() || names.size() != atlas.entries.size()) {
+		ERROR("TexturePacker", "saveLayout", ("The layout couldn't be written: " + fileName).c_str());
+		return false;
+	}
+	file << "# slice uOffset vOffset uScale vScale name\n" << std::setprecision(9);
+	for (size_t i = 0; i < atlas.entries.size(); ++i) {
+		const PackedTexture& entry = atlas.entries[i];
+		if (entry.packed) {
+			file << entry.slice << ' ' << entry.uvOffset[0] << ' ' << entry.uvOffset[1] << ' '
+				<< entry.uvScale[0] << ' ' << entry.uvScale[1] << ' ' << names[i] << '\n';
+		}
+	}
+	return file.good();
+}
+
+bool
+TexturePacker::loadLayout(const std::string& fileName,
+													std::vector<std::string>& outNames,
+													std::vector<PackedTexture>& outEntries) {
+	outNames.clear();
+	outEntries.clear();
+	std::ifstream file(fileName);
+	if (!file.is_open()) {
+		ERROR("TexturePacker", "loadLayout", ("The layout couldn't be opened: " + fileName).c_str());
+		return false;
+	}
+
+	std::string text;
+	while (std::getline(file, text)) {
+		if (text.empty() || text[0] == '#') {
+			continue;
+		}
+		// The name is the rest of the line, it may hold spaces
+		std::istringstream line(text);
+		PackedTexture entry;
+		std::string name;
+		line >> entry.slice >> entry.uvOffset[0] >> entry.uvOffset[1] >> entry.uvScale[0] >> entry.uvScale[1];
+		std::getline(line >> std::ws, name);
+		if (line.fail() || name.empty()) {
+			ERROR("TexturePacker", "loadLayout", ("The layout is malformed: " + fileName).c_str());
+			return false;
+		}
+		entry.packed = true;
+		outNames.push_back(name);
+		outEntries.push_back(entry);
+	}
+	return true;
+}
@@ -0,0 +1,286 @@
+#include "TextureStreamer.h"
+#include <algorithm>
+#include <cmath>
+
+void
+TextureStreamer::init(TextureStreamingDevice& device, const TextureStreamingSettings& settings) {
+	destroy();
+	m_device = &device;
+	m_settings = settings;
+}
+
+void
+TextureStreamer::destroy() {
+	for (size_t i = 0; i < m_entries.size(); ++i) {
+		if (m_entries[i] && m_device) {
+			m_device->releaseTexture(static_cast<StreamedTextureId>(i));
+		}
+	}
+	m_entries.clear();
+	m_frame = 0;
+	m_stats = TextureStreamingStats();
+	m_latencyFrames = 0;
+	m_latencySeconds = 0.0;
+}
+
+StreamedTextureId
+TextureStreamer::addTexture(std::unique_ptr<StagedTexture> texture, float priority) {
+	if (!m_device) {
+		ERROR("TextureStreamer", "addTexture", "The streamer has no device, call init first.");
+		return kInvalidStreamedTexture;
+	}
+	if (!texture) {
+		return kInvalidStreamedTexture;
+	}
+	const CookedTexture& cooked = texture->texture;
+	if (cooked.mips.empty() || cooked.arraySize == 0 || cooked.mips.size() % cooked.arraySize != 0) {
+		ERROR("TextureStreamer", "addTexture", ("The texture has no levels: " + texture->fileName).c_str());
+		return kInvalidStreamedTexture;
+	}
+
+	std::unique_ptr<Entry> entry(new Entry());
+	entry->mipCount = static_cast<unsigned int>(cooked.mips.size() / cooked.arraySize);
+	entry->bytesFrom.assign(entry->mipCount + 1, 0);
+	for (unsigned int mip = entry->mipCount; mip-- > 0;) {
+		uint64_t levelBytes = 0;
+		for (unsigned int slice = 0; slice < cooked.arraySize; ++slice) {
+			levelBytes += cooked.mips[slice * entry->mipCount + mip].slicePitch;
+		}
+		entry->bytesFrom[mip] = entry->bytesFrom[mip + 1] + levelBytes;
+	}
+
+	// The tail starts at the first level that fits in residentTailSize
+	entry->tailMip = entry->mipCount - 1;
+	for (unsigned int mip = 0; mip < entry->mipCount; ++mip) {
+		const TextureSubresource& level = cooked.mips[mip];
+		if (std::max(level.width, level.height) <= m_settings.residentTailSize) {
+			entry->tailMip = mip;
+			break;
+		}
+	}
+	entry->residentMip = entry->mipCount;
+	entry->wantedMip = entry->tailMip;
+	entry->targetMip = entry->tailMip;
+	entry->frameWantedMip = entry->tailMip;
+	entry->priority = priority;
+	entry->lastUsedFrame = m_frame;
+	entry->source = std::move(texture);
+
+	const StreamedTextureId id = static_cast<StreamedTextureId>(m_entries.size());
+	if (!setResidentMip(id, *entry, entry->tailMip)) {
+		ERROR("TextureStreamer", "addTexture", ("Failed to create the tail of " + entry->source->fileName).c_str());
+		return kInvalidStreamedTexture;
+	}
+	m_entries.push_back(std::move(entry));
+	return id;
+}
+
+void
+TextureStreamer::removeTexture(StreamedTextureId id) {
+	if (id >= m_entries.size() || !m_entries[id]) {
+		return;
+	}
+	m_device->releaseTexture(id);
+	m_entries[id].reset();
+}
+
+void
+TextureStreamer::reportUsage(StreamedTextureId id, float screenSize) {
+	if (id >= m_entries.size() || !m_entries[id]) {
+		return;
+	}
+	Entry& entry = *m_entries[id];
+	const TextureSubresource& base = entry.source->texture.mips[0];
+	const unsigned int mip = computeWantedMip(base.width, base.height, entry.mipCount, screenSize);
+	entry.frameWantedMip = entry.usedThisFrame ? std::min(entry.frameWantedMip, mip) : mip;
+	entry.usedThisFrame = true;
+}
+
+void
+TextureStreamer::update() {
+	++m_frame;
+	m_stats.uploadCount = 0;
+	m_stats.uploadedBytes = 0;
+	m_stats.evictionCount = 0;
+	m_stats.evictedBytes = 0;
+
+	// The feedback of the frame, or the tail once a texture hasn't been seen for a while
+	uint64_t wantedBytes = 0;
+	std::vector<StreamedTextureId> live;
+	for (size_t i = 0; i < m_entries.size(); ++i) {
+		if (!m_entries[i]) {
+			continue;
+		}
+		Entry& entry = *m_entries[i];
+		if (entry.usedThisFrame) {
+			entry.wantedMip = entry.frameWantedMip;
+			entry.lastUsedFrame = m_frame;
+			entry.usedThisFrame = false;
+		}
+		else if (m_frame - entry.lastUsedFrame > m_settings.unusedFrames) {
+			entry.wantedMip = entry.tailMip;
+		}
+		entry.targetMip = std::min(entry.wantedMip, entry.tailMip);
+		wantedBytes += entry.bytesFrom[entry.targetMip];
+		live.push_back(static_cast<StreamedTextureId>(i));
+	}
+	m_stats.wantedBytes = wantedBytes;
+
+	// Over budget: coarsen the least recently used textures first, the lowest priority among equals
+	if (wantedBytes > m_settings.budgetBytes) {
+		std::vector<StreamedTextureId> order = live;
+		std::stable_sort(order.begin(), order.end(), [&](StreamedTextureId a, StreamedTextureId b) {
+			const Entry& ea = *m_entries[a];
+			const Entry& eb = *m_entries[b];
+			if (ea.lastUsedFrame != eb.lastUsedFrame) {
+				return ea.lastUsedFrame < eb.lastUsedFrame;
+			}
+			return ea.priority < eb.priority;
+		});
+		uint64_t total = wantedBytes;
+		for (StreamedTextureId id : order) {
+			Entry& entry = *m_entries[id];
+			while (total > m_settings.budgetBytes && entry.targetMip < entry.tailMip) {
+				total -= entry.bytesFrom[entry.targetMip] - entry.bytesFrom[entry.targetMip + 1];
+				++entry.targetMip;
+			}
+			if (total <= m_settings.budgetBytes) {
+				break;
+			}
+		}
+	}
+
+	// Free memory before uploading anything
+	std::vector<StreamedTextureId> pending;
+	for (StreamedTextureId id : live) {
+		Entry& entry = *m_entries[id];
+		if (entry.targetMip > entry.residentMip) {
+			const uint64_t freed = entry.bytesFrom[entry.residentMip] - entry.bytesFrom[entry.targetMip];
+			if (setResidentMip(id, entry, entry.targetMip)) {
+				++m_stats.evictionCount;
+				m_stats.evictedBytes += freed;
+			}
+		}
+		if (entry.targetMip < entry.residentMip) {
+			if (!entry.pending) {
+				entry.pending = true;
+				entry.requestFrame = m_frame;
+				entry.requestTime = std::chrono::high_resolution_clock::now();
+			}
+			pending.push_back(id);
+		}
+		else {
+			entry.pending = false;
+		}
+	}
+
+	// Stream in, highest priority first and then the most recently used
+	std::stable_sort(pending.begin(), pending.end(), [&](StreamedTextureId a, StreamedTextureId b) {
+		const Entry& ea = *m_entries[a];
+		const Entry& eb = *m_entries[b];
+		if (ea.priority != eb.priority) {
+			return ea.priority > eb.priority;
+		}
+		return ea.lastUsedFrame > eb.lastUsedFrame;
+	});
+	uint64_t remaining = m_settings.uploadBytesPerFrame;
+	for (StreamedTextureId id : pending) {
+		Entry& entry = *m_entries[id];
+
+		// The finest level whose texture fits in what is left of the frame,
+		// or one level finer if nothing was uploaded yet
+		unsigned int mip = entry.targetMip;
+		while (mip < entry.residentMip && entry.bytesFrom[mip] > remaining) {
+			++mip;
+		}
+		if (mip == entry.residentMip) {
+			if (m_stats.uploadCount > 0) {
+				continue;
+			}
+			mip = entry.residentMip - 1;
+		}
+
+		const uint64_t bytes = entry.bytesFrom[mip];
+		if (!setResidentMip(id, entry, mip)) {
+			continue;
+		}
+		++m_stats.uploadCount;
+		m_stats.uploadedBytes += bytes;
+		remaining = bytes < remaining ? remaining - bytes : 0;
+
+		if (entry.residentMip == entry.targetMip) {
+			entry.pending = false;
+			const double seconds = std::chrono::duration<double>(
+				std::chrono::high_resolution_clock::now() - entry.requestTime).count();
+			++m_stats.completedRequests;
+			m_latencyFrames += m_frame - entry.requestFrame;
+			m_latencySeconds += seconds;
+			m_stats.maxLatencySeconds = std::max(m_stats.maxLatencySeconds, seconds);
+		}
+	}
+}
+
+bool
+TextureStreamer::getTextureInfo(StreamedTextureId id, StreamedTextureInfo& outInfo) const {
+	if (id >= m_entries.size() || !m_entries[id]) {
+		return false;
+	}
+	const Entry& entry = *m_entries[id];
+	outInfo.width = entry.source->texture.mips[0].width;
+	outInfo.height = entry.source->texture.mips[0].height;
+	outInfo.mipCount = entry.mipCount;
+	outInfo.residentMip = entry.residentMip;
+	outInfo.wantedMip = entry.wantedMip;
+	outInfo.targetMip = entry.targetMip;
+	outInfo.residentBytes = entry.bytesFrom[entry.residentMip];
+	outInfo.lastUsedFrame = entry.lastUsedFrame;
+	outInfo.priority = entry.priority;
+	return true;
+}
+
+TextureStreamingStats
+TextureStreamer::getStats() const {
+	TextureStreamingStats stats = m_stats;
+	stats.budgetBytes = m_settings.budgetBytes;
+	stats.textureCount = 0;
+	stats.residentBytes = 0;
+	stats.pendingCount = 0;
+	for (const std::unique_ptr<Entry>& entry : m_entries) {
+		if (!entry) {
+			continue;
+		}
+		++stats.textureCount;
+		stats.residentBytes += entry->bytesFrom[entry->residentMip];
+		stats.pendingCount += entry->pending ? 1 : 0;
+	}
+	if (stats.completedRequests > 0) {
+		stats.averageLatencyFrames = static_cast<double>(m_latencyFrames) / stats.completedRequests;
+		stats.averageLatencySeconds = m_latencySeconds / stats.completedRequests;
+	}
+	return stats;
+}
+
+unsigned int
+TextureStreamer::computeWantedMip(unsigned int width, unsigned int height, unsigned int mipCount, float screenSize) {
+	if (mipCount == 0) {
+		return 0;
+	}
+	const float size = static_cast<float>(std::max(width, height));
+	if (!(screenSize > 0.0f)) {
+		return mipCount - 1;
+	}
+	if (screenSize >= size) {
+		return 0;
+	}
+	const unsigned int mip = static_cast<unsigned int>(std::floor(std::log2(size / screenSize)));
+	return std::min(mip, mipCount - 1);
+}
+
+bool
+TextureStreamer::setResidentMip(StreamedTextureId id, Entry& entry, unsigned int mip) {
+	if (!m_device->createTexture(id, *entry.source, mip)) {
+		return false;
+	}
+	entry.residentMip = mip;
+	return true;
+}
@@ -0,0 +1,113 @@
+#include "ThreadPool.h"
+
+void
+ThreadPool::init(unsigned int threadCount) {
+	destroy();
+
+	threadCount = resolveThreadCount(threadCount);
+	m_stopping = false;
+	m_workers.reserve(threadCount);
+	for (unsigned int i = 0; i < threadCount; ++i) {
+		m_workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+void
+ThreadPool::destroy() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_taskAvailable.notify_all();
+
+	for (std::thread& worker : m_workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+	m_workers.clear();
+}
+
+void
+ThreadPool::enqueue(std::function<void()> task) {
+	if (m_workers.empty()) {
+		task();
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+	m_taskAvailable.notify_one();
+}
+
+void
+ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+	if (count == 0) {
+		return;
+	}
+	if (m_workers.empty() || count == 1) {
+		for (size_t i = 0; i < count; ++i) {
+			task(i);
+		}
+		return;
+	}
+
+	// Every participant pulls indices from a shared counter until none are left
+	std::atomic<size_t> nextIndex(0);
+	std::atomic<size_t> pendingHelpers(0);
+	std::mutex doneMutex;
+	std::condition_variable doneSignal;
+
+	auto drain = [&]() {
+		for (size_t i = nextIndex.fetch_add(1); i < count; i = nextIndex.fetch_add(1)) {
+			task(i);
+		}
+	};
+
+	size_t helpers = count - 1 < m_workers.size() ? count - 1 : m_workers.size();
+	pendingHelpers = helpers;
+	for (size_t h = 0; h < helpers; ++h) {
+		enqueue([&]() {
+			drain();
+			// Decrement under the lock so the caller can't return (and destroy
+			// these locals) before this helper is done touching them
+			std::lock_guard<std::mutex> lock(doneMutex);
+			if (--pendingHelpers == 0) {
+				doneSignal.notify_one();
+			}
+		});
+	}
+
+	drain();
+
+	std::unique_lock<std::mutex> lock(doneMutex);
+	doneSignal.wait(lock, [&]() { return pendingHelpers.load() == 0; });
+}
+
+unsigned int
+ThreadPool::resolveThreadCount(unsigned int requested) {
+	if (requested != 0) {
+		return requested;
+	}
+	unsigned int hardware = std::thread::hardware_concurrency();
+	return hardware != 0 ? hardware : 1;
+}
+
+void
+ThreadPool::workerLoop() {
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_taskAvailable.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+			if (m_tasks.empty()) {
+				// Only reached when stopping and every queued task has been run
+				return;
+			}
+			task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+		}
+		task();
+	}
+}
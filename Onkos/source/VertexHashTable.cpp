@@ -0,0 +1,39 @@
+#include "VertexHashTable.h"
+
+void
+VertexHashTable::init(size_t expectedKeys) {
+	// Keep the load factor at or below 0.5 so probe sequences stay short
+	size_t capacity = 16;
+	while (capacity < expectedKeys * 2) {
+		capacity <<= 1;
+	}
+
+	Slot empty = {};
+	empty.index = -1;
+	m_slots.assign(capacity, empty);
+	m_mask = capacity - 1;
+	m_count = 0;
+}
+
+void
+VertexHashTable::destroy() {
+	m_slots.clear();
+	m_slots.shrink_to_fit();
+	m_mask = 0;
+	m_count = 0;
+}
+
+void
+VertexHashTable::grow() {
+	std::vector<Slot> oldSlots;
+	oldSlots.swap(m_slots);
+
+	init(oldSlots.empty() ? 8 : oldSlots.size());
+
+	for (const Slot& slot : oldSlots) {
+		if (slot.index >= 0) {
+			int unused = 0;
+			findOrInsert(slot.key, slot.index, unused);
+		}
+	}
+}
@@ -0,0 +1,236 @@
+#include "VertexQuantizer.h"
+#include "MeshComponent.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+static const float kUnorm16Max = 65535.0f;
+static const float kSnorm16Max = 32767.0f;
+static const float kSnorm8Max = 127.0f;
+static const float kRadiansToDegrees = 57.29577951f;
+
+static inline float
+signNotZero(float value) {
+	return value < 0.0f ? -1.0f : 1.0f;
+}
+
+static inline float
+clampUnit(float value) {
+	return value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+}
+
+/**
+ * Angle in degrees between two unit vectors.
+ */
+static inline float
+angleBetween(const XMFLOAT3& a, const XMFLOAT3& b) {
+	return std::acos(clampUnit(a.x * b.x + a.y * b.y + a.z * b.z)) * kRadiansToDegrees;
+}
+
+void
+VertexQuantizer::quantize(MeshComponent& mesh, QuantizationReport* outReport) {
+	mesh.computeBounds();
+
+	const SimpleVertex* vertices = mesh.getVertexData();
+	const size_t vertexCount = mesh.getVertexCount();
+	const float boundsMin[3] = { mesh.m_boundsMin.x, mesh.m_boundsMin.y, mesh.m_boundsMin.z };
+	const float extent[3] = {
+		mesh.m_boundsMax.x - mesh.m_boundsMin.x,
+		mesh.m_boundsMax.y - mesh.m_boundsMin.y,
+		mesh.m_boundsMax.z - mesh.m_boundsMin.z };
+
+	// A flat axis quantizes to 0 and decodes back to the minimum
+	float scale[3];
+	for (int k = 0; k < 3; ++k) {
+		scale[k] = extent[k] > 0.0f ? kUnorm16Max / extent[k] : 0.0f;
+	}
+
+	QuantizationReport report;
+	double squaredErrorSum = 0.0;
+	mesh.m_quantizedVertex.resize(vertexCount);
+
+	for (size_t i = 0; i < vertexCount; ++i) {
+		const float position[3] = { vertices[i].Pos.x, vertices[i].Pos.y, vertices[i].Pos.z };
+		QuantizedVertex& out = mesh.m_quantizedVertex[i];
+
+		float squaredError = 0.0f;
+		for (int k = 0; k < 3; ++k) {
+			float q = std::floor((position[k] - boundsMin[k]) * scale[k] + 0.5f);
+			q = q < 0.0f ? 0.0f : (q > kUnorm16Max ? kUnorm16Max : q);
+			out.Pos[k] = static_cast<unsigned short>(q);
+
+			const float decoded = boundsMin[k] + (q / kUnorm16Max) * extent[k];
+			squaredError += (decoded - position[k]) * (decoded - position[k]);
+		}
+		out.Pos[3] = static_cast<unsigned short>(kUnorm16Max);
+
+		out.Tex[0] = floatToHalf(vertices[i].Tex.x);
+		out.Tex[1] = floatToHalf(vertices[i].Tex.y);
+		const float texError[2] = {
+			std::fabs(halfToFloat(out.Tex[0]) - vertices[i].Tex.x),
+			std::fabs(halfToFloat(out.Tex[1]) - vertices[i].Tex.y) };
+
+		// Unit vectors, their octahedral coordinates go to signed normalized integers
+		const XMFLOAT2 normal = encodeOctahedral(vertices[i].Norm);
+		out.Norm[0] = static_cast<short>(std::floor(clampUnit(normal.x) * kSnorm16Max + 0.5f));
+		out.Norm[1] = static_cast<short>(std::floor(clampUnit(normal.y) * kSnorm16Max + 0.5f));
+		const XMFLOAT3 tangentVector(vertices[i].Tangent.x, vertices[i].Tangent.y, vertices[i].Tangent.z);
+		const XMFLOAT2 tangent = encodeOctahedral(tangentVector);
+		out.Tangent[0] = static_cast<signed char>(std::floor(clampUnit(tangent.x) * kSnorm8Max + 0.5f));
+		out.Tangent[1] = static_cast<signed char>(std::floor(clampUnit(tangent.y) * kSnorm8Max + 0.5f));
+		out.Tangent[2] = static_cast<signed char>(vertices[i].Tangent.w < 0.0f ? -kSnorm8Max : kSnorm8Max);
+		out.Tangent[3] = 0;
+
+		const XMFLOAT3 decodedNormal = decodeOctahedral(XMFLOAT2(out.Norm[0] / kSnorm16Max, out.Norm[1] / kSnorm16Max));
+		const XMFLOAT3 decodedTangent = decodeOctahedral(XMFLOAT2(out.Tangent[0] / kSnorm8Max, out.Tangent[1] / kSnorm8Max));
+		const XMFLOAT3 originalNormal = decodeOctahedral(normal);
+		const XMFLOAT3 originalTangent = decodeOctahedral(tangent);
+		const float normalError = angleBetween(originalNormal, decodedNormal);
+		const float tangentError = angleBetween(originalTangent, decodedTangent);
+		report.maxNormalError = normalError > report.maxNormalError ? normalError : report.maxNormalError;
+		report.maxTangentError = tangentError > report.maxTangentError ? tangentError : report.maxTangentError;
+
+		const float positionError = std::sqrt(squaredError);
+		report.maxPositionError = positionError > report.maxPositionError ? positionError : report.maxPositionError;
+		report.maxTexError = texError[0] > report.maxTexError ? texError[0] : report.maxTexError;
+		report.maxTexError = texError[1] > report.maxTexError ? texError[1] : report.maxTexError;
+		squaredErrorSum += squaredError;
+	}
+
+	report.rmsPositionError = vertexCount > 0 ?
+		static_cast<float>(std::sqrt(squaredErrorSum / vertexCount)) : 0.0f;
+	report.bytesBefore = vertexCount * sizeof(SimpleVertex);
+	report.bytesAfter = vertexCount * sizeof(QuantizedVertex);
+	if (outReport) {
+		*outReport = report;
+	}
+}
+
+XMFLOAT3
+VertexQuantizer::getDequantizeScale(const MeshComponent& mesh) {
+	return XMFLOAT3(mesh.m_boundsMax.x - mesh.m_boundsMin.x,
+		mesh.m_boundsMax.y - mesh.m_boundsMin.y,
+		mesh.m_boundsMax.z - mesh.m_boundsMin.z);
+}
+
+XMFLOAT3
+VertexQuantizer::getDequantizeOffset(const MeshComponent& mesh) {
+	return mesh.m_boundsMin;
+}
+
+std::vector<VertexElement>
+VertexQuantizer::getInputLayout(VertexFormat format) {
+	std::vector<VertexElement> layout;
+	if (format == VERTEX_FORMAT_QUANTIZED) {
+		layout.push_back({ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0 });
+		layout.push_back({ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 8 });
+		layout.push_back({ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 12 });
+		layout.push_back({ "TANGENT", 0, DXGI_FORMAT_R8G8B8A8_SNORM, 16 });
+	}
+	else {
+		layout.push_back({ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0 });
+		layout.push_back({ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 12 });
+		layout.push_back({ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 20 });
+		layout.push_back({ "TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 32 });
+	}
+	return layout;
+}
+
+unsigned int
+VertexQuantizer::getVertexStride(VertexFormat format) {
+	return format == VERTEX_FORMAT_QUANTIZED ? sizeof(QuantizedVertex) : sizeof(SimpleVertex);
+}
+
+XMFLOAT2
+VertexQuantizer::encodeOctahedral(const XMFLOAT3& v) {
+	const float length = std::fabs(v.x) + std::fabs(v.y) + std::fabs(v.z);
+	if (length <= 0.0f) {
+		return XMFLOAT2(0.0f, 0.0f);
+	}
+	float x = v.x / length;
+	float y = v.y / length;
+	if (v.z < 0.0f) {
+		// Fold the lower half of the octahedron over the upper one
+		const float foldedX = (1.0f - std::fabs(y)) * signNotZero(x);
+		y = (1.0f - std::fabs(x)) * signNotZero(y);
+		x = foldedX;
+	}
+	return XMFLOAT2(x, y);
+}
+
+XMFLOAT3
+VertexQuantizer::decodeOctahedral(const XMFLOAT2& e) {
+	XMFLOAT3 v(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+	if (v.z < 0.0f) {
+		v.x = (1.0f - std::fabs(e.y)) * signNotZero(e.x);
+		v.y = (1.0f - std::fabs(e.x)) * signNotZero(e.y);
+	}
+	const float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+	return XMFLOAT3(v.x / length, v.y / length, v.z / length);
+}
+
+unsigned short
+VertexQuantizer::floatToHalf(float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	const uint32_t sign = (bits >> 16) & 0x8000u;
+	const uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+	if (magnitude >= 0x7F800000u) {
+		// Infinity stays infinity, NaN stays a (quiet) NaN
+		return static_cast<unsigned short>(sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x0200u : 0u));
+	}
+	if (magnitude >= 0x477FF000u) {
+		// Rounds above 65504, the largest half
+		return static_cast<unsigned short>(sign | 0x7C00u);
+	}
+	if (magnitude < 0x38800000u) {
+		// Below 2^-14 the result is subnormal: value / 2^-24, rounded to nearest even
+		if (magnitude < 0x33000000u) {
+			return static_cast<unsigned short>(sign);
+		}
+		const uint32_t exponent = magnitude >> 23;
+		const uint32_t mantissa = (magnitude & 0x007FFFFFu) | 0x00800000u;
+		const uint32_t shift = 126u - exponent;
+		const uint32_t halfway = 1u << (shift - 1);
+		const uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t result = mantissa >> shift;
+		if (remainder > halfway || (remainder == halfway && (result & 1u))) {
+			++result;
+		}
+		return static_cast<unsigned short>(sign | result);
+	}
+
+	// Normal range: rebias the exponent and round the mantissa to 10 bits.
+	// A carry out of the mantissa correctly bumps the exponent
+	uint32_t result = ((magnitude >> 23) - 112u) << 10 | ((magnitude >> 13) & 0x3FFu);
+	const uint32_t remainder = magnitude & 0x1FFFu;
+	if (remainder > 0x1000u || (remainder == 0x1000u && (result & 1u))) {
+		++result;
+	}
+	return static_cast<unsigned short>(sign | result);
+}
+
+float
+VertexQuantizer::halfToFloat(unsigned short value) {
+	const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+	const uint32_t exponent = (value >> 10) & 0x1Fu;
+	const uint32_t mantissa = value & 0x3FFu;
+
+	uint32_t bits;
+	if (exponent == 0) {
+		// Zero or subnormal
+		const float magnitude = static_cast<float>(mantissa) * 5.9604644775390625e-8f;
+		return sign ? -magnitude : magnitude;
+	}
+	if (exponent == 31) {
+		bits = sign | 0x7F800000u | (mantissa << 13);
+	}
+	else {
+		bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+	}
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
@@ -0,0 +1,355 @@
+//--------------------------------------------------------------------------------------
+// File: CompressorTest.cpp
+//
+// Checks TextureCompressor: solid blocks decode exactly in every format, a color image,
+// an image with alpha and a normal map keep their PSNR above fixed limits with both
+// presets, the blocks of odd sizes and of the threaded path are right, and the format
+// is picked as documented. Then times every format and preset, on one thread and on
+// the pool, and reports their throughput and PSNR.
+//
+// Usage: OnkosCompressorTest [-n <runs>] [-s <size>] [-j <threads>]
+//--------------------------------------------------------------------------------------
+#include "Prerequisites.h"
+#include "TextureCompressor.h"
+#include "ThreadPool.h"
+#include "TestMeshes.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * A format with the channels it keeps and the PSNR limits of each preset on the test
+ * images. The limits sit about 1 dB under what the encoders reach today.
+ */
+struct
+FormatCase {
+	const char* name;
+	DXGI_FORMAT format;
+	unsigned int channelCount;
+	double fastLimit;
+	double highLimit;
+};
+
+static const FormatCase kFormats[] = {
+	{ "BC1", DXGI_FORMAT_BC1_UNORM, 3, 39.0, 39.8 },
+	{ "BC3", DXGI_FORMAT_BC3_UNORM, 4, 40.2, 41.0 },
+	{ "BC5", DXGI_FORMAT_BC5_UNORM, 2, 38.4, 39.5 },
+	{ "BC7", DXGI_FORMAT_BC7_UNORM, 4, 42.0, 44.6 },
+};
+
+static const char* kQualityNames[] = { "", "fast", "high" };
+
+static unsigned int failureCount = 0;
+
+static void
+expect(bool condition, const std::string& name, const char* what) {
+	if (!condition) {
+		printf("FAILED %s: %s\n", name.c_str(), what);
+		++failureCount;
+	}
+}
+
+/**
+ * Something like a photo: smooth gradients, soft shapes with hard edges and some
+ * noise. The alpha is a gradient with a cut out disc.
+ */
+static Image
+makeColorImage(unsigned int width, unsigned int height, uint32_t seed) {
+	TestRandom random(seed);
+	Image image;
+	image.width = width;
+	image.height = height;
+	image.pixels.resize(static_cast<size_t>(width) * height * 4);
+	for (unsigned int y = 0; y < height; ++y) {
+		for (unsigned int x = 0; x < width; ++x) {
+			const float u = x / static_cast<float>(width);
+			const float v = y / static_cast<float>(height);
+			const float noise = random.nextFloat() * 12.0f - 6.0f;
+			float r = 40.0f + 160.0f * u + 30.0f * std::sin(v * 17.0f);
+			float g = 90.0f + 100.0f * v * (1.0f - u) + 40.0f * std::cos(u * 23.0f + v * 5.0f);
+			float b = ((x / 24 + y / 24) % 2) ? 200.0f - 80.0f * v : 30.0f + 60.0f * u;
+			const float dx = u - 0.6f;
+			const float dy = v - 0.4f;
+			const bool disc = dx * dx + dy * dy < 0.04f;
+			if (disc) {
+				r = 230.0f;
+				g = 210.0f - 50.0f * v;
+			}
+			unsigned char* texel = &image.pixels[(static_cast<size_t>(y) * width + x) * 4];
+			texel[0] = static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, r + noise)));
+			texel[1] = static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, g + noise)));
+			texel[2] = static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, b + noise)));
+			texel[3] = disc ? 0 : static_cast<unsigned char>(255.0f - 120.0f * u * v);
+		}
+	}
+	return image;
+}
+
+/**
+ * The tangent-space normals of a bumpy height field, packed as n * 0.5 + 0.5.
+ */
+static Image
+makeNormalImage(unsigned int width, unsigned int height) {
+	Image image;
+	image.width = width;
+	image.height = height;
+	image.pixels.resize(static_cast<size_t>(width) * height * 4);
+	auto heightAt = [&](float x, float y) {
+		return 6.0f * std::sin(x * 0.11f) * std::cos(y * 0.07f) + 2.0f * std::sin((x + y) * 0.31f);
+	};
+	for (unsigned int y = 0; y < height; ++y) {
+		for (unsigned int x = 0; x < width; ++x) {
+			float nx = heightAt(x - 1.0f, static_cast<float>(y)) - heightAt(x + 1.0f, static_cast<float>(y));
+			float ny = heightAt(static_cast<float>(x), y - 1.0f) - heightAt(static_cast<float>(x), y + 1.0f);
+			float nz = 2.0f;
+			const float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+			unsigned char* texel = &image.pixels[(static_cast<size_t>(y) * width + x) * 4];
+			texel[0] = static_cast<unsigned char>((nx / length * 0.5f + 0.5f) * 255.0f + 0.5f);
+			texel[1] = static_cast<unsigned char>((ny / length * 0.5f + 0.5f) * 255.0f + 0.5f);
+			texel[2] = static_cast<unsigned char>((nz / length * 0.5f + 0.5f) * 255.0f + 0.5f);
+			texel[3] = 255;
+		}
+	}
+	return image;
+}
+
+static Image
+makeOpaque(Image image) {
+	for (size_t i = 3; i < image.pixels.size(); i += 4) {
+		image.pixels[i] = 255;
+	}
+	return image;
+}
+
+/**
+ * The image each format is meant for: opaque color for BC1, normals for BC5.
+ */
+static const Image&
+imageFor(const FormatCase& format, const Image& color, const Image& opaque, const Image& normals) {
+	if (format.format == DXGI_FORMAT_BC1_UNORM) {
+		return opaque;
+	}
+	return format.format == DXGI_FORMAT_BC5_UNORM ? normals : color;
+}
+
+/**
+ * Solid blocks of colors RGB565 represents exactly come back exactly in every format,
+ * or within 1 in BC7.
+ */
+static void
+checkSolidBlocks() {
+	// 255 and 0 in every channel, and 132/130/132, which are 16/32/16 in RGB565
+	static const unsigned char kColors[4][4] = { { 255, 0, 0, 255 }, { 0, 255, 0, 0 }, { 0, 0, 255, 77 },
+		{ 132, 130, 132, 200 } };
+	Image image;
+	image.width = 8;
+	image.height = 8;
+	image.pixels.resize(8 * 8 * 4);
+	for (unsigned int y = 0; y < 8; ++y) {
+		for (unsigned int x = 0; x < 8; ++x) {
+			memcpy(&image.pixels[(y * 8 + x) * 4], kColors[(y / 4) * 2 + x / 4], 4);
+		}
+	}
+	for (const FormatCase& format : kFormats) {
+		for (CompressionQuality quality : { COMPRESSION_FAST, COMPRESSION_HIGH }) {
+			const std::string name = std::string(format.name) + " " + kQualityNames[quality] + " solid blocks";
+			// BC1 keeps no alpha, so its image is opaque
+			const Image input = format.format == DXGI_FORMAT_BC1_UNORM ? makeOpaque(image) : image;
+			std::vector<unsigned char> blocks;
+			Image decoded;
+			expect(TextureCompressor::compress(input, format.format, quality, blocks), name, "compress failed");
+			expect(TextureCompressor::decompress(blocks.data(), format.format, 8, 8, decoded), name, "decompress failed");
+			int worst = 0;
+			for (size_t i = 0; i < input.pixels.size(); ++i) {
+				if (i % 4 < format.channelCount) {
+					worst = std::max(worst, std::abs(input.pixels[i] - decoded.pixels[i]));
+				}
+			}
+			// A BC7 mode 6 endpoint has one p-bit for its 4 channels, so 255 next to 0 comes back as 254
+			expect(worst <= (format.format == DXGI_FORMAT_BC7_UNORM ? 1 : 0), name, "a solid block didn't decode exactly");
+		}
+	}
+	printf("%-36s exact, within 1 in BC7\n", "solid blocks");
+}
+
+/**
+ * Round trips of the test images, the sizes of the blocks and the PSNR of the report.
+ */
+static void
+checkQuality(const Image& color, const Image& opaque, const Image& normals) {
+	for (const FormatCase& format : kFormats) {
+		const Image& image = imageFor(format, color, opaque, normals);
+		double fastPsnr = 0.0;
+		for (CompressionQuality quality : { COMPRESSION_FAST, COMPRESSION_HIGH }) {
+			const std::string name = std::string(format.name) + " " + kQualityNames[quality];
+			std::vector<unsigned char> blocks;
+			CompressionReport report;
+			if (!TextureCompressor::compress(image, format.format, quality, blocks, &report)) {
+				expect(false, name, "compress failed");
+				continue;
+			}
+			const size_t expectedBytes = static_cast<size_t>(image.width / 4) * (image.height / 4) *
+				TextureCompressor::getBlockBytes(format.format);
+			expect(blocks.size() == expectedBytes && report.outputBytes == expectedBytes, name, "wrong size of the blocks");
+			expect(report.inputBytes == image.pixels.size() && report.format == format.format, name, "wrong report");
+
+			Image decoded;
+			TextureCompressor::decompress(blocks.data(), format.format, image.width, image.height, decoded);
+			const double psnr = TextureCompressor::computePsnr(image, decoded, format.channelCount);
+			expect(std::fabs(psnr - report.psnr) < 1e-9, name, "the report's PSNR differs from a decode");
+
+			const double limit = quality == COMPRESSION_FAST ? format.fastLimit : format.highLimit;
+			expect(psnr >= limit, name, "PSNR under the limit");
+			if (quality == COMPRESSION_FAST) {
+				fastPsnr = psnr;
+			}
+			else {
+				expect(psnr >= fastPsnr, name, "the high preset is worse than the fast one");
+			}
+			printf("%-36s PSNR %6.2f dB (limit %5.2f)\n", name.c_str(), psnr, limit);
+		}
+	}
+}
+
+/**
+ * Sizes that aren't a multiple of 4 repeat their edges into whole blocks, and the
+ * threaded encoder writes the same bytes as one thread.
+ */
+static void
+checkLayout(const Image& color, ThreadPool& threadPool) {
+	const Image odd = makeColorImage(13, 6, 7);
+	for (const FormatCase& format : kFormats) {
+		const std::string name = std::string(format.name) + " 13x6";
+		std::vector<unsigned char> blocks;
+		TextureCompressor::compress(odd, format.format, COMPRESSION_FAST, blocks);
+		expect(blocks.size() == 4u * 2u * TextureCompressor::getBlockBytes(format.format), name, "wrong size of the blocks");
+		expect(TextureCompressor::getRowPitch(format.format, 13) == 4u * TextureCompressor::getBlockBytes(format.format),
+			name, "wrong row pitch");
+		Image decoded;
+		TextureCompressor::decompress(blocks.data(), format.format, 13, 6, decoded);
+		expect(decoded.width == 13 && decoded.height == 6 && decoded.pixels.size() == odd.pixels.size(), name,
+			"wrong decoded size");
+		expect(TextureCompressor::computePsnr(odd, decoded, format.channelCount) > 20.0, name, "the edge blocks are wrong");
+
+		for (CompressionQuality quality : { COMPRESSION_FAST, COMPRESSION_HIGH }) {
+			std::vector<unsigned char> serial;
+			std::vector<unsigned char> threaded;
+			TextureCompressor::compress(color, format.format, quality, serial);
+			TextureCompressor::compress(color, format.format, quality, threaded, nullptr, &threadPool);
+			expect(serial == threaded, std::string(format.name) + " " + kQualityNames[quality] + " threads",
+				"the threaded blocks differ");
+		}
+	}
+	printf("%-36s whole edge blocks, identical to one thread\n", "layout");
+
+	// Only mode 6 BC7 blocks decode, a mode 0 block is reported (and logs an error)
+	std::vector<unsigned char> mode0(16, 0);
+	mode0[0] = 1;
+	Image decoded;
+	expect(!TextureCompressor::decompress(mode0.data(), DXGI_FORMAT_BC7_UNORM, 4, 4, decoded), "BC7 mode 0",
+		"decompress accepted a mode it can't decode");
+	expect(!TextureCompressor::isBlockFormat(DXGI_FORMAT_R8G8B8A8_UNORM), "RGBA8", "taken for a block format");
+}
+
+static void
+checkFormatChoice(const Image& color, const Image& opaque) {
+	expect(TextureCompressor::chooseFormat(opaque, TEXTURE_USAGE_COLOR, COMPRESSION_FAST) == DXGI_FORMAT_BC1_UNORM,
+		"choose", "opaque fast color isn't BC1");
+	expect(TextureCompressor::chooseFormat(color, TEXTURE_USAGE_COLOR, COMPRESSION_FAST) == DXGI_FORMAT_BC3_UNORM,
+		"choose", "fast color with alpha isn't BC3");
+	expect(TextureCompressor::chooseFormat(color, TEXTURE_USAGE_COLOR, COMPRESSION_HIGH) == DXGI_FORMAT_BC7_UNORM,
+		"choose", "high color isn't BC7");
+	expect(TextureCompressor::chooseFormat(opaque, TEXTURE_USAGE_NORMAL, COMPRESSION_FAST) == DXGI_FORMAT_BC5_UNORM,
+		"choose", "a normal map isn't BC5");
+	expect(TextureCompressor::chooseFormat(opaque, TEXTURE_USAGE_COLOR, COMPRESSION_NONE) == DXGI_FORMAT_R8G8B8A8_UNORM,
+		"choose", "COMPRESSION_NONE isn't RGBA8");
+	expect(TextureCompressor::chooseFormat(makeColorImage(13, 6, 7), TEXTURE_USAGE_COLOR, COMPRESSION_HIGH) ==
+		DXGI_FORMAT_R8G8B8A8_UNORM, "choose", "a base level of partial blocks isn't RGBA8");
+
+	expect(TextureCompressor::guessUsage("textures/Brick_N.png") == TEXTURE_USAGE_NORMAL, "usage", "_N isn't a normal map");
+	expect(TextureCompressor::guessUsage("C:\\art\\rock_normals.jpg") == TEXTURE_USAGE_NORMAL, "usage",
+		"_normals isn't a normal map");
+	expect(TextureCompressor::guessUsage("textures/metal_nrm") == TEXTURE_USAGE_NORMAL, "usage", "_nrm isn't a normal map");
+	expect(TextureCompressor::guessUsage("textures/banner.png") == TEXTURE_USAGE_COLOR, "usage", "a color map is a normal map");
+	expect(TextureCompressor::guessUsage("textures/_n.png") == TEXTURE_USAGE_COLOR, "usage", "a bare suffix is a normal map");
+	printf("%-36s as documented\n", "format choice");
+}
+
+static void
+runBenchmark(unsigned int size, unsigned int runs, ThreadPool& threadPool) {
+	const Image color = makeColorImage(size, size, 11);
+	const Image opaque = makeOpaque(color);
+	const Image normals = makeNormalImage(size, size);
+	for (const FormatCase& format : kFormats) {
+		const Image& image = imageFor(format, color, opaque, normals);
+		for (CompressionQuality quality : { COMPRESSION_FAST, COMPRESSION_HIGH }) {
+			for (int threaded = 0; threaded < 2; ++threaded) {
+				double best = 0.0;
+				double psnr = 0.0;
+				for (unsigned int run = 0; run < runs; ++run) {
+					std::vector<unsigned char> blocks;
+					auto start = std::chrono::high_resolution_clock::now();
+					TextureCompressor::compress(image, format.format, quality, blocks, nullptr, threaded ? &threadPool : nullptr);
+					const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+					best = run == 0 ? seconds : std::min(best, seconds);
+					if (run == 0) {
+						Image decoded;
+						TextureCompressor::decompress(blocks.data(), format.format, size, size, decoded);
+						psnr = TextureCompressor::computePsnr(image, decoded, format.channelCount);
+					}
+				}
+				printf("%s %-4s %ux%u %-8s %9.2f ms %8.1f MP/s  PSNR %6.2f dB\n", format.name, kQualityNames[quality], size,
+					size, threaded ? "threaded" : "1 thread", best * 1000.0, static_cast<double>(size) * size / best / 1e6, psnr);
+			}
+		}
+	}
+}
+
+int
+main(int argc, char** argv) {
+	unsigned int runs = 3;
+	unsigned int size = 1024;
+	unsigned int threadCount = 0;
+	for (int i = 1; i < argc; ++i) {
+		const std::string option = argv[i];
+		if (option == "-n" && i + 1 < argc) {
+			runs = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else if (option == "-s" && i + 1 < argc) {
+			size = std::max(4u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)) / 4 * 4);
+		}
+		else if (option == "-j" && i + 1 < argc) {
+			threadCount = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else {
+			printf("Usage: OnkosCompressorTest [-n <runs>] [-s <size>] [-j <threads>]\n");
+			printf("  -n <runs>     Runs of every benchmark, the best is reported (default: 3)\n");
+			printf("  -s <size>     Size of the benchmark images, a multiple of 4 (default: 1024)\n");
+			printf("  -j <threads>  Threads of the threaded runs, 0 for one per core (default: 0)\n");
+			return 1;
+		}
+	}
+
+	ThreadPool threadPool;
+	threadPool.init(std::max(2u, ThreadPool::resolveThreadCount(threadCount)) - 1);
+
+	const Image color = makeColorImage(256, 256, 5);
+	const Image opaque = makeOpaque(color);
+	const Image normals = makeNormalImage(256, 256);
+	checkSolidBlocks();
+	checkQuality(color, opaque, normals);
+	checkLayout(color, threadPool);
+	checkFormatChoice(color, opaque);
+	runBenchmark(size, runs, threadPool);
+	threadPool.destroy();
+
+	if (failureCount > 0) {
+		printf("%u checks failed\n", failureCount);
+		return 1;
+	}
+	printf("Every compressor check passed\n");
+	return 0;
+}
@@ -0,0 +1,236 @@
+//--------------------------------------------------------------------------------------
+// File: MeshCacheTest.cpp
+//
+// Loads the same OBJ cold (parsed, optimized and simplified, then written to its .onkmesh)
+// and warm (the .onkmesh mapped in place) and checks that both give the same mesh,
+// that a changed source or other settings rebuild the cache and that a cooked file
+// loads by itself. Then times both loads and reports how much faster the warm one is.
+//
+// Usage: OnkosMeshCacheTest [-n <runs>] [-s <segments>]
+//--------------------------------------------------------------------------------------
+#include "Prerequisites.h"
+#include "MeshCache.h"
+#include "MeshComponent.h"
+#include "ModelLoader.h"
+#include "TestMeshes.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+static unsigned int failureCount = 0;
+
+static void
+expect(bool condition, const char* test, const char* what) {
+	if (!condition) {
+		printf("FAILED %s: %s\n", test, what);
+		++failureCount;
+	}
+}
+
+/**
+ * Writes a mesh as an OBJ with one "p/t/n" corner per vertex.
+ */
+static bool
+writeObj(const fs::path& path, const MeshComponent& mesh) {
+	std::string text;
+	char line[160];
+	for (const SimpleVertex& vertex : mesh.m_vertex) {
+		snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n", vertex.Pos.x, vertex.Pos.y,
+			vertex.Pos.z, vertex.Tex.x, vertex.Tex.y, vertex.Norm.x, vertex.Norm.y, vertex.Norm.z);
+		text += line;
+	}
+	for (size_t i = 0; i + 3 <= mesh.m_index.size(); i += 3) {
+		snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\n", mesh.m_index[i] + 1, mesh.m_index[i] + 1,
+			mesh.m_index[i] + 1, mesh.m_index[i + 1] + 1, mesh.m_index[i + 1] + 1, mesh.m_index[i + 1] + 1,
+			mesh.m_index[i + 2] + 1, mesh.m_index[i + 2] + 1, mesh.m_index[i + 2] + 1);
+		text += line;
+	}
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(text.data(), static_cast<std::streamsize>(text.size()));
+	return file.good();
+}
+
+/**
+ * True if two meshes have the same vertices, indices, submeshes, levels and bounds.
+ */
+static bool
+sameMesh(const MeshComponent& a, const MeshComponent& b) {
+	if (a.getVertexCount() != b.getVertexCount() || a.getIndexCount() != b.getIndexCount() ||
+			a.m_subMeshes.size() != b.m_subMeshes.size() || a.getLodCount() != b.getLodCount() ||
+			a.getIndexFormat() != b.getIndexFormat() ||
+			memcmp(&a.m_boundsMin, &b.m_boundsMin, sizeof(XMFLOAT3)) != 0 ||
+			memcmp(&a.m_boundsMax, &b.m_boundsMax, sizeof(XMFLOAT3)) != 0 ||
+			memcmp(a.getVertexData(), b.getVertexData(), a.getVertexCount() * sizeof(SimpleVertex)) != 0 ||
+			memcmp(a.getIndexData(), b.getIndexData(), a.getIndexCount() * sizeof(unsigned int)) != 0) {
+		return false;
+	}
+	for (size_t i = 0; i < a.m_subMeshes.size(); ++i) {
+		const SubMesh& x = a.m_subMeshes[i];
+		const SubMesh& y = b.m_subMeshes[i];
+		if (x.startIndex != y.startIndex || x.indexCount != y.indexCount || x.baseVertex != y.baseVertex ||
+				x.materialId != y.materialId || x.objectId != y.objectId) {
+			return false;
+		}
+	}
+	for (size_t lod = 0; lod < a.getLodCount(); ++lod) {
+		const MeshLod x = a.getLod(lod);
+		const MeshLod y = b.getLod(lod);
+		if (x.firstSubMesh != y.firstSubMesh || x.subMeshCount != y.subMeshCount || x.error != y.error) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Loads a file and checks whether the cache was used.
+ */
+static bool
+load(ModelLoader& loader, const fs::path& path, MeshComponent& outMesh, bool expectHit, const char* test) {
+	outMesh.destroy();
+	if (!loader.loadModel(path.string(), outMesh)) {
+		expect(false, test, "the load failed");
+		return false;
+	}
+	expect(loader.getLastLoadStats().cacheHit == expectHit, test,
+		expectHit ? "the cache wasn't used" : "a stale cache was used");
+	return true;
+}
+
+static void
+checkCache(const fs::path& directory) {
+	const fs::path objPath = directory / "sphere.obj";
+	const fs::path cachePath = MeshCache::getCachePath(objPath.string());
+	MeshComponent source = makeSphere(48, 96);
+	writeObj(objPath, source);
+	fs::remove(cachePath);
+
+	ModelLoader loader;
+	MeshComponent cold;
+	MeshComponent warm;
+	if (!load(loader, objPath, cold, false, "cold") || !load(loader, objPath, warm, true, "warm")) {
+		return;
+	}
+	expect(fs::exists(cachePath), "cold", "the cache wasn't written");
+	expect(warm.isMapped() && !cold.isMapped(), "warm", "the cache wasn't mapped in place");
+	expect(sameMesh(cold, warm), "warm", "the cached mesh differs from the parsed one");
+	printf("%-32s ok (%zu vertices, %zu levels)\n", "cold and warm give one mesh", cold.getVertexCount(),
+		cold.getLodCount());
+
+	// Other settings give other arrays, the cache is rebuilt for them
+	MeshComponent other;
+	loader.setOptimizeMesh(false);
+	load(loader, objPath, other, false, "other settings");
+	load(loader, objPath, other, true, "other settings, warm");
+	loader.setOptimizeMesh(true);
+	load(loader, objPath, other, false, "settings back");
+	printf("%-32s ok\n", "settings rebuild the cache");
+
+	// One more triangle changes the hash of the source
+	source.m_index.insert(source.m_index.end(), { 0u, 1u, 2u });
+	warm.destroy();
+	writeObj(objPath, source);
+	MeshComponent changed;
+	if (load(loader, objPath, changed, false, "changed source")) {
+		expect(changed.getIndexCount() != cold.getIndexCount() || changed.getVertexCount() != cold.getVertexCount(),
+			"changed source", "the old mesh came back");
+	}
+	MeshComponent changedWarm;
+	load(loader, objPath, changedWarm, true, "changed source, warm");
+	expect(sameMesh(changed, changedWarm), "changed source, warm", "the rebuilt cache differs from the parsed mesh");
+	printf("%-32s ok\n", "a changed source rebuilds");
+
+	// A cooked file is mapped with no source to check
+	MeshComponent cooked;
+	changedWarm.destroy();
+	fs::remove(objPath);
+	if (load(loader, cachePath, cooked, true, "cooked")) {
+		expect(sameMesh(changed, cooked), "cooked", "the cooked mesh differs from the parsed one");
+	}
+	printf("%-32s ok\n", "a cooked file loads alone");
+}
+
+/**
+ * Times the cold load (cache removed first) and the warm load of the same sphere,
+ * with the default settings, best of the runs.
+ */
+static void
+runBenchmark(const fs::path& directory, unsigned int segments, unsigned int runs) {
+	const fs::path objPath = directory / "bench.obj";
+	const fs::path cachePath = MeshCache::getCachePath(objPath.string());
+	writeObj(objPath, makeSphere(segments / 2, segments));
+	const double megabytes = fs::file_size(objPath) / (1024.0 * 1024.0);
+
+	ModelLoader loader;
+	double bestCold = 0.0;
+	double bestWarm = 0.0;
+	double bestHash = 0.0;
+	MeshComponent mesh;
+	for (unsigned int run = 0; run < runs; ++run) {
+		mesh.destroy();
+		fs::remove(cachePath);
+		if (!load(loader, objPath, mesh, false, "benchmark, cold")) {
+			return;
+		}
+		const double cold = loader.getLastLoadStats().parseSeconds;
+		bestCold = run == 0 ? cold : std::min(bestCold, cold);
+
+		// Every warm run maps the file again, the first right after it was written
+		for (int warmRun = 0; warmRun < 3; ++warmRun) {
+			if (!load(loader, objPath, mesh, true, "benchmark, warm")) {
+				return;
+			}
+			const ModelLoadStats& stats = loader.getLastLoadStats();
+			if ((run == 0 && warmRun == 0) || stats.parseSeconds < bestWarm) {
+				bestWarm = stats.parseSeconds;
+				bestHash = stats.hashSeconds;
+			}
+		}
+	}
+	printf("%.1f MB OBJ, %zu vertices, %zu levels, .onkmesh %.1f MB\n", megabytes, mesh.getVertexCount(),
+		mesh.getLodCount(), fs::file_size(cachePath) / (1024.0 * 1024.0));
+	printf("cold load (parse, process)        %10.2f ms\n", bestCold * 1000.0);
+	printf("warm load (hash, map)             %10.2f ms (%.2f ms hashing the OBJ)\n", bestWarm * 1000.0,
+		bestHash * 1000.0);
+	printf("warm load is %.1fx faster\n", bestCold / bestWarm);
+}
+
+int
+main(int argc, char** argv) {
+	unsigned int runs = 3;
+	unsigned int segments = 512;
+	for (int i = 1; i < argc; ++i) {
+		const std::string option = argv[i];
+		if (option == "-n" && i + 1 < argc) {
+			runs = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else if (option == "-s" && i + 1 < argc) {
+			segments = std::max(4u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else {
+			printf("Usage: OnkosMeshCacheTest [-n <runs>] [-s <segments>]\n");
+			printf("  -n <runs>       Runs of the benchmark, the best is reported (default: 3)\n");
+			printf("  -s <segments>   Segments around the benchmark sphere, half as many rings (default: 512)\n");
+			return 1;
+		}
+	}
+
+	const fs::path directory = fs::temp_directory_path() / "OnkosMeshCacheTest";
+	fs::create_directories(directory);
+	checkCache(directory);
+	runBenchmark(directory, segments, runs);
+	std::error_code error;
+	fs::remove_all(directory, error);
+
+	if (failureCount > 0) {
+		printf("%u checks failed\n", failureCount);
+		return 1;
+	}
+	printf("Every mesh cache check passed\n");
+	return 0;
+}
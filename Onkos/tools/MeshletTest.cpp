@@ -0,0 +1,179 @@
+//--------------------------------------------------------------------------------------
+// File: MeshletTest.cpp
+//
+// Checks MeshletBuilder on procedural meshes: every triangle lands in exactly one
+// meshlet, the vertex and triangle limits hold, every vertex is inside the bounding
+// sphere of its meshlet and every face normal is inside its normal cone.
+//
+// Usage: OnkosMeshletTest
+//--------------------------------------------------------------------------------------
+#include "Prerequisites.h"
+#include "MeshletBuilder.h"
+#include "MeshComponent.h"
+#include "MeshOptimizer.h"
+#include "TestMeshes.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <map>
+
+// Slack for the float rounding of the sphere and the cone
+static const float kTolerance = 1e-4f;
+
+static unsigned int failureCount = 0;
+
+static void
+expect(bool condition, const char* mesh, const char* what, size_t meshlet) {
+	if (!condition) {
+		if (failureCount < 20) {
+			printf("FAILED %s: %s (meshlet %zu)\n", mesh, what, meshlet);
+		}
+		++failureCount;
+	}
+}
+
+/**
+ * Builds the meshlets of a mesh and checks them against its triangles.
+ */
+static void
+checkMesh(const char* name, const MeshComponent& mesh) {
+	MeshletData meshlets;
+	MeshletBuilder::build(mesh, meshlets);
+
+	const SimpleVertex* vertices = mesh.getVertexData();
+	const unsigned int* indices = mesh.getIndexData();
+
+	// The triangles of the full level, in vertex array numbering, with how often they appear
+	std::map<std::array<unsigned int, 3>, int> expected;
+	const MeshLod full = mesh.getLod(0);
+	std::vector<SubMesh> ranges(mesh.m_subMeshes.begin() + full.firstSubMesh,
+		mesh.m_subMeshes.begin() + full.firstSubMesh + full.subMeshCount);
+	if (ranges.empty()) {
+		SubMesh whole;
+		whole.indexCount = static_cast<unsigned int>(mesh.getIndexCount());
+		ranges.push_back(whole);
+	}
+	size_t triangleCount = 0;
+	for (const SubMesh& range : ranges) {
+		for (size_t i = range.startIndex; i + 3 <= range.startIndex + range.indexCount; i += 3) {
+			const std::array<unsigned int, 3> triangle = {
+				indices[i] + range.baseVertex, indices[i + 1] + range.baseVertex, indices[i + 2] + range.baseVertex };
+			++expected[triangle];
+			++triangleCount;
+		}
+	}
+
+	size_t coveredCount = 0;
+	for (size_t m = 0; m < meshlets.size(); ++m) {
+		const unsigned int vertexCount = meshlets.vertexCount[m];
+		const unsigned int meshletTriangles = meshlets.triangleCount[m];
+		expect(vertexCount > 0 && vertexCount <= kMeshletMaxVertices, name, "vertex limit", m);
+		expect(meshletTriangles > 0 && meshletTriangles <= kMeshletMaxTriangles, name, "triangle limit", m);
+
+		const unsigned int* local = &meshlets.vertexIndices[meshlets.vertexOffset[m]];
+		const XMFLOAT3 center(meshlets.centerX[m], meshlets.centerY[m], meshlets.centerZ[m]);
+		const float radius = meshlets.radius[m];
+		for (unsigned int v = 0; v < vertexCount; ++v) {
+			const XMFLOAT3& p = vertices[local[v]].Pos;
+			const float dx = p.x - center.x;
+			const float dy = p.y - center.y;
+			const float dz = p.z - center.z;
+			expect(std::sqrt(dx * dx + dy * dy + dz * dz) <= radius * (1.0f + kTolerance) + kTolerance,
+				name, "vertex outside the bounding sphere", m);
+		}
+
+		const XMFLOAT3 axis(meshlets.coneAxisX[m], meshlets.coneAxisY[m], meshlets.coneAxisZ[m]);
+		const float cutoff = meshlets.coneCutoff[m];
+		expect(std::fabs(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z - 1.0f) <= kTolerance,
+			name, "cone axis isn't unit length", m);
+		const float minimumDot = std::sqrt(std::max(0.0f, 1.0f - cutoff * cutoff));
+
+		const unsigned char* corners = &meshlets.triangleIndices[meshlets.triangleOffset[m]];
+		for (unsigned int t = 0; t < meshletTriangles; ++t) {
+			const bool inRange = corners[t * 3] < vertexCount &&
+				corners[t * 3 + 1] < vertexCount &&
+				corners[t * 3 + 2] < vertexCount;
+			expect(inRange, name, "local corner out of range", m);
+			if (!inRange) {
+				continue;
+			}
+			const std::array<unsigned int, 3> triangle = {
+				local[corners[t * 3]], local[corners[t * 3 + 1]], local[corners[t * 3 + 2]] };
+			auto found = expected.find(triangle);
+			expect(found != expected.end() && found->second > 0, name, "triangle not in the mesh or covered twice", m);
+			if (found != expected.end()) {
+				--found->second;
+			}
+			++coveredCount;
+
+			// A cutoff of 1 means the meshlet is never culled, any normal fits
+			if (cutoff >= 1.0f) {
+				continue;
+			}
+			const XMFLOAT3& p0 = vertices[triangle[0]].Pos;
+			const XMFLOAT3& p1 = vertices[triangle[1]].Pos;
+			const XMFLOAT3& p2 = vertices[triangle[2]].Pos;
+			const XMFLOAT3 e1(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z);
+			const XMFLOAT3 e2(p2.x - p0.x, p2.y - p0.y, p2.z - p0.z);
+			const XMFLOAT3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+			const float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+			if (length <= 0.0f) {
+				continue;
+			}
+			const float d = (n.x * axis.x + n.y * axis.y + n.z * axis.z) / length;
+			expect(d >= minimumDot - kTolerance, name, "face normal outside the normal cone", m);
+		}
+	}
+	expect(coveredCount == triangleCount, name, "a triangle isn't in any meshlet", meshlets.size());
+
+	printf("%-28s %7zu triangles %6zu meshlets %6.1f triangles/meshlet\n", name, triangleCount, meshlets.size(),
+		meshlets.size() > 0 ? static_cast<double>(coveredCount) / meshlets.size() : 0.0);
+}
+
+int
+main() {
+	MeshComponent grid = makeGrid(96, 64);
+	checkMesh("grid", grid);
+
+	MeshComponent sphere = makeSphere(48, 96);
+	checkMesh("sphere", sphere);
+	MeshOptimizer::optimizeMesh(sphere);
+	checkMesh("sphere optimized", sphere);
+
+	// Random order fills meshlets by the vertex limit instead of the triangle limit
+	MeshComponent shuffled = makeSphere(32, 64);
+	shuffleTriangles(shuffled.m_index, 7);
+	checkMesh("sphere shuffled", shuffled);
+
+	// Two submeshes, the second with a base vertex, a degenerate and a repeated triangle
+	MeshComponent parts = makeGrid(40, 40);
+	const unsigned int half = static_cast<unsigned int>(parts.m_index.size() / 6 * 3);
+	const int baseVertex = 41;
+	for (size_t i = half; i < parts.m_index.size(); ++i) {
+		parts.m_index[i] -= baseVertex;
+	}
+	const unsigned int extra[9] = { 0, 0, 1, 5, 6, 7, 5, 6, 7 };
+	parts.m_index.insert(parts.m_index.end(), extra, extra + 9);
+	SubMesh first;
+	first.indexCount = half;
+	SubMesh second;
+	second.startIndex = half;
+	second.indexCount = static_cast<unsigned int>(parts.m_index.size()) - half;
+	second.baseVertex = baseVertex;
+	parts.m_subMeshes.push_back(first);
+	parts.m_subMeshes.push_back(second);
+	parts.m_numIndex = static_cast<int>(parts.m_index.size());
+	checkMesh("submeshes", parts);
+
+	MeshComponent split = makeSphere(200, 400);
+	MeshOptimizer::optimizeMesh(split);
+	MeshOptimizer::splitIndex16(split);
+	checkMesh("sphere split to 16 bits", split);
+
+	if (failureCount > 0) {
+		printf("%u checks failed\n", failureCount);
+		return 1;
+	}
+	printf("Every meshlet check passed\n");
+	return 0;
+}
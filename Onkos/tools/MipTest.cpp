@@ -0,0 +1,375 @@
+//--------------------------------------------------------------------------------------
+// File: MipTest.cpp
+//
+// Golden-image tests of MipGenerator, headless: the box and Kaiser chains, in linear
+// and sRGB space, are compared with stored golden levels of a small image and with a
+// double precision reference of the filters on larger images of odd sizes. Known
+// answers (a checker averages to 188 in sRGB), constant images and the threaded path
+// are checked too. Then times full chains of a large image with every filter.
+//
+// Usage: OnkosMipTest [-n <runs>] [-s <size>] [-j <threads>]
+//--------------------------------------------------------------------------------------
+#include "Prerequisites.h"
+#include "MipGenerator.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+static unsigned int failureCount = 0;
+
+static const char* kSettingNames[] = { "box linear", "box sRGB", "Kaiser linear", "Kaiser sRGB" };
+
+static MipSettings
+makeSettings(int index) {
+	MipSettings settings;
+	settings.filter = index < 2 ? MIP_FILTER_BOX : MIP_FILTER_KAISER;
+	settings.srgb = index % 2 == 1;
+	return settings;
+}
+
+static void
+expect(bool condition, const std::string& name, const char* what) {
+	if (!condition) {
+		printf("FAILED %s: %s\n", name.c_str(), what);
+		++failureCount;
+	}
+}
+
+/**
+ * An image with gradients, a XOR pattern and varying alpha.
+ */
+static Image
+makeImage(unsigned int width, unsigned int height) {
+	Image image;
+	image.width = width;
+	image.height = height;
+	image.pixels.resize(static_cast<size_t>(width) * height * 4);
+	for (unsigned int y = 0; y < height; ++y) {
+		for (unsigned int x = 0; x < width; ++x) {
+			unsigned char* texel = &image.pixels[(static_cast<size_t>(y) * width + x) * 4];
+			texel[0] = static_cast<unsigned char>(x * 255 / (width > 1 ? width - 1 : 1));
+			texel[1] = static_cast<unsigned char>(y * 255 / (height > 1 ? height - 1 : 1));
+			texel[2] = static_cast<unsigned char>(((x ^ y) * 37) & 0xFF);
+			texel[3] = static_cast<unsigned char>(255 - ((x + y) * 29) % 200);
+		}
+	}
+	return image;
+}
+
+static int
+maxDifference(const Image& a, const Image& b) {
+	if (a.width != b.width || a.height != b.height || a.pixels.size() != b.pixels.size()) {
+		return 256;
+	}
+	int difference = 0;
+	for (size_t i = 0; i < a.pixels.size(); ++i) {
+		difference = std::max(difference, std::abs(a.pixels[i] - b.pixels[i]));
+	}
+	return difference;
+}
+
+static double
+decodeSrgb(double value) {
+	return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+}
+
+static unsigned char
+encode(double value, bool srgb) {
+	value = std::min(1.0, std::max(0.0, value));
+	if (srgb) {
+		value = value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+	}
+	return static_cast<unsigned char>(value * 255.0 + 0.5);
+}
+
+static double
+bessel0(double x) {
+	double sum = 1.0;
+	double term = 1.0;
+	for (int k = 1; k < 64; ++k) {
+		term *= (x * x * 0.25) / (static_cast<double>(k) * k);
+		sum += term;
+	}
+	return sum;
+}
+
+/**
+ * Kaiser-windowed sinc, 3 texels of radius and alpha 4, as NVTT defines it.
+ */
+static double
+kaiser(double x) {
+	const double width = 3.0;
+	const double t = x / width;
+	if (t * t >= 1.0) {
+		return 0.0;
+	}
+	const double pix = 3.14159265358979323846 * x;
+	const double sinc = std::fabs(pix) < 1e-12 ? 1.0 : std::sin(pix) / pix;
+	return sinc * bessel0(4.0 * std::sqrt(1.0 - t * t)) / bessel0(4.0);
+}
+
+/**
+ * The weights of one axis of the reference Kaiser reduction, per target texel.
+ */
+static std::vector<std::vector<std::pair<unsigned int, double>>>
+kaiserAxis(unsigned int sourceSize, unsigned int targetSize) {
+	std::vector<std::vector<std::pair<unsigned int, double>>> axis(targetSize);
+	const double scale = static_cast<double>(sourceSize) / targetSize;
+	for (unsigned int i = 0; i < targetSize; ++i) {
+		const double center = (i + 0.5) * scale;
+		double sum = 0.0;
+		for (int s = static_cast<int>(std::floor(center - 3.0 * scale)); s <= static_cast<int>(std::ceil(center + 3.0 * scale)); ++s) {
+			const double weight = kaiser((s + 0.5 - center) / scale);
+			if (weight != 0.0) {
+				const int clamped = std::min(std::max(s, 0), static_cast<int>(sourceSize) - 1);
+				axis[i].emplace_back(static_cast<unsigned int>(clamped), weight);
+				sum += weight;
+			}
+		}
+		for (auto& tap : axis[i]) {
+			tap.second /= sum;
+		}
+	}
+	return axis;
+}
+
+/**
+ * A straightforward double precision reduction of one level, the golden reference.
+ */
+static Image
+referenceReduce(const Image& source, const MipSettings& settings) {
+	Image target;
+	target.width = source.width > 1 ? source.width / 2 : 1;
+	target.height = source.height > 1 ? source.height / 2 : 1;
+	target.pixels.resize(static_cast<size_t>(target.width) * target.height * 4);
+
+	auto decode = [&](unsigned int x, unsigned int y, unsigned int c) {
+		const double value = source.pixels[(static_cast<size_t>(y) * source.width + x) * 4 + c] / 255.0;
+		return settings.srgb && c < 3 ? decodeSrgb(value) : value;
+	};
+
+	std::vector<std::vector<std::pair<unsigned int, double>>> horizontal;
+	std::vector<std::vector<std::pair<unsigned int, double>>> vertical;
+	if (settings.filter == MIP_FILTER_KAISER) {
+		horizontal = kaiserAxis(source.width, target.width);
+		vertical = kaiserAxis(source.height, target.height);
+	}
+	else {
+		// 2x2, the last texel of an odd or single-texel axis repeats
+		horizontal.resize(target.width);
+		vertical.resize(target.height);
+		for (unsigned int x = 0; x < target.width; ++x) {
+			horizontal[x] = { { x * 2, 0.5 }, { std::min(x * 2 + 1, source.width - 1), 0.5 } };
+		}
+		for (unsigned int y = 0; y < target.height; ++y) {
+			vertical[y] = { { y * 2, 0.5 }, { std::min(y * 2 + 1, source.height - 1), 0.5 } };
+		}
+	}
+
+	for (unsigned int y = 0; y < target.height; ++y) {
+		for (unsigned int x = 0; x < target.width; ++x) {
+			for (unsigned int c = 0; c < 4; ++c) {
+				double sum = 0.0;
+				for (const auto& row : vertical[y]) {
+					for (const auto& column : horizontal[x]) {
+						sum += decode(column.first, row.first, c) * row.second * column.second;
+					}
+				}
+				target.pixels[(static_cast<size_t>(y) * target.width + x) * 4 + c] = encode(sum, settings.srgb && c < 3);
+			}
+		}
+	}
+	return target;
+}
+
+/**
+ * Every level against the reference reduction of the level above it.
+ */
+static void
+checkReference(const Image& base, ThreadPool* threadPool) {
+	for (int setting = 0; setting < 4; ++setting) {
+		const MipSettings settings = makeSettings(setting);
+		std::vector<Image> mips(1, base);
+		MipGenerator::generate(mips, settings, threadPool);
+		const std::string name = std::string(kSettingNames[setting]) + " " + std::to_string(base.width) + "x" +
+			std::to_string(base.height) + (threadPool ? " threaded" : "");
+		expect(mips.size() == MipGenerator::getMipCount(base.width, base.height), name, "wrong number of levels");
+
+		int worst = 0;
+		for (size_t level = 1; level < mips.size(); ++level) {
+			worst = std::max(worst, maxDifference(mips[level], referenceReduce(mips[level - 1], settings)));
+		}
+		// The filters work in float and round through tables, one step of difference is allowed
+		expect(worst <= 1, name, "a level differs from the reference by more than 1");
+		printf("%-36s %2zu levels  max diff to the reference %d\n", name.c_str(), mips.size(), worst);
+	}
+}
+
+/**
+ * The 2x2 and 1x1 levels of makeImage(4, 4) for every setting. The box values follow by hand
+ * from the (sum + 2) / 4 rule and the sRGB curve, the Kaiser ones are the output of today's filter.
+ */
+static const unsigned char kGolden[4][5][4] = {
+	// box linear
+	{ { 43, 43, 19, 226 }, { 213, 43, 93, 168 }, { 43, 213, 93, 168 }, { 213, 213, 19, 110 }, { 128, 128, 56, 168 } },
+	// box sRGB
+	{ { 60, 60, 24, 226 }, { 218, 60, 95, 168 }, { 60, 218, 95, 168 }, { 218, 218, 24, 110 }, { 164, 164, 70, 168 } },
+	// Kaiser linear
+	{ { 41, 41, 25, 227 }, { 214, 41, 86, 168 }, { 41, 214, 86, 168 }, { 214, 214, 25, 109 }, { 127, 127, 56, 168 } },
+	// Kaiser sRGB
+	{ { 35, 35, 37, 227 }, { 217, 35, 91, 168 }, { 35, 217, 91, 168 }, { 217, 217, 37, 109 }, { 161, 161, 70, 168 } },
+};
+
+static void
+checkGolden() {
+	for (int setting = 0; setting < 4; ++setting) {
+		std::vector<Image> mips(1, makeImage(4, 4));
+		MipGenerator::generate(mips, makeSettings(setting));
+		const std::string name = std::string(kSettingNames[setting]) + " golden 4x4";
+		if (mips.size() != 3) {
+			expect(false, name, "wrong number of levels");
+			continue;
+		}
+		int worst = 0;
+		for (int texel = 0; texel < 5; ++texel) {
+			const unsigned char* value = texel < 4 ? &mips[1].pixels[texel * 4] : &mips[2].pixels[0];
+			for (int c = 0; c < 4; ++c) {
+				worst = std::max(worst, std::abs(value[c] - kGolden[setting][texel][c]));
+			}
+		}
+		expect(worst <= 1, name, "differs from the golden levels");
+		printf("%-36s max diff to the golden levels %d\n", name.c_str(), worst);
+	}
+}
+
+/**
+ * Answers that follow from the definition of the filters.
+ */
+static void
+checkKnownAnswers() {
+	// A black and white checker is 50% linear light: 128 in linear space, 188 in sRGB
+	Image checker;
+	checker.width = 64;
+	checker.height = 64;
+	checker.pixels.resize(64 * 64 * 4);
+	for (unsigned int i = 0; i < 64 * 64; ++i) {
+		const unsigned char value = ((i % 64) + (i / 64)) % 2 ? 255 : 0;
+		checker.pixels[i * 4] = checker.pixels[i * 4 + 1] = checker.pixels[i * 4 + 2] = value;
+		checker.pixels[i * 4 + 3] = 255;
+	}
+	for (int setting = 0; setting < 4; ++setting) {
+		std::vector<Image> mips(1, checker);
+		MipGenerator::generate(mips, makeSettings(setting));
+		const int expected = setting % 2 ? 188 : 128;
+		const int value = mips.back().pixels[0];
+		expect(std::abs(value - expected) <= 1, std::string(kSettingNames[setting]) + " checker", "wrong average");
+		printf("%-36s 1x1 level %d (expected %d)\n", (std::string(kSettingNames[setting]) + " checker").c_str(), value,
+			expected);
+
+		// A constant image stays constant, the weights of every filter add up to one
+		Image flat = makeImage(37, 21);
+		for (size_t i = 0; i < flat.pixels.size(); i += 4) {
+			flat.pixels[i] = 200;
+			flat.pixels[i + 1] = 13;
+			flat.pixels[i + 2] = 77;
+			flat.pixels[i + 3] = 128;
+		}
+		std::vector<Image> flatMips(1, flat);
+		MipGenerator::generate(flatMips, makeSettings(setting));
+		bool constant = true;
+		for (const Image& level : flatMips) {
+			for (size_t i = 0; i < level.pixels.size(); ++i) {
+				constant = constant && std::abs(level.pixels[i] - flat.pixels[i % 4]) <= 1;
+			}
+		}
+		expect(constant, std::string(kSettingNames[setting]) + " constant", "a constant image changed");
+	}
+}
+
+/**
+ * The threaded chain must be byte-identical to the single-threaded one.
+ */
+static void
+checkThreads(ThreadPool& threadPool) {
+	const Image base = makeImage(1024, 600);
+	for (int setting = 0; setting < 4; ++setting) {
+		std::vector<Image> serial(1, base);
+		std::vector<Image> threaded(1, base);
+		MipGenerator::generate(serial, makeSettings(setting));
+		MipGenerator::generate(threaded, makeSettings(setting), &threadPool);
+		bool identical = serial.size() == threaded.size();
+		for (size_t level = 0; identical && level < serial.size(); ++level) {
+			identical = serial[level].pixels == threaded[level].pixels;
+		}
+		expect(identical, std::string(kSettingNames[setting]) + " threads", "the threaded chain differs");
+	}
+	printf("%-36s identical to one thread\n", "threaded chains");
+}
+
+static void
+runBenchmark(unsigned int size, unsigned int runs, ThreadPool& threadPool) {
+	const Image base = makeImage(size, size);
+	for (int setting = 0; setting < 4; ++setting) {
+		for (int threaded = 0; threaded < 2; ++threaded) {
+			double best = 0.0;
+			for (unsigned int run = 0; run < runs; ++run) {
+				std::vector<Image> mips(1, base);
+				auto start = std::chrono::high_resolution_clock::now();
+				MipGenerator::generate(mips, makeSettings(setting), threaded ? &threadPool : nullptr);
+				const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+				best = run == 0 ? seconds : std::min(best, seconds);
+			}
+			printf("%-14s %ux%u chain %-10s %9.2f ms %9.1f MP/s\n", kSettingNames[setting], size, size,
+				threaded ? "threaded" : "1 thread", best * 1000.0, static_cast<double>(size) * size / best / 1e6);
+		}
+	}
+}
+
+int
+main(int argc, char** argv) {
+	unsigned int runs = 3;
+	unsigned int size = 2048;
+	unsigned int threadCount = 0;
+	for (int i = 1; i < argc; ++i) {
+		const std::string option = argv[i];
+		if (option == "-n" && i + 1 < argc) {
+			runs = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else if (option == "-s" && i + 1 < argc) {
+			size = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else if (option == "-j" && i + 1 < argc) {
+			threadCount = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else {
+			printf("Usage: OnkosMipTest [-n <runs>] [-s <size>] [-j <threads>]\n");
+			printf("  -n <runs>     Runs of every benchmark, the best is reported (default: 3)\n");
+			printf("  -s <size>     Size of the benchmark image (default: 2048)\n");
+			printf("  -j <threads>  Threads of the threaded runs, 0 for one per core (default: 0)\n");
+			return 1;
+		}
+	}
+
+	ThreadPool threadPool;
+	threadPool.init(std::max(2u, ThreadPool::resolveThreadCount(threadCount)) - 1);
+
+	checkGolden();
+	checkKnownAnswers();
+	checkReference(makeImage(64, 64), nullptr);
+	checkReference(makeImage(75, 33), nullptr);
+	checkReference(makeImage(1, 19), nullptr);
+	checkReference(makeImage(300, 260), &threadPool);
+	checkThreads(threadPool);
+	runBenchmark(size, runs, threadPool);
+	threadPool.destroy();
+
+	if (failureCount > 0) {
+		printf("%u checks failed\n", failureCount);
+		return 1;
+	}
+	printf("Every mip check passed\n");
+	return 0;
+}
@@ -0,0 +1,597 @@
+//--------------------------------------------------------------------------------------
+// File: ObjFaceTest.cpp
+//
+// Runs ModelLoader over a corpus of small OBJ files that cover every face corner
+// form ("p", "p/t", "p//n", "p/t/n"), negative indices, out-of-range, overflowing and
+// malformed indices, exponents past INT_MAX and corners with missing attributes, and
+// checks the vertices of every triangle. A large file is also parsed on one and on
+// several threads, which must give the same mesh, and a file loaded into a mesh that
+// already has vertices must append the same vertices as when loaded alone. The files
+// the old getline/stringstream parser could read must give the same mesh with it.
+// Then times the parse alone and the whole load of a grid in each corner form, the
+// getline parser on the same grid, and one large file on 1, 2, 4... threads.
+//
+// Usage: OnkosObjFaceTest [-n <runs>] [-s <grid size>] [-t <threads>]
+//--------------------------------------------------------------------------------------
+#include "Prerequisites.h"
+#include "MeshComponent.h"
+#include "ModelLoader.h"
+#include "TestMeshes.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+static unsigned int failureCount = 0;
+
+// Marks an attribute the corner doesn't have
+static const int kNone = -1;
+
+/**
+ * The vertex a triangle corner must have: indices into the attributes of kHeader.
+ */
+struct
+ExpectedCorner {
+	int p;
+	int t;
+	int n;
+};
+
+// Four positions, texture coordinates and normals, all different so a wrong index shows
+static const char* kHeader =
+	"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+	"vt 0.125 0.5\nvt 0.25 0.5\nvt 0.375 0.5\nvt 0.5 0.5\n"
+	"vn 1 0 0\nvn 0 1 0\nvn 0 -1 0\nvn -1 0 0\n";
+
+static const XMFLOAT3 kPositions[] = { {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0} };
+static const XMFLOAT2 kUvs[] = { {0.125f, 0.5f}, {0.25f, 0.5f}, {0.375f, 0.5f}, {0.5f, 0.5f} };
+static const XMFLOAT3 kNormals[] = { {1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {-1, 0, 0} };
+
+static bool
+equal(const XMFLOAT3& a, const XMFLOAT3& b) {
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+static bool
+equal(const XMFLOAT2& a, const XMFLOAT2& b) {
+	return a.x == b.x && a.y == b.y;
+}
+
+static void
+fail(const char* name, const char* what) {
+	printf("FAILED %s: %s\n", name, what);
+	++failureCount;
+}
+
+static bool
+writeFile(const fs::path& path, const std::string& text) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(text.data(), static_cast<std::streamsize>(text.size()));
+	return file.good();
+}
+
+/**
+ * Loads an OBJ text with a fresh loader, without the cache or any processing after the merge.
+ */
+static bool
+loadText(const fs::path& directory, const std::string& text, MeshComponent& outMesh, unsigned int threadCount = 1) {
+	const fs::path path = directory / "case.obj";
+	if (!writeFile(path, text)) {
+		return false;
+	}
+	ModelLoader loader;
+	loader.setThreadCount(threadCount);
+	loader.setUseMeshCache(false);
+	loader.setOptimizeMesh(false);
+	loader.setLodLevelCount(0);
+	return loader.loadModel(path.string(), outMesh);
+}
+
+/**
+ * Loads a case that must succeed and checks every triangle corner against the expected attributes.
+ * Corners without a normal must get a generated one instead, facing along Z for these flat faces.
+ */
+static void
+expectMesh(const fs::path& directory, const char* name, const std::string& faces,
+					 const std::vector<ExpectedCorner>& expected) {
+	MeshComponent mesh;
+	if (!loadText(directory, kHeader + faces, mesh)) {
+		fail(name, "the load failed");
+		return;
+	}
+	const unsigned int* indices = mesh.getIndexData();
+	const SimpleVertex* vertices = mesh.getVertexData();
+	if (mesh.getIndexCount() != expected.size()) {
+		fail(name, "wrong number of triangle corners");
+		return;
+	}
+
+	// Submeshes may reorder the index ranges, this corpus has a single one
+	for (size_t i = 0; i < expected.size(); ++i) {
+		const SimpleVertex& vertex = vertices[indices[i]];
+		const ExpectedCorner& corner = expected[i];
+		if (!equal(vertex.Pos, kPositions[corner.p])) {
+			fail(name, "wrong position");
+			return;
+		}
+		if (!equal(vertex.Tex, corner.t == kNone ? XMFLOAT2(0.0f, 0.0f) : kUvs[corner.t])) {
+			fail(name, "wrong texture coordinate");
+			return;
+		}
+		if (corner.n != kNone ? !equal(vertex.Norm, kNormals[corner.n]) :
+				std::fabs(std::fabs(vertex.Norm.z) - 1.0f) > 1e-4f) {
+			fail(name, "wrong normal");
+			return;
+		}
+	}
+	printf("%-40s ok (%zu triangles)\n", name, expected.size() / 3);
+}
+
+/**
+ * Loads a case that must be rejected.
+ */
+static void
+expectFailure(const fs::path& directory, const char* name, const std::string& faces) {
+	MeshComponent mesh;
+	if (loadText(directory, kHeader + faces, mesh)) {
+		fail(name, "the load succeeded");
+		return;
+	}
+	printf("%-40s ok (rejected)\n", name);
+}
+
+static void
+runCorpus(const fs::path& directory) {
+	// A quad is split as 0,1,2 and 0,2,3
+	expectMesh(directory, "p", "f 1 2 3 4\n",
+		{ {0, kNone, kNone}, {1, kNone, kNone}, {2, kNone, kNone}, {0, kNone, kNone}, {2, kNone, kNone}, {3, kNone, kNone} });
+	expectMesh(directory, "p/t", "f 1/4 2/3 3/2 4/1\n",
+		{ {0, 3, kNone}, {1, 2, kNone}, {2, 1, kNone}, {0, 3, kNone}, {2, 1, kNone}, {3, 0, kNone} });
+	expectMesh(directory, "p//n", "f 1//1 2//2 3//3 4//4\n",
+		{ {0, kNone, 0}, {1, kNone, 1}, {2, kNone, 2}, {0, kNone, 0}, {2, kNone, 2}, {3, kNone, 3} });
+	expectMesh(directory, "p/t/n", "f 1/2/3 2/3/4 3/4/1 4/1/2\n",
+		{ {0, 1, 2}, {1, 2, 3}, {2, 3, 0}, {0, 1, 2}, {2, 3, 0}, {3, 0, 1} });
+	expectMesh(directory, "p/t/n, negative", "f -4/-3/-2 -3/-2/-1 -2/-1/-4 -1/-4/-3\n",
+		{ {0, 1, 2}, {1, 2, 3}, {2, 3, 0}, {0, 1, 2}, {2, 3, 0}, {3, 0, 1} });
+	expectMesh(directory, "p, negative and positive mixed", "f -4 2 -2\n",
+		{ {0, kNone, kNone}, {1, kNone, kNone}, {2, kNone, kNone} });
+	expectMesh(directory, "p/t, explicit plus sign", "f +1/+1 +2/+2 +3/+3\n",
+		{ {0, 0, kNone}, {1, 1, kNone}, {2, 2, kNone} });
+
+	// Relative indices count back from the data read so far, not from the end of the file
+	expectMesh(directory, "negative, before more data", "f -4 -3 -2\nv 9 9 9\nf -5 -3 -2\n",
+		{ {0, kNone, kNone}, {1, kNone, kNone}, {2, kNone, kNone}, {0, kNone, kNone}, {2, kNone, kNone},
+			{3, kNone, kNone} });
+
+	// Without a normal on every corner the whole mesh gets generated normals
+	expectMesh(directory, "one corner without a normal", "f 1//1 2//2 3\n",
+		{ {0, kNone, kNone}, {1, kNone, kNone}, {2, kNone, kNone} });
+	expectMesh(directory, "one corner without a texture coordinate", "f 1/1/1 2//2 3/3/3\n",
+		{ {0, 0, 0}, {1, kNone, 1}, {2, 2, 2} });
+	expectMesh(directory, "tabs, CRLF and leading blanks", " \tf\t1/1/1  2/2/2\t3/3/3 \r\n",
+		{ {0, 0, 0}, {1, 1, 1}, {2, 2, 2} });
+
+	expectFailure(directory, "position out of range", "f 1 2 5\n");
+	expectFailure(directory, "texture coordinate out of range", "f 1/1 2/5 3/1\n");
+	expectFailure(directory, "normal out of range", "f 1//1 2//1 3//5\n");
+	expectFailure(directory, "negative before the start of the file", "f 1 2 -5\n");
+	expectFailure(directory, "zero index", "f 0 1 2\n");
+	expectFailure(directory, "four indices in a corner", "f 1/1/1/1 2/2/2 3/3/3\n");
+	expectFailure(directory, "slash without an index", "f 1/ 2/ 3/\n");
+	expectFailure(directory, "two slashes without a normal", "f 1// 2// 3//\n");
+	expectFailure(directory, "not a number", "f a b c\n");
+	expectFailure(directory, "garbage after an index", "f 1x 2 3\n");
+	expectFailure(directory, "index past INT_MAX", "f 1 2 2147483648\n");
+	expectFailure(directory, "negative index past INT_MAX", "f 1 2 -99999999999999999999\n");
+
+	// A position whose exponents don't fit in an int still parses, to 0 here
+	expectMesh(directory, "exponents past INT_MAX", "v 1e-99999999999 0e99999999999 -0E-2147483648\nf -1 2 3\n",
+		{ {0, kNone, kNone}, {1, kNone, kNone}, {2, kNone, kNone} });
+}
+
+/**
+ * Writes a width x width grid of quads in one of the corner forms.
+ */
+static std::string
+makeGrid(unsigned int width, const char* form) {
+	std::string text;
+	text.reserve(static_cast<size_t>(width + 1) * (width + 1) * 48 + static_cast<size_t>(width) * width * 64);
+	char line[160];
+	const unsigned int rowSize = width + 1;
+	const bool relative = strcmp(form, "-p/-t/-n") == 0;
+	for (unsigned int y = 0; y <= width; ++y) {
+		for (unsigned int x = 0; x <= width; ++x) {
+			snprintf(line, sizeof(line), "v %.4f %.4f %.4f\nvt %.5f %.5f\nvn 0 0 -1\n",
+				x * 0.01f, y * 0.01f, ((x * 7 + y * 13) % 17) * 0.001f, x / static_cast<float>(width), y / static_cast<float>(width));
+			text += line;
+		}
+		if (y == 0) {
+			continue;
+		}
+		// The faces of a row follow its vertices, so relative indices stay small
+		for (unsigned int x = 0; x < width; ++x) {
+			unsigned int corners[4] = { (y - 1) * rowSize + x + 1, (y - 1) * rowSize + x + 2, y * rowSize + x + 2,
+				y * rowSize + x + 1 };
+			text += "f";
+			for (unsigned int corner : corners) {
+				const int value = relative ? static_cast<int>(corner) - static_cast<int>((y + 1) * rowSize) - 1 :
+					static_cast<int>(corner);
+				if (strcmp(form, "p") == 0) {
+					snprintf(line, sizeof(line), " %d", value);
+				}
+				else if (strcmp(form, "p/t") == 0) {
+					snprintf(line, sizeof(line), " %d/%d", value, value);
+				}
+				else if (strcmp(form, "p//n") == 0) {
+					snprintf(line, sizeof(line), " %d//%d", value, value);
+				}
+				else {
+					snprintf(line, sizeof(line), " %d/%d/%d", value, value, value);
+				}
+				text += line;
+			}
+			text += "\n";
+		}
+	}
+	return text;
+}
+
+/**
+ * A file large enough to be split into chunks must give the same mesh on one thread and on several.
+ */
+static void
+checkThreads(const fs::path& directory) {
+	const std::string text = makeGrid(400, "-p/-t/-n");
+	MeshComponent serial;
+	MeshComponent parallel;
+	if (!loadText(directory, text, serial, 1) || !loadText(directory, text, parallel, 4)) {
+		fail("threads", "the load failed");
+		return;
+	}
+	const bool same = serial.getVertexCount() == parallel.getVertexCount() &&
+		serial.getIndexCount() == parallel.getIndexCount() &&
+		memcmp(serial.getVertexData(), parallel.getVertexData(), serial.getVertexCount() * sizeof(SimpleVertex)) == 0 &&
+		memcmp(serial.getIndexData(), parallel.getIndexData(), serial.getIndexCount() * sizeof(unsigned int)) == 0;
+	if (!same) {
+		fail("threads", "one and four threads give different meshes");
+		return;
+	}
+	printf("%-40s ok (%.1f MB, %zu vertices)\n", "relative indices across chunks",
+		text.size() / (1024.0 * 1024.0), serial.getVertexCount());
+}
+
+/**
+ * A file loaded into a mesh that already has vertices must append the same vertices, with
+ * the same generated normals, as when it's loaded alone, and leave the old ones untouched.
+ */
+static void
+checkAppend(const fs::path& directory) {
+	const std::string text = makeGrid(64, "p");
+	MeshComponent alone;
+	MeshComponent appended;
+	if (!loadText(directory, text, alone, 4) ||
+			!loadText(directory, std::string(kHeader) + "f 1//1 2//2 3//3\n", appended, 4)) {
+		fail("append", "the load failed");
+		return;
+	}
+	const std::vector<SimpleVertex> before(appended.getVertexData(), appended.getVertexData() + appended.getVertexCount());
+	const size_t firstIndex = appended.getIndexCount();
+	if (!loadText(directory, text, appended, 4)) {
+		fail("append", "the second load failed");
+		return;
+	}
+	bool same = appended.getVertexCount() == before.size() + alone.getVertexCount() &&
+		appended.getIndexCount() == firstIndex + alone.getIndexCount() &&
+		memcmp(appended.getVertexData(), before.data(), before.size() * sizeof(SimpleVertex)) == 0 &&
+		memcmp(appended.getVertexData() + before.size(), alone.getVertexData(),
+			alone.getVertexCount() * sizeof(SimpleVertex)) == 0;
+	for (size_t i = 0; same && i < alone.getIndexCount(); ++i) {
+		same = appended.getIndexData()[firstIndex + i] == alone.getIndexData()[i] + before.size();
+	}
+	if (!same) {
+		fail("append", "the appended vertices differ from the file loaded alone");
+		return;
+	}
+	printf("%-40s ok (%zu + %zu vertices)\n", "load into a mesh with vertices", before.size(), alone.getVertexCount());
+}
+
+/**
+ * The getline and stringstream parser the loader used before it mapped the file, kept as
+ * the reference: "p/t/n" corners only, triangles and quads, corners welded by their text.
+ */
+static bool
+referenceLoad(const fs::path& path, MeshComponent& outMesh) {
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		return false;
+	}
+	std::vector<XMFLOAT3> positions;
+	std::vector<XMFLOAT2> uvs;
+	std::vector<XMFLOAT3> normals;
+	std::map<std::string, unsigned int> uniqueVertices;
+	std::string line;
+	while (std::getline(file, line)) {
+		std::stringstream streamLine(line);
+		std::string prefix;
+		streamLine >> prefix;
+		if (prefix == "vt") {
+			XMFLOAT2 uv;
+			streamLine >> uv.x >> uv.y;
+			uvs.push_back(uv);
+		}
+		else if (prefix == "vn" || prefix == "v") {
+			XMFLOAT3 value;
+			streamLine >> value.x >> value.y >> value.z;
+			(prefix == "v" ? positions : normals).push_back(value);
+		}
+		else if (prefix == "f") {
+			std::string corner;
+			std::vector<unsigned int> face;
+			while (streamLine >> corner) {
+				auto found = uniqueVertices.find(corner);
+				if (found == uniqueVertices.end()) {
+					std::stringstream cornerStream(corner);
+					std::string index;
+					int attributes[3];
+					for (int& attribute : attributes) {
+						std::getline(cornerStream, index, '/');
+						attribute = std::stoi(index) - 1;
+					}
+					if (attributes[0] < 0 || attributes[0] >= static_cast<int>(positions.size()) ||
+							attributes[1] < 0 || attributes[1] >= static_cast<int>(uvs.size()) ||
+							attributes[2] < 0 || attributes[2] >= static_cast<int>(normals.size())) {
+						return false;
+					}
+					SimpleVertex vertex = {};
+					vertex.Pos = positions[attributes[0]];
+					vertex.Tex = uvs[attributes[1]];
+					vertex.Norm = normals[attributes[2]];
+					found = uniqueVertices.emplace(corner, static_cast<unsigned int>(outMesh.m_vertex.size())).first;
+					outMesh.m_vertex.push_back(vertex);
+				}
+				face.push_back(found->second);
+			}
+			if (face.size() != 3 && face.size() != 4) {
+				return false;
+			}
+			const unsigned int triangles[6] = { face[0], face[1], face[2], face[0], face[2], face[face.size() - 1] };
+			outMesh.m_index.insert(outMesh.m_index.end(), triangles, triangles + (face.size() - 2) * 3);
+		}
+	}
+	outMesh.m_numVertex = static_cast<int>(outMesh.m_vertex.size());
+	outMesh.m_numIndex = static_cast<int>(outMesh.m_index.size());
+	return true;
+}
+
+/**
+ * Random positions, texture coordinates and normals written in every number form the
+ * reference reads (signs, exponents, long mantissas), and triangles that combine them.
+ */
+static std::string
+makeNumberSoup(unsigned int count) {
+	static const char* forms[] = { "%.9g", "%.6f", "%e", "%.3E", "%+.2f", "%.0f", "%.17g", "%.7e" };
+	TestRandom random(99);
+	std::string text;
+	char number[64];
+	for (const char* prefix : { "v", "vt", "vn" }) {
+		for (unsigned int i = 0; i < count; ++i) {
+			text += prefix;
+			for (int c = prefix[1] == 't' ? 2 : 3; c > 0; --c) {
+				// Magnitudes from 1e-30 to 1e30, past the exact powers of ten of the fast path
+				const int scale = static_cast<int>(random.next() % 61) - 30;
+				const double value = (random.nextFloat() * 2.0 - 1.0) * std::pow(10.0, scale);
+				snprintf(number, sizeof(number), forms[random.next() % 8], value);
+				text += ' ';
+				text += number;
+			}
+			text += '\n';
+		}
+	}
+	for (unsigned int i = 0; i < count; ++i) {
+		const unsigned int p = random.next() % count;
+		text += "f";
+		for (unsigned int c = 0; c < 3; ++c) {
+			snprintf(number, sizeof(number), " %u/%u/%u", (p + c) % count + 1, random.next() % count + 1,
+				random.next() % count + 1);
+			text += number;
+		}
+		text += '\n';
+	}
+	return text;
+}
+
+/**
+ * Loads fixtures the old parser could read with both parsers; they must give the same
+ * vertices (bit for bit), the same welding and the same triangles.
+ */
+static void
+checkReference(const fs::path& directory) {
+	const std::pair<const char*, std::string> fixtures[] = {
+		{ "reference, p/t/n quad", std::string(kHeader) + "f 1/2/3 2/3/4 3/4/1 4/1/2\n" },
+		{ "reference, shared corners", std::string(kHeader) + "f 1/1/1 2/2/2 3/3/3\nf 1/1/1 3/3/3 4/4/4\nf 4/1/1 1/1/1 2/2/2\n" },
+		{ "reference, tabs and CRLF", std::string(kHeader) + " \tf\t1/1/1  2/2/2\t3/3/3 \r\nf 1/2/3 3/2/1 4/4/4\r\n" },
+		{ "reference, grid", makeGrid(64, "p/t/n") },
+		{ "reference, number forms", makeNumberSoup(2000) },
+	};
+	const fs::path path = directory / "case.obj";
+	for (const auto& fixture : fixtures) {
+		MeshComponent mapped;
+		MeshComponent reference;
+		if (!loadText(directory, fixture.second, mapped) || !referenceLoad(path, reference)) {
+			fail(fixture.first, "a load failed");
+			continue;
+		}
+		bool same = mapped.getVertexCount() == reference.getVertexCount() &&
+			mapped.getIndexCount() == reference.getIndexCount() &&
+			memcmp(mapped.getIndexData(), reference.getIndexData(), reference.getIndexCount() * sizeof(unsigned int)) == 0;
+		for (size_t i = 0; same && i < reference.getVertexCount(); ++i) {
+			const SimpleVertex& a = mapped.getVertexData()[i];
+			const SimpleVertex& b = reference.getVertexData()[i];
+			same = memcmp(&a.Pos, &b.Pos, sizeof(a.Pos)) == 0 && memcmp(&a.Tex, &b.Tex, sizeof(a.Tex)) == 0 &&
+				memcmp(&a.Norm, &b.Norm, sizeof(a.Norm)) == 0;
+		}
+		if (!same) {
+			fail(fixture.first, "the mapped parser and the getline parser give different meshes");
+			continue;
+		}
+		printf("%-40s ok (%zu vertices, %zu triangles)\n", fixture.first, reference.getVertexCount(),
+			reference.getIndexCount() / 3);
+	}
+}
+
+/**
+ * Times the single-threaded load of the same grid in every corner form, best of the runs.
+ * The parse columns are the scan and the merge alone (ModelLoadStats::scanSeconds and
+ * mergeSeconds); the load columns add the normals, tangents and the rest of the load.
+ * The getline parser reads the "p/t/n" file too, for the speedup of the mapped one.
+ */
+static void
+runBenchmark(const fs::path& directory, unsigned int gridSize, unsigned int runs) {
+	static const char* forms[] = { "p", "p/t", "p//n", "p/t/n", "-p/-t/-n" };
+	printf("%-10s %6s %10s %10s %10s %10s\n", "form", "MB", "parse ms", "parse MB/s", "load ms", "load MB/s");
+	double mappedParse = 0.0;
+	for (const char* form : forms) {
+		const std::string text = makeGrid(gridSize, form);
+		const double megabytes = text.size() / (1024.0 * 1024.0);
+		const fs::path path = directory / "bench.obj";
+		writeFile(path, text);
+		ModelLoader loader;
+		loader.setThreadCount(1);
+		loader.setUseMeshCache(false);
+		loader.setOptimizeMesh(false);
+		loader.setLodLevelCount(0);
+
+		double bestParse = 0.0;
+		double bestLoad = 0.0;
+		for (unsigned int run = 0; run < runs; ++run) {
+			MeshComponent mesh;
+			if (!loader.loadModel(path.string(), mesh)) {
+				fail(form, "the benchmark load failed");
+				return;
+			}
+			const ModelLoadStats& stats = loader.getLastLoadStats();
+			const double parse = stats.scanSeconds + stats.mergeSeconds;
+			bestParse = run == 0 ? parse : std::min(bestParse, parse);
+			bestLoad = run == 0 ? stats.parseSeconds : std::min(bestLoad, stats.parseSeconds);
+		}
+		printf("%-10s %6.1f %10.2f %10.1f %10.2f %10.1f\n", form, megabytes, bestParse * 1000.0, megabytes / bestParse,
+			bestLoad * 1000.0, megabytes / bestLoad);
+
+		if (strcmp(form, "p/t/n") == 0) {
+			mappedParse = bestParse;
+			double bestReference = 0.0;
+			for (unsigned int run = 0; run < runs; ++run) {
+				MeshComponent mesh;
+				auto start = std::chrono::high_resolution_clock::now();
+				if (!referenceLoad(path, mesh)) {
+					fail(form, "the getline parser failed");
+					return;
+				}
+				const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+				bestReference = run == 0 ? seconds : std::min(bestReference, seconds);
+			}
+			printf("%-10s %6.1f %10.2f %10.1f   getline parser, the mapped one parses %.1fx faster\n", "p/t/n",
+				megabytes, bestReference * 1000.0, megabytes / bestReference, bestReference / mappedParse);
+		}
+	}
+}
+
+/**
+ * Loads one large "p/t/n" grid on 1, 2, 4... threads up to maxThreads, best of the runs,
+ * and reports the throughput and the speedup over one thread of the parse and the load.
+ */
+static void
+runThreadSweep(const fs::path& directory, unsigned int gridSize, unsigned int runs, unsigned int maxThreads) {
+	const std::string text = makeGrid(gridSize * 2, "p/t/n");
+	const double megabytes = text.size() / (1024.0 * 1024.0);
+	const fs::path path = directory / "sweep.obj";
+	writeFile(path, text);
+	printf("%.1f MB on up to %u threads\n", megabytes, maxThreads);
+	printf("%-8s %7s %10s %10s %8s %10s %10s %8s\n", "threads", "chunks", "parse ms", "parse MB/s", "speedup",
+		"load ms", "load MB/s", "speedup");
+
+	double serialParse = 0.0;
+	double serialLoad = 0.0;
+	for (unsigned int threads = 1; threads <= maxThreads; threads = threads == maxThreads ? threads + 1 :
+			std::min(threads * 2, maxThreads)) {
+		ModelLoader loader;
+		loader.setThreadCount(threads);
+		loader.setUseMeshCache(false);
+		loader.setOptimizeMesh(false);
+		loader.setLodLevelCount(0);
+		double bestParse = 0.0;
+		double bestLoad = 0.0;
+		unsigned int chunks = 0;
+		for (unsigned int run = 0; run < runs; ++run) {
+			MeshComponent mesh;
+			if (!loader.loadModel(path.string(), mesh)) {
+				fail("thread sweep", "the load failed");
+				return;
+			}
+			const ModelLoadStats& stats = loader.getLastLoadStats();
+			const double parse = stats.scanSeconds + stats.mergeSeconds;
+			bestParse = run == 0 ? parse : std::min(bestParse, parse);
+			bestLoad = run == 0 ? stats.parseSeconds : std::min(bestLoad, stats.parseSeconds);
+			chunks = stats.chunkCount;
+		}
+		if (threads == 1) {
+			serialParse = bestParse;
+			serialLoad = bestLoad;
+		}
+		printf("%-8u %7u %10.2f %10.1f %7.2fx %10.2f %10.1f %7.2fx\n", threads, chunks, bestParse * 1000.0,
+			megabytes / bestParse, serialParse / bestParse, bestLoad * 1000.0, megabytes / bestLoad, serialLoad / bestLoad);
+	}
+}
+
+int
+main(int argc, char** argv) {
+	unsigned int runs = 3;
+	unsigned int gridSize = 512;
+	unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (int i = 1; i < argc; ++i) {
+		const std::string option = argv[i];
+		if (option == "-n" && i + 1 < argc) {
+			runs = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else if (option == "-s" && i + 1 < argc) {
+			gridSize = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else if (option == "-t" && i + 1 < argc) {
+			maxThreads = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else {
+			printf("Usage: OnkosObjFaceTest [-n <runs>] [-s <grid size>] [-t <threads>]\n");
+			printf("  -n <runs>       Runs of every benchmark, the best is reported (default: 3)\n");
+			printf("  -s <grid size>  Quads per side of the benchmark grid, twice that for the thread sweep (default: 512)\n");
+			printf("  -t <threads>    Most threads of the thread sweep (default: the number of cores)\n");
+			return 1;
+		}
+	}
+
+	const fs::path directory = fs::temp_directory_path() / "OnkosObjFaceTest";
+	fs::create_directories(directory);
+	runCorpus(directory);
+	checkThreads(directory);
+	checkAppend(directory);
+	checkReference(directory);
+	runBenchmark(directory, gridSize, runs);
+	runThreadSweep(directory, gridSize, runs, maxThreads);
+	std::error_code error;
+	fs::remove_all(directory, error);
+
+	if (failureCount > 0) {
+		printf("%u checks failed\n", failureCount);
+		return 1;
+	}
+	printf("Every OBJ face check passed\n");
+	return 0;
+}
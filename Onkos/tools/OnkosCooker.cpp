@@ -0,0 +1,644 @@
+//--------------------------------------------------------------------------------------
+// File: OnkosCooker.cpp
+//
+// Offline asset cooker. Converts every OBJ/PNG/JPG found in a directory into the
+// binary forms the engine loads without parsing or decoding:
+//   .obj        -> .onkmesh (welded and optimized arrays, see MeshCache and MeshOptimizer)
+//   .png / .jpg -> .onktex  (BC1/BC3/BC5/BC7 or RGBA8 with a full mip chain, see
+//                            TextureCache, MipGenerator and TextureCompressor)
+//   .mtl        -> .mtl     (copied, the cooked meshes read their materials from it)
+//   .dds/.ktx2  -> copied   (already in GPU layout, checked with TextureContainer)
+//
+// With -atlas the small color textures are also packed into the slices of one
+// texture array (atlas.dds) with the remap of their texture coordinates
+// (atlas.txt), see TexturePacker.
+//
+// With -maxsize the textures larger than the given size are downscaled (Lanczos3)
+// before their mips are built, and with -premultiply the colors of the color
+// textures with alpha are multiplied by it, see ImageProcessor.
+//
+// Assets are cooked in parallel on every core. An output whose stored source
+// hash matches the current source file (and, for textures, the current texture
+// options) is considered up to date and skipped.
+//
+// Usage: OnkosCooker <input dir> <output dir> [-j <threads>] [-f] [-k] [-linear]
+//                    [-c none|fast|high] [-atlas <page size>] [-maxsize <size>] [-premultiply]
+//--------------------------------------------------------------------------------------
+#include "Prerequisites.h"
+#include "ContentHash.h"
+#include "ImageDecoder.h"
+#include "ImageProcessor.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "MeshletBuilder.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MipGenerator.h"
+#include "ModelLoader.h"
+#include "TextureCache.h"
+#include "TextureCompressor.h"
+#include "TextureContainer.h"
+#include "TexturePacker.h"
+#include "ThreadPool.h"
+#include "VertexQuantizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+/**
+ * @enum CookResult
+ * @brief Outcome of cooking a single asset.
+ */
+enum
+CookResult {
+	COOKED = 0,     ///< The output was (re)built.
+	UP_TO_DATE = 1, ///< The output already matched the source and was skipped.
+	FAILED = 2      ///< The source couldn't be read or converted.
+};
+
+/**
+ * @struct MeshReport
+ * @brief GPU efficiency estimates of a mesh, printed before and after optimizing it.
+ */
+struct
+MeshReport {
+	VertexCacheStats cache;
+	VertexFetchStats fetch;
+	OverdrawStats overdraw;
+};
+
+/**
+ * @struct TextureOptions
+ * @brief How the base level of every texture is prepared before its mips are built.
+ */
+struct
+TextureOptions {
+	/** @brief The filter and the color space of the mips. */
+	MipSettings mipSettings;
+
+	/** @brief The block compression preset. */
+	CompressionQuality quality = COMPRESSION_FAST;
+
+	/** @brief Largest side kept; larger textures are downscaled. 0 keeps every size. */
+	unsigned int maxSize = 0;
+
+	/** @brief Multiplies the colors of the color textures with alpha by it. */
+	bool premultiply = false;
+};
+
+/**
+ * @struct CookJob
+ * @brief One source asset and the cooked file it produces.
+ */
+struct
+CookJob {
+	fs::path source;
+	fs::path output;
+	bool isMesh = false;
+	bool isCopy = false;
+	bool isContainer = false;
+	CookResult result = FAILED;
+	double seconds = 0.0;
+	MeshReport before;
+	MeshReport after;
+	QuantizationReport quantization;
+	size_t meshletCount = 0;
+	size_t triangleCount = 0;
+	size_t subMeshCount = 0;
+	size_t materialCount = 0;
+	size_t objectCount = 0;
+	std::vector<size_t> lodTriangles;
+	std::vector<float> lodErrors;
+	unsigned int sourceWidth = 0;
+	unsigned int sourceHeight = 0;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	double resizeSeconds = 0.0;
+	size_t mipCount = 0;
+	double mipSeconds = 0.0;
+	CompressionReport compression;
+	CookedTexture container;
+};
+
+static const char*
+getFormatName(DXGI_FORMAT format) {
+	switch (format) {
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+		return "BC1";
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+		return "BC2";
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+		return "BC3";
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+		return "BC4";
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+		return "BC5";
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC6H_SF16:
+		return "BC6H";
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return "BC7";
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		return "RGBA8";
+	default:
+		return "other";
+	}
+}
+
+static MeshReport
+analyzeMesh(const MeshComponent& mesh) {
+	MeshReport report;
+	const unsigned int* indices = mesh.getIndexData();
+	const size_t indexCount = mesh.getIndexCount();
+	const size_t vertexCount = mesh.getVertexCount();
+	if (indexCount == 0 || vertexCount == 0) {
+		return report;
+	}
+	report.cache = MeshOptimizer::analyzeVertexCache(indices, indexCount, vertexCount);
+	report.fetch = MeshOptimizer::analyzeVertexFetch(indices, indexCount, vertexCount, sizeof(SimpleVertex));
+	report.overdraw = MeshOptimizer::analyzeOverdraw(indices, indexCount,
+		&mesh.getVertexData()[0].Pos.x, sizeof(SimpleVertex), vertexCount);
+	return report;
+}
+
+static CookResult
+cookMesh(CookJob& job, bool force) {
+	MappedFile source;
+	if (!source.init(job.source.string())) {
+		return FAILED;
+	}
+	const uint64_t sourceHash = ContentHash::compute(source.data(), source.size());
+
+	// Cooked meshes are always optimized and get the default levels of detail
+	MeshCacheSettings settings;
+	settings.optimizeMesh = true;
+	settings.lodLevelCount = kLodDefaultLevelCount;
+	MeshCache meshCache;
+	MeshComponent mesh;
+	if (!force && meshCache.load(job.output.string(), sourceHash, settings, mesh)) {
+		return UP_TO_DATE;
+	}
+
+	// Assets are already cooked in parallel, so each one is parsed on a single thread
+	ModelLoader loader;
+	loader.setThreadCount(1);
+	loader.setUseMeshCache(false);
+	loader.setOptimizeMesh(false);
+	loader.setLodLevelCount(0);
+	if (!loader.loadModel(job.source.string(), mesh)) {
+		return FAILED;
+	}
+
+	job.before = analyzeMesh(mesh);
+	if (!MeshOptimizer::optimizeMesh(mesh)) {
+		return FAILED;
+	}
+	job.after = analyzeMesh(mesh);
+
+	// Report only, the cooked file keeps full vertices and the runtime chooses
+	MeshComponent quantized;
+	quantized.m_vertex = mesh.m_vertex;
+	VertexQuantizer::quantize(quantized, &job.quantization);
+
+	MeshletData meshlets;
+	MeshletBuilder::build(mesh, meshlets);
+	job.meshletCount = meshlets.size();
+	job.triangleCount = mesh.getIndexCount() / 3;
+	job.subMeshCount = mesh.m_subMeshes.size();
+	job.materialCount = mesh.m_materials.size();
+	job.objectCount = mesh.m_objectNames.size();
+
+	if (!MeshSimplifier::buildLodChain(mesh, settings.lodLevelCount)) {
+		return FAILED;
+	}
+	for (size_t lod = 0; lod < mesh.getLodCount(); ++lod) {
+		const MeshLod level = mesh.getLod(lod);
+		size_t indexCount = 0;
+		for (unsigned int i = 0; i < level.subMeshCount; ++i) {
+			indexCount += mesh.m_subMeshes[level.firstSubMesh + i].indexCount;
+		}
+		job.lodTriangles.push_back(indexCount / 3);
+		job.lodErrors.push_back(level.error);
+	}
+	MeshOptimizer::splitIndex16(mesh);
+
+	return meshCache.save(job.output.string(), mesh, sourceHash, settings) ? COOKED : FAILED;
+}
+
+/**
+ * Mixes the texture options into the hash of the source file, so an output
+ * cooked with other options doesn't count as up to date.
+ */
+static uint64_t
+hashTextureOptions(const TextureOptions& options, uint64_t sourceHash) {
+	const uint32_t values[] = {
+		static_cast<uint32_t>(options.mipSettings.filter),
+		options.mipSettings.srgb ? 1u : 0u,
+		static_cast<uint32_t>(options.quality),
+		options.maxSize,
+		options.premultiply ? 1u : 0u
+	};
+	return ContentHash::compute(values, sizeof(values), sourceHash);
+}
+
+static CookResult
+cookTexture(CookJob& job, bool force, const TextureOptions& options) {
+	MappedFile source;
+	if (!source.init(job.source.string())) {
+		return FAILED;
+	}
+	const uint64_t sourceHash = hashTextureOptions(options, ContentHash::compute(source.data(), source.size()));
+
+	TextureCache textureCache;
+	CookedTexture existing;
+	if (!force && textureCache.load(job.output.string(), sourceHash, existing)) {
+		return UP_TO_DATE;
+	}
+
+	std::vector<Image> mips(1);
+	if (!ImageDecoder::decodeMemory(source.data(), source.size(), mips[0])) {
+		return FAILED;
+	}
+	// Normal maps are data, their mips aren't filtered as sRGB
+	const TextureUsage usage = TextureCompressor::guessUsage(job.source.string());
+	MipSettings settings = options.mipSettings;
+	settings.srgb = settings.srgb && usage != TEXTURE_USAGE_NORMAL;
+	job.sourceWidth = mips[0].width;
+	job.sourceHeight = mips[0].height;
+
+	// Keeps the aspect ratio, the larger side becomes maxSize
+	if (options.maxSize > 0 && std::max(mips[0].width, mips[0].height) > options.maxSize) {
+		const uint64_t larger = std::max(mips[0].width, mips[0].height);
+		const unsigned int width = std::max(1u, static_cast<unsigned int>((uint64_t(mips[0].width) * options.maxSize + larger / 2) / larger));
+		const unsigned int height = std::max(1u, static_cast<unsigned int>((uint64_t(mips[0].height) * options.maxSize + larger / 2) / larger));
+		ResizeSettings resizeSettings;
+		resizeSettings.srgb = settings.srgb;
+		auto resizeStart = std::chrono::high_resolution_clock::now();
+		Image resized;
+		if (!ImageProcessor::resize(mips[0], resized, width, height, resizeSettings)) {
+			return FAILED;
+		}
+		mips[0] = std::move(resized);
+		job.resizeSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - resizeStart).count();
+	}
+	job.width = mips[0].width;
+	job.height = mips[0].height;
+	if (options.premultiply && usage == TEXTURE_USAGE_COLOR && !ImageProcessor::isOpaque(mips[0])) {
+		ImageProcessor::premultiplyAlpha(mips[0]);
+	}
+
+	auto mipStart = std::chrono::high_resolution_clock::now();
+	MipGenerator::generate(mips, settings);
+	job.mipSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - mipStart).count();
+	job.mipCount = mips.size();
+
+	const CompressionQuality quality = options.quality;
+	const DXGI_FORMAT format = TextureCompressor::chooseFormat(mips[0], usage, quality);
+	if (!TextureCompressor::isBlockFormat(format)) {
+		return textureCache.save(job.output.string(),
+			DXGI_FORMAT_R8G8B8A8_UNORM,
+			TextureCache::describe(mips),
+			sourceHash) ? COOKED : FAILED;
+	}
+
+	std::vector<std::vector<unsigned char>> levels;
+	std::vector<TextureSubresource> subresources;
+	if (!TextureCompressor::compressChain(mips, format, quality, levels, subresources, &job.compression)) {
+		return FAILED;
+	}
+	return textureCache.save(job.output.string(), format, subresources, sourceHash) ? COOKED : FAILED;
+}
+
+static CookResult
+cookCopy(CookJob& job, bool force) {
+	// DDS and KTX2 files are loaded as they are, so a file the engine can't read is an error here
+	if (job.isContainer && !TextureContainer::load(job.source.string(), job.container)) {
+		return FAILED;
+	}
+
+	MappedFile source;
+	if (!source.init(job.source.string())) {
+		return FAILED;
+	}
+
+	MappedFile existing;
+	std::error_code error;
+	if (!force && fs::exists(job.output, error) && existing.init(job.output.string()) &&
+			existing.size() == source.size() &&
+			ContentHash::compute(existing.data(), existing.size()) == ContentHash::compute(source.data(), source.size())) {
+		return UP_TO_DATE;
+	}
+	existing.destroy();
+
+	return fs::copy_file(job.source, job.output, fs::copy_options::overwrite_existing, error) ? COOKED : FAILED;
+}
+
+/**
+ * Packs the color textures no larger than a quarter of a page into atlas.dds
+ * and atlas.txt in the output directory. Always rebuilt, it depends on every texture.
+ */
+static bool
+cookAtlas(const std::vector<CookJob>& jobs,
+					const fs::path& inputDir,
+					const fs::path& outputDir,
+					unsigned int pageSize,
+					const MipSettings& mipSettings,
+					CompressionQuality quality,
+					ThreadPool& threadPool) {
+	auto startTime = std::chrono::high_resolution_clock::now();
+	std::vector<const CookJob*> textures;
+	for (const CookJob& job : jobs) {
+		if (!job.isMesh && !job.isCopy && job.result != FAILED &&
+				TextureCompressor::guessUsage(job.source.string()) == TEXTURE_USAGE_COLOR) {
+			textures.push_back(&job);
+		}
+	}
+	std::vector<Image> decoded(textures.size());
+	threadPool.parallelFor(textures.size(), [&](size_t i) {
+		ImageDecoder::decodeFile(textures[i]->source.string(), decoded[i]);
+	});
+
+	std::vector<const Image*> images;
+	std::vector<std::string> names;
+	for (size_t i = 0; i < textures.size(); ++i) {
+		if (!decoded[i].empty() && std::max(decoded[i].width, decoded[i].height) <= pageSize / 4) {
+			images.push_back(&decoded[i]);
+			names.push_back(fs::relative(textures[i]->source, inputDir).generic_string());
+		}
+	}
+	if (images.empty()) {
+		printf("atlas: no texture is small enough for %ux%u pages\n", pageSize, pageSize);
+		return true;
+	}
+
+	TexturePackerSettings settings;
+	settings.pageWidth = pageSize;
+	settings.pageHeight = pageSize;
+	settings.mipSettings = mipSettings;
+	TextureAtlas atlas;
+	TexturePackerStats stats;
+	if (!TexturePacker::pack(images, settings, atlas, &stats, &threadPool)) {
+		return false;
+	}
+
+	// Every slice shares one format, the one with alpha if any page needs it
+	DXGI_FORMAT format = TextureCompressor::chooseFormat(atlas.pages[0][0], TEXTURE_USAGE_COLOR, quality);
+	for (const std::vector<Image>& page : atlas.pages) {
+		const DXGI_FORMAT pageFormat = TextureCompressor::chooseFormat(page[0], TEXTURE_USAGE_COLOR, quality);
+		if (format == DXGI_FORMAT_BC1_UNORM) {
+			format = pageFormat;
+		}
+	}
+	CookedTexture texture = atlas.describe();
+	std::vector<std::vector<unsigned char>> levels;
+	if (TextureCompressor::isBlockFormat(format)) {
+		texture.format = format;
+		texture.mips.clear();
+		for (const std::vector<Image>& page : atlas.pages) {
+			std::vector<std::vector<unsigned char>> pageLevels;
+			std::vector<TextureSubresource> subresources;
+			if (!TextureCompressor::compressChain(page, format, quality, pageLevels, subresources, nullptr, &threadPool)) {
+				return false;
+			}
+			// The subresources point into the level vectors, which keep their buffers when moved
+			for (std::vector<unsigned char>& level : pageLevels) {
+				levels.push_back(std::move(level));
+			}
+			texture.mips.insert(texture.mips.end(), subresources.begin(), subresources.end());
+		}
+	}
+
+	if (!TextureContainer::saveDds((outputDir / "atlas.dds").string(), texture) ||
+			!TexturePacker::saveLayout((outputDir / "atlas.txt").string(), names, atlas)) {
+		return false;
+	}
+	printf("atlas: %zu/%zu textures in %zu %s pages of %ux%u, %.1f%% covered, packed in %.4fs, copied in %.3fs\n",
+		stats.packedCount, stats.imageCount, stats.pageCount, getFormatName(texture.format), pageSize, pageSize,
+		stats.efficiency * 100.0, stats.packSeconds, stats.copySeconds);
+	printf("       %zu texture bindings -> 1 (%zu slices), %.3fs in total\n",
+		stats.packedCount, stats.pageCount,
+		std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count());
+	return true;
+}
+
+static void
+printUsage() {
+	printf("Usage: OnkosCooker <input dir> <output dir> [-j <threads>] [-f] [-k] [-linear] [options]\n");
+	printf("  -j <threads>  Number of worker threads (default: one per core)\n");
+	printf("  -f            Cook every asset even if its output is up to date\n");
+	printf("  -k            Build the mip chains with the Kaiser filter instead of the box filter\n");
+	printf("  -linear       Filter the texture colors as linear data instead of sRGB\n");
+	printf("  -c <preset>   Texture compression: none, fast (BC1/BC3/BC5, default) or high (BC7/BC5)\n");
+	printf("  -atlas <size> Also pack the color textures up to size/4 into atlas.dds, size x size pages\n");
+	printf("  -maxsize <n>  Downscale the textures whose larger side exceeds n (Lanczos3)\n");
+	printf("  -premultiply  Multiply the colors of the color textures with alpha by it\n");
+}
+
+int
+main(int argc, char** argv) {
+	if (argc < 3) {
+		printUsage();
+		return 1;
+	}
+
+	const fs::path inputDir = argv[1];
+	const fs::path outputDir = argv[2];
+	unsigned int threadCount = 0;
+	bool force = false;
+	TextureOptions textureOptions;
+	MipSettings& mipSettings = textureOptions.mipSettings;
+	CompressionQuality& compression = textureOptions.quality;
+	unsigned int atlasSize = 0;
+
+	for (int i = 3; i < argc; ++i) {
+		const std::string option = argv[i];
+		if (option == "-j" && i + 1 < argc) {
+			threadCount = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (option == "-f") {
+			force = true;
+		}
+		else if (option == "-k") {
+			mipSettings.filter = MIP_FILTER_KAISER;
+		}
+		else if (option == "-linear") {
+			mipSettings.srgb = false;
+		}
+		else if (option == "-c" && i + 1 < argc) {
+			const std::string preset = argv[++i];
+			if (preset == "none") {
+				compression = COMPRESSION_NONE;
+			}
+			else if (preset == "fast") {
+				compression = COMPRESSION_FAST;
+			}
+			else if (preset == "high") {
+				compression = COMPRESSION_HIGH;
+			}
+			else {
+				printUsage();
+				return 1;
+			}
+		}
+		else if (option == "-atlas" && i + 1 < argc) {
+			atlasSize = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+			if (atlasSize < 4) {
+				printUsage();
+				return 1;
+			}
+		}
+		else if (option == "-maxsize" && i + 1 < argc) {
+			textureOptions.maxSize = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+			if (textureOptions.maxSize == 0) {
+				printUsage();
+				return 1;
+			}
+		}
+		else if (option == "-premultiply") {
+			textureOptions.premultiply = true;
+		}
+		else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	std::error_code error;
+	if (!fs::is_directory(inputDir, error)) {
+		printf("Input directory not found: %s\n", inputDir.string().c_str());
+		return 1;
+	}
+
+	// Collect the assets, sorted so the report is stable between runs
+	std::vector<CookJob> jobs;
+	for (const fs::directory_entry& entry : fs::recursive_directory_iterator(inputDir, error)) {
+		if (!entry.is_regular_file()) {
+			continue;
+		}
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(),
+			[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+		CookJob job;
+		job.source = entry.path();
+		if (extension == ".obj") {
+			job.isMesh = true;
+			job.output = outputDir / fs::relative(entry.path(), inputDir).replace_extension(".onkmesh");
+		}
+		else if (extension == ".png" || extension == ".jpg" || extension == ".jpeg") {
+			job.output = outputDir / fs::relative(entry.path(), inputDir).replace_extension(".onktex");
+		}
+		else if (extension == ".mtl") {
+			job.isCopy = true;
+			job.output = outputDir / fs::relative(entry.path(), inputDir);
+		}
+		else if (extension == ".dds" || extension == ".ktx2") {
+			job.isCopy = true;
+			job.isContainer = true;
+			job.output = outputDir / fs::relative(entry.path(), inputDir);
+		}
+		else {
+			continue;
+		}
+		jobs.push_back(job);
+	}
+	std::sort(jobs.begin(), jobs.end(),
+		[](const CookJob& a, const CookJob& b) { return a.source < b.source; });
+
+	for (const CookJob& job : jobs) {
+		fs::create_directories(job.output.parent_path(), error);
+	}
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	ThreadPool threadPool;
+	threadPool.init(ThreadPool::resolveThreadCount(threadCount) - 1);
+	threadPool.parallelFor(jobs.size(), [&](size_t i) {
+		auto jobStart = std::chrono::high_resolution_clock::now();
+		jobs[i].result = jobs[i].isMesh ? cookMesh(jobs[i], force) :
+			(jobs[i].isCopy ? cookCopy(jobs[i], force) : cookTexture(jobs[i], force, textureOptions));
+		jobs[i].seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - jobStart).count();
+	});
+	threadPool.destroy();
+
+	double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+	static const char* resultNames[] = { "cooked", "up to date", "FAILED" };
+	unsigned int counts[3] = {};
+	for (const CookJob& job : jobs) {
+		++counts[job.result];
+		printf("[%-10s] %8.3fs  %s -> %s\n",
+			resultNames[job.result],
+			job.seconds,
+			job.source.string().c_str(),
+			job.output.string().c_str());
+		if (job.isMesh && job.result == COOKED) {
+			printf("              ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+				job.before.cache.acmr, job.after.cache.acmr,
+				job.before.cache.atvr, job.after.cache.atvr);
+			printf("              overfetch %.3f -> %.3f, overdraw %.3f -> %.3f\n",
+				job.before.fetch.overfetch, job.after.fetch.overfetch,
+				job.before.overdraw.overdraw, job.after.overdraw.overdraw);
+			printf("              quantized %zu -> %zu bytes, max error %g (position), %g (UV), %.2f/%.2f deg (normal/tangent)\n",
+				job.quantization.bytesBefore, job.quantization.bytesAfter,
+				job.quantization.maxPositionError, job.quantization.maxTexError,
+				job.quantization.maxNormalError, job.quantization.maxTangentError);
+			printf("              %zu submeshes, %zu materials, %zu objects\n",
+				job.subMeshCount, job.materialCount, job.objectCount);
+			printf("              %zu meshlets, %.1f triangles each\n",
+				job.meshletCount,
+				job.meshletCount > 0 ? static_cast<double>(job.triangleCount) / job.meshletCount : 0.0);
+			printf("              LODs:");
+			for (size_t lod = 0; lod < job.lodTriangles.size(); ++lod) {
+				printf(" %zu tris (error %g)", job.lodTriangles[lod], job.lodErrors[lod]);
+			}
+			printf("\n");
+		}
+		else if (job.isContainer && job.result != FAILED) {
+			const CookedTexture& texture = job.container;
+			printf("              %s %ux%u, %zu mips, %u slices%s\n",
+				getFormatName(texture.format), texture.mips[0].width, texture.mips[0].height,
+				texture.mips.size() / texture.arraySize, texture.arraySize, texture.cubemap ? " (cube)" : "");
+		}
+		else if (!job.isMesh && !job.isCopy && job.result == COOKED) {
+			if (job.width != job.sourceWidth || job.height != job.sourceHeight) {
+				printf("              resized %ux%u -> %ux%u in %.3fs\n",
+					job.sourceWidth, job.sourceHeight, job.width, job.height, job.resizeSeconds);
+			}
+			printf("              %zu mips in %.3fs\n", job.mipCount, job.mipSeconds);
+			if (job.compression.outputBytes > 0) {
+				printf("              %s: %zu -> %zu bytes in %.3fs (%.1f MB/s), PSNR %.2f dB\n",
+					getFormatName(job.compression.format),
+					job.compression.inputBytes, job.compression.outputBytes, job.compression.seconds,
+					job.compression.seconds > 0.0 ? job.compression.inputBytes / job.compression.seconds / 1e6 : 0.0,
+					job.compression.psnr);
+			}
+		}
+	}
+	printf("%zu assets: %u cooked, %u up to date, %u failed in %.3fs (%u threads)\n",
+		jobs.size(), counts[COOKED], counts[UP_TO_DATE], counts[FAILED], elapsed,
+		ThreadPool::resolveThreadCount(threadCount));
+
+	bool atlasCooked = true;
+	if (atlasSize > 0) {
+		threadPool.init(ThreadPool::resolveThreadCount(threadCount) - 1);
+		atlasCooked = cookAtlas(jobs, inputDir, outputDir, atlasSize, mipSettings, compression, threadPool);
+		threadPool.destroy();
+		if (!atlasCooked) {
+			printf("atlas: FAILED\n");
+		}
+	}
+
+	return counts[FAILED] == 0 && atlasCooked ? 0 : 1;
+}
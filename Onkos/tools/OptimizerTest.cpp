@@ -0,0 +1,167 @@
+//--------------------------------------------------------------------------------------
+// File: OptimizerTest.cpp
+//
+// Regression test of MeshOptimizer: shuffles the triangles of a grid and of a sphere,
+// reorders them again and checks that the ACMR and ATVR of a 16 entry FIFO cache come
+// back under fixed limits, that the overdraw pass keeps the ACMR within its threshold,
+// that the fetch order lowers the overfetch and that no pass changes the triangles.
+// Then splits a large sphere into submeshes with 16-bit indices and checks it the same way.
+//
+// Usage: OnkosOptimizerTest
+//--------------------------------------------------------------------------------------
+#include "Prerequisites.h"
+#include "MeshComponent.h"
+#include "MeshOptimizer.h"
+#include "TestMeshes.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
+/**
+ * The limits a shuffled mesh has to reach again once optimized. They sit a little
+ * above what the passes reach today, so a change that loses locality fails.
+ */
+struct
+CacheLimits {
+	float acmr;
+	float atvr;
+	float overfetch;
+};
+
+static unsigned int failureCount = 0;
+
+static void
+expect(bool condition, const char* mesh, const char* what) {
+	if (!condition) {
+		printf("FAILED %s: %s\n", mesh, what);
+		++failureCount;
+	}
+}
+
+/**
+ * The triangles of a list by the positions of their corners, each rotated to start
+ * at its smallest corner and sorted, so two orders of the same triangles compare equal.
+ */
+static std::vector<std::array<float, 9>>
+triangleSet(const MeshComponent& mesh) {
+	std::vector<std::array<float, 9>> triangles;
+	const SimpleVertex* vertices = mesh.getVertexData();
+	const unsigned int* indices = mesh.getIndexData();
+	for (size_t i = 0; i + 3 <= mesh.getIndexCount(); i += 3) {
+		std::array<std::array<float, 3>, 3> corners;
+		for (size_t c = 0; c < 3; ++c) {
+			const XMFLOAT3& p = vertices[indices[i + c]].Pos;
+			corners[c] = { p.x, p.y, p.z };
+		}
+		const size_t first = std::min_element(corners.begin(), corners.end()) - corners.begin();
+		std::array<float, 9> triangle;
+		for (size_t c = 0; c < 3; ++c) {
+			std::copy(corners[(first + c) % 3].begin(), corners[(first + c) % 3].end(), triangle.begin() + c * 3);
+		}
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+static VertexCacheStats
+cacheStats(const MeshComponent& mesh) {
+	return MeshOptimizer::analyzeVertexCache(mesh.m_index.data(), mesh.m_index.size(), mesh.m_vertex.size());
+}
+
+static VertexFetchStats
+fetchStats(const MeshComponent& mesh) {
+	return MeshOptimizer::analyzeVertexFetch(mesh.m_index.data(), mesh.m_index.size(), mesh.m_vertex.size(),
+		sizeof(SimpleVertex));
+}
+
+static void
+checkMesh(const char* name, MeshComponent mesh, const CacheLimits& limits) {
+	shuffleTriangles(mesh.m_index, 1234);
+	const std::vector<std::array<float, 9>> triangles = triangleSet(mesh);
+	const VertexCacheStats shuffled = cacheStats(mesh);
+	const VertexFetchStats shuffledFetch = fetchStats(mesh);
+
+	// Vertex cache order alone
+	MeshComponent cacheOnly = mesh;
+	expect(MeshOptimizer::optimizeVertexCache(cacheOnly.m_index.data(), cacheOnly.m_index.size(), cacheOnly.m_vertex.size()),
+		name, "optimizeVertexCache failed");
+	const VertexCacheStats cache = cacheStats(cacheOnly);
+	expect(triangleSet(cacheOnly) == triangles, name, "optimizeVertexCache changed the triangles");
+	expect(cache.acmr <= limits.acmr, name, "ACMR above the limit after optimizeVertexCache");
+	expect(cache.atvr <= limits.atvr, name, "ATVR above the limit after optimizeVertexCache");
+
+	// Every pass, the overdraw order may give back up to its threshold of ACMR
+	expect(MeshOptimizer::optimizeMesh(mesh), name, "optimizeMesh failed");
+	const VertexCacheStats optimized = cacheStats(mesh);
+	const VertexFetchStats optimizedFetch = fetchStats(mesh);
+	expect(triangleSet(mesh) == triangles, name, "optimizeMesh changed the triangles");
+	expect(optimized.acmr <= cache.acmr * kOverdrawThreshold + 1e-4f, name, "the overdraw order exceeds its ACMR threshold");
+	expect(optimizedFetch.overfetch <= limits.overfetch, name, "overfetch above the limit after optimizeMesh");
+
+	printf("%-8s %6zu triangles  ACMR %.3f -> %.3f -> %.3f (limit %.3f)  ATVR %.3f -> %.3f (limit %.3f)  "
+		"overfetch %.2f -> %.2f (limit %.2f)\n", name, mesh.m_index.size() / 3, shuffled.acmr, cache.acmr, optimized.acmr,
+		limits.acmr, shuffled.atvr, cache.atvr, limits.atvr, shuffledFetch.overfetch, optimizedFetch.overfetch,
+		limits.overfetch);
+}
+
+/**
+ * Splits a sphere too large for 16-bit indices whose first submesh ends with a stray index,
+ * so the second one starts off a multiple of 3. Every split submesh must hold whole
+ * triangles with indices below 65536 and, with its base vertex, the same triangles.
+ */
+static void
+checkSplit() {
+	const char* name = "split";
+	MeshComponent mesh = makeSphere(200, 400);
+	MeshOptimizer::optimizeMesh(mesh);
+	const std::vector<std::array<float, 9>> triangles = triangleSet(mesh);
+	const size_t vertexCount = mesh.m_vertex.size();
+
+	// The first submesh is large enough to be cut too
+	const unsigned int cut = static_cast<unsigned int>(mesh.m_index.size() / 18 * 15);
+	mesh.m_index.insert(mesh.m_index.begin() + cut, 0u);
+	mesh.m_numIndex = static_cast<int>(mesh.m_index.size());
+	SubMesh first;
+	first.indexCount = cut + 1;
+	SubMesh second;
+	second.startIndex = cut + 1;
+	second.indexCount = static_cast<unsigned int>(mesh.m_index.size()) - second.startIndex;
+	mesh.m_subMeshes = { first, second };
+
+	expect(mesh.getIndexFormat() == DXGI_FORMAT_R32_UINT, name, "a mesh that needs 32-bit indices reports 16 bits");
+	MeshOptimizer::splitIndex16(mesh);
+	expect(mesh.m_indexFormat == DXGI_FORMAT_R16_UINT && mesh.getIndexFormat() == DXGI_FORMAT_R16_UINT, name,
+		"the split didn't record the 16-bit index format");
+	MeshComponent flat;
+	flat.m_vertex = mesh.m_vertex;
+	bool wholeTriangles = true;
+	bool index16 = true;
+	for (const SubMesh& subMesh : mesh.m_subMeshes) {
+		wholeTriangles = wholeTriangles && subMesh.indexCount % 3 == 0;
+		for (unsigned int i = subMesh.startIndex; i < subMesh.startIndex + subMesh.indexCount; ++i) {
+			index16 = index16 && mesh.m_index[i] < kMaxIndex16Vertices;
+			flat.m_index.push_back(mesh.m_index[i] + subMesh.baseVertex);
+		}
+	}
+	expect(mesh.m_subMeshes.size() > 2, name, "the mesh wasn't split");
+	expect(wholeTriangles, name, "a submesh doesn't hold whole triangles");
+	expect(index16, name, "an index doesn't fit in 16 bits");
+	expect(triangleSet(flat) == triangles, name, "splitIndex16 changed the triangles");
+	printf("%-8s %6zu triangles  %zu submeshes  %zu -> %zu vertices\n", name, triangles.size(), mesh.m_subMeshes.size(),
+		vertexCount, mesh.m_vertex.size());
+}
+
+int
+main() {
+	checkMesh("grid", makeGrid(128, 128), CacheLimits{ 0.70f, 1.38f, 1.85f });
+	checkMesh("sphere", makeSphere(96, 192), CacheLimits{ 0.70f, 1.38f, 1.75f });
+	checkSplit();
+
+	if (failureCount > 0) {
+		printf("%u checks failed\n", failureCount);
+		return 1;
+	}
+	printf("Every optimizer check passed\n");
+	return 0;
+}
@@ -0,0 +1,417 @@
+//--------------------------------------------------------------------------------------
+// File: PackerTest.cpp
+//
+// Checks SkylinePacker and TexturePacker, headless: placements stay in the area and
+// never overlap, a set that tiles the area exactly fills it, and in an atlas every
+// cell keeps its gutter, at every level the image and its repeated edge texels are
+// where the entry says, the UV remap matches and the threaded copy gives the same
+// pages. Then packs a fixed set of rectangles (the same seed every run) with the
+// skyline alone and with TexturePacker, and reports the coverage and the times.
+//
+// Usage: OnkosPackerTest [-n <runs>] [-s <page size>] [-c <rectangles>]
+//--------------------------------------------------------------------------------------
+#include "Prerequisites.h"
+#include "TexturePacker.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static unsigned int failureCount = 0;
+
+static void
+expect(bool condition, const char* test, const char* what) {
+	if (!condition) {
+		printf("FAILED %s: %s\n", test, what);
+		++failureCount;
+	}
+}
+
+/**
+ * The same sizes on every platform and every run.
+ */
+struct
+PackerRandom {
+	uint32_t state;
+
+	explicit PackerRandom(uint32_t seed) : state(seed) {}
+
+	uint32_t
+	next() {
+		state = state * 1664525u + 1013904223u;
+		return state >> 8;
+	}
+
+	/** Skewed towards minimum, like the textures of a scene: many small, few large. */
+	unsigned int
+	nextSize(unsigned int minimum, unsigned int maximum) {
+		const double t = (next() & 0xFFFF) / 65536.0;
+		return minimum + static_cast<unsigned int>(t * t * (maximum - minimum + 1));
+	}
+};
+
+/**
+ * A placed rectangle: [x, x + width) x [y, y + height) in a page.
+ */
+struct
+Placement {
+	unsigned int slice;
+	unsigned int x;
+	unsigned int y;
+	unsigned int width;
+	unsigned int height;
+};
+
+static bool
+overlaps(const Placement& a, const Placement& b) {
+	return a.slice == b.slice && a.x < b.x + b.width && b.x < a.x + a.width &&
+		a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+/**
+ * Checks that every placement is inside the page and that no two overlap.
+ */
+static void
+checkPlacements(const std::vector<Placement>& placements,
+								unsigned int pageWidth,
+								unsigned int pageHeight,
+								const char* test) {
+	bool inside = true;
+	bool disjoint = true;
+	for (size_t i = 0; i < placements.size(); ++i) {
+		const Placement& a = placements[i];
+		inside = inside && a.x + a.width <= pageWidth && a.y + a.height <= pageHeight;
+		for (size_t j = i + 1; j < placements.size() && disjoint; ++j) {
+			disjoint = !overlaps(a, placements[j]);
+		}
+	}
+	expect(inside, test, "a placement leaves the page");
+	expect(disjoint, test, "two placements overlap");
+}
+
+/**
+ * An image no other image of the set has: its index in blue and alpha, its
+ * texel coordinates in red and green.
+ */
+static Image
+makeImage(unsigned int width, unsigned int height, unsigned int index) {
+	Image image;
+	image.width = width;
+	image.height = height;
+	image.pixels.resize(static_cast<size_t>(width) * height * 4);
+	for (unsigned int y = 0; y < height; ++y) {
+		for (unsigned int x = 0; x < width; ++x) {
+			unsigned char* texel = &image.pixels[(static_cast<size_t>(y) * width + x) * 4];
+			texel[0] = static_cast<unsigned char>(x * 255 / (width > 1 ? width - 1 : 1));
+			texel[1] = static_cast<unsigned char>(y * 255 / (height > 1 ? height - 1 : 1));
+			texel[2] = static_cast<unsigned char>(index & 0xFF);
+			texel[3] = static_cast<unsigned char>(128 + (index >> 8) % 128);
+		}
+	}
+	return image;
+}
+
+/**
+ * The gutter TexturePacker keeps, the padding rounded up to the alignment of the levels.
+ */
+static unsigned int
+getGutter(const TexturePackerSettings& settings, unsigned int& outAlignment) {
+	const unsigned int mipCount = std::max(1u,
+		std::min(settings.mipCount, MipGenerator::getMipCount(settings.pageWidth, settings.pageHeight)));
+	outAlignment = 1u << (mipCount - 1);
+	return (settings.padding + outAlignment - 1) / outAlignment * outAlignment;
+}
+
+/**
+ * Checks an atlas against its images: the cells (image and gutter) are aligned,
+ * inside the page and disjoint, the UV remap matches the texels and at every level
+ * the image and its gutter of repeated edge texels are in the page.
+ */
+static void
+checkAtlas(const std::vector<Image>& images,
+					 const TexturePackerSettings& settings,
+					 const TextureAtlas& atlas,
+					 const char* test) {
+	unsigned int alignment = 1;
+	const unsigned int gutter = getGutter(settings, alignment);
+	std::vector<Placement> cells;
+	bool aligned = true;
+	bool remapped = true;
+	for (const PackedTexture& entry : atlas.entries) {
+		if (!entry.packed) {
+			continue;
+		}
+		aligned = aligned && entry.x >= gutter && entry.y >= gutter &&
+			(entry.x - gutter) % alignment == 0 && (entry.y - gutter) % alignment == 0;
+		remapped = remapped && entry.slice < atlas.pages.size() &&
+			entry.uvOffset[0] == static_cast<float>(entry.x) / settings.pageWidth &&
+			entry.uvOffset[1] == static_cast<float>(entry.y) / settings.pageHeight &&
+			entry.uvScale[0] == static_cast<float>(entry.width) / settings.pageWidth &&
+			entry.uvScale[1] == static_cast<float>(entry.height) / settings.pageHeight;
+		cells.push_back({ entry.slice, entry.x - std::min(entry.x, gutter), entry.y - std::min(entry.y, gutter),
+			entry.width + 2 * gutter, entry.height + 2 * gutter });
+	}
+	expect(aligned, test, "a cell isn't aligned to the levels");
+	expect(remapped, test, "the UV remap doesn't match the texels");
+	checkPlacements(cells, settings.pageWidth, settings.pageHeight, test);
+	if (!aligned || !remapped) {
+		return;
+	}
+
+	// Every texel of the image or its gutter, clamped to the page, repeats the nearest texel of the image
+	bool kept = true;
+	for (size_t index = 0; index < images.size() && kept; ++index) {
+		const PackedTexture& entry = atlas.entries[index];
+		if (!entry.packed) {
+			continue;
+		}
+		const std::vector<Image>& page = atlas.pages[entry.slice];
+		Image reduced[2];
+		const Image* level = &images[index];
+		for (unsigned int mip = 0; mip < page.size() && kept; ++mip) {
+			if (mip > 0) {
+				MipGenerator::reduce(*level, reduced[mip & 1], settings.mipSettings);
+				level = &reduced[mip & 1];
+			}
+			const int x = static_cast<int>(entry.x >> mip);
+			const int y = static_cast<int>(entry.y >> mip);
+			const int levelGutter = static_cast<int>(gutter >> mip);
+			kept = kept && (gutter == 0 || levelGutter > 0);
+			const int endX = std::min(static_cast<int>(page[mip].width), x + static_cast<int>(level->width) + levelGutter);
+			const int endY = std::min(static_cast<int>(page[mip].height), y + static_cast<int>(level->height) + levelGutter);
+			for (int row = std::max(0, y - levelGutter); row < endY && kept; ++row) {
+				const int sourceRow = std::min(std::max(row - y, 0), static_cast<int>(level->height) - 1);
+				for (int column = std::max(0, x - levelGutter); column < endX && kept; ++column) {
+					const int sourceColumn = std::min(std::max(column - x, 0), static_cast<int>(level->width) - 1);
+					kept = memcmp(&page[mip].pixels[(static_cast<size_t>(row) * page[mip].width + column) * 4],
+						&level->pixels[(static_cast<size_t>(sourceRow) * level->width + sourceColumn) * 4], 4) == 0;
+				}
+			}
+		}
+	}
+	expect(kept, test, "an image or its gutter was overwritten or misplaced");
+}
+
+static void
+checkSkyline() {
+	SkylinePacker packer;
+	packer.init(64, 64);
+	unsigned int x = 0;
+	unsigned int y = 0;
+	expect(!packer.insert(0, 8, x, y) && !packer.insert(65, 8, x, y) && !packer.insert(8, 65, x, y),
+		"skyline", "an empty or oversized rectangle was placed");
+
+	// Sixteen 16x16 squares tile the area exactly, a seventeenth doesn't fit
+	std::vector<Placement> placements;
+	bool placed = true;
+	for (unsigned int i = 0; i < 16; ++i) {
+		placed = placed && packer.insert(16, 16, x, y);
+		placements.push_back({ 0, x, y, 16, 16 });
+	}
+	expect(placed, "skyline, tiling", "a square of the tiling wasn't placed");
+	expect(!packer.insert(1, 1, x, y), "skyline, tiling", "a rectangle was placed in a full area");
+	expect(packer.getUsedArea() == 64 * 64, "skyline, tiling", "the used area isn't the whole area");
+	checkPlacements(placements, 64, 64, "skyline, tiling");
+
+	// Mixed sizes, the used area is the sum of the placed ones
+	packer.init(256, 256);
+	placements.clear();
+	PackerRandom random(7);
+	uint64_t area = 0;
+	for (unsigned int i = 0; i < 400; ++i) {
+		const unsigned int width = random.nextSize(1, 60);
+		const unsigned int height = random.nextSize(1, 60);
+		if (packer.insert(width, height, x, y)) {
+			placements.push_back({ 0, x, y, width, height });
+			area += static_cast<uint64_t>(width) * height;
+		}
+	}
+	expect(packer.getUsedArea() == area, "skyline, mixed", "the used area isn't the sum of the placements");
+	checkPlacements(placements, 256, 256, "skyline, mixed");
+	printf("%-32s ok (%zu/400 placed, %.1f%% covered)\n", "skyline", placements.size(),
+		100.0 * area / (256.0 * 256.0));
+}
+
+static void
+checkTexturePacker(ThreadPool& threadPool) {
+	// Odd sizes, a 1x1 image, one image too large for a page and sizes that
+	// spill into a second page
+	std::vector<Image> images;
+	PackerRandom random(11);
+	images.push_back(makeImage(1, 1, 0));
+	images.push_back(makeImage(300, 16, 1));
+	for (unsigned int i = 2; i < 48; ++i) {
+		images.push_back(makeImage(random.nextSize(3, 61), random.nextSize(3, 61), i));
+	}
+	std::vector<const Image*> pointers;
+	for (const Image& image : images) {
+		pointers.push_back(&image);
+	}
+
+	TexturePackerSettings settings;
+	settings.pageWidth = 256;
+	settings.pageHeight = 256;
+	settings.padding = 3;
+	settings.mipCount = 4;
+	TextureAtlas atlas;
+	TexturePackerStats stats;
+	if (!TexturePacker::pack(pointers, settings, atlas, &stats)) {
+		expect(false, "atlas", "the pack failed");
+		return;
+	}
+	expect(!atlas.entries[1].packed, "atlas", "an image larger than a page was packed");
+	expect(stats.packedCount == images.size() - 1, "atlas", "an image that fits wasn't packed");
+	expect(stats.pageCount > 1, "atlas", "the images didn't spill into a second page");
+	checkAtlas(images, settings, atlas, "atlas");
+	const size_t pageCount = stats.pageCount;
+
+	// The threaded copy writes the same pages
+	TextureAtlas threaded;
+	TexturePacker::pack(pointers, settings, threaded, nullptr, &threadPool);
+	bool same = threaded.pages.size() == atlas.pages.size();
+	for (size_t slice = 0; slice < atlas.pages.size() && same; ++slice) {
+		for (size_t mip = 0; mip < atlas.pages[slice].size() && same; ++mip) {
+			same = threaded.pages[slice][mip].pixels == atlas.pages[slice][mip].pixels;
+		}
+	}
+	expect(same, "atlas, threaded", "the threaded pages differ");
+
+	// Without a gutter nor levels the images sit edge to edge, still apart
+	settings.padding = 0;
+	settings.mipCount = 1;
+	TexturePacker::pack(pointers, settings, atlas);
+	checkAtlas(images, settings, atlas, "atlas, no gutter");
+	printf("%-32s ok (%zu images in %zu pages)\n", "atlas", stats.packedCount, pageCount);
+}
+
+/**
+ * Packs the same rectangles every run, first with the skyline alone over as
+ * many pages as it takes, then as images with TexturePacker, best of the runs.
+ */
+static void
+runBenchmark(unsigned int pageSize, unsigned int count, unsigned int runs, ThreadPool& threadPool) {
+	std::vector<Image> images;
+	std::vector<const Image*> pointers;
+	PackerRandom random(1234);
+	const unsigned int largest = std::max(4u, pageSize / 4);
+	for (unsigned int i = 0; i < count; ++i) {
+		images.push_back(makeImage(random.nextSize(4, largest), random.nextSize(4, largest), i));
+	}
+	for (const Image& image : images) {
+		pointers.push_back(&image);
+	}
+
+	// Skyline alone, first fit over the open pages in the order TexturePacker uses
+	std::vector<size_t> order(images.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		if (images[a].height != images[b].height) {
+			return images[a].height > images[b].height;
+		}
+		return images[a].width > images[b].width;
+	});
+	double bestSkyline = 0.0;
+	std::vector<Placement> placements;
+	std::vector<SkylinePacker> packers;
+	for (unsigned int run = 0; run < runs; ++run) {
+		placements.clear();
+		packers.clear();
+		auto start = std::chrono::high_resolution_clock::now();
+		for (size_t index : order) {
+			unsigned int x = 0;
+			unsigned int y = 0;
+			size_t slice = 0;
+			while (slice < packers.size() && !packers[slice].insert(images[index].width, images[index].height, x, y)) {
+				++slice;
+			}
+			if (slice == packers.size()) {
+				packers.emplace_back();
+				packers.back().init(pageSize, pageSize);
+				packers.back().insert(images[index].width, images[index].height, x, y);
+			}
+			placements.push_back({ static_cast<unsigned int>(slice), x, y, images[index].width, images[index].height });
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		bestSkyline = run == 0 ? seconds : std::min(bestSkyline, seconds);
+	}
+	checkPlacements(placements, pageSize, pageSize, "benchmark, skyline");
+	uint64_t usedArea = 0;
+	for (const SkylinePacker& packer : packers) {
+		usedArea += packer.getUsedArea();
+	}
+
+	// TexturePacker, gutters and levels included
+	TexturePackerSettings settings;
+	settings.pageWidth = pageSize;
+	settings.pageHeight = pageSize;
+	settings.maxPages = count;
+	TextureAtlas atlas;
+	TexturePackerStats best;
+	for (unsigned int run = 0; run < runs; ++run) {
+		TexturePackerStats stats;
+		if (!TexturePacker::pack(pointers, settings, atlas, &stats, &threadPool)) {
+			expect(false, "benchmark, atlas", "the pack failed");
+			return;
+		}
+		if (run == 0 || stats.packSeconds + stats.copySeconds < best.packSeconds + best.copySeconds) {
+			best = stats;
+		}
+	}
+	checkAtlas(images, settings, atlas, "benchmark, atlas");
+	expect(best.packedCount == count, "benchmark, atlas", "a rectangle wasn't packed");
+
+	printf("%u rectangles from 4x4 to %ux%u, %ux%u pages\n", count, largest, largest, pageSize, pageSize);
+	printf("skyline alone                     %10.3f ms, %zu pages, %.1f%% covered, %.0f rectangles/ms\n",
+		bestSkyline * 1000.0, packers.size(), 100.0 * usedArea / (static_cast<double>(pageSize) * pageSize * packers.size()),
+		count / (bestSkyline * 1000.0));
+	unsigned int alignment = 1;
+	printf("atlas, gutter %u, %u levels       %10.3f ms placing, %.3f ms copying, %zu pages, %.1f%% covered\n",
+		getGutter(settings, alignment), settings.mipCount, best.packSeconds * 1000.0, best.copySeconds * 1000.0, best.pageCount,
+		best.efficiency * 100.0);
+}
+
+int
+main(int argc, char** argv) {
+	unsigned int runs = 3;
+	unsigned int pageSize = 2048;
+	unsigned int count = 1000;
+	for (int i = 1; i < argc; ++i) {
+		const std::string option = argv[i];
+		if (option == "-n" && i + 1 < argc) {
+			runs = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else if (option == "-s" && i + 1 < argc) {
+			pageSize = std::max(64u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else if (option == "-c" && i + 1 < argc) {
+			count = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else {
+			printf("Usage: OnkosPackerTest [-n <runs>] [-s <page size>] [-c <rectangles>]\n");
+			printf("  -n <runs>        Runs of every benchmark, the best is reported (default: 3)\n");
+			printf("  -s <page size>   Width and height of the benchmark pages (default: 2048)\n");
+			printf("  -c <rectangles>  Rectangles of the benchmark, up to a quarter page (default: 1000)\n");
+			return 1;
+		}
+	}
+
+	ThreadPool threadPool;
+	threadPool.init(std::max(2u, ThreadPool::resolveThreadCount(0)) - 1);
+
+	checkSkyline();
+	checkTexturePacker(threadPool);
+	runBenchmark(pageSize, count, runs, threadPool);
+	threadPool.destroy();
+
+	if (failureCount > 0) {
+		printf("%u checks failed\n", failureCount);
+		return 1;
+	}
+	printf("Every packer check passed\n");
+	return 0;
+}
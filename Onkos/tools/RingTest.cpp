@@ -0,0 +1,241 @@
+//--------------------------------------------------------------------------------------
+// File: RingTest.cpp
+//
+// Checks RingAllocator against a mock GPU that finishes every frame a few frames after
+// it was submitted, the way ConstantBufferRing uses it: no live range ever overlaps
+// another, every range is aligned and inside the ring, a full ring is reported and
+// refilled once frames retire, and nothing leaks once the GPU is idle. Then times
+// allocate() for a stream of constant blocks.
+//
+// Usage: OnkosRingTest [-n <runs>]
+//--------------------------------------------------------------------------------------
+#include "Prerequisites.h"
+#include "RingAllocator.h"
+#include "TestMeshes.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+static unsigned int failureCount = 0;
+
+static void
+expect(bool condition, const std::string& test, const char* what) {
+	if (!condition) {
+		printf("FAILED %s: %s\n", test.c_str(), what);
+		++failureCount;
+	}
+}
+
+/**
+ * A range handed out by the ring, with the fence of the frame that used it (0 while
+ * the frame is being recorded).
+ */
+struct
+LiveRange {
+	uint64_t offset;
+	uint64_t size;
+	uint64_t fence;
+};
+
+/**
+ * The GPU side: frames complete `latency` frames after their fence, or at once when
+ * the CPU waits for the oldest one, as ConstantBufferRing does when the ring is full.
+ */
+struct
+MockGpu {
+	uint64_t submitted = 0;
+	uint64_t completed = 0;
+	unsigned int latency = 0;
+	std::vector<LiveRange> live;
+
+	void
+	complete(RingAllocator& ring, uint64_t fence) {
+		completed = std::max(completed, fence);
+		ring.retire(completed);
+		live.erase(std::remove_if(live.begin(), live.end(), [&](const LiveRange& range) {
+			return range.fence != 0 && range.fence <= completed;
+		}), live.end());
+	}
+};
+
+static void
+checkBasics() {
+	const char* test = "basics";
+	RingAllocator ring;
+	expect(!ring.init(1000, 100), test, "accepted an alignment that isn't a power of two");
+	expect(!ring.init(128, 256), test, "accepted a capacity smaller than the alignment");
+	uint64_t offset = 0;
+	expect(!ring.allocate(16, offset), test, "allocated from a ring that failed to init");
+
+	expect(ring.init(1000, 256), test, "rejected a valid ring");
+	expect(ring.getStats().capacity == 768, test, "the capacity isn't rounded down to the alignment");
+	expect(!ring.allocate(0, offset), test, "allocated an empty range");
+
+	// Three ranges of one frame fill the ring, a fourth doesn't fit
+	for (uint64_t expected : { 0u, 256u, 512u }) {
+		expect(ring.allocate(100, offset) && offset == expected, test, "wrong offset of a range");
+	}
+	expect(!ring.allocate(1, offset) && ring.getStats().failedCount == 1, test, "a full ring didn't report it");
+	ring.endFrame(1);
+	expect(ring.hasPendingFrames() && ring.getOldestFence() == 1, test, "the frame isn't pending");
+	ring.endFrame(2);
+	expect(ring.getOldestFence() == 1, test, "an empty frame was recorded");
+
+	// A frame that spans the end skips the space left there, and frees it too
+	ring.retire(1);
+	expect(ring.getStats().usedBytes == 0 && !ring.hasPendingFrames(), test, "retire didn't free the frame");
+	expect(ring.allocate(300, offset) && offset == 0, test, "an empty ring didn't start over");
+	ring.endFrame(3);
+	expect(ring.allocate(256, offset) && offset == 512, test, "wrong offset after a range of two blocks");
+	ring.endFrame(4);
+	ring.retire(3);
+	expect(ring.allocate(512, offset) && offset == 0 && ring.getStats().wrapCount == 0, test,
+		"a range didn't fit the start of the ring");
+	ring.endFrame(5);
+	ring.retire(4);
+	expect(ring.allocate(200, offset) && offset == 512, test, "the head didn't continue after the wrap");
+	expect(ring.getStats().usedBytes == 768, test, "wrong used bytes");
+	ring.endFrame(6);
+	ring.retire(6);
+	expect(ring.getStats().usedBytes == 0 && ring.getStats().peakBytes == 768, test, "wrong stats once idle");
+
+	// Space left at the end is skipped when a range doesn't fit there
+	ring.init(1024, 256);
+	ring.allocate(512, offset);
+	ring.endFrame(1);
+	ring.allocate(256, offset);
+	ring.endFrame(2);
+	ring.retire(1);
+	expect(ring.allocate(512, offset) && offset == 0 && ring.getStats().wrapCount == 1, test, "didn't wrap");
+	expect(ring.getStats().usedBytes == 1024, test, "the skipped space isn't counted as used");
+	ring.endFrame(3);
+	ring.retire(3);
+	expect(ring.getStats().usedBytes == 0, test, "the skipped space wasn't freed");
+	printf("%-24s alignment, offsets, wraps and retirement as documented\n", test);
+}
+
+/**
+ * Random frames of random blocks on rings of random size with a GPU of random latency.
+ */
+static void
+checkMockGpu() {
+	TestRandom random(7);
+	size_t allocations = 0;
+	size_t waits = 0;
+	size_t wraps = 0;
+	for (int trial = 0; trial < 200; ++trial) {
+		const std::string test = "mock GPU trial " + std::to_string(trial);
+		const unsigned int alignment = 256;
+		const uint64_t capacity = alignment * (1 + random.next() % 64);
+		RingAllocator ring;
+		ring.init(capacity, alignment);
+		MockGpu gpu;
+		gpu.latency = random.next() % 4;
+
+		bool aligned = true;
+		bool disjoint = true;
+		bool withinCapacity = true;
+		for (int frame = 0; frame < 300; ++frame) {
+			if (gpu.submitted >= gpu.latency) {
+				gpu.complete(ring, gpu.submitted - gpu.latency);
+			}
+			const unsigned int blockCount = random.next() % 6;
+			for (unsigned int block = 0; block < blockCount; ++block) {
+				const unsigned int size = 1 + random.next() % 700;
+				uint64_t offset = 0;
+				bool allocated = ring.allocate(size, offset);
+				while (!allocated && ring.hasPendingFrames()) {
+					++waits;
+					gpu.complete(ring, ring.getOldestFence());
+					allocated = ring.allocate(size, offset);
+				}
+				if (!allocated) {
+					// Only a block larger than the ring fails with the GPU idle
+					expect(size > capacity || gpu.live.size() > 0, test, "failed on an idle ring with room");
+					continue;
+				}
+				const uint64_t alignedSize = (size + alignment - 1) / alignment * alignment;
+				aligned = aligned && offset % alignment == 0;
+				withinCapacity = withinCapacity && offset + alignedSize <= capacity;
+				for (const LiveRange& range : gpu.live) {
+					disjoint = disjoint && (offset >= range.offset + range.size || range.offset >= offset + alignedSize);
+				}
+				gpu.live.push_back(LiveRange{ offset, alignedSize, 0 });
+				++allocations;
+			}
+			ring.endFrame(++gpu.submitted);
+			for (LiveRange& range : gpu.live) {
+				range.fence = range.fence == 0 ? gpu.submitted : range.fence;
+			}
+			withinCapacity = withinCapacity && ring.getStats().usedBytes <= capacity;
+		}
+		expect(aligned, test, "a range isn't aligned");
+		expect(disjoint, test, "a range overlaps one the GPU may still read");
+		expect(withinCapacity, test, "a range or the used bytes go past the ring");
+		gpu.complete(ring, gpu.submitted);
+		expect(ring.getStats().usedBytes == 0 && !ring.hasPendingFrames(), test, "bytes leaked once the GPU is idle");
+		wraps += ring.getStats().wrapCount;
+	}
+	printf("%-24s 200 rings, %zu ranges, %zu waits for the GPU, %zu wraps\n", "mock GPU", allocations, waits, wraps);
+}
+
+/**
+ * Times frames of per-object constant blocks the size of this engine's (a few hundred bytes)
+ * on a 4 MB ring, two frames in flight.
+ */
+static void
+runBenchmark(unsigned int runs) {
+	static const unsigned int kFrames = 1000;
+	static const unsigned int kBlocksPerFrame = 2000;
+	double best = 0.0;
+	for (unsigned int run = 0; run < runs; ++run) {
+		RingAllocator ring;
+		ring.init(4 * 1024 * 1024, 256);
+		uint64_t checksum = 0;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (unsigned int frame = 1; frame <= kFrames; ++frame) {
+			if (frame > 2) {
+				ring.retire(frame - 2);
+			}
+			for (unsigned int block = 0; block < kBlocksPerFrame; ++block) {
+				uint64_t offset = 0;
+				ring.allocate(64 + (block % 4) * 96, offset);
+				checksum += offset;
+			}
+			ring.endFrame(frame);
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		best = run == 0 ? seconds : std::min(best, seconds);
+		expect(ring.getStats().failedCount == 0 && checksum > 0, "benchmark", "a block didn't fit");
+	}
+	printf("%u frames of %u blocks, best of %u runs: %.2f ms, %.1f ns per allocation\n", kFrames, kBlocksPerFrame, runs,
+		best * 1000.0, best / (static_cast<double>(kFrames) * kBlocksPerFrame) * 1e9);
+}
+
+int
+main(int argc, char** argv) {
+	unsigned int runs = 3;
+	for (int i = 1; i < argc; ++i) {
+		const std::string option = argv[i];
+		if (option == "-n" && i + 1 < argc) {
+			runs = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else {
+			printf("Usage: OnkosRingTest [-n <runs>]\n");
+			printf("  -n <runs>     Runs of the benchmark, the best is reported (default: 3)\n");
+			return 1;
+		}
+	}
+
+	checkBasics();
+	checkMockGpu();
+	runBenchmark(runs);
+
+	if (failureCount > 0) {
+		printf("%u checks failed\n", failureCount);
+		return 1;
+	}
+	printf("Every ring check passed\n");
+	return 0;
+}
@@ -0,0 +1,433 @@
+//--------------------------------------------------------------------------------------
+// File: StreamerTest.cpp
+//
+// Checks the policy of TextureStreamer against a fake TextureStreamingDevice that only
+// records what is resident: textures start with their tail, stream in as far as the
+// feedback asks within the upload limit, drop the least recently used (then lowest
+// priority) levels when over budget, fall back to the tail once unused, and survive
+// failed creations. A long random run checks the budget and the accounting every
+// frame, and then update() is timed over many textures.
+//
+// Usage: OnkosStreamerTest [-n <runs>] [-t <textures>]
+//--------------------------------------------------------------------------------------
+#include "Prerequisites.h"
+#include "TextureStreamer.h"
+#include "TestMeshes.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+static unsigned int failureCount = 0;
+
+static void
+expect(bool condition, const char* test, const char* what) {
+	if (!condition) {
+		printf("FAILED %s: %s\n", test, what);
+		++failureCount;
+	}
+}
+
+/**
+ * Records the level every texture has resident and the bytes that takes, and fails
+ * the creations it is told to.
+ */
+class
+FakeStreamingDevice : public TextureStreamingDevice {
+public:
+	bool
+	createTexture(StreamedTextureId id, const StagedTexture& texture, unsigned int firstMip) override {
+		if (failing.count(id)) {
+			return false;
+		}
+		const CookedTexture& cooked = texture.texture;
+		const size_t mipCount = cooked.mips.size() / cooked.arraySize;
+		uint64_t bytes = 0;
+		for (size_t slice = 0; slice < cooked.arraySize; ++slice) {
+			for (size_t mip = firstMip; mip < mipCount; ++mip) {
+				bytes += cooked.mips[slice * mipCount + mip].slicePitch;
+			}
+		}
+		residentBytes -= resident.count(id) ? resident[id].second : 0;
+		resident[id] = std::make_pair(firstMip, bytes);
+		residentBytes += bytes;
+		return true;
+	}
+
+	void
+	releaseTexture(StreamedTextureId id) override {
+		++releaseCount;
+		if (resident.count(id)) {
+			residentBytes -= resident[id].second;
+			resident.erase(id);
+		}
+	}
+
+	/** @brief The first resident level and its bytes, per texture. */
+	std::map<StreamedTextureId, std::pair<unsigned int, uint64_t>> resident;
+	uint64_t residentBytes = 0;
+	size_t releaseCount = 0;
+	std::map<StreamedTextureId, bool> failing;
+};
+
+/**
+ * A square RGBA8 texture with a full mip chain, and arraySize slices. The streamer
+ * never reads the texels, so the levels point into one shared dummy buffer.
+ */
+static std::unique_ptr<StagedTexture>
+makeTexture(unsigned int size, unsigned int arraySize = 1) {
+	static const unsigned char dummy[4] = {};
+	std::unique_ptr<StagedTexture> texture(new StagedTexture());
+	texture->fileName = "texture" + std::to_string(size);
+	texture->texture.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	texture->texture.arraySize = arraySize;
+	for (unsigned int slice = 0; slice < arraySize; ++slice) {
+		for (unsigned int level = size; ; level /= 2) {
+			TextureSubresource mip;
+			mip.data = dummy;
+			mip.width = level;
+			mip.height = level;
+			mip.rowPitch = level * 4;
+			mip.slicePitch = level * level * 4;
+			texture->texture.mips.push_back(mip);
+			if (level == 1) {
+				break;
+			}
+		}
+	}
+	return texture;
+}
+
+static uint64_t
+chainBytes(unsigned int size, unsigned int mip, unsigned int arraySize = 1) {
+	uint64_t bytes = 0;
+	for (unsigned int level = size >> mip; level > 0; level /= 2) {
+		bytes += static_cast<uint64_t>(level) * level * 4;
+	}
+	return bytes * arraySize;
+}
+
+static StreamedTextureInfo
+infoOf(const TextureStreamer& streamer, StreamedTextureId id) {
+	StreamedTextureInfo info;
+	streamer.getTextureInfo(id, info);
+	return info;
+}
+
+static void
+checkWantedMip() {
+	const char* test = "computeWantedMip";
+	expect(TextureStreamer::computeWantedMip(1024, 1024, 11, 1024.0f) == 0, test, "full size isn't level 0");
+	expect(TextureStreamer::computeWantedMip(1024, 1024, 11, 4000.0f) == 0, test, "magnified isn't level 0");
+	expect(TextureStreamer::computeWantedMip(1024, 1024, 11, 512.0f) == 1, test, "half size isn't level 1");
+	expect(TextureStreamer::computeWantedMip(1024, 1024, 11, 300.0f) == 1, test, "300 pixels isn't level 1");
+	expect(TextureStreamer::computeWantedMip(1024, 256, 11, 256.0f) == 2, test, "the larger side isn't used");
+	expect(TextureStreamer::computeWantedMip(1024, 1024, 11, 0.25f) == 10, test, "tiny isn't the last level");
+	expect(TextureStreamer::computeWantedMip(1024, 1024, 11, 0.0f) == 10, test, "hidden isn't the last level");
+	expect(TextureStreamer::computeWantedMip(1024, 1024, 11, std::nanf("")) == 10, test, "NaN isn't the last level");
+	expect(TextureStreamer::computeWantedMip(1024, 1024, 0, 10.0f) == 0, test, "no levels isn't 0");
+}
+
+static void
+checkRegistration() {
+	const char* test = "addTexture";
+	FakeStreamingDevice device;
+	TextureStreamer streamer;
+	expect(streamer.addTexture(makeTexture(256)) == kInvalidStreamedTexture, test, "accepted a texture before init");
+
+	streamer.init(device);
+	const StreamedTextureId id = streamer.addTexture(makeTexture(1024));
+	expect(id != kInvalidStreamedTexture, test, "rejected a texture");
+	// The tail is 64x64 and smaller, level 4 of 1024
+	expect(infoOf(streamer, id).residentMip == 4 && device.resident[id].first == 4, test, "the tail isn't resident");
+	expect(device.residentBytes == chainBytes(1024, 4), test, "the tail has the wrong size");
+
+	const StreamedTextureId small = streamer.addTexture(makeTexture(32));
+	expect(infoOf(streamer, small).residentMip == 0, test, "a texture smaller than the tail isn't fully resident");
+
+	expect(streamer.addTexture(std::unique_ptr<StagedTexture>(new StagedTexture())) == kInvalidStreamedTexture, test,
+		"accepted a texture without levels");
+	device.failing[2] = true;
+	expect(streamer.addTexture(makeTexture(128)) == kInvalidStreamedTexture, test, "accepted a tail the device didn't create");
+
+	streamer.removeTexture(id);
+	expect(!device.resident.count(id) && device.releaseCount == 1, test, "removeTexture didn't release");
+	expect(streamer.getStats().textureCount == 1, test, "removeTexture didn't unregister");
+	streamer.destroy();
+	expect(device.resident.empty() && device.residentBytes == 0, test, "destroy didn't release every texture");
+	printf("%-32s tails resident, bad textures rejected, released on remove and destroy\n", test);
+}
+
+static void
+checkStreamIn() {
+	const char* test = "stream in";
+	FakeStreamingDevice device;
+	TextureStreamer streamer;
+	TextureStreamingSettings settings;
+	settings.uploadBytesPerFrame = 1024 * 1024;
+	streamer.init(device, settings);
+	const StreamedTextureId id = streamer.addTexture(makeTexture(2048));
+
+	// Levels 3 and coarser fit the 1 MB limit at once, the others are too large and go in one
+	// level per update, the least progress an update always makes
+	unsigned int frames = 0;
+	bool withinLimit = true;
+	while (infoOf(streamer, id).residentMip > 0 && frames < 100) {
+		streamer.reportUsage(id, 2048.0f);
+		streamer.update();
+		const TextureStreamingStats stats = streamer.getStats();
+		withinLimit = withinLimit && (stats.uploadedBytes <= settings.uploadBytesPerFrame || stats.uploadCount == 1);
+		++frames;
+	}
+	const TextureStreamingStats stats = streamer.getStats();
+	expect(infoOf(streamer, id).residentMip == 0 && device.resident[id].first == 0, test, "level 0 never became resident");
+	expect(withinLimit, test, "an update uploaded over the limit with several textures");
+	expect(frames == 4, test, "took the wrong number of updates");
+	expect(stats.completedRequests == 1 && stats.averageLatencyFrames == frames - 1, test, "wrong latency");
+	expect(stats.pendingCount == 0 && stats.residentBytes == device.residentBytes, test, "wrong stats");
+
+	// A smaller size on screen doesn't drop levels while the budget allows them
+	for (int frame = 0; frame < 3; ++frame) {
+		streamer.reportUsage(id, 100.0f);
+		streamer.reportUsage(id, 2048.0f);
+		streamer.update();
+	}
+	expect(infoOf(streamer, id).wantedMip == 0, test, "several reports in a frame don't keep the finest");
+	printf("%-32s 2048 resident after %u updates of at most %llu bytes\n", test, frames,
+		static_cast<unsigned long long>(settings.uploadBytesPerFrame));
+}
+
+static void
+checkBudget() {
+	const char* test = "budget";
+	FakeStreamingDevice device;
+	TextureStreamer streamer;
+	TextureStreamingSettings settings;
+	settings.budgetBytes = chainBytes(1024, 0) * 2 + chainBytes(1024, 4) * 2;
+	settings.uploadBytesPerFrame = UINT64_MAX;
+	streamer.init(device, settings);
+	StreamedTextureId ids[4];
+	for (int i = 0; i < 4; ++i) {
+		ids[i] = streamer.addTexture(makeTexture(1024), i == 1 ? 2.0f : 1.0f);
+	}
+
+	// Texture 0 is seen first and then only the others: it is the least recently used
+	streamer.reportUsage(ids[0], 1024.0f);
+	streamer.update();
+	for (int i = 1; i < 4; ++i) {
+		streamer.reportUsage(ids[i], 1024.0f);
+	}
+	streamer.update();
+	TextureStreamingStats stats = streamer.getStats();
+	expect(stats.residentBytes <= settings.budgetBytes, test, "over budget");
+	expect(infoOf(streamer, ids[0]).residentMip == 4, test, "the least recently used texture kept its levels");
+	expect(stats.evictionCount == 1 && stats.evictedBytes == chainBytes(1024, 0) - chainBytes(1024, 4), test,
+		"wrong eviction stats");
+
+	// Among textures used in the same frame the lowest priority is coarsened first, texture 1
+	// has the highest and keeps its levels although it comes first
+	expect(infoOf(streamer, ids[1]).residentMip == 0, test, "the high priority texture lost levels");
+	expect(infoOf(streamer, ids[2]).residentMip == 4 && infoOf(streamer, ids[3]).residentMip == 0, test,
+		"the first texture of low priority isn't the one coarsened");
+	expect(stats.wantedBytes == chainBytes(1024, 0) * 4, test, "wrong wanted bytes");
+
+	// A smaller budget evicts by the next update, never below the tails
+	streamer.setBudget(1);
+	for (int i = 1; i < 4; ++i) {
+		streamer.reportUsage(ids[i], 1024.0f);
+	}
+	streamer.update();
+	stats = streamer.getStats();
+	expect(stats.residentBytes == chainBytes(1024, 4) * 4 && device.residentBytes == stats.residentBytes, test,
+		"a tiny budget didn't leave exactly the tails");
+	printf("%-32s LRU texture evicted first, then the lowest priority, tails kept\n", test);
+}
+
+static void
+checkUnused() {
+	const char* test = "unused";
+	FakeStreamingDevice device;
+	TextureStreamer streamer;
+	TextureStreamingSettings settings;
+	settings.unusedFrames = 10;
+	settings.uploadBytesPerFrame = UINT64_MAX;
+	streamer.init(device, settings);
+	const StreamedTextureId id = streamer.addTexture(makeTexture(512, 6));
+	streamer.reportUsage(id, 512.0f);
+	streamer.update();
+	expect(device.residentBytes == chainBytes(512, 0, 6), test, "the cube isn't fully resident");
+
+	unsigned int frames = 0;
+	while (infoOf(streamer, id).residentMip == 0 && frames < 100) {
+		streamer.update();
+		++frames;
+	}
+	expect(frames == settings.unusedFrames + 1, test, "fell back to the tail after the wrong number of updates");
+	expect(infoOf(streamer, id).residentMip == 3 && device.residentBytes == chainBytes(512, 3, 6), test,
+		"didn't fall back to the tail of every face");
+	printf("%-32s a cube falls back to its tail %u updates after its last use\n", test, frames);
+}
+
+static void
+checkDeviceFailure() {
+	const char* test = "device failure";
+	FakeStreamingDevice device;
+	TextureStreamer streamer;
+	TextureStreamingSettings settings;
+	settings.uploadBytesPerFrame = UINT64_MAX;
+	streamer.init(device, settings);
+	const StreamedTextureId id = streamer.addTexture(makeTexture(1024));
+	device.failing[id] = true;
+	for (int frame = 0; frame < 3; ++frame) {
+		streamer.reportUsage(id, 1024.0f);
+		streamer.update();
+	}
+	expect(infoOf(streamer, id).residentMip == 4 && device.resident[id].first == 4, test, "a failed creation changed the level");
+	expect(streamer.getStats().pendingCount == 1, test, "a failed request isn't pending");
+
+	device.failing.clear();
+	streamer.reportUsage(id, 1024.0f);
+	streamer.update();
+	const TextureStreamingStats stats = streamer.getStats();
+	expect(infoOf(streamer, id).residentMip == 0 && stats.pendingCount == 0, test, "the request wasn't retried");
+	expect(stats.completedRequests == 1 && stats.averageLatencyFrames == 3.0, test, "the latency doesn't count the retries");
+	printf("%-32s old level kept, retried until it succeeds\n", test);
+}
+
+/**
+ * Many textures seen at random sizes for many frames: the budget, the upload limit and
+ * the accounting hold after every update.
+ */
+static void
+checkRandomRun() {
+	const char* test = "random run";
+	FakeStreamingDevice device;
+	TextureStreamer streamer;
+	TextureStreamingSettings settings;
+	settings.budgetBytes = 48ull * 1024 * 1024;
+	settings.uploadBytesPerFrame = 4ull * 1024 * 1024;
+	settings.unusedFrames = 30;
+	streamer.init(device, settings);
+
+	// The tails can't be evicted, the budget only holds while it is larger than they are
+	TestRandom random(21);
+	std::vector<StreamedTextureId> ids;
+	uint64_t tails = 0;
+	for (int i = 0; i < 300; ++i) {
+		const unsigned int size = 64u << (random.next() % 6);
+		const unsigned int arraySize = i % 7 == 0 ? 6 : 1;
+		ids.push_back(streamer.addTexture(makeTexture(size, arraySize), 1.0f + (random.next() % 3)));
+		tails += chainBytes(size, static_cast<unsigned int>(std::log2(size / 64)), arraySize);
+	}
+
+	bool withinBudget = true;
+	bool withinLimit = true;
+	bool accounted = true;
+	bool withinTarget = true;
+	size_t uploads = 0;
+	size_t evictions = 0;
+	for (int frame = 0; frame < 600; ++frame) {
+		// A window of visible textures that drifts, at sizes that change every frame
+		const size_t first = (frame / 4) % ids.size();
+		for (size_t i = 0; i < 60; ++i) {
+			streamer.reportUsage(ids[(first + i) % ids.size()], static_cast<float>(random.next() % 3000));
+		}
+		if (frame == 300) {
+			streamer.setBudget(settings.budgetBytes / 3);
+		}
+		streamer.update();
+
+		const TextureStreamingStats stats = streamer.getStats();
+		for (StreamedTextureId id : ids) {
+			const StreamedTextureInfo info = infoOf(streamer, id);
+			withinTarget = withinTarget && info.residentMip >= info.targetMip;
+			accounted = accounted && device.resident[id].first == info.residentMip &&
+				device.resident[id].second == info.residentBytes;
+		}
+		withinBudget = withinBudget && stats.residentBytes <= std::max(stats.budgetBytes, tails);
+		withinLimit = withinLimit && (stats.uploadedBytes <= settings.uploadBytesPerFrame || stats.uploadCount == 1);
+		accounted = accounted && stats.residentBytes == device.residentBytes;
+		uploads += stats.uploadCount;
+		evictions += stats.evictionCount;
+	}
+	expect(withinBudget, test, "over budget after an update");
+	expect(withinLimit, test, "an update uploaded over the limit");
+	expect(accounted, test, "the streamer and the device disagree");
+	expect(withinTarget, test, "a texture is finer than its target");
+	expect(uploads > 0 && evictions > 0, test, "nothing was streamed");
+	const TextureStreamingStats stats = streamer.getStats();
+	printf("%-32s 600 updates of 300 textures: %zu uploads, %zu evictions, %zu requests, %.1f updates of latency\n",
+		test, uploads, evictions, stats.completedRequests, stats.averageLatencyFrames);
+}
+
+/**
+ * Times update() on many textures, each reported every frame at a size that keeps changing.
+ */
+static void
+runBenchmark(unsigned int textureCount, unsigned int runs) {
+	FakeStreamingDevice device;
+	TextureStreamer streamer;
+	TextureStreamingSettings settings;
+	settings.budgetBytes = 512ull * 1024 * 1024;
+	streamer.init(device, settings);
+	TestRandom random(5);
+	std::vector<StreamedTextureId> ids;
+	for (unsigned int i = 0; i < textureCount; ++i) {
+		ids.push_back(streamer.addTexture(makeTexture(64u << (random.next() % 6))));
+	}
+
+	const unsigned int frames = 100;
+	double best = 0.0;
+	for (unsigned int run = 0; run < runs; ++run) {
+		auto start = std::chrono::high_resolution_clock::now();
+		for (unsigned int frame = 0; frame < frames; ++frame) {
+			for (StreamedTextureId id : ids) {
+				streamer.reportUsage(id, static_cast<float>(random.next() % 2048));
+			}
+			streamer.update();
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		best = run == 0 ? seconds : std::min(best, seconds);
+	}
+	printf("%u textures, %u updates, best of %u runs: %.3f ms per update, %.0f ns per texture\n", textureCount, frames,
+		runs, best / frames * 1000.0, best / frames / textureCount * 1e9);
+}
+
+int
+main(int argc, char** argv) {
+	unsigned int runs = 3;
+	unsigned int textureCount = 10000;
+	for (int i = 1; i < argc; ++i) {
+		const std::string option = argv[i];
+		if (option == "-n" && i + 1 < argc) {
+			runs = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else if (option == "-t" && i + 1 < argc) {
+			textureCount = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else {
+			printf("Usage: OnkosStreamerTest [-n <runs>] [-t <textures>]\n");
+			printf("  -n <runs>      Runs of the benchmark, the best is reported (default: 3)\n");
+			printf("  -t <textures>  Textures of the benchmark (default: 10000)\n");
+			return 1;
+		}
+	}
+
+	checkWantedMip();
+	checkRegistration();
+	checkStreamIn();
+	checkBudget();
+	checkUnused();
+	checkDeviceFailure();
+	checkRandomRun();
+	runBenchmark(textureCount, runs);
+
+	if (failureCount > 0) {
+		printf("%u checks failed\n", failureCount);
+		return 1;
+	}
+	printf("Every streamer check passed\n");
+	return 0;
+}
@@ -0,0 +1,111 @@
+//--------------------------------------------------------------------------------------
+// File: TestMeshes.h
+//
+// Procedural meshes shared by the mesh test programs of the tools directory.
+//--------------------------------------------------------------------------------------
+#pragma once
+#include "Prerequisites.h"
+#include "MeshComponent.h"
+#include <cmath>
+#include <utility>
+
+/**
+ * A small linear congruential generator, so every run sees the same input.
+ */
+struct
+TestRandom {
+	uint32_t state;
+
+	explicit TestRandom(uint32_t seed) : state(seed) {}
+
+	uint32_t
+	next() {
+		state = state * 1664525u + 1013904223u;
+		return state >> 8;
+	}
+
+	/** A float in [0, 1). */
+	float
+	nextFloat() { return (next() & 0xFFFF) / 65536.0f; }
+};
+
+/**
+ * A (width + 1) x (height + 1) grid of vertices in the XY plane with a wave in Z,
+ * two triangles per cell, clockwise seen from -Z like the rest of the engine.
+ */
+inline MeshComponent
+makeGrid(unsigned int width, unsigned int height) {
+	MeshComponent mesh;
+	for (unsigned int y = 0; y <= height; ++y) {
+		for (unsigned int x = 0; x <= width; ++x) {
+			SimpleVertex vertex = {};
+			vertex.Pos = XMFLOAT3(static_cast<float>(x), static_cast<float>(y), std::sin(x * 0.35f) * std::cos(y * 0.25f));
+			vertex.Tex = XMFLOAT2(x / static_cast<float>(width), y / static_cast<float>(height));
+			vertex.Norm = XMFLOAT3(0.0f, 0.0f, -1.0f);
+			mesh.m_vertex.push_back(vertex);
+		}
+	}
+	for (unsigned int y = 0; y < height; ++y) {
+		for (unsigned int x = 0; x < width; ++x) {
+			const unsigned int a = y * (width + 1) + x;
+			const unsigned int b = a + 1;
+			const unsigned int c = a + width + 1;
+			const unsigned int d = c + 1;
+			const unsigned int cell[6] = { a, c, b, b, c, d };
+			mesh.m_index.insert(mesh.m_index.end(), cell, cell + 6);
+		}
+	}
+	mesh.m_numVertex = static_cast<int>(mesh.m_vertex.size());
+	mesh.m_numIndex = static_cast<int>(mesh.m_index.size());
+	mesh.computeBounds();
+	return mesh;
+}
+
+/**
+ * A UV sphere of unit radius, with its own vertex at every corner of the poles.
+ */
+inline MeshComponent
+makeSphere(unsigned int rings, unsigned int segments) {
+	MeshComponent mesh;
+	const float pi = 3.14159265f;
+	for (unsigned int ring = 0; ring <= rings; ++ring) {
+		const float theta = pi * ring / rings;
+		for (unsigned int segment = 0; segment <= segments; ++segment) {
+			const float phi = 2.0f * pi * segment / segments;
+			SimpleVertex vertex = {};
+			vertex.Pos = XMFLOAT3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			vertex.Tex = XMFLOAT2(segment / static_cast<float>(segments), ring / static_cast<float>(rings));
+			vertex.Norm = vertex.Pos;
+			mesh.m_vertex.push_back(vertex);
+		}
+	}
+	for (unsigned int ring = 0; ring < rings; ++ring) {
+		for (unsigned int segment = 0; segment < segments; ++segment) {
+			const unsigned int a = ring * (segments + 1) + segment;
+			const unsigned int b = a + 1;
+			const unsigned int c = a + segments + 1;
+			const unsigned int d = c + 1;
+			const unsigned int quad[6] = { a, b, c, b, d, c };
+			mesh.m_index.insert(mesh.m_index.end(), quad, quad + 6);
+		}
+	}
+	mesh.m_numVertex = static_cast<int>(mesh.m_vertex.size());
+	mesh.m_numIndex = static_cast<int>(mesh.m_index.size());
+	mesh.computeBounds();
+	return mesh;
+}
+
+/**
+ * Puts the triangles of a list in a random order (Fisher-Yates), keeping each triangle intact.
+ */
+inline void
+shuffleTriangles(std::vector<unsigned int>& indices, uint32_t seed) {
+	TestRandom random(seed);
+	const size_t triangleCount = indices.size() / 3;
+	for (size_t i = triangleCount; i > 1; --i) {
+		const size_t j = random.next() % i;
+		for (size_t c = 0; c < 3; ++c) {
+			std::swap(indices[(i - 1) * 3 + c], indices[j * 3 + c]);
+		}
+	}
+}
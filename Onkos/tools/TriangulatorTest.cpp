@@ -0,0 +1,236 @@
+//--------------------------------------------------------------------------------------
+// File: TriangulatorTest.cpp
+//
+// Checks PolygonTriangulator on convex, concave, collinear and self-touching polygons
+// in several planes: every polygon of n corners gives n - 2 triangles that keep its
+// winding and cover exactly its area. Then times it on a stream of n-gons, most of
+// them concave, like the faces of a heavily n-gon modeled OBJ.
+//
+// Usage: OnkosTriangulatorTest [-n <runs>]
+//--------------------------------------------------------------------------------------
+#include "Prerequisites.h"
+#include "PolygonTriangulator.h"
+#include "TestMeshes.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Relative slack for the float rounding of the areas
+static const float kAreaTolerance = 1e-4f;
+
+static unsigned int failureCount = 0;
+
+static XMFLOAT3
+cross(const XMFLOAT3& a, const XMFLOAT3& b) {
+	return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+static float
+dot(const XMFLOAT3& a, const XMFLOAT3& b) {
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static XMFLOAT3
+subtract(const XMFLOAT3& a, const XMFLOAT3& b) {
+	return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+/**
+ * Places 2D corners on a plane through the origin with the given (not necessarily unit) axes.
+ */
+static std::vector<XMFLOAT3>
+toPlane(const std::vector<XMFLOAT2>& corners, const XMFLOAT3& u, const XMFLOAT3& v) {
+	std::vector<XMFLOAT3> points;
+	for (const XMFLOAT2& c : corners) {
+		points.push_back(XMFLOAT3(u.x * c.x + v.x * c.y, u.y * c.x + v.y * c.y, u.z * c.x + v.z * c.y));
+	}
+	return points;
+}
+
+/**
+ * Triangulates a polygon and checks the triangle count, the winding and the covered area.
+ */
+static void
+checkPolygon(PolygonTriangulator& triangulator, const char* name, const std::vector<XMFLOAT3>& points) {
+	const size_t cornerCount = points.size();
+	std::vector<unsigned int> triangles((cornerCount - 2) * 3, 0xFFFFFFFFu);
+	const size_t triangleCount = triangulator.triangulate(points.data(), cornerCount, triangles.data());
+	if (triangleCount != cornerCount - 2) {
+		printf("FAILED %s: %zu triangles for %zu corners\n", name, triangleCount, cornerCount);
+		++failureCount;
+		return;
+	}
+
+	// Newell's normal is twice the vector area of the polygon
+	XMFLOAT3 normal(0.0f, 0.0f, 0.0f);
+	for (size_t i = 0; i < cornerCount; ++i) {
+		const XMFLOAT3 term = cross(points[i], points[(i + 1) % cornerCount]);
+		normal = XMFLOAT3(normal.x + term.x, normal.y + term.y, normal.z + term.z);
+	}
+	const float polygonArea = std::sqrt(dot(normal, normal)) * 0.5f;
+
+	// Triangles that overlap or fold over count their area twice and can't add up to the polygon
+	float coveredArea = 0.0f;
+	bool flipped = false;
+	std::vector<int> uses(cornerCount, 0);
+	for (size_t t = 0; t < triangleCount; ++t) {
+		const unsigned int* corner = &triangles[t * 3];
+		if (corner[0] >= cornerCount || corner[1] >= cornerCount || corner[2] >= cornerCount) {
+			printf("FAILED %s: corner out of range\n", name);
+			++failureCount;
+			return;
+		}
+		++uses[corner[0]];
+		++uses[corner[1]];
+		++uses[corner[2]];
+		const XMFLOAT3 n = cross(subtract(points[corner[1]], points[corner[0]]),
+			subtract(points[corner[2]], points[corner[0]]));
+		coveredArea += std::sqrt(dot(n, n)) * 0.5f;
+		flipped = flipped || dot(n, normal) < -kAreaTolerance * polygonArea;
+	}
+	const bool everyCorner = std::find(uses.begin(), uses.end(), 0) == uses.end();
+	const float scale = std::max(polygonArea, 1.0f);
+	if (flipped || !everyCorner || std::fabs(coveredArea - polygonArea) > kAreaTolerance * scale) {
+		printf("FAILED %s: area %g covered %g%s%s\n", name, polygonArea, coveredArea,
+			flipped ? ", flipped triangle" : "", everyCorner ? "" : ", unused corner");
+		++failureCount;
+		return;
+	}
+	printf("%-32s %3zu corners %3zu triangles  area %g\n", name, cornerCount, triangleCount, polygonArea);
+}
+
+/**
+ * Checks a 2D polygon in both windings and in planes facing along every axis and a skewed one.
+ */
+static void
+checkCase(PolygonTriangulator& triangulator, const char* name, std::vector<XMFLOAT2> corners) {
+	static const XMFLOAT3 planes[][2] = {
+		{ XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f) },
+		{ XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f) },
+		{ XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(1.0f, 0.0f, 0.0f) },
+		{ XMFLOAT3(0.8f, 0.6f, 0.0f), XMFLOAT3(-0.36f, 0.48f, 0.8f) },
+	};
+	static const char* planeNames[] = { "XY", "YZ", "ZX", "skewed" };
+	for (int winding = 0; winding < 2; ++winding) {
+		for (int plane = 0; plane < 4; ++plane) {
+			const std::string label = std::string(name) + (winding ? " reversed " : " ") + planeNames[plane];
+			checkPolygon(triangulator, label.c_str(), toPlane(corners, planes[plane][0], planes[plane][1]));
+		}
+		std::reverse(corners.begin(), corners.end());
+	}
+}
+
+/**
+ * A star of random radii around the origin: convex at low spread, deeply concave at high spread.
+ */
+static std::vector<XMFLOAT2>
+makeStar(TestRandom& random, size_t cornerCount, float spread) {
+	std::vector<XMFLOAT2> corners;
+	for (size_t i = 0; i < cornerCount; ++i) {
+		const float angle = 6.2831853f * i / cornerCount;
+		const float radius = 1.0f - spread * random.nextFloat();
+		corners.push_back(XMFLOAT2(std::cos(angle) * radius, std::sin(angle) * radius));
+	}
+	return corners;
+}
+
+static void
+runTests(PolygonTriangulator& triangulator) {
+	checkCase(triangulator, "triangle", { {0, 0}, {1, 0}, {0, 1} });
+	checkCase(triangulator, "square", { {0, 0}, {1, 0}, {1, 1}, {0, 1} });
+	checkCase(triangulator, "concave quad (dart)", { {0, 0}, {2, 1}, {0, 2}, {0.5f, 1} });
+	checkCase(triangulator, "L shape", { {0, 0}, {2, 0}, {2, 1}, {1, 1}, {1, 2}, {0, 2} });
+	checkCase(triangulator, "comb", { {0, 0}, {5, 0}, {5, 3}, {4, 3}, {4, 1}, {3, 1}, {3, 3}, {2, 3}, {2, 1},
+		{1, 1}, {1, 3}, {0, 3} });
+	checkCase(triangulator, "spiral", { {0, 0}, {4, 0}, {4, 4}, {1, 4}, {1, 2}, {2, 2}, {2, 3}, {3, 3}, {3, 1},
+		{0, 1} });
+
+	// Corners in the middle of an edge
+	checkCase(triangulator, "square, collinear corners", { {0, 0}, {1, 0}, {2, 0}, {2, 1}, {2, 2}, {1, 2}, {0, 2},
+		{0, 1} });
+	checkCase(triangulator, "L shape, collinear corners", { {0, 0}, {1, 0}, {2, 0}, {2, 1}, {1.5f, 1}, {1, 1},
+		{1, 1.5f}, {1, 2}, {0, 2}, {0, 1} });
+	checkCase(triangulator, "collinear run to a reflex", { {0, 0}, {3, 0}, {3, 3}, {2, 2}, {1, 1}, {0, 3} });
+
+	// A corner that touches another corner or an edge
+	checkCase(triangulator, "two squares sharing a corner", { {0, 0}, {1, 0}, {1, 1}, {2, 1}, {2, 2}, {1, 2},
+		{1, 1}, {0, 1} });
+	checkCase(triangulator, "keyhole", { {0, 0}, {4, 0}, {4, 4}, {2, 4}, {2, 3}, {3, 3}, {3, 1}, {1, 1}, {1, 3},
+		{2, 3}, {2, 4}, {0, 4} });
+	checkCase(triangulator, "corner touching an edge", { {0, 0}, {4, 0}, {4, 2}, {2, 0}, {0, 2} });
+
+	TestRandom random(99);
+	for (size_t cornerCount : { 5, 8, 16, 33, 64 }) {
+		for (float spread : { 0.0f, 0.3f, 0.7f }) {
+			const std::string name = "star " + std::to_string(cornerCount) + " spread " + std::to_string(spread).substr(0, 3);
+			checkCase(triangulator, name.c_str(), makeStar(random, cornerCount, spread));
+		}
+	}
+
+	// Degenerate input still gives n - 2 triangles, of no area
+	checkPolygon(triangulator, "all corners on a line", { XMFLOAT3(0, 0, 0), XMFLOAT3(1, 0, 0), XMFLOAT3(2, 0, 0),
+		XMFLOAT3(3, 0, 0) });
+}
+
+/**
+ * Times the triangulation of many n-gons, best of the runs.
+ */
+static void
+runBenchmark(PolygonTriangulator& triangulator, unsigned int runs) {
+	static const size_t kPolygonCount = 20000;
+	TestRandom random(2026);
+	std::vector<std::vector<XMFLOAT3>> polygons;
+	size_t cornerTotal = 0;
+	for (size_t i = 0; i < kPolygonCount; ++i) {
+		// 5 to 36 corners, three of every four concave, in a random plane
+		const size_t cornerCount = 5 + random.next() % 32;
+		const float spread = (i % 4 == 0) ? 0.0f : 0.6f;
+		const XMFLOAT3 u(1.0f, random.nextFloat() - 0.5f, random.nextFloat() - 0.5f);
+		const XMFLOAT3 v(random.nextFloat() - 0.5f, 1.0f, random.nextFloat() - 0.5f);
+		polygons.push_back(toPlane(makeStar(random, cornerCount, spread), u, v));
+		cornerTotal += cornerCount;
+	}
+
+	std::vector<unsigned int> triangles(36 * 3);
+	double best = 0.0;
+	size_t triangleTotal = 0;
+	for (unsigned int run = 0; run < runs; ++run) {
+		triangleTotal = 0;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (const std::vector<XMFLOAT3>& polygon : polygons) {
+			triangleTotal += triangulator.triangulate(polygon.data(), polygon.size(), triangles.data());
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		best = run == 0 ? seconds : std::min(best, seconds);
+	}
+	printf("%zu n-gons (%zu corners), best of %u runs: %.2f ms, %.2f M triangles/s, %.0f ns per polygon\n",
+		polygons.size(), cornerTotal, runs, best * 1000.0, triangleTotal / best / 1e6, best / polygons.size() * 1e9);
+}
+
+int
+main(int argc, char** argv) {
+	unsigned int runs = 3;
+	for (int i = 1; i < argc; ++i) {
+		const std::string option = argv[i];
+		if (option == "-n" && i + 1 < argc) {
+			runs = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else {
+			printf("Usage: OnkosTriangulatorTest [-n <runs>]\n");
+			printf("  -n <runs>     Runs of the benchmark, the best is reported (default: 3)\n");
+			return 1;
+		}
+	}
+
+	PolygonTriangulator triangulator;
+	runTests(triangulator);
+	runBenchmark(triangulator, runs);
+
+	if (failureCount > 0) {
+		printf("%u polygons failed\n", failureCount);
+		return 1;
+	}
+	printf("Every polygon check passed\n");
+	return 0;
+}